@@ -4,20 +4,146 @@
 
 #include <Arduino.h>
 #include <usb_serial.h>
+#include <SD.h>
 
 #include "defines.h"
 
+#include "src/utils/logging/logging.h"
+#include "src/utils/logging/boot_log.h"
+#include "src/utils/boot/boot.h"
+
+/**
+ * USB serial, available once a host opened the port
+ */
+struct SerialTransport
+{
+    bool is_available() const
+        { return Serial; }
+
+    size_t write(const char* bytes, size_t size)
+        {
+            const int room = Serial.availableForWrite();
+            if (room <= 0)
+                { return 0; }
+            return Serial.write(bytes, size < static_cast<size_t>(room) ? size : room);
+        }
+
+    error::status_byte flush()
+        {
+            Serial.flush();
+            return error::status_byte{};
+        }
+};
+
+/**
+ * Log file on the SD card, available once the card is mounted
+ */
+struct SdTransport
+{
+    bool is_available() const
+        { return file; }
+
+    size_t write(const char* bytes, size_t size)
+        { return file.write(bytes, size); }
+
+    error::status_byte flush()
+        {
+            file.flush();
+            return error::status_byte{};
+        }
+
+    static File file;
+};
+File SdTransport::file;
+
+using boot_log_type = logging::BootLog<4096, SerialTransport, SdTransport>;
+static boot_log_type boot_log{SerialTransport{}, SdTransport{}};
+static logging::Logger<boot_log_type::printer_type, logging::severity_filter> logger{boot_log.printer(), {error::severity::INFO}};
+
+static logging::raw_header header(const char* facility)
+    { return logging::raw_header{facility, error::errcode::OK | error::severity::INFO, millis()}; }
+
+namespace steps
+{
+
+using boot::step_result;
+
+step_result init_logger(bool)
+    {
+        logger(header("boot"), "%s %s\n", BUILD_DATE, BUILD_STR);
+        return step_result::Done;
+    }
+
+/** Opening the port is not waited for: buffered logs are replayed once a host reads it */
+step_result begin_serial(bool)
+    {
+        Serial.begin(9600);
+        return step_result::Done;
+    }
+
+step_result init_sd_card(bool)
+    {
+        if (!SD.begin(BUILTIN_SDCARD))
+            { return step_result::Failed; }
+        SD.mkdir("logs");
+        SdTransport::file = SD.open(LOG_FILE, FILE_WRITE);
+        return SdTransport::file ? step_result::Done : step_result::Failed;
+    }
+
+/** Steps of drivers not wired in the sketch yet */
+step_result pending(bool)
+    { return step_result::Done; }
+
+} /* endof namespace steps */
+
+static const boot::step_fn BOOT_STEPS[boot::DEVICE_STEPS_COUNT] = {
+    /* InitLogger */                &steps::init_logger,
+    /* BeginSerial */               &steps::begin_serial,
+    /* InitSdCard */                &steps::init_sd_card,
+    /* LogToSerial */               &steps::pending,
+    /* LogToFile */                 &steps::pending,
+    /* LoadConfig */                &steps::pending,
+    /* ConfigureHardware */         &steps::pending,
+    /* SetupLedsDriver */           &steps::pending,
+    /* ConfigureI2CBuses */         &steps::pending,
+    /* ConfigureMcpRegisters */     &steps::pending,
+    /* SetupPadsDriver */           &steps::pending,
+    /* SetupEncodersDriver */       &steps::pending,
+    /* SetupAnalog */               &steps::pending,
+    /* SetupErrorLed */             &steps::pending,
+    /* ConfigureRawGpio */          &steps::pending,
+    /* InitState */                 &steps::pending,
+    /* InitControlSurface */        &steps::pending,
+    /* SetupActionTimers */         &steps::pending,
+    /* SetupActionsStack */         &steps::pending,
+    /* SetupQuadratureDecoders */   &steps::pending,
+    /* SetupMidi */                 &steps::pending,
+    /* BeginMidi */                 &steps::pending,
+    /* ConfigureSoftware */         &steps::pending,
+};
+
+struct BootContext
+{
+    static unsigned long micros()       { return ::micros(); }
+};
+
+static boot::Executor<BootContext> executor{boot::DEVICE_GRAPH, BOOT_STEPS, boot::DEVICE_STEPS_COUNT};
+
+/** Boot steps are only run from a valid graph */
+static bool booting = false;
+
 void setup()
 {
-    /* %0: load configuration */
-    /* %1: configure hardware */
-    Serial.begin(9600);
-    while (!Serial) { /* nothing */ }
-    Serial.println(BUILD_DATE);
-    Serial.println(BUILD_ID);
+    const error::status_byte status = executor.setup();
+    booting = status;
+    /* buffered, replayed once a transport is available */
+    if (!booting)
+        { logger(logging::raw_header{"boot", status, millis()}, "invalid boot graph, no step is run\n"); }
 }
 
 void loop()
 {
-
-}
\ No newline at end of file
+    if (booting && !executor.is_over() && executor.update() != boot::step_state::Running)
+        { executor.dump(logger, "boot"); }
+    boot_log.pump();
+}
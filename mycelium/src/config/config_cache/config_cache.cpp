@@ -0,0 +1,74 @@
+/**
+ * 
+ */
+
+#include "config_cache.hxx"
+
+#include <cstring>
+
+namespace config
+{
+namespace config_cache
+{
+
+void
+config_image::clear()
+    {
+        std::memset(this, 0, sizeof(config_image));
+        std::memset(pad_colors, UNSET, sizeof(pad_colors));
+        std::memset(ring_values, UNSET, sizeof(ring_values));
+        header.magic = IMAGE_MAGIC;
+        header.version = IMAGE_VERSION;
+        header.size = sizeof(config_image);
+    }
+
+uint32_t
+checksum_of(const config_image& image)
+    {
+        image_header header = image.header;
+        header.checksum = 0;
+
+        fnv1a hash;
+        hash.feed(&header, sizeof(header));
+        hash.feed(reinterpret_cast<const uint8_t*>(&image) + sizeof(header), sizeof(config_image) - sizeof(header));
+        return hash.value;
+    }
+
+error::status_byte
+validate(const void* bytes, size_t size)
+    {
+        const config_image& image = *static_cast<const config_image*>(bytes);
+        if (size != sizeof(config_image)
+            || image.header.magic != IMAGE_MAGIC
+            || image.header.version != IMAGE_VERSION
+            || image.header.size != sizeof(config_image)
+            || image.header.checksum != checksum_of(image))
+            { return error::errcode::INVALID_ARGUMENT | error::severity::WARNING; }
+        return error::status_byte{};
+    }
+
+const config_image*
+map(const void* bytes, size_t size)
+    {
+        if (reinterpret_cast<uintptr_t>(bytes) % alignof(config_image) != 0 || !validate(bytes, size))
+            { return nullptr; }
+        return static_cast<const config_image*>(bytes);
+    }
+
+error::status_byte
+load_mappings(const config_image& image, midi::midi_mapping::Mappings& mappings)
+    {
+        for (uint8_t m=0; m<MODES_COUNT; ++m)
+            {
+                const midi::midi_mapping::mode mode = static_cast<midi::midi_mapping::mode>(m);
+                if (!image.has(mode))
+                    { continue; }
+                const error::status_byte status = mappings.load(mode, image.bindings[m], image.bindings_count[m]);
+                if (!status)
+                    { return status; }
+            }
+        return error::status_byte{};
+    }
+
+} /* endof namespace config_cache */
+} /* endof namespace config */
@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "config_cache.hxx"
@@ -0,0 +1,137 @@
+/**
+ * 
+ */
+
+#include "config_cache.hxx"
+
+namespace config
+{
+namespace config_cache
+{
+
+/**
+ * Reader adapter hashing the text while it is read
+ */
+template <typename Reader>
+struct hashing_reader
+{
+    Reader& reader;
+    fnv1a hash;
+    size_t bytes;
+
+    size_t read(char* buffer, size_t size)
+        {
+            size = reader.read(buffer, size);
+            hash.feed(buffer, size);
+            bytes += size;
+            return size;
+        }
+};
+
+template <typename Reader>
+    error::status_byte
+compile(Reader& reader, config_image& image)
+    {
+        using config_parser::entry_kind;
+
+        image.clear();
+        hashing_reader<Reader> hashing{reader, fnv1a{}, 0};
+        config_parser::ConfigParser<hashing_reader<Reader>> parser(hashing);
+        error::status_byte status;
+
+        config_parser::entry e;
+        while (parser.next(e))
+            {
+                switch (e.kind)
+                    {
+                    case entry_kind::Section:
+                        if (e.in == config_parser::section::Mapping)
+                            { image.modes_mask |= 1 << static_cast<uint8_t>(e.mode); }
+                        break;
+
+                    case entry_kind::Setting:
+                        image.settings_mask |= 1 << static_cast<uint8_t>(e.option.key);
+                        image.settings[static_cast<uint8_t>(e.option.key)] = e.option.value;
+                        break;
+
+                    case entry_kind::Binding:
+                        {
+                            uint16_t& count = image.bindings_count[static_cast<uint8_t>(e.mode)];
+                            if (count == BINDINGS_MAX_COUNT)
+                                {
+                                    if (status)
+                                        { status = error::errcode::MEMORY_ERROR | error::severity::ERROR; }
+                                    image.header.errors += 1;
+                                    break;
+                                }
+                            image.bindings[static_cast<uint8_t>(e.mode)][count++] = e.binding;
+                            break;
+                        }
+
+                    case entry_kind::PadState:
+                        image.pad_colors[static_cast<uint8_t>(e.pad.pad)] = static_cast<uint8_t>(e.pad.color);
+                        break;
+
+                    case entry_kind::EncoderState:
+                        image.ring_values[static_cast<uint8_t>(e.encoder.encoder)] = e.encoder.value;
+                        break;
+
+                    case entry_kind::Error:
+                        if (status)
+                            { status = e.status; }
+                        image.header.errors += 1;
+                        break;
+                    }
+            }
+
+        image.header.text_hash = hashing.hash.value;
+        image.header.checksum = checksum_of(image);
+        return status;
+    }
+
+template <typename Storage>
+    error::status_byte
+load(Storage& storage, config_image& image, load_report* report)
+    {
+        load_report r{load_source::Cache, 0, 0, false};
+
+        const size_t size = storage.read_image(&image, sizeof(config_image));
+        if (validate(&image, size))
+            {
+                fnv1a hash;
+                char window[config_parser::READ_WINDOW_SIZE];
+                while (size_t count = storage.read_text(window, sizeof(window)))
+                    {
+                        hash.feed(window, count);
+                        r.text_bytes += count;
+                    }
+                if (hash.value == image.header.text_hash)
+                    {
+                        r.errors = image.header.errors;
+                        if (report)
+                            { *report = r; }
+                        return error::status_byte{};
+                    }
+                storage.rewind_text();
+            }
+
+        struct text_reader
+        {
+            Storage& storage;
+            size_t read(char* buffer, size_t size)  { return storage.read_text(buffer, size); }
+        } reader{storage};
+
+        hashing_reader<text_reader> counting{reader, fnv1a{}, 0};
+        const error::status_byte status = compile(counting, image);
+        r.source = load_source::Text;
+        r.text_bytes += counting.bytes;
+        r.errors = image.header.errors;
+        r.stored = storage.write_image(&image, sizeof(config_image));
+        if (report)
+            { *report = r; }
+        /* faulty lines were reported while compiling, failing to store only slows next boot */
+        return status;
+    }
+
+} /* endof namespace config_cache */
+} /* endof namespace config */
@@ -0,0 +1,158 @@
+/**
+ * 
+ */
+
+#ifndef DEF_CONFIG_CACHE_HXX
+#define DEF_CONFIG_CACHE_HXX
+
+#include "error.hpp"
+#include "../config_parser/config_parser.hxx"
+#include "../../midi/midi_mapping/midi_mapping.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace config
+{
+namespace config_cache
+{
+
+using config_parser::SETTINGS_COUNT;
+using midi::midi_mapping::PADS_COUNT;
+using midi::midi_mapping::ENCODERS_COUNT;
+using midi::midi_mapping::MODES_COUNT;
+using midi::midi_mapping::BINDINGS_MAX_COUNT;
+
+/**
+ * Image identification: "MYCC" read as a little endian word,
+ *  version changes with the meaning of any field
+ */
+static constexpr const uint32_t IMAGE_MAGIC = 0x4343594D;
+static constexpr const uint16_t IMAGE_VERSION = 1;
+
+/** Pad colors and led-ring values not set by the configuration */
+static constexpr const uint8_t UNSET = 0xFF;
+
+/**
+ * FNV-1a hash, fed incrementally
+ */
+struct fnv1a
+{
+    static constexpr const uint32_t OFFSET_BASIS = 0x811C9DC5;
+    static constexpr const uint32_t PRIME = 0x01000193;
+
+    uint32_t value = OFFSET_BASIS;
+
+    void feed(const void* bytes, size_t size)
+        {
+            const uint8_t* b = static_cast<const uint8_t*>(bytes);
+            for (size_t i=0; i<size; ++i)
+                { value = (value ^ b[i]) * PRIME; }
+        }
+};
+
+struct image_header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;          ///< whole image size, changes with the layout
+    uint32_t text_hash;     ///< hash of the configuration text the image was compiled from
+    uint32_t checksum;      ///< hash of the whole image, computed with a zero checksum
+    uint16_t errors;        ///< faulty lines skipped while compiling
+    uint16_t reserved;
+};
+
+/**
+ * Compiled configuration: every parsed value at a fixed place,
+ *  plain data usable in place from the bytes of the file
+ */
+struct config_image
+{
+    image_header header;
+
+    uint32_t settings_mask;                     ///< one bit per @c config_parser::setting present
+    uint32_t settings[SETTINGS_COUNT];
+
+    uint8_t pad_colors[PADS_COUNT];             ///< @c hw::leds_driver::pad_color, or UNSET
+    uint8_t ring_values[ENCODERS_COUNT];        ///< led-ring values, or UNSET
+
+    uint8_t modes_mask;                         ///< one bit per configured mapping mode
+    uint16_t bindings_count[MODES_COUNT];
+    midi::midi_mapping::binding bindings[MODES_COUNT][BINDINGS_MAX_COUNT];
+
+    /** Resets to an image without any configured value */
+    void clear();
+
+    bool has(config_parser::setting s) const
+        { return settings_mask & (1 << static_cast<uint8_t>(s)); }
+    uint32_t get(config_parser::setting s) const
+        { return settings[static_cast<uint8_t>(s)]; }
+
+    bool has(midi::midi_mapping::mode m) const
+        { return modes_mask & (1 << static_cast<uint8_t>(m)); }
+};
+
+static_assert(sizeof(midi::midi_mapping::binding) == 5);
+static_assert(sizeof(config_image) < UINT16_MAX);
+
+/** Hash of an image, computed as if its checksum was zero */
+uint32_t checksum_of(const config_image& image);
+
+/**
+ * Checks an image read from storage: size, magic, version and checksum,
+ *  fails with INVALID_ARGUMENT if the image must be compiled again
+ */
+error::status_byte validate(const void* bytes, size_t size);
+
+/**
+ * Uses bytes of a stored image in place, null if invalid or misaligned
+ */
+const config_image* map(const void* bytes, size_t size);
+
+/** Replaces mappings of configured modes, built-in mappings are kept for the others */
+error::status_byte load_mappings(const config_image& image, midi::midi_mapping::Mappings& mappings);
+
+/**
+ * Parses a configuration text into @c image, hashing it on the way.
+ *  Faulty lines are skipped and counted in the header, status of the first one is returned
+ */
+template <typename Reader>
+error::status_byte compile(Reader& reader, config_image& image);
+
+/**
+ * Where the configuration came from
+ */
+enum class load_source: uint8_t
+{
+    Cache,      ///< stored image matched the text
+    Text,       ///< text was parsed and the image stored again
+};
+
+struct load_report
+{
+    load_source source;
+    size_t text_bytes;      ///< bytes of text read, to hash or to parse
+    uint16_t errors;        ///< faulty lines of the configuration text
+    bool stored;            ///< image was written back
+};
+
+/**
+ * Boot time loader: the stored image is used when its text hash matches the text file,
+ *  otherwise the text is compiled and the image written back. The text is always read to be hashed,
+ *  but only parsed when it changed.
+ *
+ * Storage must provide:
+ *  - size_t read_text(char* buffer, size_t size): next bytes of the text file, zero at its end
+ *  - void rewind_text(): reads the text file from its beginning again
+ *  - size_t read_image(void* buffer, size_t size): reads the stored image, returns its size, zero if missing
+ *  - bool write_image(const void* buffer, size_t size): replaces the stored image
+ */
+template <typename Storage>
+error::status_byte load(Storage& storage, config_image& image, load_report* report=nullptr);
+
+} /* endof namespace config_cache */
+} /* endof namespace config */
+
+#include "config_cache.hpp"
+
+#endif /* DEF_CONFIG_CACHE_HXX */
@@ -0,0 +1,314 @@
+/**
+ * 
+ */
+
+#include "config_parser.hxx"
+
+#include <cstring>
+
+namespace config
+{
+namespace config_parser
+{
+
+using midi::midi_mapping::control;
+using midi::midi_mapping::control_kind;
+
+const setting_schema SETTINGS_SCHEMA[SETTINGS_COUNT] = {
+    { "refresh_rate",           1,          1000        },
+    { "i2c_frequency",          100000,     1000000     },
+    { "sweep_rate",             100,        40000       },
+    { "note_off_as_note_on",    0,          1           },
+    { "status_refresh_period",  0,          10000000    },
+};
+
+namespace
+{
+
+bool same(const char* name, const char* text, size_t size)
+    { return name != nullptr && std::strncmp(name, text, size) == 0 && name[size] == '\0'; }
+
+bool reject(entry& out, const line_tokens& line, uint8_t token, const char* message)
+    {
+        out.kind = entry_kind::Error;
+        /* missing tokens are reported past the end of the line */
+        const line_tokens::token& last = line.tokens[line.count -1];
+        out.at = location{line.line, token < line.count
+            ? line.tokens[token].column : static_cast<uint16_t>(last.column + last.size)};
+        out.message = message;
+        out.status = error::errcode::INVALID_ARGUMENT | error::severity::ERROR;
+        return true;
+    }
+
+/** Parses a number token no greater than @c max */
+bool number(const line_tokens::token& t, unsigned long max, unsigned long& value)
+    {
+        if (t.type != line_tokens::Number)
+            { return false; }
+        value = 0;
+        for (uint8_t i=0; i<t.size; ++i)
+            {
+                value = value * 10 + (t.text[i] - '0');
+                if (value > max)
+                    { return false; }
+            }
+        return true;
+    }
+
+bool is_word(const line_tokens& line, uint8_t index, const char* word)
+    { return index < line.count && line.tokens[index].is(word); }
+
+bool interpret_section(const line_tokens& line, parse_scope& scope, entry& out)
+    {
+        if (line.count < 2 || line.tokens[1].type != line_tokens::Word)
+            { return reject(out, line, 1, "expected a section name"); }
+
+        uint8_t closing = 2;
+        if (is_word(line, 1, "settings"))
+            { scope.current = section::Settings; }
+        else if (is_word(line, 1, "state"))
+            { scope.current = section::State; }
+        else if (is_word(line, 1, "mapping"))
+            {
+                if (is_word(line, 2, "apc40"))
+                    { scope.mode = midi::midi_mapping::mode::Apc40; }
+                else if (is_word(line, 2, "extended"))
+                    { scope.mode = midi::midi_mapping::mode::Extended; }
+                else
+                    { return reject(out, line, 2, "expected apc40 or extended mapping"); }
+                scope.current = section::Mapping;
+                closing = 3;
+            }
+        else
+            { return reject(out, line, 1, "unknown section"); }
+
+        if (closing >= line.count || line.tokens[closing].type != line_tokens::Close)
+            {
+                scope.current = section::None;
+                return reject(out, line, closing, "expected ']'");
+            }
+        if (closing + 1 < line.count)
+            {
+                scope.current = section::None;
+                return reject(out, line, closing + 1, "unexpected value after section");
+            }
+
+        out.kind = entry_kind::Section;
+        out.in = scope.current;
+        out.mode = scope.mode;
+        return true;
+    }
+
+bool interpret_setting(const line_tokens& line, entry& out)
+    {
+        const line_tokens::token& key = line.tokens[0];
+        uint8_t index = 0;
+        while (index < SETTINGS_COUNT && !key.is(SETTINGS_SCHEMA[index].name))
+            { ++index; }
+        if (index == SETTINGS_COUNT)
+            { return reject(out, line, 0, "unknown setting"); }
+        if (line.count < 3)
+            { return reject(out, line, 2, "expected a value"); }
+
+        unsigned long value;
+        const setting_schema& schema = SETTINGS_SCHEMA[index];
+        if (!number(line.tokens[2], schema.max, value) || value < schema.min)
+            { return reject(out, line, 2, "value out of range"); }
+        if (line.count > 3)
+            { return reject(out, line, 3, "unexpected value"); }
+
+        out.kind = entry_kind::Setting;
+        out.option = entry::setting_value{static_cast<setting>(index), value};
+        return true;
+    }
+
+bool interpret_state(const line_tokens& line, entry& out)
+    {
+        const line_tokens::token& key = line.tokens[0];
+        const control target = find_control(key.text, key.size);
+        if (target.is_none())
+            { return reject(out, line, 0, "unknown device element"); }
+        if (line.count < 3)
+            { return reject(out, line, 2, "expected a value"); }
+        if (line.count > 3)
+            { return reject(out, line, 3, "unexpected value"); }
+
+        using hw::leds_driver::pad_color;
+        const line_tokens::token& value = line.tokens[2];
+        switch (target.kind)
+            {
+            case control_kind::Pad:
+                {
+                    const hw::pads::Pad pad = static_cast<hw::pads::Pad>(target.index);
+                    if (hw::is_blind(pad))
+                        { return reject(out, line, 0, "pad has no led"); }
+
+                    pad_color color;
+                    if (value.is("off"))
+                        { color = pad_color::OFF; }
+                    else if (value.is("on") || value.is("green"))
+                        { color = pad_color::GREEN; }
+                    else if (value.is("red"))
+                        { color = pad_color::RED; }
+                    else if (value.is("orange"))
+                        { color = pad_color::ORANGE; }
+                    else
+                        { return reject(out, line, 2, "expected off, on, green, red or orange"); }
+                    if (hw::pads::is_monochrome(pad) && color != pad_color::OFF && color != pad_color::ON)
+                        { return reject(out, line, 2, "pad has a single led"); }
+
+                    out.kind = entry_kind::PadState;
+                    out.pad = entry::pad_state{pad, color};
+                    return true;
+                }
+
+            case control_kind::Encoder:
+                {
+                    const hw::analog::Encoder encoder = static_cast<hw::analog::Encoder>(target.index);
+                    if (hw::is_blind(encoder))
+                        { return reject(out, line, 0, "encoder has no led-ring"); }
+                    unsigned long v;
+                    if (!number(value, midi::DATA_BITMASK, v))
+                        { return reject(out, line, 2, "value out of range"); }
+
+                    out.kind = entry_kind::EncoderState;
+                    out.encoder = entry::encoder_state{encoder, static_cast<uint8_t>(v)};
+                    return true;
+                }
+
+            default:
+                return reject(out, line, 0, "expected a pad or an encoder");
+            }
+    }
+
+bool interpret_binding(const line_tokens& line, entry& out)
+    {
+        /* optional style keyword, then element, '=', message type, channel, number and direction */
+        const uint8_t first = is_word(line, 0, "style") && line.count > 1 ? 1 : 0;
+        const line_tokens::token& key = line.tokens[first];
+        control target = find_control(key.text, key.size);
+        if (target.is_none())
+            { return reject(out, line, first, "unknown device element"); }
+        if (first == 1)
+            {
+                if (target.kind != control_kind::Encoder || hw::is_blind(static_cast<hw::analog::Encoder>(target.index)))
+                    { return reject(out, line, first, "style applies to encoders with a led-ring"); }
+                target.kind = control_kind::RingStyle;
+            }
+        if (first + 1 >= line.count || line.tokens[first + 1].type != line_tokens::Equal)
+            { return reject(out, line, first + 1, "expected '='"); }
+
+        const uint8_t type = first + 2;
+        midi::status family;
+        if (is_word(line, type, "note"))
+            {
+                if (target.kind != control_kind::Pad)
+                    { return reject(out, line, type, "only pads send notes"); }
+                family = midi::status::NoteOn;
+            }
+        else if (is_word(line, type, "cc"))
+            { family = midi::status::ControlChange; }
+        else
+            { return reject(out, line, type, "expected note or cc"); }
+
+        unsigned long channel, data;
+        if (type + 1 >= line.count || !number(line.tokens[type + 1], midi::CHANNEL_BITMASK, channel))
+            { return reject(out, line, type + 1, "expected a channel from 0 to 15"); }
+        if (type + 2 >= line.count || !number(line.tokens[type + 2], midi::DATA_BITMASK, data))
+            { return reject(out, line, type + 2, "expected a number from 0 to 127"); }
+
+        uint8_t flags = midi::midi_mapping::Both;
+        const uint8_t direction = type + 3;
+        if (direction < line.count)
+            {
+                if (is_word(line, direction, "in"))
+                    { flags = midi::midi_mapping::Incoming; }
+                else if (is_word(line, direction, "out"))
+                    { flags = midi::midi_mapping::Outgoing; }
+                else if (!is_word(line, direction, "both"))
+                    { return reject(out, line, direction, "expected in, out or both"); }
+                if (direction + 1 < line.count)
+                    { return reject(out, line, direction + 1, "unexpected value"); }
+            }
+
+        out.kind = entry_kind::Binding;
+        out.binding = midi::midi_mapping::binding{target,
+            midi::make_status(family, static_cast<uint8_t>(channel)), static_cast<uint8_t>(data), flags};
+        return true;
+    }
+
+} /* endof namespace */
+
+bool
+line_tokens::token::is(const char* word) const
+    {
+        return same(word, text, size);
+    }
+
+midi::midi_mapping::control
+find_control(const char* name, size_t size)
+    {
+        hw::pads::Pad pad;
+        if (reflect::from_name(name, size, pad))
+            { return control{control_kind::Pad, static_cast<uint8_t>(pad)}; }
+        hw::analog::Encoder encoder;
+        if (reflect::from_name(name, size, encoder))
+            { return control{control_kind::Encoder, static_cast<uint8_t>(encoder)}; }
+        hw::analog::Fader fader;
+        if (reflect::from_name(name, size, fader))
+            { return control{control_kind::Fader, static_cast<uint8_t>(fader)}; }
+        return control{control_kind::None, 0};
+    }
+
+const char*
+name_of(const midi::midi_mapping::control& c)
+    {
+        switch (c.kind)
+            {
+            case control_kind::Pad:         return reflect::name_of(static_cast<hw::pads::Pad>(c.index));
+            case control_kind::Encoder:
+            case control_kind::RingStyle:   return reflect::name_of(static_cast<hw::analog::Encoder>(c.index));
+            case control_kind::Fader:       return reflect::name_of(static_cast<hw::analog::Fader>(c.index));
+            default:                        return nullptr;
+            }
+    }
+
+bool
+interpret(const line_tokens& line, parse_scope& scope, entry& out)
+    {
+        if (line.count == 0)
+            { return false; }
+
+        out.at = location{line.line, line.tokens[0].column};
+        out.status = error::status_byte{};
+        /* faulty headers are reported in the section open before them */
+        out.in = scope.current;
+        out.mode = scope.mode;
+        if (line.tokens[0].type == line_tokens::Open)
+            { return interpret_section(line, scope, out); }
+
+        if (line.tokens[0].type != line_tokens::Word)
+            { return reject(out, line, 0, "expected a name"); }
+
+        switch (scope.current)
+            {
+            case section::Settings:
+                if (line.count < 2 || line.tokens[1].type != line_tokens::Equal)
+                    { return reject(out, line, 1, "expected '='"); }
+                return interpret_setting(line, out);
+
+            case section::State:
+                if (line.count < 2 || line.tokens[1].type != line_tokens::Equal)
+                    { return reject(out, line, 1, "expected '='"); }
+                return interpret_state(line, out);
+
+            case section::Mapping:
+                return interpret_binding(line, out);
+
+            default:
+                return reject(out, line, 0, "entry outside of any section");
+            }
+    }
+
+} /* endof namespace config_parser */
+} /* endof namespace config */
@@ -0,0 +1,198 @@
+/**
+ * 
+ */
+
+#include "config_parser.hxx"
+
+namespace config
+{
+namespace config_parser
+{
+
+template <typename R>
+ConfigParser<R>::ConfigParser(Reader& reader)
+    : _reader{reader}
+    {
+        reset();
+    }
+
+template <typename R>
+void
+ConfigParser<R>::reset()
+    {
+        _begin = 0;
+        _end = 0;
+        _eof = false;
+
+        _line.count = 0;
+        _line.line = 1;
+        _line.fault = nullptr;
+        _line.fault_column = 0;
+        _scope = parse_scope{section::None, midi::midi_mapping::mode::Apc40};
+        _column = 0;
+        _in_token = false;
+        _in_comment = false;
+
+        _lines = 0;
+        _errors = 0;
+        _status = error::status_byte{};
+    }
+
+template <typename R>
+bool
+ConfigParser<R>::next(entry& out)
+    {
+        for (;;)
+            {
+                if (_begin == _end)
+                    {
+                        if (!_eof)
+                            {
+                                _begin = 0;
+                                _end = _reader.read(_window, READ_WINDOW_SIZE);
+                                _eof = _end == 0;
+                                continue;
+                            }
+                        /* last line without a trailing newline */
+                        if (_column == 0)
+                            { return false; }
+                        if (end_line(out))
+                            { return true; }
+                        continue;
+                    }
+
+                const char c = _window[_begin++];
+                if (c == '\n')
+                    {
+                        if (end_line(out))
+                            { return true; }
+                        continue;
+                    }
+                feed(c);
+            }
+    }
+
+template <typename R>
+void
+ConfigParser<R>::fault(uint16_t column, const char* message)
+    {
+        if (_line.fault == nullptr)
+            {
+                _line.fault = message;
+                _line.fault_column = column;
+            }
+        _in_token = false;
+    }
+
+template <typename R>
+void
+ConfigParser<R>::close_token()
+    {
+        _in_token = false;
+    }
+
+template <typename R>
+void
+ConfigParser<R>::feed(char c)
+    {
+        if (_column < UINT16_MAX)
+            { _column += 1; }
+        if (_in_comment || _line.fault != nullptr)
+            { return; }
+
+        const bool digit = '0' <= c && c <= '9';
+        const bool letter = ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_';
+
+        if (_in_token)
+            {
+                line_tokens::token& t = _line.tokens[_line.count -1];
+                if (t.type == line_tokens::Word && (digit || letter || c == '.'))
+                    {
+                        if (t.size == TOKEN_MAX_SIZE)
+                            { return fault(t.column, "token too long"); }
+                        t.text[t.size++] = c;
+                        return;
+                    }
+                if (t.type == line_tokens::Number && (digit || letter || c == '.'))
+                    {
+                        if (!digit)
+                            { return fault(t.column, "malformed number"); }
+                        if (t.size == TOKEN_MAX_SIZE)
+                            { return fault(t.column, "token too long"); }
+                        t.text[t.size++] = c;
+                        return;
+                    }
+                close_token();
+            }
+
+        if (c == ' ' || c == '\t' || c == '\r')
+            { return; }
+        if (c == '#')
+            {
+                _in_comment = true;
+                return;
+            }
+
+        line_tokens::kind type;
+        switch (c)
+            {
+            case '[':   type = line_tokens::Open;       break;
+            case ']':   type = line_tokens::Close;      break;
+            case '=':   type = line_tokens::Equal;      break;
+            default:
+                if (digit)
+                    { type = line_tokens::Number; }
+                else if (letter)
+                    { type = line_tokens::Word; }
+                else
+                    { return fault(_column, "unexpected character"); }
+            }
+
+        if (_line.count == LINE_MAX_TOKENS)
+            { return fault(_column, "too many values"); }
+        line_tokens::token& t = _line.tokens[_line.count++];
+        t.type = type;
+        t.column = _column;
+        t.text[0] = c;
+        t.size = 1;
+        _in_token = type == line_tokens::Word || type == line_tokens::Number;
+    }
+
+template <typename R>
+bool
+ConfigParser<R>::end_line(entry& out)
+    {
+        close_token();
+        bool produced;
+        if (_line.fault != nullptr)
+            {
+                out.kind = entry_kind::Error;
+                out.at = location{_line.line, _line.fault_column};
+                out.in = _scope.current;
+                out.mode = _scope.mode;
+                out.message = _line.fault;
+                out.status = error::errcode::INVALID_ARGUMENT | error::severity::ERROR;
+                produced = true;
+            }
+        else
+            { produced = interpret(_line, _scope, out); }
+
+        if (produced && out.kind == entry_kind::Error)
+            {
+                if (_errors == 0)
+                    { _status = out.status; }
+                _errors += 1;
+            }
+
+        _lines += 1;
+        _line.line += 1;
+        _line.count = 0;
+        _line.fault = nullptr;
+        _line.fault_column = 0;
+        _column = 0;
+        _in_comment = false;
+        return produced;
+    }
+
+} /* endof namespace config_parser */
+} /* endof namespace config */
@@ -0,0 +1,270 @@
+/**
+ * 
+ */
+
+#ifndef DEF_CONFIG_PARSER_HXX
+#define DEF_CONFIG_PARSER_HXX
+
+#include "error.hpp"
+#include "../../hw/hw_defines.hxx"
+#include "../../hw/hw_names.hxx"
+#include "../../hw/leds_driver/leds_types.hxx"
+#include "../../midi/midi_mapping/midi_mapping.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace config
+{
+namespace config_parser
+{
+
+/**
+ * Bytes read from the file at once, the only buffer holding raw text
+ */
+static constexpr const size_t READ_WINDOW_SIZE = 128;
+
+/**
+ * Longest word or number, and most tokens on a single line
+ */
+static constexpr const uint8_t TOKEN_MAX_SIZE = 24;
+static constexpr const uint8_t LINE_MAX_TOKENS = 8;
+
+/**
+ * Device configuration format, one entry per line, '#' starts a comment:
+ *
+ *  [settings]
+ *  refresh_rate = 250
+ *
+ *  [mapping apc40]                     # or extended
+ *  CLIP_0_0 = note 0 53                # pads: note or cc, channel, number, optional in, out or both
+ *  PAN_0 = cc 0 48 out
+ *  style PAN_0 = cc 0 56 in            # encoder led-ring display style
+ *
+ *  [state]
+ *  CLIP_0_0 = orange                   # pads: off, on, green, red or orange
+ *  PAN_0 = 64                          # encoders: led-ring value
+ *
+ * Device elements are named as their @c hw::pads::Pad, @c hw::analog::Encoder and @c hw::analog::Fader enumerators
+ */
+enum class section: uint8_t
+{
+    None,           ///< before the first section header
+    Settings,
+    Mapping,
+    State,
+    __SECTIONS_COUNT__
+};
+
+/**
+ * Tunable settings of the firmware modules
+ */
+enum class setting: uint8_t
+{
+    RefreshRate,            ///< leds and pads matrix refresh rate in Hz
+    I2CFrequency,           ///< leds drivers bus frequency in Hz
+    SweepRate,              ///< analog inputs sweeps per second
+    NoteOffAsNoteOn,        ///< sends note offs as zero velocity note ons, 0 or 1
+    StatusRefreshPeriod,    ///< running status refresh period in us, 0 disables it
+    __SETTINGS_COUNT__
+};
+
+static constexpr const uint8_t SETTINGS_COUNT = static_cast<uint8_t>(setting::__SETTINGS_COUNT__);
+
+/**
+ * Name and accepted range of a setting
+ */
+struct setting_schema
+{
+    const char* name;
+    unsigned long min;
+    unsigned long max;
+};
+
+extern const setting_schema SETTINGS_SCHEMA[SETTINGS_COUNT];
+
+/**
+ * Device element named by the @c size first chars of @c name, none if unknown:
+ *  names are the enumerators of pads, encoders and faders, see hw_names.hxx
+ */
+midi::midi_mapping::control find_control(const char* name, size_t size);
+
+/** Name of a device element, null for unused values */
+const char* name_of(const midi::midi_mapping::control& c);
+
+/**
+ * Kind of a parsed entry
+ */
+enum class entry_kind: uint8_t
+{
+    Section,        ///< section header, @c mode is set for mapping sections
+    Setting,
+    Binding,        ///< a mapping line, for the mode of the current section
+    PadState,
+    EncoderState,
+    Error,          ///< a rejected line, @c status and @c message describe the failure
+};
+
+/**
+ * Location in the file, both 1-based
+ */
+struct location
+{
+    uint32_t line;
+    uint16_t column;
+};
+
+/**
+ * A single parsed line, the payload member matches @c kind
+ */
+struct entry
+{
+    entry_kind kind;
+    location at;                    ///< first token of the line, or faulty token on errors
+    section in;                     ///< section the line belongs to
+    midi::midi_mapping::mode mode;  ///< mode of the current mapping section
+
+    struct setting_value
+    {
+        setting key;
+        unsigned long value;
+    };
+
+    struct pad_state
+    {
+        hw::pads::Pad pad;
+        hw::leds_driver::pad_color color;
+    };
+
+    struct encoder_state
+    {
+        hw::analog::Encoder encoder;
+        uint8_t value;
+    };
+
+    union
+    {
+        setting_value option;
+        midi::midi_mapping::binding binding;
+        pad_state pad;
+        encoder_state encoder;
+        const char* message;
+    };
+
+    error::status_byte status;
+};
+
+/**
+ * Tokens of the line being read
+ */
+struct line_tokens
+{
+    enum kind: uint8_t
+    {
+        Word,       ///< letters, digits, '_' and '.', starting with a letter or '_'
+        Number,     ///< decimal digits
+        Open,       ///< '['
+        Close,      ///< ']'
+        Equal,      ///< '='
+    };
+
+    struct token
+    {
+        kind type;
+        uint8_t size;
+        uint16_t column;
+        char text[TOKEN_MAX_SIZE];
+
+        bool is(const char* word) const;
+    };
+
+    token tokens[LINE_MAX_TOKENS];
+    uint8_t count;
+    uint32_t line;
+
+    /** First fault of the line: its column and message, null when the line is well formed */
+    uint16_t fault_column;
+    const char* fault;
+};
+
+/**
+ * Section and mode of the lines being parsed
+ */
+struct parse_scope
+{
+    section current;
+    midi::midi_mapping::mode mode;
+};
+
+/**
+ * Validates a whole line against the schema, updating @c scope on section headers.
+ *  Returns false on empty and comment lines
+ */
+bool interpret(const line_tokens& line, parse_scope& scope, entry& out);
+
+/**
+ * Single pass configuration parser: reads through a fixed window and validates each line when it ends,
+ *  never holding more than a window and a line of tokens. Lines are reported one entry at a time,
+ *  faulty lines as errors, parsing goes on with the next line.
+ *
+ * Reader must provide:
+ *  - size_t read(char* buffer, size_t size): copies up to @c size next bytes of the file,
+ *      returns the count of copied bytes, zero at the end of the file
+ */
+template <typename _Reader>
+class ConfigParser
+{
+public:
+    using Reader = _Reader;
+
+    explicit ConfigParser(Reader& reader);
+
+    /** Restarts at the current position of the reader, as the first line of a file */
+    void reset();
+
+    /** Parses lines until one yields an entry, returns false at the end of the file */
+    bool next(entry& out);
+
+    /** Lines and faulty lines seen so far */
+    uint32_t lines_count() const        { return _lines; }
+    uint32_t errors_count() const       { return _errors; }
+
+    /** Status of the first faulty line, OK if none */
+    error::status_byte status() const   { return _status; }
+
+private:
+    /** Adds a char to the current line */
+    void feed(char c);
+
+    /** Validates the line being read and starts the next one, returns true if it yields an entry */
+    bool end_line(entry& out);
+
+    /** Ends current token */
+    void close_token();
+
+    /** Flags current line as faulty, first fault is kept */
+    void fault(uint16_t column, const char* message);
+
+    Reader& _reader;
+    char _window[READ_WINDOW_SIZE];
+    size_t _begin;
+    size_t _end;
+    bool _eof;
+
+    line_tokens _line;
+    parse_scope _scope;
+    uint16_t _column;           ///< column of the last char read, 0 at the beginning of a line
+    bool _in_token;
+    bool _in_comment;
+
+    uint32_t _lines;
+    uint32_t _errors;
+    error::status_byte _status;
+};
+
+} /* endof namespace config_parser */
+} /* endof namespace config */
+
+#include "config_parser.hpp"
+
+#endif /* DEF_CONFIG_PARSER_HXX */
@@ -0,0 +1,192 @@
+/**
+ * 
+ */
+
+#include "state_store.hxx"
+
+#include <cstdio>
+#include <cstring>
+
+namespace config
+{
+namespace state_store
+{
+
+size_t StoreDefaultSettings::CompactionThreshold = 8192;
+
+uint32_t
+checksum_of(const record_header& header, const uint8_t* payload)
+    {
+        record_header h = header;
+        h.checksum = 0;
+
+        config_cache::fnv1a hash;
+        hash.feed(&h, sizeof(h));
+        hash.feed(payload, header.size);
+        return hash.value;
+    }
+
+uint32_t
+key_of(const char* name)
+    {
+        config_cache::fnv1a hash;
+        hash.feed(name, std::strlen(name));
+        return hash.value;
+    }
+
+size_t
+format_block(char line[SNAPSHOT_LINE_MAX_SIZE], uint8_t block, const uint8_t* bytes, uint8_t size)
+    {
+        static constexpr const char DIGITS[] = "0123456789abcdef";
+        size_t length = 0;
+        if (block >= 10)
+            { line[length++] = DIGITS[block / 10]; }
+        line[length++] = DIGITS[block % 10];
+        line[length++] = ' ';
+        line[length++] = '=';
+        for (uint8_t i=0; i<size; ++i)
+            {
+                line[length++] = ' ';
+                line[length++] = DIGITS[bytes[i] >> 4];
+                line[length++] = DIGITS[bytes[i] & 0x0F];
+            }
+        line[length++] = '\n';
+        return length;
+    }
+
+namespace
+{
+
+int hex_value(char c)
+    {
+        if ('0' <= c && c <= '9')   { return c - '0'; }
+        if ('a' <= c && c <= 'f')   { return c - 'a' + 10; }
+        if ('A' <= c && c <= 'F')   { return c - 'A' + 10; }
+        return -1;
+    }
+
+} /* endof namespace */
+
+bool
+parse_block(const char* line, size_t size, uint8_t& block, uint8_t bytes[BLOCK_SIZE], uint8_t& count)
+    {
+        size_t i = 0;
+        unsigned index = 0;
+        for (; i<size && '0' <= line[i] && line[i] <= '9'; ++i)
+            {
+                index = index * 10 + (line[i] - '0');
+                if (index >= REGION_MAX_BLOCKS)
+                    { return false; }
+            }
+        if (i == 0)
+            { return false; }
+        while (i < size && line[i] == ' ')
+            { ++i; }
+        if (i == size || line[i++] != '=')
+            { return false; }
+
+        count = 0;
+        while (i < size)
+            {
+                if (line[i] == ' ')
+                    { ++i; continue; }
+                if (i + 1 >= size || count == BLOCK_SIZE)
+                    { return false; }
+                const int high = hex_value(line[i]), low = hex_value(line[i + 1]);
+                if (high < 0 || low < 0)
+                    { return false; }
+                bytes[count++] = (high << 4) | low;
+                i += 2;
+            }
+        block = index;
+        return count != 0;
+    }
+
+namespace
+{
+
+using midi::midi_mapping::PADS_COUNT;
+using midi::midi_mapping::ENCODERS_COUNT;
+using hw::leds_driver::pad_color;
+
+const char* color_name(hw::pads::Pad pad, uint8_t color)
+    {
+        switch (static_cast<pad_color>(color & 0b11))
+            {
+            case pad_color::OFF:        return "off";
+            case pad_color::GREEN:      return hw::pads::is_monochrome(pad) ? "on" : "green";
+            case pad_color::RED:        return hw::pads::is_monochrome(pad) ? "on" : "red";
+            default:                    return hw::pads::is_monochrome(pad) ? "on" : "orange";
+            }
+    }
+
+size_t format_leds(const uint8_t* data, uint16_t index, char line[SNAPSHOT_LINE_MAX_SIZE])
+    {
+        if (index < PADS_COUNT)
+            {
+                const hw::pads::Pad pad = static_cast<hw::pads::Pad>(index);
+                const char* name = reflect::name_of(pad);
+                if (name == nullptr || hw::is_blind(pad))
+                    { return 0; }
+                return snprintf(line, SNAPSHOT_LINE_MAX_SIZE, "%s = %s\n", name, color_name(pad, data[index]));
+            }
+
+        const hw::analog::Encoder encoder = static_cast<hw::analog::Encoder>(index - PADS_COUNT);
+        const char* name = reflect::name_of(encoder);
+        if (name == nullptr || hw::is_blind(encoder))
+            { return 0; }
+        return snprintf(line, SNAPSHOT_LINE_MAX_SIZE, "%s = %u\n", name, data[index]);
+    }
+
+/**
+ * Reads a snapshot line as the single entry of a [state] section of the configuration
+ */
+struct state_line_reader
+{
+    char text[sizeof("[state]\n") + SNAPSHOT_LINE_MAX_SIZE];
+    size_t size;
+    size_t offset;
+
+    size_t read(char* buffer, size_t count)
+        {
+            if (count > size - offset)
+                { count = size - offset; }
+            std::memcpy(buffer, text + offset, count);
+            offset += count;
+            return count;
+        }
+};
+
+bool parse_leds(uint8_t* data, const char* line, size_t size)
+    {
+        static constexpr const char HEADER[] = "[state]\n";
+        state_line_reader reader;
+        if (size >= SNAPSHOT_LINE_MAX_SIZE)
+            { return false; }
+        std::memcpy(reader.text, HEADER, sizeof(HEADER) -1);
+        std::memcpy(reader.text + sizeof(HEADER) -1, line, size);
+        reader.size = sizeof(HEADER) -1 + size;
+        reader.offset = 0;
+
+        config_parser::ConfigParser<state_line_reader> parser(reader);
+        config_parser::entry e;
+        while (parser.next(e))
+            {
+                if (e.kind == config_parser::entry_kind::PadState)
+                    { data[static_cast<uint8_t>(e.pad.pad)] = static_cast<uint8_t>(e.pad.color); }
+                else if (e.kind == config_parser::entry_kind::EncoderState)
+                    { data[PADS_COUNT + static_cast<uint8_t>(e.encoder.encoder)] = e.encoder.value; }
+                else if (e.kind != config_parser::entry_kind::Section)
+                    { return false; }
+            }
+        return parser.errors_count() == 0;
+    }
+
+} /* endof namespace */
+
+const region_text LEDS_STATE_TEXT = {
+    PADS_COUNT + ENCODERS_COUNT, PADS_COUNT + ENCODERS_COUNT, &format_leds, &parse_leds
+};
+
+} /* endof namespace state_store */
+} /* endof namespace config */
@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "state_store.hxx"
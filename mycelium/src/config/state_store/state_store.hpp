@@ -0,0 +1,385 @@
+/**
+ * 
+ */
+
+#include "state_store.hxx"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace config
+{
+namespace state_store
+{
+
+template <typename St, typename S>
+StateStore<St, S>::StateStore(Storage& storage)
+    : _storage{storage}, _regions{}, _regions_count{0},
+      _sequence{0}, _journal_size{0}, _must_compact{false}, _counters{}
+    {}
+
+template <typename St, typename S>
+    error::status_byte
+StateStore<St, S>::add(const char* name, void* data, uint16_t size, uint8_t* index, const region_text* text)
+    {
+        const size_t length = std::strlen(name);
+        if (length == 0 || REGION_NAME_MAX_SIZE <= length || size == 0 || REGION_MAX_SIZE < size)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+        if (text && text->size != size)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+        for (size_t i=0; i<length; ++i)
+            {
+                const char c = name[i];
+                if (!(('a' <= c && c <= 'z') || ('0' <= c && c <= '9') || c == '_'))
+                    { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+            }
+        const uint32_t key = key_of(name);
+        for (uint8_t r=0; r<_regions_count; ++r)
+            {
+                if (_regions[r].key == key)
+                    { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+            }
+        if (_regions_count == REGIONS_MAX)
+            { return error::errcode::MEMORY_ERROR | error::severity::ERROR; }
+
+        region& r = _regions[_regions_count];
+        std::memcpy(r.name, name, length + 1);
+        r.data = static_cast<uint8_t*>(data);
+        r.size = size;
+        r.dirty = 0;
+        r.key = key;
+        r.text = text;
+        if (index)
+            { *index = _regions_count; }
+        _regions_count += 1;
+        return error::status_byte{};
+    }
+
+template <typename St, typename S>
+void
+StateStore<St, S>::touch(uint8_t index, uint16_t offset, uint16_t size)
+    {
+        if (_regions_count <= index || size == 0)
+            { return; }
+        region& r = _regions[index];
+        if (r.size <= offset)
+            { return; }
+        const uint16_t last = (offset + size < r.size ? offset + size : r.size) -1;
+        for (uint8_t b=offset / BLOCK_SIZE; b<=last / BLOCK_SIZE; ++b)
+            { r.dirty |= static_cast<uint64_t>(1) << b; }
+    }
+
+template <typename St, typename S>
+bool
+StateStore<St, S>::is_dirty() const
+    {
+        for (uint8_t r=0; r<_regions_count; ++r)
+            {
+                if (_regions[r].dirty)
+                    { return true; }
+            }
+        return false;
+    }
+
+template <typename St, typename S>
+bool
+StateStore<St, S>::append(record_header header, const uint8_t* payload)
+    {
+        uint8_t bytes[sizeof(record_header) + BLOCK_SIZE];
+        header.checksum = checksum_of(header, payload);
+        std::memcpy(bytes, &header, sizeof(header));
+        std::memcpy(bytes + sizeof(header), payload, header.size);
+
+        const size_t size = sizeof(header) + header.size;
+        if (!_storage.append(file::Journal, bytes, size))
+            { return false; }
+        _journal_size += size;
+        _counters.bytes_written += size;
+        return true;
+    }
+
+template <typename St, typename S>
+    error::status_byte
+StateStore<St, S>::save()
+    {
+        if (_must_compact)
+            { return compact(); }
+        if (!is_dirty())
+            { return error::status_byte{}; }
+
+        const size_t begin = _journal_size;
+        const uint32_t sequence = _sequence + 1;
+        unsigned long blocks = 0;
+        bool written = true;
+        for (uint8_t i=0; i<_regions_count && written; ++i)
+            {
+                const region& r = _regions[i];
+                for (uint8_t b=0; b<r.blocks_count() && written; ++b)
+                    {
+                        if (!(r.dirty & (static_cast<uint64_t>(1) << b)))
+                            { continue; }
+                        written = append(record_header{Block, b, r.block_size(b), 0, r.key, sequence, 0}, r.data + b * BLOCK_SIZE);
+                        blocks += 1;
+                    }
+            }
+        written = written && append(record_header{Commit, 0, 0, 0, 0, sequence, 0}, nullptr);
+
+        if (!written)
+            {
+                /* an uncommitted save would hide the next ones on load */
+                if (_storage.truncate(file::Journal, begin))
+                    { _journal_size = begin; }
+                else
+                    { _must_compact = true; }
+                return error::errcode::HWERROR | error::severity::ERROR;
+            }
+
+        for (uint8_t i=0; i<_regions_count; ++i)
+            { _regions[i].dirty = 0; }
+        _sequence = sequence;
+        _counters.saves += 1;
+        _counters.blocks += blocks;
+
+        if (_journal_size > Settings::CompactionThreshold)
+            { return compact(); }
+        return error::status_byte{};
+    }
+
+template <typename St, typename S>
+bool
+StateStore<St, S>::write_text(config_cache::fnv1a& hash, const char* text, size_t size)
+    {
+        hash.feed(text, size);
+        _counters.bytes_written += size;
+        return _storage.append(file::SnapshotTemp, text, size);
+    }
+
+template <typename St, typename S>
+    error::status_byte
+StateStore<St, S>::compact()
+    {
+        const uint32_t sequence = _sequence + 1;
+        config_cache::fnv1a hash;
+        char line[SNAPSHOT_LINE_MAX_SIZE];
+
+        bool written = _storage.truncate(file::SnapshotTemp, 0);
+        static constexpr const char HEADER[] = "# mycelium device state\n";
+        written = written && write_text(hash, HEADER, sizeof(HEADER) -1);
+        written = written && write_text(hash, line, snprintf(line, sizeof(line), "sequence = %lu\n",
+            static_cast<unsigned long>(sequence)));
+        for (uint8_t i=0; i<_regions_count && written; ++i)
+            {
+                const region& r = _regions[i];
+                written = write_text(hash, line, snprintf(line, sizeof(line), "[%s]\n", r.name));
+                for (uint16_t e=0; r.text && e<r.text->entries && written; ++e)
+                    {
+                        const size_t size = r.text->format(r.data, e, line);
+                        written = size == 0 || write_text(hash, line, size);
+                    }
+                for (uint8_t b=0; !r.text && b<r.blocks_count() && written; ++b)
+                    { written = write_text(hash, line, format_block(line, b, r.data + b * BLOCK_SIZE, r.block_size(b))); }
+            }
+        if (written)
+            {
+                const int size = snprintf(line, sizeof(line), "checksum = %08lx\n", static_cast<unsigned long>(hash.value));
+                _counters.bytes_written += size;
+                written = _storage.append(file::SnapshotTemp, line, size);
+            }
+        if (!written || !_storage.replace(file::SnapshotTemp, file::Snapshot))
+            { return error::errcode::HWERROR | error::severity::ERROR; }
+
+        /* the snapshot holds every edit: journal records are older than its sequence from now on */
+        for (uint8_t i=0; i<_regions_count; ++i)
+            { _regions[i].dirty = 0; }
+        _sequence = sequence;
+        _counters.compactions += 1;
+        if (!_storage.truncate(file::Journal, 0))
+            {
+                _must_compact = true;
+                return error::errcode::HWERROR | error::severity::WARNING;
+            }
+        _journal_size = 0;
+        _must_compact = false;
+        return error::status_byte{};
+    }
+
+template <typename St, typename S>
+void
+StateStore<St, S>::parse_line(const char* line, size_t size, uint32_t& sequence, int& current)
+    {
+        static constexpr const char SEQUENCE[] = "sequence = ";
+        if (size == 0 || line[0] == '#')
+            { return; }
+        if (size > sizeof(SEQUENCE) -1 && std::strncmp(line, SEQUENCE, sizeof(SEQUENCE) -1) == 0)
+            {
+                sequence = std::strtoul(line + sizeof(SEQUENCE) -1, nullptr, 10);
+                return;
+            }
+        if (line[0] == '[' && line[size -1] == ']')
+            {
+                current = -1;
+                for (uint8_t i=0; i<_regions_count; ++i)
+                    {
+                        if (std::strlen(_regions[i].name) == size - 2 && std::strncmp(_regions[i].name, line + 1, size - 2) == 0)
+                            { current = i; }
+                    }
+                return;
+            }
+
+        if (current < 0)
+            { return; }
+        region& r = _regions[current];
+        /* blocks are still read for regions with a text form, as written before it was given */
+        if (r.text && !('0' <= line[0] && line[0] <= '9'))
+            {
+                r.text->parse(r.data, line, size);
+                return;
+            }
+
+        uint8_t block, count;
+        uint8_t bytes[BLOCK_SIZE];
+        if (!parse_block(line, size, block, bytes, count))
+            { return; }
+        /* regions resized since the snapshot only get their matching blocks */
+        if (block < r.blocks_count() && count == r.block_size(block))
+            { std::memcpy(r.data + block * BLOCK_SIZE, bytes, count); }
+    }
+
+template <typename St, typename S>
+bool
+StateStore<St, S>::read_snapshot(bool apply, uint32_t& sequence)
+    {
+        static constexpr const char CHECKSUM[] = "checksum = ";
+        config_cache::fnv1a hash;
+        char window[64];
+        char line[SNAPSHOT_LINE_MAX_SIZE];
+        size_t length = 0;
+        int current = -1;
+
+        const size_t total = _storage.size(file::Snapshot);
+        for (size_t offset=0; offset<total; )
+            {
+                const size_t count = _storage.read(file::Snapshot, offset, window, sizeof(window));
+                if (count == 0)
+                    { return false; }
+                offset += count;
+                for (size_t i=0; i<count; ++i)
+                    {
+                        if (window[i] != '\n')
+                            {
+                                if (length == sizeof(line) -1)
+                                    { return false; }
+                                line[length++] = window[i];
+                                continue;
+                            }
+                        line[length] = '\0';
+                        if (length > sizeof(CHECKSUM) -1 && std::strncmp(line, CHECKSUM, sizeof(CHECKSUM) -1) == 0)
+                            { return std::strtoul(line + sizeof(CHECKSUM) -1, nullptr, 16) == hash.value; }
+                        hash.feed(line, length);
+                        hash.feed("\n", 1);
+                        if (apply)
+                            { parse_line(line, length, sequence, current); }
+                        length = 0;
+                    }
+            }
+        /* missing checksum line */
+        return false;
+    }
+
+template <typename St, typename S>
+void
+StateStore<St, S>::replay(uint32_t snapshot_sequence)
+    {
+        const size_t total = _storage.size(file::Journal);
+        record_header header;
+        uint8_t payload[BLOCK_SIZE];
+
+        auto read_record = [&](size_t offset) -> bool {
+                if (offset + sizeof(header) > total
+                    || _storage.read(file::Journal, offset, &header, sizeof(header)) != sizeof(header)
+                    || (header.type != Block && header.type != Commit)
+                    || header.size > BLOCK_SIZE
+                    || offset + sizeof(header) + header.size > total
+                    || _storage.read(file::Journal, offset + sizeof(header), payload, header.size) != header.size)
+                    { return false; }
+                return header.checksum == checksum_of(header, payload);
+            };
+
+        /* first pass: end of the last complete save */
+        size_t committed = 0;
+        bool open = false;
+        uint32_t open_sequence = 0;
+        for (size_t offset=0; read_record(offset); offset += sizeof(header) + header.size)
+            {
+                if (open && header.sequence != open_sequence)
+                    { break; }
+                if (header.type == Commit)
+                    {
+                        if (!open)
+                            { break; }
+                        committed = offset + sizeof(header);
+                        open = false;
+                        continue;
+                    }
+                open = true;
+                open_sequence = header.sequence;
+            }
+
+        /* second pass: applies saves newer than the snapshot */
+        for (size_t offset=0; offset<committed && read_record(offset); offset += sizeof(header) + header.size)
+            {
+                if (header.sequence <= snapshot_sequence)
+                    { continue; }
+                if (header.type == Commit)
+                    {
+                        _counters.replayed += 1;
+                        _sequence = header.sequence > _sequence ? header.sequence : _sequence;
+                        continue;
+                    }
+                for (uint8_t i=0; i<_regions_count; ++i)
+                    {
+                        region& r = _regions[i];
+                        if (r.key == header.region && header.block < r.blocks_count() && header.size == r.block_size(header.block))
+                            { std::memcpy(r.data + header.block * BLOCK_SIZE, payload, header.size); }
+                    }
+            }
+
+        _journal_size = total;
+        if (committed < total)
+            {
+                _counters.discarded += total - committed;
+                if (_storage.truncate(file::Journal, committed))
+                    { _journal_size = committed; }
+                else
+                    { _must_compact = true; }
+            }
+    }
+
+template <typename St, typename S>
+    error::status_byte
+StateStore<St, S>::load()
+    {
+        error::status_byte status;
+        uint32_t sequence = 0;
+        if (_storage.size(file::Snapshot) > 0)
+            {
+                if (read_snapshot(false, sequence))
+                    { read_snapshot(true, sequence); }
+                else
+                    {
+                        sequence = 0;
+                        status = error::errcode::INVALID_ARGUMENT | error::severity::WARNING;
+                    }
+            }
+
+        _sequence = sequence;
+        _must_compact = false;
+        replay(sequence);
+        for (uint8_t i=0; i<_regions_count; ++i)
+            { _regions[i].dirty = 0; }
+        return status;
+    }
+
+} /* endof namespace state_store */
+} /* endof namespace config */
@@ -0,0 +1,247 @@
+/**
+ * 
+ */
+
+#ifndef DEF_STATE_STORE_HXX
+#define DEF_STATE_STORE_HXX
+
+#include "error.hpp"
+#include "../config_cache/config_cache.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace config
+{
+namespace state_store
+{
+
+/**
+ * Unit of change tracking: edited regions are saved by blocks
+ */
+static constexpr const uint8_t BLOCK_SIZE = 32;
+static constexpr const uint8_t REGION_MAX_BLOCKS = 64;
+static constexpr const uint16_t REGION_MAX_SIZE = BLOCK_SIZE * REGION_MAX_BLOCKS;
+
+static constexpr const uint8_t REGIONS_MAX = 8;
+static constexpr const uint8_t REGION_NAME_MAX_SIZE = 16;
+
+/**
+ * Longest snapshot line: a block as hexadecimal bytes, or an entry of a region text form
+ */
+static constexpr const uint8_t SNAPSHOT_LINE_MAX_SIZE = 128;
+
+/**
+ * Files of the store:
+ *  - Snapshot: whole state as text, one line per entry or per block of each region
+ *  - SnapshotTemp: next snapshot being written, replaces the snapshot once complete
+ *  - Journal: binary records of blocks saved since the snapshot
+ */
+enum class file: uint8_t
+{
+    Snapshot,
+    SnapshotTemp,
+    Journal,
+};
+
+/**
+ * Journal records: blocks of a save followed by its commit,
+ *  a save is applied on load only once its commit is read
+ */
+enum record_type: uint8_t
+{
+    Block   = 0xB5,
+    Commit  = 0xC5,
+};
+
+struct record_header
+{
+    uint8_t type;
+    uint8_t block;
+    uint8_t size;           ///< payload bytes following the header
+    uint8_t reserved;
+    uint32_t region;        ///< key of the region, see @c key_of
+    uint32_t sequence;      ///< save the record belongs to
+    uint32_t checksum;      ///< hash of the header, with a zero checksum, and of the payload
+};
+
+static_assert(sizeof(record_header) == 16);
+
+/** Hash of a record, computed as if its checksum was zero */
+uint32_t checksum_of(const record_header& header, const uint8_t* payload);
+
+/**
+ * Key of a region in journal records: hash of its name,
+ *  so that records still reach their region once regions are registered in another order
+ */
+uint32_t key_of(const char* name);
+
+/**
+ * Writes a block as a snapshot line, "index = hexadecimal bytes\n", returns its size
+ */
+size_t format_block(char line[SNAPSHOT_LINE_MAX_SIZE], uint8_t block, const uint8_t* bytes, uint8_t size);
+
+/**
+ * Reads a block line, returns false if malformed
+ */
+bool parse_block(const char* line, size_t size, uint8_t& block, uint8_t bytes[BLOCK_SIZE], uint8_t& count);
+
+/**
+ * Text form of a region in snapshots, regions without one are written as hexadecimal blocks:
+ *  - format writes the line of entry @c index, "NAME = value\n", returns its size,
+ *      zero if the entry has no line
+ *  - parse applies a line to the region, returns false if malformed.
+ *      Lines are never numbers first: those are read as blocks
+ */
+struct region_text
+{
+    uint16_t size;          ///< size of the regions it applies to
+    uint16_t entries;
+    size_t (*format)(const uint8_t* data, uint16_t index, char line[SNAPSHOT_LINE_MAX_SIZE]);
+    bool (*parse)(uint8_t* data, const char* line, size_t size);
+};
+
+/**
+ * Leds state in the [state] syntax of the configuration, "CLIP_0_0 = orange" and "PAN_0 = 64":
+ *  a @c hw::leds_driver::pad_color per pad followed by a led-ring value per encoder.
+ *  Pads and encoders without led are not written
+ */
+extern const region_text LEDS_STATE_TEXT;
+
+struct StoreDefaultSettings
+{
+    /**
+     * Journal size in bytes above which a save compacts the journal into a new snapshot
+     *  @note defaults to 8KB
+     */
+    static size_t CompactionThreshold;
+};
+
+struct store_counters
+{
+    unsigned long saves;            ///< saves with at least one dirty block
+    unsigned long blocks;           ///< blocks appended to the journal
+    unsigned long bytes_written;    ///< journal and snapshot bytes
+    unsigned long compactions;
+    unsigned long replayed;         ///< journal saves applied on load
+    unsigned long discarded;        ///< journal bytes dropped on load: torn or uncommitted saves
+};
+
+/**
+ * Device state persistence: registered regions of memory are saved incrementally.
+ *  Edits mark blocks dirty, a save appends dirty blocks to the journal and commits them,
+ *  when the journal grows too large the whole state is written as a readable snapshot and the journal emptied.
+ *
+ * Crash consistency:
+ *  - a save is applied on load only if its commit record was written entirely, torn tails are truncated
+ *  - snapshots are written aside and replace the previous one at once
+ *  - snapshots carry the sequence of the last save they include, older journal records are skipped
+ *
+ * Snapshot format, checksum covers every previous byte:
+ *
+ *  # mycelium device state
+ *  sequence = 42
+ *  [leds]
+ *  CLIP_0_0 = orange               # regions with a text form: an entry per line
+ *  PAN_0 = 64
+ *  [patterns]
+ *  0 = 00 01 02 ...                # other regions: block index = its bytes
+ *  checksum = 1a2b3c4d
+ *
+ * Storage must provide:
+ *  - size_t size(file): current size, zero if missing
+ *  - size_t read(file, size_t offset, void* buffer, size_t size): returns the count of bytes read
+ *  - bool append(file, const void* bytes, size_t size)
+ *  - bool truncate(file, size_t size): shrinks or creates a file
+ *  - bool replace(file from, file to): atomically renames @c from as @c to
+ */
+template <typename _Storage, typename _Settings=StoreDefaultSettings>
+class StateStore
+{
+public:
+    using Storage = _Storage;
+    using Settings = _Settings;
+
+    explicit StateStore(Storage& storage);
+
+    /**
+     * Registers a region of state, its content is the default state until loaded,
+     *  written in snapshots with @c text when given, returns the region index
+     *  or fails with INVALID_ARGUMENT / MEMORY_ERROR.
+     *  Regions are found by name on load, whatever their registration order
+     */
+    error::status_byte add(const char* name, void* data, uint16_t size, uint8_t* index=nullptr,
+        const region_text* text=nullptr);
+
+    /**
+     * Restores registered regions from the snapshot and the journal,
+     *  regions missing from the files keep their content.
+     *  Fails with INVALID_ARGUMENT if the snapshot is corrupted, the journal is still replayed
+     */
+    error::status_byte load();
+
+    /** Marks a range of a region as edited */
+    void touch(uint8_t region, uint16_t offset, uint16_t size);
+    void touch(uint8_t region)                  { touch(region, 0, _regions[region].size); }
+
+    /**
+     * Appends dirty blocks to the journal as a single save, compacting the journal when too large.
+     *  On failure edited blocks stay dirty and the save is retried by the next call
+     */
+    error::status_byte save();
+
+    /** Writes the whole state as a new snapshot and empties the journal */
+    error::status_byte compact();
+
+    bool is_dirty() const;
+    size_t journal_size() const                 { return _journal_size; }
+    uint32_t sequence() const                   { return _sequence; }
+    const store_counters& counters() const      { return _counters; }
+
+private:
+    struct region
+    {
+        char name[REGION_NAME_MAX_SIZE];
+        uint8_t* data;
+        uint16_t size;
+        uint64_t dirty;     ///< one bit per block
+        uint32_t key;       ///< see @c key_of
+        const region_text* text;
+
+        uint8_t blocks_count() const            { return (size + BLOCK_SIZE -1) / BLOCK_SIZE; }
+        uint8_t block_size(uint8_t block) const
+            { return block + 1 < blocks_count() ? BLOCK_SIZE : size - block * BLOCK_SIZE; }
+    };
+
+    /** Appends a record, with its checksum */
+    bool append(record_header header, const uint8_t* payload);
+
+    /** Replays committed saves newer than the snapshot, truncates anything after the last commit */
+    void replay(uint32_t snapshot_sequence);
+
+    /** Reads the snapshot, applying it if @c apply, returns false if corrupted */
+    bool read_snapshot(bool apply, uint32_t& sequence);
+
+    /** Writes formatted text to the temporary snapshot, hashing it */
+    bool write_text(config_cache::fnv1a& hash, const char* text, size_t size);
+
+    /** Applies a snapshot line to regions */
+    void parse_line(const char* line, size_t size, uint32_t& sequence, int& current);
+
+    Storage& _storage;
+    region _regions[REGIONS_MAX];
+    uint8_t _regions_count;
+
+    uint32_t _sequence;
+    size_t _journal_size;
+    bool _must_compact;     ///< journal tail could not be cleaned after a failed save
+
+    store_counters _counters;
+};
+
+} /* endof namespace state_store */
+} /* endof namespace config */
+
+#include "state_store.hpp"
+
+#endif /* DEF_STATE_STORE_HXX */
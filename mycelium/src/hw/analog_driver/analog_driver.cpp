@@ -0,0 +1,23 @@
+/**
+ * 
+ */
+
+#include "analog_driver.h"
+
+namespace hw
+{
+namespace analog_driver
+{
+
+uint8_t FilterDefaultSettings::AdcBits = 10;
+uint8_t FilterDefaultSettings::OversamplingShift = 2;
+uint8_t FilterDefaultSettings::FilterShift = 2;
+uint8_t FilterDefaultSettings::OutputBits = 7;
+uint16_t FilterDefaultSettings::HysteresisRest = 192;
+uint16_t FilterDefaultSettings::HysteresisMoving = 32;
+uint16_t FilterDefaultSettings::ActivityThreshold = 64;
+
+unsigned long DriverDefaultSettings::SweepRate = 4000;
+
+} /* endof namespace analog_driver */
+} /* endof namespace hw */
@@ -0,0 +1,6 @@
+/**
+ * 
+ */
+
+#include "analog_filter.hxx"
+#include "analog_driver.hxx"
@@ -0,0 +1,116 @@
+/**
+ * 
+ */
+
+#include "analog_driver.hxx"
+
+namespace hw
+{
+namespace analog_driver
+{
+
+template <typename C, typename S>
+AnalogDriver<C, S>::AnalogDriver()
+    : _blocks{}, _back{0}, _ready{NO_BLOCK}, _address{0},
+    _sweeps{0}, _dropped{0}, _overruns{0},
+    _window_begin{0}, _window_sweeps{0}, _sweep_rate{0}
+    {}
+
+template <typename C, typename S>
+    error::status_byte
+AnalogDriver<C, S>::setup()
+    {
+        _back = 0;
+        _ready.store(NO_BLOCK, std::memory_order_relaxed);
+        _address = 0;
+        _sweeps.store(0, std::memory_order_relaxed);
+        _dropped.store(0, std::memory_order_relaxed);
+        _overruns.store(0, std::memory_order_relaxed);
+
+        Context::select_address(_address);
+        Context::start_conversions();
+
+        _window_begin = Context::micros();
+        _window_sweeps = 0;
+        _sweep_rate = 0;
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+void
+AnalogDriver<C, S>::on_tick()
+    {
+        uint16_t values[MUX_COUNT];
+        if (!Context::read_conversions(values))
+            {
+                _overruns.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+        sample_block& block = _blocks[_back];
+        for (uint8_t mux=0; mux<MUX_COUNT; ++mux)
+            { block.samples[mux * MUX_CHANNELS_COUNT + _address] = values[mux]; }
+
+        /* next conversions run while the sweep is published */
+        _address = (_address + 1) & MUX_ADDRESS_BITMASK;
+        Context::select_address(_address);
+        Context::start_conversions();
+
+        if (_address != 0)
+            { return; }
+
+        block.timestamp = Context::micros();
+        _sweeps.fetch_add(1, std::memory_order_relaxed);
+        if (_ready.load(std::memory_order_acquire) != NO_BLOCK)
+            {
+                /* previous sweep still held by the main loop, next sweep rewrites this block */
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        _ready.store(_back, std::memory_order_release);
+        _back ^= 1;
+    }
+
+template <typename C, typename S>
+template <typename Fn>
+bool
+AnalogDriver<C, S>::consume(Fn&& fn)
+    {
+        const uint8_t ready = _ready.load(std::memory_order_acquire);
+        if (ready == NO_BLOCK)
+            { return false; }
+
+        fn(static_cast<const sample_block&>(_blocks[ready]));
+        _ready.store(NO_BLOCK, std::memory_order_release);
+        return true;
+    }
+
+template <typename C, typename S>
+template <size_t N, typename FS>
+bool
+AnalogDriver<C, S>::consume(AnalogFilters<N, FS>& filters)
+    {
+        static_assert(N <= CHANNELS_COUNT, "more filters than analog channels");
+        return consume([&filters](const sample_block& block) {
+                for (uint8_t channel=0; channel<N; ++channel)
+                    { filters.feed(channel, block.samples[channel]); }
+            });
+    }
+
+template <typename C, typename S>
+void
+AnalogDriver<C, S>::update()
+    {
+        const unsigned long now = Context::micros();
+        const unsigned long elapsed = now - _window_begin;
+        if (elapsed < RATE_WINDOW_US)
+            { return; }
+
+        const unsigned long sweeps = sweeps_count();
+        _sweep_rate = (sweeps - _window_sweeps) * 1e6f / elapsed;
+        _window_begin = now;
+        _window_sweeps = sweeps;
+    }
+
+} /* endof namespace analog_driver */
+} /* endof namespace hw */
@@ -0,0 +1,143 @@
+/**
+ * 
+ */
+
+#ifndef DEF_ANALOG_DRIVER_HXX
+#define DEF_ANALOG_DRIVER_HXX
+
+#include "error.hpp"
+#include "../hw_defines.hxx"
+#include "analog_filter.hxx"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace hw
+{
+namespace analog_driver
+{
+
+/**
+ * HP4067 analog multiplexers, one per ADC input (A0 and A1),
+ *  channel address lines are common to both
+ */
+static constexpr const uint8_t MUX_COUNT = 2;
+static constexpr const uint8_t MUX_CHANNELS_COUNT = 16;
+static constexpr const uint8_t MUX_ADDRESS_BITMASK = 0x0F;
+static constexpr const uint8_t CHANNELS_COUNT = MUX_COUNT * MUX_CHANNELS_COUNT;
+
+/**
+ * Samples of a whole sweep, indexed by channel: @c mux * 16 + address
+ */
+struct sample_block
+{
+    uint16_t samples[CHANNELS_COUNT];
+    unsigned long timestamp;    ///< micros at sweep completion
+};
+
+/**
+ * 
+ */
+struct DriverDefaultSettings
+{
+    /**
+     * Target frequency of whole sweeps in Hz,
+     *  multiplied by @c MUX_CHANNELS_COUNT to obtain the tick rate
+     *  @note defaults to 4kHz: 64kHz ticks, 4 samples per filter step at 1kHz
+     */
+    static unsigned long SweepRate;
+};
+
+/**
+ * Analog acquisition engine: a timer interrupt sequences the muxes addresses and the conversions
+ *  into a double-buffered sample block, complete sweeps are handed to the main loop.
+ *
+ * On each tick, the conversions started on previous tick are collected,
+ *  next address is selected and new conversions are started:
+ *  mux settling is covered by the ADC sampling time.
+ * A sweep completed while the main loop still holds the previous one is dropped.
+ *
+ * Context is the hardware layer and must provide the following static members:
+ *  - @c void select_address(uint8_t address): sets muxes address lines
+ *  - @c void start_conversions(): starts conversion of every mux output
+ *  - @c bool read_conversions(uint16_t values[MUX_COUNT]): false if not finished yet
+ *  - @c unsigned long micros()
+ */
+template <typename _Context, typename _Settings=DriverDefaultSettings>
+class AnalogDriver
+{
+public:
+    using Settings = _Settings;
+    using Context = _Context;
+
+    AnalogDriver();
+
+    /**
+     * Selects first address and starts the first conversions,
+     *  the tick interrupt should be started after, with @c tick_period
+     */
+    error::status_byte setup();
+
+    /** Period of the tick interrupt in microseconds */
+    float tick_period() const
+        { return 1e6f / (Settings::SweepRate * MUX_CHANNELS_COUNT); }
+
+    /**
+     * Tick interrupt entry, never blocks
+     */
+    void on_tick();
+
+    /**
+     * Hands the last complete sweep to @c fn(const sample_block&) if any,
+     *  the block is released when @c fn returns. Main loop only.
+     *  Returns true if a sweep was consumed.
+     */
+    template <typename Fn>
+    bool consume(Fn&& fn);
+
+    /**
+     * Consumes last sweep into analog filters, channel N feeds filter N,
+     *  returns true if a sweep was consumed
+     */
+    template <size_t N, typename S>
+    bool consume(AnalogFilters<N, S>& filters);
+
+    /** Refreshes the achieved sweep rate, to be called on each loop */
+    void update();
+
+    /** Achieved frequency of complete sweeps in Hz */
+    float sweep_rate() const                { return _sweep_rate; }
+
+    unsigned long sweeps_count() const      { return _sweeps.load(std::memory_order_relaxed); }
+    /** Sweeps completed while the main loop was still holding the previous one */
+    unsigned long dropped_count() const     { return _dropped.load(std::memory_order_relaxed); }
+    /** Ticks where conversions were not finished yet */
+    unsigned long overruns_count() const    { return _overruns.load(std::memory_order_relaxed); }
+
+private:
+    /** Rates are measured over windows of at least this duration in microseconds */
+    static constexpr const unsigned long RATE_WINDOW_US = 250000;
+
+    static constexpr const uint8_t NO_BLOCK = 0xFF;
+
+    sample_block _blocks[2];
+    uint8_t _back;                      ///< block written by the interrupt
+    std::atomic<uint8_t> _ready;        ///< block handed to the main loop, or NO_BLOCK
+    uint8_t _address;                   ///< address beeing converted
+
+    std::atomic<unsigned long> _sweeps;
+    std::atomic<unsigned long> _dropped;
+    std::atomic<unsigned long> _overruns;
+
+    unsigned long _window_begin;
+    unsigned long _window_sweeps;
+    float _sweep_rate;
+};
+
+} /* endof namespace analog_driver */
+} /* endof namespace hw */
+
+#include "analog_driver.hpp"
+
+#endif /* DEF_ANALOG_DRIVER_HXX */
@@ -0,0 +1,90 @@
+/**
+ * 
+ */
+
+#include "analog_filter.hxx"
+
+namespace hw
+{
+namespace analog_driver
+{
+
+template <typename S>
+void
+AnalogFilter<S>::reset(uint16_t sample)
+    {
+        _accumulator = static_cast<uint32_t>(sample) << Settings::OversamplingShift;
+        _samples = 0;
+        _filtered = decimate();
+        _state = static_cast<uint32_t>(_filtered) << 8;
+        _accumulator = 0;
+        _activity = 0;
+        _output = _filtered >> (FINE_BITS - Settings::OutputBits);
+    }
+
+template <typename S>
+bool
+AnalogFilter<S>::feed(uint16_t sample)
+    {
+        _accumulator += sample;
+        _samples += 1;
+        if (_samples < (1 << Settings::OversamplingShift))
+            { return false; }
+
+        const uint32_t input = decimate();
+        _accumulator = 0;
+        _samples = 0;
+
+        /* y += (x - y) >> k, signed arithmetic on the Q8 state */
+        const int32_t error = static_cast<int32_t>(input << 8) - static_cast<int32_t>(_state);
+        _state = static_cast<int32_t>(_state) + (error >> Settings::FilterShift);
+
+        const uint16_t previous = _filtered;
+        _filtered = _state >> 8;
+
+        /* activity: absolute change smoothed over about 8 steps, in Q3 */
+        const uint32_t change = _filtered > previous ? _filtered - previous : previous - _filtered;
+        const uint32_t activity = _activity - (_activity >> 3) + change;
+        _activity = activity < UINT16_MAX ? activity : UINT16_MAX;
+
+        return quantize();
+    }
+
+template <typename S>
+uint16_t
+AnalogFilter<S>::hysteresis() const
+    {
+        const uint32_t threshold = Settings::ActivityThreshold;
+        const uint32_t activity = (_activity >> 3) < threshold ? (_activity >> 3) : threshold;
+        const uint32_t span = Settings::HysteresisRest - Settings::HysteresisMoving;
+        const uint32_t step_fraction = Settings::HysteresisRest - span * activity / threshold;
+
+        /* step_fraction is in 1/256 of an output step */
+        const uint8_t step_bits = FINE_BITS - Settings::OutputBits;
+        return step_bits >= 8 ? step_fraction << (step_bits - 8) : step_fraction >> (8 - step_bits);
+    }
+
+template <typename S>
+bool
+AnalogFilter<S>::quantize()
+    {
+        const uint8_t step_bits = FINE_BITS - Settings::OutputBits;
+        const uint16_t candidate = _filtered >> step_bits;
+        if (candidate == _output)
+            { return false; }
+
+        /* leave current step only once past it's boundary by the hysteresis,
+         *  which is less than a step so both ends of the scale stay reachable */
+        const uint32_t h = hysteresis();
+        const uint16_t next = (candidate > _output)
+            ? (_filtered - h) >> step_bits
+            : (_filtered + h) >> step_bits;
+
+        if ((candidate > _output) ? (next <= _output) : (next >= _output))
+            { return false; }
+        _output = next;
+        return true;
+    }
+
+} /* endof namespace analog_driver */
+} /* endof namespace hw */
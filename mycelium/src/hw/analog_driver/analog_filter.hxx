@@ -0,0 +1,187 @@
+/**
+ * 
+ */
+
+#ifndef DEF_ANALOG_FILTER_HXX
+#define DEF_ANALOG_FILTER_HXX
+
+#include "../hw_defines.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace hw
+{
+namespace analog_driver
+{
+
+/**
+ * Filtered values are handled as unsigned 16 bits fractions of the ADC full scale
+ */
+static constexpr const uint8_t FINE_BITS = 16;
+static constexpr const uint32_t FINE_MAX = (1UL << FINE_BITS) -1;
+
+/**
+ * 
+ */
+struct FilterDefaultSettings
+{
+    /**
+     * Resolution of raw samples
+     *  @note defaults to 10 bits, teensy ADC default resolution
+     */
+    static uint8_t AdcBits;
+
+    /**
+     * Raw samples averaged per filter step, as a power of two
+     *  @note defaults to 2: 4 samples per step, adding one bit of resolution
+     */
+    static uint8_t OversamplingShift;
+
+    /**
+     * IIR low-pass coefficient as a power of two: y += (x - y) / 2^FilterShift
+     *  @note defaults to 2, time constant of about 4 filter steps
+     */
+    static uint8_t FilterShift;
+
+    /**
+     * Resolution of emitted values
+     *  @note defaults to 7 bits, MIDI control change resolution
+     */
+    static uint8_t OutputBits;
+
+    /**
+     * Hysteresis around output steps boundaries in 1/256 of an output step,
+     *  interpolated from @c HysteresisRest to @c HysteresisMoving with the channel activity
+     *  @note defaults to 0.75 step at rest and 0.125 step while moving
+     */
+    static uint16_t HysteresisRest;
+    static uint16_t HysteresisMoving;
+
+    /**
+     * Activity (smoothed absolute change of the filtered value per step, fine units)
+     *  from which a channel is considered moving
+     *  @note defaults to 64: a 1/1024 of the full scale per step
+     */
+    static uint16_t ActivityThreshold;
+};
+
+/**
+ * Acquisition stage of a single analog channel: fixed-point oversampling,
+ *  one-pole IIR low-pass, adaptive hysteresis and quantization.
+ *  A new value is reported only when the quantized output changes,
+ *  the hysteresis is wide while the control rests to swallow ADC jitter
+ *  and narrow while it moves to keep the tracking lag low.
+ */
+template <typename _Settings=FilterDefaultSettings>
+class AnalogFilter
+{
+public:
+    using Settings = _Settings;
+
+    AnalogFilter()
+        : _accumulator{0}, _samples{0}, _state{0}, _filtered{0}, _activity{0}, _output{0}
+        {}
+
+    /** Starts from given raw sample, without any transient */
+    void reset(uint16_t sample);
+
+    /**
+     * Feeds a raw sample, returns true if the quantized output changed
+     *  @note the filter runs once every 2^OversamplingShift samples
+     */
+    bool feed(uint16_t sample);
+
+    /** Returns quantized output on @c Settings::OutputBits */
+    uint16_t value() const          { return _output; }
+
+    /** Returns filtered value as a fraction of full scale on 16 bits */
+    uint16_t filtered() const       { return _filtered; }
+
+    /** Returns hysteresis currently applied, in fine units */
+    uint16_t hysteresis() const;
+
+private:
+    /** Raw samples sum scaled to fine units */
+    uint32_t decimate() const
+        {
+            const uint8_t bits = Settings::AdcBits + Settings::OversamplingShift;
+            return bits < FINE_BITS ? _accumulator << (FINE_BITS - bits) : _accumulator >> (bits - FINE_BITS);
+        }
+
+    /** Applies hysteresis and quantization, returns true on output change */
+    bool quantize();
+
+    uint32_t _accumulator;  ///< raw samples sum of current oversampling window
+    uint8_t _samples;       ///< raw samples count in current window
+    uint32_t _state;        ///< IIR state, fine units in Q8
+    uint16_t _filtered;     ///< IIR output, fine units
+    uint16_t _activity;     ///< smoothed absolute change of @c _filtered per step, Q3
+    uint16_t _output;
+};
+
+/**
+ * Quantized value change of an analog channel
+ */
+struct analog_event
+{
+    uint8_t channel;
+    uint16_t value;
+};
+
+/**
+ * Filters of a set of channels, changed channels are flagged until polled
+ */
+template <size_t _Size, typename _Settings=FilterDefaultSettings>
+class AnalogFilters
+{
+public:
+    using filter_type = AnalogFilter<_Settings>;
+    static constexpr const size_t Size = _Size;
+
+    static_assert(Size <= 32, "changes are flagged on a 32 bits mask");
+
+    AnalogFilters()
+        : _filters{}, _changed{0}
+        {}
+
+    void reset(uint8_t channel, uint16_t sample)
+        { _filters[channel].reset(sample); }
+
+    /** Feeds a raw sample of given channel, returns true if it's output changed */
+    bool feed(uint8_t channel, uint16_t sample)
+        {
+            if (!_filters[channel].feed(sample))
+                { return false; }
+            _changed |= 1UL << channel;
+            return true;
+        }
+
+    /** Pops next changed channel with it's latest value, returns false if none */
+    bool poll(analog_event& event)
+        {
+            if (_changed == 0)
+                { return false; }
+            event.channel = __builtin_ctzl(_changed);
+            event.value = _filters[event.channel].value();
+            _changed &= _changed -1;
+            return true;
+        }
+
+    const filter_type& operator[] (uint8_t channel) const   { return _filters[channel]; }
+
+private:
+    filter_type _filters[Size];
+    uint32_t _changed;
+};
+
+/** Filters for every @c analog::Fader */
+template <typename _Settings=FilterDefaultSettings>
+using FadersFilters = AnalogFilters<static_cast<size_t>(analog::Fader::__FADERS_COUNT__), _Settings>;
+
+} /* endof namespace analog_driver */
+} /* endof namespace hw */
+
+#include "analog_filter.hpp"
+
+#endif /* DEF_ANALOG_FILTER_HXX */
@@ -0,0 +1,24 @@
+/**
+ * 
+ */
+
+#include "encoders_driver.hxx"
+
+namespace hw
+{
+namespace encoders_driver
+{
+
+uint8_t DriverDefaultSettings::StepsPerDetent = 4;
+
+acceleration_point DriverDefaultSettings::AccelerationCurve[ACCELERATION_POINTS_COUNT] = {
+    {  10, 1 * UNIT_GAIN },
+    {  40, 2 * UNIT_GAIN },
+    { 100, 4 * UNIT_GAIN },
+    { 200, 8 * UNIT_GAIN },
+};
+
+unsigned long DriverDefaultSettings::VelocityTimeout = 100000;
+
+} /* endof namespace encoders_driver */
+} /* endof namespace hw */
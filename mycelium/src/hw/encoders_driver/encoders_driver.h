@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "encoders_driver.hxx"
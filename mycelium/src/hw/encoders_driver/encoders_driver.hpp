@@ -0,0 +1,90 @@
+/**
+ * 
+ */
+
+#include "encoders_driver.hxx"
+
+namespace hw
+{
+namespace encoders_driver
+{
+
+template <typename C, typename S>
+EncodersDriver<C, S>::EncodersDriver()
+    : _decoders{}, _motion{}
+    {}
+
+template <typename C, typename S>
+    error::status_byte
+EncodersDriver<C, S>::setup()
+    {
+        const unsigned long now = Context::micros();
+        for (uint8_t i=0; i<ENCODERS_COUNT; ++i)
+            {
+                const analog::Encoder encoder = static_cast<analog::Encoder>(i);
+                _decoders[i].reset(Context::read_phases(encoder));
+                _motion[i] = motion{now, 0, 0};
+            }
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+int16_t
+EncodersDriver<C, S>::read(analog::Encoder encoder)
+    {
+        if (!(static_cast<uint8_t>(encoder) < ENCODERS_COUNT))
+            { return 0; }
+
+        motion& m = _motion[static_cast<uint8_t>(encoder)];
+        const int16_t detents = read_raw(encoder);
+        const unsigned long now = Context::micros();
+        const unsigned long elapsed = now - m.last_motion;
+
+        if (detents == 0)
+            {
+                /* a slow turn after a pause must not inherit the previous speed */
+                if (elapsed > Settings::VelocityTimeout)
+                    {
+                        m.last_motion = now - Settings::VelocityTimeout;
+                        m.velocity = 0;
+                        m.remainder = 0;
+                    }
+                return 0;
+            }
+
+        const unsigned long magnitude = detents < 0 ? -detents : detents;
+        const unsigned long velocity = elapsed ? magnitude * 1000000UL / elapsed : UINT16_MAX;
+        m.velocity = velocity < UINT16_MAX ? velocity : UINT16_MAX;
+        m.last_motion = now;
+
+        /* fractional part is only carried while turning the same way */
+        if ((m.remainder < 0) != (detents < 0))
+            { m.remainder = 0; }
+
+        const int32_t scaled = static_cast<int32_t>(detents) * gain_of(m.velocity) + m.remainder;
+        const int32_t result = scaled / UNIT_GAIN;
+        m.remainder = scaled - result * UNIT_GAIN;
+        return static_cast<int16_t>(result);
+    }
+
+template <typename C, typename S>
+uint16_t
+EncodersDriver<C, S>::gain_of(uint16_t velocity)
+    {
+        const acceleration_point* curve = Settings::AccelerationCurve;
+        if (velocity <= curve[0].velocity)
+            { return curve[0].gain; }
+
+        for (size_t i=1; i<ACCELERATION_POINTS_COUNT; ++i)
+            {
+                if (velocity >= curve[i].velocity)
+                    { continue; }
+                const uint32_t span = curve[i].velocity - curve[i-1].velocity;
+                const int32_t delta = curve[i].gain - curve[i-1].gain;
+                return curve[i-1].gain + delta * static_cast<int32_t>(velocity - curve[i-1].velocity) / static_cast<int32_t>(span);
+            }
+        return curve[ACCELERATION_POINTS_COUNT -1].gain;
+    }
+
+} /* endof namespace encoders_driver */
+} /* endof namespace hw */
@@ -0,0 +1,224 @@
+/**
+ * 
+ */
+
+#ifndef DEF_ENCODERS_DRIVER_HXX
+#define DEF_ENCODERS_DRIVER_HXX
+
+#include "error.hpp"
+#include "../hw_defines.hxx"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace hw
+{
+namespace encoders_driver
+{
+
+static constexpr const size_t ENCODERS_COUNT = static_cast<size_t>(analog::Encoder::__ENCODERS_COUNT__);
+
+/**
+ * Quadrature phases are packed as 2 bits: bit 0 is channel A, bit 1 is channel B
+ */
+using phases = uint8_t;
+
+/**
+ * Quarter steps indexed by (previous phases << 2 | current phases),
+ *  @c SKIPPED marks transitions where both channels changed at once:
+ *  an intermediate state was missed, direction can't be read from the table
+ */
+static constexpr const int8_t SKIPPED = 2;
+static constexpr const int8_t QUADRATURE_TRANSITIONS[16] = {
+/* from  to:  00       01       10       11   */
+/* 00 */      0,      +1,      -1,      SKIPPED,
+/* 01 */     -1,       0,      SKIPPED, +1,
+/* 10 */     +1,      SKIPPED, 0,      -1,
+/* 11 */      SKIPPED, -1,     +1,      0,
+};
+
+/**
+ * Decoder of a single encoder, @c update can be called from a pin change interrupt
+ *  while the main loop consumes the accumulated quarter steps.
+ *
+ * Skipped transitions are counted as two quarter steps in the last known direction,
+ *  which is right as long as the encoder can't turn half a step between two interrupts.
+ */
+class QuadratureDecoder
+{
+public:
+    QuadratureDecoder()
+        : _phases{0}, _direction{1}, _steps{0}, _skipped{0}
+        {}
+
+    /** Sets current phases without counting any step */
+    void reset(phases current)
+        {
+            _phases = current & 0b11;
+            _direction = 1;
+            _steps.store(0, std::memory_order_relaxed);
+            _skipped.store(0, std::memory_order_relaxed);
+        }
+
+    /**
+     * Decodes a phases change, interrupt safe as long as a single context updates a decoder
+     */
+    void update(phases current)
+        {
+            current &= 0b11;
+            int8_t step = QUADRATURE_TRANSITIONS[(_phases << 2) | current];
+            _phases = current;
+            if (step == 0)
+                { return; }
+
+            if (step == SKIPPED)
+                {
+                    step = 2 * _direction;
+                    _skipped.fetch_add(1, std::memory_order_relaxed);
+                }
+            else
+                { _direction = step; }
+            _steps.fetch_add(step, std::memory_order_relaxed);
+        }
+
+    /**
+     * Removes whole detents from accumulated quarter steps and returns them,
+     *  partial detents are kept for next call
+     */
+    int32_t take_detents(uint8_t steps_per_detent)
+        {
+            const int32_t detents = _steps.load(std::memory_order_relaxed) / steps_per_detent;
+            if (detents != 0)
+                { _steps.fetch_sub(detents * steps_per_detent, std::memory_order_relaxed); }
+            return detents;
+        }
+
+    /** Returns quarter steps not consumed yet */
+    int32_t pending_steps() const       { return _steps.load(std::memory_order_relaxed); }
+
+    /** Returns count of transitions where a state was skipped */
+    uint16_t skipped_count() const      { return _skipped.load(std::memory_order_relaxed); }
+
+private:
+    volatile phases _phases;        ///< only written by the updating context
+    volatile int8_t _direction;     ///< last decoded direction, used to resolve skipped states
+    std::atomic<int32_t> _steps;    ///< quarter steps not consumed yet, word sized to stay lock-free
+    std::atomic<uint16_t> _skipped;
+};
+
+/**
+ * Point of the acceleration curve: detents turned faster than @c velocity
+ *  are multiplied by @c gain (fixed point, 16 is x1), linearly interpolated between points
+ */
+struct acceleration_point
+{
+    uint16_t velocity;  ///< detents per second
+    uint16_t gain;      ///< Q4 multiplier
+};
+
+static constexpr const uint8_t GAIN_SHIFT = 4;
+static constexpr const uint16_t UNIT_GAIN = 1 << GAIN_SHIFT;
+static constexpr const size_t ACCELERATION_POINTS_COUNT = 4;
+
+/**
+ * 
+ */
+struct DriverDefaultSettings
+{
+    /**
+     * Quarter steps between two mechanical detents
+     *  @note defaults to 4: a whole quadrature cycle per detent
+     */
+    static uint8_t StepsPerDetent;
+
+    /**
+     * Velocity acceleration curve applied by @c EncodersDriver::read,
+     *  points must be sorted by velocity
+     *  @note defaults to x1 below 10 detents/s, up to x8 at 200 detents/s
+     */
+    static acceleration_point AccelerationCurve[ACCELERATION_POINTS_COUNT];
+
+    /**
+     * Idle time after which the encoder velocity is considered null in microseconds
+     *  @note defaults to 100ms
+     */
+    static unsigned long VelocityTimeout;
+};
+
+/**
+ * Rotary encoders driver: quadrature decoding runs from pin change interrupts,
+ *  the main loop reads accelerated detents.
+ *
+ * Context must provide the following static members:
+ *  - @c phases read_phases(analog::Encoder): current levels of both channels
+ *  - @c unsigned long micros()
+ */
+template <typename _Context, typename _Settings=DriverDefaultSettings>
+class EncodersDriver
+{
+public:
+    using Settings = _Settings;
+    using Context = _Context;
+
+    EncodersDriver();
+
+    /**
+     * Reads initial phases of every encoder, interrupts should be attached after
+     */
+    error::status_byte setup();
+
+    /**
+     * Pin change interrupt entry: reads phases of given encoder and decodes them
+     */
+    void on_pin_change(analog::Encoder encoder)
+        { decoder(encoder).update(Context::read_phases(encoder)); }
+
+    /**
+     * Interrupt entry for callers already holding the phases, e.g. from a whole port read
+     */
+    void on_pin_change(analog::Encoder encoder, phases current)
+        { decoder(encoder).update(current); }
+
+    /**
+     * Returns detents turned since last read, positive clockwise,
+     *  multiplied by the acceleration curve, main loop only
+     */
+    int16_t read(analog::Encoder encoder);
+
+    /** Returns detents turned since last read, without acceleration */
+    int16_t read_raw(analog::Encoder encoder)
+        { return static_cast<int16_t>(decoder(encoder).take_detents(Settings::StepsPerDetent)); }
+
+    /** Returns last estimated velocity in detents per second */
+    uint16_t velocity(analog::Encoder encoder) const
+        { return _motion[static_cast<uint8_t>(encoder)].velocity; }
+
+    const QuadratureDecoder& decoder(analog::Encoder encoder) const
+        { return _decoders[static_cast<uint8_t>(encoder)]; }
+
+    /** Returns gain (Q4) of the acceleration curve at given velocity */
+    static uint16_t gain_of(uint16_t velocity);
+
+private:
+    QuadratureDecoder& decoder(analog::Encoder encoder)
+        { return _decoders[static_cast<uint8_t>(encoder)]; }
+
+    /** Main loop side state of an encoder */
+    struct motion
+    {
+        unsigned long last_motion;  ///< timestamp of last read detent in us
+        uint16_t velocity;          ///< detents per second
+        int16_t remainder;          ///< Q4 fraction of accelerated detents not returned yet
+    };
+
+    QuadratureDecoder _decoders[ENCODERS_COUNT];
+    motion _motion[ENCODERS_COUNT];
+};
+
+} /* endof namespace encoders_driver */
+} /* endof namespace hw */
+
+#include "encoders_driver.hpp"
+
+#endif /* DEF_ENCODERS_DRIVER_HXX */
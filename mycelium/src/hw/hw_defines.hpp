@@ -46,6 +46,9 @@ constexpr bool is_blind<analog::Fader>(analog::Fader f)
 namespace pads
 {
 
+static constexpr bool is_monochrome(Pad p)
+    { return !(is_blind(p) || is_bichrome(p)); }
+
 
 static_assert(static_cast<uint8_t>(Pad::__PADS_COUNT__) == 8 * static_cast<uint8_t>(PadRow::__ROWS_COUNT__));
 
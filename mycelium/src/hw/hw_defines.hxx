@@ -61,19 +61,17 @@ namespace pads
  */
 enum class Pad: uint8_t
     {
-    __FIRST_PAD__ = 0,
-
     /** Bicolor pads */
 
         /**
          * LAUNCH PADS
          *  pins 26, 27, 28, 29, 30
          */
-        MAKE_8(CLIP_0, '0000'),
-        MAKE_8(CLIP_1, '0001'),
-        MAKE_8(CLIP_2, '0010'),
-        MAKE_8(CLIP_3, '0011'),
-        MAKE_8(CLIP_4, '0100'),
+        MAKE_8(CLIP_0, 0000),
+        MAKE_8(CLIP_1, 0001),
+        MAKE_8(CLIP_2, 0010),
+        MAKE_8(CLIP_3, 0011),
+        MAKE_8(CLIP_4, 0100),
 
     /** Monochrome pads */
 
@@ -82,8 +80,8 @@ enum class Pad: uint8_t
          *  pins 31, 32, 33
          */
 
-        MAKE_8(CLIP_STOP,    '0101'),
-        MAKE_8(TRACK_SELECT, '0110'),
+        MAKE_8(CLIP_STOP,    0101),
+        MAKE_8(TRACK_SELECT, 0110),
 
         SCENE_LAUNCH_0 = 0b0'0111'000,
         SCENE_LAUNCH_1,
@@ -98,9 +96,9 @@ enum class Pad: uint8_t
          * TRACK ACTION PADS
          *  pins 34, 35, 36
          */
-        MAKE_8(RECORD_ARM,  '1000'),
-        MAKE_8(SOLO_CUE,    '1001'),
-        MAKE_8(ACTIVATOR,   '1010'),
+        MAKE_8(RECORD_ARM,  1000),
+        MAKE_8(SOLO_CUE,    1001),
+        MAKE_8(ACTIVATOR,   1010),
 
         /**
          * DEVICE CONTROL
@@ -144,7 +142,10 @@ enum class Pad: uint8_t
         BANK_UP,
         BANK_DOWN,
 
-    __PADS_COUNT__
+    __PADS_COUNT__,
+
+    /** declared last: reflected names of aliased values are the first enumerators declared */
+    __FIRST_PAD__ = CLIP_0_0,
     }; /* endof enum Pad */
 
 constexpr bool operator< (Pad lhs, Pad rhs)
@@ -155,8 +156,6 @@ constexpr bool operator< (Pad lhs, Pad rhs)
  */
 enum class PadRow: uint8_t
     {
-    __FIRST_ROW__ = 0,
-
     /** Bicolor pads */
 
         Clip_0 = 0,
@@ -180,7 +179,10 @@ enum class PadRow: uint8_t
         TransportControl,
         BankControl,
 
-    __ROWS_COUNT__
+    __ROWS_COUNT__,
+
+    /** declared last: reflected names of aliased values are the first enumerators declared */
+    __FIRST_ROW__ = Clip_0,
     }; /* endof enum PadRow */
 
 /**
@@ -192,9 +194,9 @@ static constexpr bool is_bichrome(Pad p)
 
 /**
  * Returns true if given pad has a single led attached
+ * @note defined in hw_defines.hpp, after @c is_blind<Pad> specialisation
  */
-static constexpr bool is_monochrome(Pad p)
-    { return !(is_blind(p) || is_bichrome(p)); }
+static constexpr bool is_monochrome(Pad p);
 
 /**
  * Utility defines for easy walkthrough existing pads
@@ -277,18 +279,19 @@ namespace analog
  */
 enum class Encoder: uint8_t
     {
-    __FIRST_ENCODER__   = 0,
-
     /** Encoders with led-ring */
 
-        MAKE_8(PAN, '0000'),
-        MAKE_8(CTRL, '0001'),
+        MAKE_8(PAN, 0000),
+        MAKE_8(CTRL, 0001),
 
     /** blind encoder */
 
         CUE_LEVEL,
 
-    __ENCODERS_COUNT__
+    __ENCODERS_COUNT__,
+
+    /** declared last: reflected names of aliased values are the first enumerators declared */
+    __FIRST_ENCODER__ = PAN_0,
     }; /* endof enum Encoder */
 
 /**
@@ -310,14 +313,15 @@ enum class EncoderGroup: uint8_t
  */
 enum class Fader: uint8_t
     {
-    __FIRST_FADER__ = 0,
-
-        MAKE_8(TRACK_LEVEL, '0000'),
+        MAKE_8(TRACK_LEVEL, 0000),
 
         MASTER_LEVEL,
         CROSSFADE,
 
-    __FADERS_COUNT__
+    __FADERS_COUNT__,
+
+    /** declared last: reflected names of aliased values are the first enumerators declared */
+    __FIRST_FADER__ = TRACK_LEVEL_0,
     }; /* endof enum Fader */
 
 /**
@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "hw_names.hxx"
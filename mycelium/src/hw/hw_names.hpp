@@ -0,0 +1,71 @@
+/**
+ * 
+ */
+
+#include "hw_names.hxx"
+
+namespace hw
+{
+namespace pads
+{
+
+static_assert(reflect::is_round_trip<Pad>());
+static_assert(reflect::is_round_trip<PadRow>());
+
+static_assert(reflect::enumerator_name<Pad, Pad::CLIP_0_0>() == "CLIP_0_0");
+static_assert(reflect::enumerator_name<Pad, Pad::CLIP_4_7>() == "CLIP_4_7");
+static_assert(reflect::enumerator_name<Pad, Pad::STOP_ALL_CLIPS>() == "STOP_ALL_CLIPS");
+static_assert(reflect::enumerator_name<Pad, Pad::BANK_DOWN>() == "BANK_DOWN");
+static_assert(reflect::enumerator_name<Pad, Pad::__UNUSED_33_7__>().empty());
+static_assert(reflect::enumerator_name<Pad, Pad::__UNUSED_39_4__>().empty());
+static_assert(reflect::enumerator_name<Pad, Pad::__PADS_COUNT__>().empty());
+
+static_assert(reflect::name_of(Pad::__UNUSED_33_7__) == nullptr);
+static_assert(reflect::name_of(Pad::__PADS_COUNT__) == nullptr);
+static_assert(reflect::name_of(Pad::SEND_C)[0] == 'S' && reflect::name_of(Pad::SEND_C)[6] == '\0');
+
+static_assert(reflect::enumerator_name<PadRow, PadRow::Clip_0>() == "Clip_0");
+static_assert(reflect::enumerator_name<PadRow, PadRow::BankControl>() == "BankControl");
+
+namespace
+{
+
+constexpr bool named(const char* name, Pad expected)
+    {
+        Pad p{};
+        return reflect::from_name(name, std::char_traits<char>::length(name), p) && p == expected;
+    }
+
+constexpr bool unknown(const char* name)
+    {
+        Pad p{};
+        return !reflect::from_name(name, std::char_traits<char>::length(name), p);
+    }
+
+} /* endof namespace */
+
+static_assert(named("CLIP_0_0", Pad::CLIP_0_0));
+static_assert(named("SCENE_LAUNCH_4", Pad::SCENE_LAUNCH_4));
+static_assert(named("PAN", Pad::PAN));
+static_assert(unknown("CLIP_0"));
+static_assert(unknown("CLIP_0_00"));
+static_assert(unknown("clip_0_0"));
+static_assert(unknown("__UNUSED_33_7__"));
+static_assert(unknown(""));
+
+} /* endof namespace pads */
+
+namespace analog
+{
+
+static_assert(reflect::is_round_trip<Encoder>());
+static_assert(reflect::is_round_trip<Fader>());
+
+static_assert(reflect::enumerator_name<Encoder, Encoder::PAN_0>() == "PAN_0");
+static_assert(reflect::enumerator_name<Encoder, Encoder::CTRL_7>() == "CTRL_7");
+static_assert(reflect::enumerator_name<Encoder, Encoder::CUE_LEVEL>() == "CUE_LEVEL");
+static_assert(reflect::enumerator_name<Fader, Fader::TRACK_LEVEL_0>() == "TRACK_LEVEL_0");
+static_assert(reflect::enumerator_name<Fader, Fader::CROSSFADE>() == "CROSSFADE");
+
+} /* endof namespace analog */
+} /* endof namespace hw */
@@ -0,0 +1,36 @@
+/**
+ * Names of device elements, reflected from their enumerations:
+ *  @c reflect::name_of and @c reflect::from_name convert pads, pad rows, encoders and faders
+ *  from and to the names of their enumerators, e.g. CLIP_3_7, TrackSelect, CTRL_2, MASTER_LEVEL.
+ */
+
+#ifndef DEF_HW_NAMES_HXX
+#define DEF_HW_NAMES_HXX
+
+#include "hw_defines.hxx"
+#include "../utils/reflect/reflect.hxx"
+
+namespace reflect
+{
+
+template <>
+struct enum_size<hw::pads::Pad>
+    { static constexpr const size_t value = static_cast<size_t>(hw::pads::Pad::__PADS_COUNT__); };
+
+template <>
+struct enum_size<hw::pads::PadRow>
+    { static constexpr const size_t value = static_cast<size_t>(hw::pads::PadRow::__ROWS_COUNT__); };
+
+template <>
+struct enum_size<hw::analog::Encoder>
+    { static constexpr const size_t value = static_cast<size_t>(hw::analog::Encoder::__ENCODERS_COUNT__); };
+
+template <>
+struct enum_size<hw::analog::Fader>
+    { static constexpr const size_t value = static_cast<size_t>(hw::analog::Fader::__FADERS_COUNT__); };
+
+} /* endof namespace reflect */
+
+#include "hw_names.hpp"
+
+#endif /* DEF_HW_NAMES_HXX */
@@ -9,12 +9,13 @@ namespace hw
 namespace leds_driver
 {
 
-auto DriverDefaultSettings::RefreshRate = 50;
+unsigned long DriverDefaultSettings::RefreshRate = 50;
+unsigned long DriverDefaultSettings::I2CFrequency = 400000;
 
 #ifdef NDEBUG
-auto DriverDefaultSettings::LogLevel = error::severity::INFO;
+error::severity DriverDefaultSettings::LogLevel = error::severity::INFO;
 #else
-auto DriverDefaultSettings::LogLevel = error::severity::DEBUG;
+error::severity DriverDefaultSettings::LogLevel = error::severity::DEBUG;
 #endif
 
 } /* endof namespace leds_driver */
@@ -9,5 +9,397 @@ namespace hw
 namespace leds_driver
 {
 
+inline void
+leds_frame::clear()
+    {
+        for (uint8_t c=0; c<MULTIPLEX_COLUMS_COUNT; ++c)
+            {
+                if (!(columns & (1 << c)))
+                    { continue; }
+                for (size_t d=0; d<ANNODE_DRIVER_COUNT; ++d)
+                    { masks[c][d] = bits[c][d] = 0; }
+            }
+        columns = 0;
+    }
+
+inline bool
+leds_frame::set(pads::Pad addr, pad_color state)
+    {
+        if (is_blind(addr) || !(addr < pads::Pad::__PADS_COUNT__))
+            { return false; }
+        stage(get_column(addr), annode_of(addr), pads::is_bichrome(addr) ? 0b11 : 0b01, static_cast<uint16_t>(state));
+        return true;
+    }
+
+inline bool
+leds_frame::set(analog::Encoder addr, ledring_state state)
+    {
+        if (is_blind(addr) || !(static_cast<uint8_t>(addr) < static_cast<uint8_t>(analog::Encoder::__ENCODERS_COUNT__)))
+            { return false; }
+        stage(get_column(addr), annode_pin{annode_of(addr), 0}, 0xFFFE, state.word());
+        return true;
+    }
+
+template <typename C, typename S>
+LedsDriver<C, S>::LedsDriver()
+    : _gpio_words{}, _dirty_columns{0}, _mcp_write_buffer{}, _cycle_state{CycleState::CONFIGURING},
+    _column{0}, _next_column{0}, _pending_writes{0}, _last_step{0}, _steps_count{0}
+    {
+        for (auto& column: _mcp_write_buffer)
+            for (auto& mcp: column)
+                { mcp[0] = MCP_GPIOA; }
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::setup()
+    {
+        Context::pin_mode_output(CATHODE_ADDR_PINA0);
+        Context::pin_mode_output(CATHODE_ADDR_PINA1);
+        Context::pin_mode_output(CATHODE_ADDR_PINA2);
+        Context::pin_mode_output(CATHODE_ENABLE_PIN);
+        Context::digital_write(CATHODE_ENABLE_PIN, !CATHODE_ENABLE_LEVEL);
+
+        for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+            {
+                master_type& master = Context::i2c_master(static_cast<annode_driver>(i));
+                master.begin(Settings::I2CFrequency);
+                master.write_async(MCP_I2C_ADDRESS, MCP_CONFIGURATION, WRITE_BUFFER_SIZE, true);
+            }
+
+        _cycle_state = CycleState::CONFIGURING;
+        _column = _next_column = 0;
+        _steps_count = 0;
+        _last_step = Context::micros();
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+template <typename StepFn>
+    error::status_byte
+LedsDriver<C, S>::update(StepFn&& on_column_end)
+    {
+        bool failed = false;
+        error::errcode err = error::errcode::OK;
+
+        switch (_cycle_state)
+        {
+        case CycleState::CONFIGURING:
+            if (!mcps_finished(failed))
+                { return error::status_byte{}; }
+            if (failed)
+                {
+                    /* MCP might not be powered yet, retry whole configuration */
+                    setup();
+                    return error::errcode::HWERROR | error::severity::ERROR;
+                }
+            _cycle_state = CycleState::READY;
+            return error::status_byte{};
+
+        case CycleState::READY:
+            if (Context::micros() - _last_step < column_period())
+                { return error::status_byte{}; }
+            /* no column has been powered yet right after configuration */
+            if (_steps_count != 0)
+                { on_column_end(_column); }
+            err = begin_cycle();
+            break;
+
+        case CycleState::UPDATING_GPIOS:
+            err = update_mcps();
+            break;
+
+        case CycleState::ENDING:
+            err = end_cycle();
+            break;
+
+        default:
+            return error::errcode::INVALID_STATE | error::severity::CRITICAL;
+        }
+
+        if (err != error::errcode::OK)
+            { return err | error::severity::ERROR; }
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::errcode
+LedsDriver<C, S>::begin_cycle()
+    {
+        const unsigned long now = Context::micros();
+        const unsigned long period = column_period();
+
+        /* keep a steady rate, but do not try to catch up if late by more than a step */
+        _last_step = (now - _last_step < 2 * period) ? _last_step + period : now;
+
+        Context::digital_write(CATHODE_ENABLE_PIN, !CATHODE_ENABLE_LEVEL);
+        _next_column = (_column + 1) & MULTIPLEX_COLUMN_BITMASK;
+
+        /* publish edits, transmit buffer of other columns are never touched while on the wire */
+        if (_dirty_columns & (1 << _next_column))
+            {
+                for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+                    {
+                        const uint16_t word = _gpio_words[_next_column][i];
+                        _mcp_write_buffer[_next_column][i][1] = word & 0xFF;
+                        _mcp_write_buffer[_next_column][i][2] = word >> 8;
+                    }
+                _dirty_columns &= ~(1 << _next_column);
+            }
+
+        _pending_writes = (1 << ANNODE_DRIVER_COUNT) -1;
+        _cycle_state = CycleState::UPDATING_GPIOS;
+
+        return update_mcps();
+    }
+
+template <typename C, typename S>
+    error::errcode
+LedsDriver<C, S>::update_mcps()
+    {
+        for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+            {
+                if (!(_pending_writes & (1 << i)))
+                    { continue; }
+
+                master_type& master = Context::i2c_master(static_cast<annode_driver>(i));
+                if (!master.finished())
+                    { continue; }
+
+                master.write_async(MCP_I2C_ADDRESS, _mcp_write_buffer[_next_column][i], WRITE_BUFFER_SIZE, true);
+                _pending_writes &= ~(1 << i);
+            }
+
+        if (_pending_writes == 0)
+            { _cycle_state = CycleState::ENDING; }
+        return error::errcode::OK;
+    }
+
+template <typename C, typename S>
+    error::errcode
+LedsDriver<C, S>::end_cycle()
+    {
+        bool failed = false;
+        if (!mcps_finished(failed))
+            { return error::errcode::OK; }
+
+        /* column is powered even on failure, a single wrong frame is better than a dark one */
+        Context::digital_write(CATHODE_ADDR_PINA0, _next_column & 0b001);
+        Context::digital_write(CATHODE_ADDR_PINA1, _next_column & 0b010);
+        Context::digital_write(CATHODE_ADDR_PINA2, _next_column & 0b100);
+        Context::digital_write(CATHODE_ENABLE_PIN, CATHODE_ENABLE_LEVEL);
+
+        _column = _next_column;
+        _steps_count += 1;
+        _cycle_state = CycleState::READY;
+
+        return failed ? error::errcode::HWERROR : error::errcode::OK;
+    }
+
+template <typename C, typename S>
+unsigned long
+LedsDriver<C, S>::bus_time_left() const
+    {
+        /* first step is not preceded by @c on_column_end, where sharing drivers collect their transactions */
+        if (_cycle_state != CycleState::READY || _steps_count == 0)
+            { return 0; }
+        const unsigned long elapsed = Context::micros() - _last_step;
+        return elapsed < column_period() ? column_period() - elapsed : 0;
+    }
+
+template <typename C, typename S>
+bool
+LedsDriver<C, S>::mcps_finished(bool& failed) const
+    {
+        bool finished = true;
+        for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+            {
+                master_type& master = Context::i2c_master(static_cast<annode_driver>(i));
+                if (!master.finished())
+                    { finished = false; }
+                else if (master.has_error())
+                    { failed = true; }
+            }
+        return finished;
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::set_state(pads::Pad addr, pad_color state)
+    {
+        if (is_blind(addr) || !(addr < pads::Pad::__PADS_COUNT__))
+            { return error::errcode::INVALID_ARGUMENT | error::severity::WARNING; }
+
+        /* red led of bichrome pads is wired next to the green one */
+        const uint16_t mask = pads::is_bichrome(addr) ? 0b11 : 0b01;
+        write_bits(get_column(addr), annode_of(addr), mask, static_cast<uint16_t>(state));
+
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::set_state(analog::Encoder addr, ledring_state state)
+    {
+        if (is_blind(addr) || !(static_cast<uint8_t>(addr) < static_cast<uint8_t>(analog::Encoder::__ENCODERS_COUNT__)))
+            { return error::errcode::INVALID_ARGUMENT | error::severity::WARNING; }
+
+        /* bit 0 belongs to a push button led */
+        write_bits(get_column(addr), annode_pin{annode_of(addr), 0}, 0xFFFE, state.word());
+
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::get_state(pads::Pad addr, pad_color* state) const
+    {
+        if (nullptr == state || is_blind(addr) || !(addr < pads::Pad::__PADS_COUNT__))
+            { return error::errcode::INVALID_ARGUMENT | error::severity::WARNING; }
+
+        const annode_pin pin = annode_of(addr);
+        const uint16_t mask = pads::is_bichrome(addr) ? 0b11 : 0b01;
+        *state = static_cast<pad_color>((gpio_word(get_column(addr), pin.driver) >> pin.bit) & mask);
+
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::get_state(analog::Encoder addr, ledring_state* state) const
+    {
+        if (nullptr == state || is_blind(addr) || !(static_cast<uint8_t>(addr) < static_cast<uint8_t>(analog::Encoder::__ENCODERS_COUNT__)))
+            { return error::errcode::INVALID_ARGUMENT | error::severity::WARNING; }
+
+        const uint16_t word = gpio_word(get_column(addr), annode_of(addr)) & 0xFFFE;
+        if (word == 0)
+            { *state = ledring_state{0, 0}; }
+        else
+            {
+                const uint8_t start = __builtin_ctz(word) -1;
+                const uint8_t count = __builtin_popcount(word);
+                *state = ledring_state{start, count};
+            }
+
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::set_row(pads::PadRow row, const pad_color colors[COLUMNS_COUNT])
+    {
+        if (nullptr == colors || !(row < pads::PadRow::BankControl))
+            { return error::errcode::INVALID_ARGUMENT | error::severity::WARNING; }
+
+        const pads::Pad first = static_cast<pads::Pad>(static_cast<uint8_t>(row) << 3);
+        const annode_pin pin = annode_of(first);
+        const uint16_t mask = pads::is_bichrome(first) ? 0b11 : 0b01;
+
+        for (uint8_t x=0; x<COLUMNS_COUNT; ++x)
+            {
+                if (is_blind(static_cast<pads::Pad>(static_cast<uint8_t>(first) | x)))
+                    { continue; }
+                uint16_t& word = gpio_word(x, pin.driver);
+                word = (word & ~(mask << pin.bit)) | ((static_cast<uint16_t>(colors[x]) & mask) << pin.bit);
+            }
+        _dirty_columns = 0xFF;
+
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    uint16_t
+LedsDriver<C, S>::pack_clip_column(const pad_color colors[pads::CLIP_ROWS])
+    {
+        uint16_t bits = 0;
+        for (uint8_t y=0; y<pads::CLIP_ROWS; ++y)
+            { bits |= (static_cast<uint16_t>(colors[y]) & 0b11) << (2*y); }
+        return bits;
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::set_column(uint8_t column, const pad_color colors[pads::CLIP_ROWS])
+    {
+        if (nullptr == colors || COLUMNS_COUNT <= column)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::WARNING; }
+
+        uint16_t& word = gpio_word(column, annode_driver::PadsMatrix);
+        word = (word & ~CLIP_BITS_MASK) | pack_clip_column(colors);
+        _dirty_columns |= 1 << column;
+
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::set_matrix(const pad_color colors[pads::CLIP_ROWS][pads::CLIP_COLS])
+    {
+        if (nullptr == colors)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::WARNING; }
+
+        for (uint8_t x=0; x<pads::CLIP_COLS; ++x)
+            {
+                pad_color column[pads::CLIP_ROWS];
+                for (uint8_t y=0; y<pads::CLIP_ROWS; ++y)
+                    { column[y] = colors[y][x]; }
+
+                uint16_t& word = gpio_word(x, annode_driver::PadsMatrix);
+                word = (word & ~CLIP_BITS_MASK) | pack_clip_column(column);
+            }
+        _dirty_columns = 0xFF;
+
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::fill(rows_mask mask, pad_color color)
+    {
+        if (mask & ~(rows_mask_of(pads::PadRow::BankControl) -1))
+            { return error::errcode::INVALID_ARGUMENT | error::severity::WARNING; }
+
+        /* build per driver masks once, then apply them on every column */
+        uint16_t clear[ANNODE_DRIVER_COUNT] = {0};
+        uint16_t bits[ANNODE_DRIVER_COUNT] = {0};
+
+        for (uint8_t row=0; row<static_cast<uint8_t>(pads::PadRow::BankControl); ++row)
+            {
+                if (!(mask & (1 << row)))
+                    { continue; }
+
+                const pads::Pad first = static_cast<pads::Pad>(row << 3);
+                const annode_pin pin = annode_of(first);
+                const uint16_t leds = pads::is_bichrome(first) ? 0b11 : 0b01;
+                const uint8_t d = static_cast<uint8_t>(pin.driver);
+
+                clear[d] |= leds << pin.bit;
+                bits[d] |= (static_cast<uint16_t>(color) & leds) << pin.bit;
+            }
+
+        for (auto& column: _gpio_words)
+            for (size_t d=0; d<ANNODE_DRIVER_COUNT; ++d)
+                { column[d] = (column[d] & ~clear[d]) | bits[d]; }
+        _dirty_columns = 0xFF;
+
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+LedsDriver<C, S>::commit(const leds_frame& frame)
+    {
+        for (uint8_t c=0; c<MULTIPLEX_COLUMS_COUNT; ++c)
+            {
+                if (!(frame.columns & (1 << c)))
+                    { continue; }
+                for (size_t d=0; d<ANNODE_DRIVER_COUNT; ++d)
+                    { _gpio_words[c][d] = (_gpio_words[c][d] & ~frame.masks[c][d]) | frame.bits[c][d]; }
+            }
+        _dirty_columns |= frame.columns;
+
+        return error::status_byte{};
+    }
+
 } /* endof namespace leds_driver */
-} /* endof namespace hw */
\ No newline at end of file
+} /* endof namespace hw */
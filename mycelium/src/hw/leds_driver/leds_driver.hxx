@@ -5,7 +5,9 @@
 #ifndef DEF_LEDS_DRIVER_HXX
 #define DEF_LEDS_DRIVER_HXX
 
-#include "../../error.hxx"
+#include "error.hpp"
+#include "../hw_defines.hxx"
+#include "leds_types.hxx"
 
 #include <cstdint>
 #include <cstddef>
@@ -32,6 +34,12 @@ static constexpr const uint8_t CATHODE_ADDR_PINA1 = 10;
 static constexpr const uint8_t CATHODE_ADDR_PINA2 = 11;
 static constexpr const uint8_t CATHODE_ENABLE_PIN = 12;
 
+/**
+ * Level written on @c CATHODE_ENABLE_PIN to power the selected column,
+ *  CD74AC138 enable input is active low
+ */
+static constexpr const bool CATHODE_ENABLE_LEVEL = false;
+
 /**
  * 
  */
@@ -39,6 +47,103 @@ enum class annode_driver: uint8_t
     { LedsRingLow=0, LedsRingHigh=1, PushButtons=1, PadsMatrix=2 };
 static constexpr const size_t ANNODE_DRIVER_COUNT = 3;
 
+/**
+ * MCP23017 i2c address and registers, one chip per i2c bus,
+ *  registers are given for IOCON.BANK = 0 (power-on default)
+ */
+static constexpr const uint8_t MCP_I2C_ADDRESS  = 0x20;
+static constexpr const uint8_t MCP_IODIRA       = 0x00;
+static constexpr const uint8_t MCP_GPIOA        = 0x12;
+
+/**
+ * Location of a single led on the annodes drivers,
+ *  @c bit indexes the 16 bits GPIO word, GPIOA beeing the low significant byte
+ */
+struct annode_pin
+{
+    annode_driver driver;
+    uint8_t bit;
+};
+
+/**
+ * Returns where given pad's led is wired, @c red selects the second led of bichrome pads
+ *  - launch pads: green and red leds of row Y on bits 2Y and 2Y+1 of the pads MCP
+ *  - monochrome rows from clip stop to activator on the 6 remaining pads MCP bits
+ *  - device control and track control pads on the free bit 0 of the led-rings MCPs
+ * @warning result is meaningless for blind pads
+ */
+static constexpr annode_pin annode_of(pads::Pad p, bool red=false)
+    {
+        const uint8_t row = static_cast<uint8_t>(get_row(p));
+        if (pads::is_bichrome(p))
+            { return {annode_driver::PadsMatrix, static_cast<uint8_t>(2*row + (red ? 1 : 0))}; }
+        if (row <= static_cast<uint8_t>(pads::PadRow::Activator))
+            { return {annode_driver::PadsMatrix, static_cast<uint8_t>(row + pads::CLIP_ROWS)}; }
+        if (row == static_cast<uint8_t>(pads::PadRow::DeviceControl))
+            { return {annode_driver::PushButtons, 0}; }
+        return {annode_driver::LedsRingLow, 0};
+    }
+
+/**
+ * Returns the MCP driving given encoder's led-ring, leds uses bits 1 to 15
+ */
+static constexpr annode_driver annode_of(analog::Encoder e)
+    {
+        return get_row(e) == analog::EncoderGroup::Pan
+            ? annode_driver::LedsRingLow
+            : annode_driver::LedsRingHigh;
+    }
+
+static_assert(annode_of(pads::Pad::CLIP_4_3, true).bit == 9);
+static_assert(annode_of(pads::Pad::ACTIVATOR_0).bit == 15);
+static_assert(annode_of(pads::Pad::METRONOME).driver == annode_driver::PushButtons);
+static_assert(annode_of(pads::Pad::SEND_C).driver == annode_driver::LedsRingLow);
+
+/**
+ * Bitmask of pads rows, bit N selects @c PadRow N, used for bulk updates
+ */
+using rows_mask = uint16_t;
+
+static constexpr rows_mask rows_mask_of(pads::PadRow row)
+    { return static_cast<rows_mask>(1) << static_cast<uint8_t>(row); }
+
+static constexpr const rows_mask CLIP_ROWS_MASK = (1 << pads::CLIP_ROWS) -1;
+
+/**
+ * Staged leds edits, applied at once by @c LedsDriver::commit
+ *  so that a burst of changes marks each edited column dirty a single time,
+ *  later edits of a led override earlier ones
+ */
+struct leds_frame
+{
+    uint16_t masks[MULTIPLEX_COLUMS_COUNT][ANNODE_DRIVER_COUNT];    ///< edited bits per annode word
+    uint16_t bits[MULTIPLEX_COLUMS_COUNT][ANNODE_DRIVER_COUNT];     ///< new value of edited bits
+    uint8_t columns;                                                ///< one bit per edited column
+
+    leds_frame(): masks{}, bits{}, columns{0}     {}
+
+    /** Drops every staged edit, only edited columns are cleared */
+    void clear();
+
+    bool is_empty() const           { return columns == 0; }
+
+    /**
+     * Stages the state of a single object, same rules as @c LedsDriver::set_state:
+     *  returns false and ignores the edit for blind and out of range objects
+     */
+    bool set(pads::Pad addr, pad_color state);
+    bool set(analog::Encoder addr, ledring_state state);
+
+private:
+    void stage(uint8_t column, annode_pin pin, uint16_t mask, uint16_t value)
+        {
+            masks[column][static_cast<uint8_t>(pin.driver)] |= mask << pin.bit;
+            uint16_t& word = bits[column][static_cast<uint8_t>(pin.driver)];
+            word = (word & ~(mask << pin.bit)) | ((value & mask) << pin.bit);
+            columns |= 1 << column;
+        }
+}; /* endof struct leds_frame */
+
 /**
  * 
  */
@@ -46,14 +151,20 @@ struct DriverDefaultSettings
 {
     /**
      * Target frequency to refresh whole device ouputs in Hz
-     * 
+     *
      *  Will be multiplied by multiplexer buses count (columns count)
      *      to obtain the update rate for the driver, @c LedsDriver::update
-     * 
+     *
      *  @note defaults to 50Hz, leading to an update rate of 400Hz
      * */
     static unsigned long RefreshRate;
 
+    /**
+     * Clock of the three i2c buses in Hz
+     *  @note defaults to 400kHz, MCP23017 accepts up to 1.7MHz
+     */
+    static unsigned long I2CFrequency;
+
     /**
      * Filters out logs below given severity
      * @note defaults to @c error::severity::DEBUG if macro NDEBUG is undefined
@@ -63,32 +174,104 @@ struct DriverDefaultSettings
 };
 
 /**
- * 
+ * Multiplexed leds driver, each column step blanks the cathodes,
+ *  writes the column annodes on the three MCPs (one per bus, in parallel),
+ *  then selects and powers the new column.
+ *
+ * Context must provide the following static members:
+ *  - @c master_type: i2c master following teensy4_i2c @c I2CMaster interface
+ *  - @c master_type& i2c_master(annode_driver)
+ *  - @c void pin_mode_output(uint8_t pin)
+ *  - @c void digital_write(uint8_t pin, bool level)
+ *  - @c unsigned long micros()
  */
-template <typename _Settings=DriverDefaultSettings, typename _Context>
+template <typename _Context, typename _Settings=DriverDefaultSettings>
 class LedsDriver
 {
 public:
     using Settings = _Settings;
     using Context = _Context;
+    using master_type = typename Context::master_type;
+
+    LedsDriver();
 
+    /**
+     * Configures cathode pins and launches MCPs configuration,
+     *  refresh starts once every MCP acknowledged it's configuration
+     */
     error::status_byte setup();
-    error::status_byte update();
+
+    /**
+     * Advances the refresh cycle, never blocks and should be called on each loop,
+     *  returns an HWERROR if an i2c transaction failed
+     */
+    error::status_byte update()         { return update([](uint8_t) {}); }
+
+    /**
+     * Same as @c update, calling @c on_column_end(column) at the end of each column step:
+     *  the column is still selected and powered, right before it gets blanked.
+     *  Used to share the column addressing with the inputs scan.
+     */
+    template <typename StepFn>
+    error::status_byte update(StepFn&& on_column_end);
 
     /**
      * Changes state of a single object
      */
-    template <typename Address, typename State>
-    error::status_byte set_state(Address addr, State state);
+    error::status_byte set_state(pads::Pad addr, pad_color state);
+    error::status_byte set_state(analog::Encoder addr, ledring_state state);
+
+    error::status_byte get_state(pads::Pad addr, pad_color* state) const;
+    error::status_byte get_state(analog::Encoder addr, ledring_state* state) const;
+
+    /**
+     * Region updates: writes packed annode words directly
+     *  and marks dirty columns once for the whole region
+     */
+    error::status_byte set_row(pads::PadRow row, const pad_color colors[COLUMNS_COUNT]);
 
-    template <typename Address, typename State>
-    error::status_byte get_state(Address addr, State* state);
+    /** Changes a column of the launch pads matrix, @c CLIP_Y_X[0..4][column] */
+    error::status_byte set_column(uint8_t column, const pad_color colors[pads::CLIP_ROWS]);
+
+    /** Redraws the whole launch pads matrix, indexed as @c CLIP_Y_X */
+    error::status_byte set_matrix(const pad_color colors[pads::CLIP_ROWS][pads::CLIP_COLS]);
+
+    /**
+     * Sets every led of given rows to a single color,
+     *  monochrome rows uses @c pad_color::ON channel
+     * @note bits wired to blind pads are written too, which is harmless
+     */
+    error::status_byte fill(rows_mask mask, pad_color color);
+
+    /**
+     * Applies every edit staged in @c frame,
+     *  edited columns are published together on their next step
+     */
+    error::status_byte commit(const leds_frame& frame);
+
+    /** Returns index of the last powered column */
+    uint8_t column() const              { return _column; }
+
+    /**
+     * Returns time in us the i2c buses stay unused before the next column step,
+     *  zero until the first column is powered and while writing a column.
+     *  Other devices sharing a bus may use it meanwhile, collecting their transactions in @c on_column_end
+     */
+    unsigned long bus_time_left() const;
+
+    /** Returns count of column steps since setup, used to compute achieved rates */
+    unsigned long steps_count() const   { return _steps_count; }
 
 private:
     static const uint8_t WRITE_BUFFER_SIZE = 3;
 
+    static constexpr const uint8_t MCP_CONFIGURATION[WRITE_BUFFER_SIZE] = {
+        MCP_IODIRA, 0x00, 0x00  /* all pins as outputs */
+    };
+
     enum class CycleState: uint8_t
     {
+        CONFIGURING,        ///< Waiting for MCPs registers configuration
         READY,              ///< Driver is ready to begin a new cycle
         UPDATING_GPIOS,     ///< Writing GPIOS for all MCPs
         ENDING,             ///< Waiting for transmition ACK
@@ -98,8 +281,47 @@ private:
     error::errcode update_mcps();
     error::errcode end_cycle();
 
+    /** Returns true if every MCP transaction is done, @c failed is set on i2c error */
+    bool mcps_finished(bool& failed) const;
+
+    /** Period between two column steps in microseconds */
+    unsigned long column_period() const
+        { return 1000000UL / (Settings::RefreshRate * MULTIPLEX_COLUMS_COUNT); }
+
+    uint16_t& gpio_word(uint8_t column, annode_driver driver)
+        { return _gpio_words[column][static_cast<uint8_t>(driver)]; }
+    uint16_t gpio_word(uint8_t column, annode_driver driver) const
+        { return _gpio_words[column][static_cast<uint8_t>(driver)]; }
+
+    /** Writes given bits of a single annode word and marks it's column dirty */
+    void write_bits(uint8_t column, annode_pin pin, uint16_t mask, uint16_t bits)
+        {
+            uint16_t& word = gpio_word(column, pin.driver);
+            word = (word & ~(mask << pin.bit)) | ((bits & mask) << pin.bit);
+            _dirty_columns |= 1 << column;
+        }
+
+    /** Bits of the launch pads on the pads MCP word */
+    static constexpr const uint16_t CLIP_BITS_MASK = (1 << (2 * pads::CLIP_ROWS)) -1;
+
+    /** Packs launch pads colors of a column, row Y on bits 2Y and 2Y+1 */
+    static uint16_t pack_clip_column(const pad_color colors[pads::CLIP_ROWS]);
+
+    /**
+     * Leds state as packed GPIO words, edited by setters,
+     *  copied into the transmit buffer when a dirty column is about to be written
+     */
+    uint16_t _gpio_words[MULTIPLEX_COLUMS_COUNT][ANNODE_DRIVER_COUNT];
+    uint8_t _dirty_columns;     ///< one bit per column edited since it's last transmission
+
     uint8_t _mcp_write_buffer[MULTIPLEX_COLUMS_COUNT][ANNODE_DRIVER_COUNT][WRITE_BUFFER_SIZE];
-    
+
+    CycleState _cycle_state;
+    uint8_t _column;            ///< last powered column
+    uint8_t _next_column;       ///< column beeing written
+    uint8_t _pending_writes;    ///< bitmask of MCPs not written yet for this step
+    unsigned long _last_step;   ///< timestamp of last step begin in us
+    unsigned long _steps_count;
 
 }; /* endof class LedsDriver */
 
@@ -108,4 +330,4 @@ private:
 
 #include "leds_driver.hpp"
 
-#endif /* DEF_LEDS_DRIVER_HXX */
\ No newline at end of file
+#endif /* DEF_LEDS_DRIVER_HXX */
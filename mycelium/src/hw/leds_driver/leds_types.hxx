@@ -44,7 +44,7 @@ struct ledring_state
     constexpr uint16_t word() const
     {
         return
-            (static_cast<uint32_t>(0x01) << (start+count+1))-1  /* 0...0_start+count << 1...1 */
+            ((static_cast<uint32_t>(0x01) << (start+count+1))-1)/* 0...0_start+count << 1...1 */
             &
             ~((static_cast<uint32_t>(0x01) << (start+1))-1)     /* 1...1 << start_0...0 */
         ;
@@ -73,9 +73,9 @@ struct ledring_state
 static_assert(sizeof(ledring_state) == sizeof(uint8_t));
 
 static_assert(ledring_state{0,0}.word()     == 0x0);    /* 0 */
-static_assert(ledring_state{0,0xFF}.word()  == 0xFFFE); /* 0b1111'1111'1111'111_ */
+static_assert(ledring_state{0,0x0F}.word()  == 0xFFFE); /* 0b1111'1111'1111'111_ */
 static_assert(ledring_state{3,5}.word()     == 0x01F0); /* 0b0000'0001'1111'000_ */
-static_assert(ledring_state{0xFF,5}.word()  == 0x0);    /* 0 */
+static_assert(ledring_state{0x0F,5}.word()  == 0x0);    /* 0 */
 static_assert(ledring_state::center().word()== 0x0100); /* 0b0000'0001'0000'000_ */
 
 // /**
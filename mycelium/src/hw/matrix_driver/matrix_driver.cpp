@@ -0,0 +1,15 @@
+/**
+ * 
+ */
+
+#include "matrix_driver.hxx"
+
+namespace hw
+{
+namespace matrix_driver
+{
+
+unsigned long DriverDefaultSettings::RefreshRate = 250;
+
+} /* endof namespace matrix_driver */
+} /* endof namespace hw */
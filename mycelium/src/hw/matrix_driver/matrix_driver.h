@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "matrix_driver.hxx"
@@ -0,0 +1,83 @@
+/**
+ * 
+ */
+
+#include "matrix_driver.hxx"
+
+namespace hw
+{
+namespace matrix_driver
+{
+
+template <typename C, typename S>
+MatrixDriver<C, S>::MatrixDriver()
+    : _leds{}, _debouncer{}, _edges{}, _samples_count{0},
+    _window_begin{0}, _window_steps{0}, _window_samples{0}, _refresh_rate{0}, _scan_rate{0}
+    {}
+
+template <typename C, typename S>
+    error::status_byte
+MatrixDriver<C, S>::setup()
+    {
+        for (auto pin: pads_driver::ROWS_PINS)
+            { Context::pin_mode_input_pullup(pin); }
+
+        _debouncer.reset();
+        _edges.clear();
+        _samples_count = 0;
+
+        const error::status_byte status = _leds.setup();
+
+        _window_begin = Context::micros();
+        _window_steps = _window_samples = 0;
+        _refresh_rate = _scan_rate = 0;
+        return status;
+    }
+
+template <typename C, typename S>
+    error::status_byte
+MatrixDriver<C, S>::update()
+    {
+        const error::status_byte status = _leds.update([this](uint8_t column) { sample(column); });
+        measure_rates();
+        return status;
+    }
+
+template <typename C, typename S>
+void
+MatrixDriver<C, S>::sample(uint8_t column)
+    {
+        const uint16_t levels = Context::read_rows();
+        const uint16_t pressed = pads_driver::ROW_PRESSED_LEVEL ? levels : ~levels;
+        const uint16_t edges = _debouncer.feed(column, pressed);
+        _edges.push(column, edges);
+        pads_driver::mark_lanes(column, _debouncer.started(column), latency::stage::ScanSample);
+        pads_driver::mark_lanes(column, edges, latency::stage::DebounceEdge);
+        _samples_count += 1;
+    }
+
+template <typename C, typename S>
+void
+MatrixDriver<C, S>::measure_rates()
+    {
+        const unsigned long now = Context::micros();
+        const unsigned long elapsed = now - _window_begin;
+        if (elapsed < RATES_WINDOW_US)
+            { return; }
+
+        /* leds steps counter is reset by setup retries */
+        const unsigned long steps = _leds.steps_count();
+        if (steps < _window_steps)
+            { _window_steps = 0; }
+
+        const float frames_us = static_cast<float>(elapsed) * leds_driver::MULTIPLEX_COLUMS_COUNT;
+        _refresh_rate = (steps - _window_steps) * 1e6f / frames_us;
+        _scan_rate = (_samples_count - _window_samples) * 1e6f / frames_us;
+
+        _window_begin = now;
+        _window_steps = steps;
+        _window_samples = _samples_count;
+    }
+
+} /* endof namespace matrix_driver */
+} /* endof namespace hw */
@@ -0,0 +1,111 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MATRIX_DRIVER_HXX
+#define DEF_MATRIX_DRIVER_HXX
+
+#include "error.hpp"
+#include "../hw_defines.hxx"
+#include "../leds_driver/leds_driver.hxx"
+#include "../pads_driver/pads_driver.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace hw
+{
+namespace matrix_driver
+{
+
+/**
+ * Achieved rates are measured over windows of at least this duration in microseconds
+ */
+static constexpr const unsigned long RATES_WINDOW_US = 250000;
+
+/**
+ * Leds driver settings, with a refresh rate fast enough to debounce the pads
+ */
+struct DriverDefaultSettings: public leds_driver::DriverDefaultSettings
+{
+    /**
+     * Target frequency to refresh whole leds and to scan whole pads in Hz
+     *
+     *  @note defaults to 250Hz: a pad is sampled every 4ms, debounced in 12 to 16ms,
+     *      where the 50Hz of the standalone leds driver would take up to 80ms
+     */
+    static unsigned long RefreshRate;
+};
+
+/**
+ * Column-synchronous leds refresh and pads scan:
+ *  the column addressing pins are common to cathodes and input sinks,
+ *  so a single pipeline stage per column step selects the column, latches the annodes,
+ *  samples the input rows once the column has been powered for a whole step, then advances.
+ *  Columns are switched once per step for both jobs and the scan rate follows the refresh rate.
+ *
+ * Context must provide the members required by both @c leds_driver::LedsDriver
+ *  and @c pads_driver::PadsDriver
+ */
+template <typename _Context, typename _Settings=DriverDefaultSettings>
+class MatrixDriver
+{
+public:
+    using Settings = _Settings;
+    using Context = _Context;
+    using leds_type = leds_driver::LedsDriver<Context, Settings>;
+
+    MatrixDriver();
+
+    /**
+     * Configures rows as inputs and starts the leds driver,
+     *  scan starts with the first powered column
+     */
+    error::status_byte setup();
+
+    /**
+     * Advances the pipeline, never blocks and should be called on each loop,
+     *  returns leds driver errors
+     */
+    error::status_byte update();
+
+    /** Pops next debounced pad edge, returns false if none */
+    bool poll(pads_driver::pad_event& event)    { return _edges.pop(_debouncer, event); }
+
+    leds_type& leds()                                   { return _leds; }
+    const leds_type& leds() const                       { return _leds; }
+    const pads_driver::Debouncer& debouncer() const     { return _debouncer; }
+
+    /** Achieved frequencies of whole leds refreshes and whole pads scans, in Hz */
+    float refresh_rate() const      { return _refresh_rate; }
+    float scan_rate() const         { return _scan_rate; }
+
+    /** Count of sampled columns since setup */
+    unsigned long samples_count() const     { return _samples_count; }
+
+private:
+    /** Samples the rows sunk by the powered column */
+    void sample(uint8_t column);
+
+    /** Refreshes achieved rates once the measure window elapsed */
+    void measure_rates();
+
+    leds_type _leds;
+    pads_driver::Debouncer _debouncer;
+    pads_driver::EdgesQueue _edges;
+
+    unsigned long _samples_count;
+
+    unsigned long _window_begin;    ///< timestamp of current measure window in us
+    unsigned long _window_steps;    ///< leds column steps at window begin
+    unsigned long _window_samples;  ///< sampled columns at window begin
+    float _refresh_rate;
+    float _scan_rate;
+};
+
+} /* endof namespace matrix_driver */
+} /* endof namespace hw */
+
+#include "matrix_driver.hpp"
+
+#endif /* DEF_MATRIX_DRIVER_HXX */
@@ -0,0 +1,15 @@
+/**
+ * 
+ */
+
+#include "pads_driver.hxx"
+
+namespace hw
+{
+namespace pads_driver
+{
+
+unsigned long DriverDefaultSettings::ScanRate = 250;
+
+} /* endof namespace pads_driver */
+} /* endof namespace hw */
\ No newline at end of file
@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "pads_driver.hxx"
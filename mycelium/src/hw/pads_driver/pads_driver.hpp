@@ -0,0 +1,74 @@
+/**
+ * 
+ */
+
+#include "pads_driver.hxx"
+
+namespace hw
+{
+namespace pads_driver
+{
+
+template <typename C, typename S>
+PadsDriver<C, S>::PadsDriver()
+    : _debouncer{}, _edges{}, _column{0}, _last_step{0}, _steps_count{0}
+    {}
+
+template <typename C, typename S>
+    error::status_byte
+PadsDriver<C, S>::setup()
+    {
+        Context::pin_mode_output(SINK_ADDR_PINA0);
+        Context::pin_mode_output(SINK_ADDR_PINA1);
+        Context::pin_mode_output(SINK_ADDR_PINA2);
+        for (auto pin: ROWS_PINS)
+            { Context::pin_mode_input_pullup(pin); }
+
+        _debouncer.reset();
+        _edges.clear();
+
+        _column = 0;
+        Context::digital_write(SINK_ADDR_PINA0, false);
+        Context::digital_write(SINK_ADDR_PINA1, false);
+        Context::digital_write(SINK_ADDR_PINA2, false);
+
+        _steps_count = 0;
+        _last_step = Context::micros();
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+PadsDriver<C, S>::update()
+    {
+        const unsigned long now = Context::micros();
+        const unsigned long period = column_period();
+        if (now - _last_step < period)
+            { return error::status_byte{}; }
+
+        /* keep a steady rate, but do not try to catch up if late by more than a step */
+        _last_step = (now - _last_step < 2 * period) ? _last_step + period : now;
+        step();
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+void
+PadsDriver<C, S>::step()
+    {
+        const uint16_t levels = Context::read_rows();
+        const uint16_t pressed = ROW_PRESSED_LEVEL ? levels : ~levels;
+        const uint16_t edges = _debouncer.feed(_column, pressed);
+        _edges.push(_column, edges);
+        mark_lanes(_column, _debouncer.started(_column), latency::stage::ScanSample);
+        mark_lanes(_column, edges, latency::stage::DebounceEdge);
+
+        _column = (_column + 1) & leds_driver::MULTIPLEX_COLUMN_BITMASK;
+        Context::digital_write(SINK_ADDR_PINA0, _column & 0b001);
+        Context::digital_write(SINK_ADDR_PINA1, _column & 0b010);
+        Context::digital_write(SINK_ADDR_PINA2, _column & 0b100);
+        _steps_count += 1;
+    }
+
+} /* endof namespace pads_driver */
+} /* endof namespace hw */
\ No newline at end of file
@@ -0,0 +1,267 @@
+/**
+ * 
+ */
+
+#ifndef DEF_PADS_DRIVER_HXX
+#define DEF_PADS_DRIVER_HXX
+
+#include "error.hpp"
+#include "../hw_defines.hxx"
+#include "../leds_driver/leds_driver.hxx"
+#include "../../utils/latency/latency.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace hw
+{
+namespace pads_driver
+{
+
+/**
+ * Rows sources pins, row R of @c pads::PadRow is read on pin 26+R
+ */
+static constexpr const uint8_t ROWS_COUNT = static_cast<uint8_t>(pads::PadRow::__ROWS_COUNT__);
+static constexpr const uint8_t ROWS_PINS[ROWS_COUNT] = {
+    26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39
+};
+
+/**
+ * Sinks are selected by the columns addressing pins shared with leds cathodes
+ */
+static constexpr const uint8_t SINK_ADDR_PINA0 = leds_driver::CATHODE_ADDR_PINA0;
+static constexpr const uint8_t SINK_ADDR_PINA1 = leds_driver::CATHODE_ADDR_PINA1;
+static constexpr const uint8_t SINK_ADDR_PINA2 = leds_driver::CATHODE_ADDR_PINA2;
+
+/**
+ * Rows are pulled up, a pressed pad sinks it's row through the selected column
+ */
+static constexpr const bool ROW_PRESSED_LEVEL = false;
+
+/**
+ * Debounced press or release of a single pad
+ */
+struct pad_event
+{
+    pads::Pad pad;
+    bool pressed;
+};
+
+/**
+ * Bit-parallel debouncer using vertical counters:
+ *  each column holds one lane per row, all lanes of a sampled column are debounced at once
+ *  and a lane toggles after 4 consecutive samples differing from it's stable state.
+ * 
+ * Cost of @c feed is constant, whatever the number of held or bouncing pads.
+ */
+class Debouncer
+{
+public:
+    using word_type = uint16_t;     /**< bit R is the lane of @c PadRow R */
+
+    static constexpr const word_type ROWS_BITMASK = (1 << ROWS_COUNT) -1;
+    static constexpr const uint8_t SAMPLES_COUNT = 4;
+
+    Debouncer()
+        : _stable{}, _cnt0{}, _cnt1{}
+        {}
+
+    /**
+     * Feeds a sampled column, bit R of @c pressed is true if pad of row R is down
+     *  returns the lanes which debounced state toggled: press or release edges
+     */
+    word_type feed(uint8_t column, word_type pressed)
+        {
+            column &= leds_driver::MULTIPLEX_COLUMN_BITMASK;
+            const word_type delta = (pressed & ROWS_BITMASK) ^ _stable[column];
+
+            /* 2 bits counters, reset on lanes matching stable state */
+            _cnt1[column] = (_cnt1[column] ^ _cnt0[column]) & delta;
+            _cnt0[column] = ~_cnt0[column] & delta;
+
+            /* counters wrapped: 4 samples in a row differed */
+            const word_type toggle = delta & ~(_cnt0[column] | _cnt1[column]);
+            _stable[column] ^= toggle;
+            return toggle;
+        }
+
+    /**
+     * Returns lanes of a column which last sample was the first one
+     *  differing from their debounced state
+     */
+    word_type started(uint8_t column) const
+        {
+            column &= leds_driver::MULTIPLEX_COLUMN_BITMASK;
+            return _cnt0[column] & ~_cnt1[column];
+        }
+
+    /** Returns debounced state of a column, bit R set if pad of row R is down */
+    word_type column_state(uint8_t column) const
+        { return _stable[column & leds_driver::MULTIPLEX_COLUMN_BITMASK]; }
+
+    /** Returns debounced state of a row, bit X set if pad of column X is down */
+    uint8_t row_state(pads::PadRow row) const
+        {
+            uint8_t result = 0;
+            for (uint8_t x=0; x<COLUMNS_COUNT; ++x)
+                { result |= ((_stable[x] >> static_cast<uint8_t>(row)) & 0x01) << x; }
+            return result;
+        }
+
+    bool is_pressed(pads::Pad pad) const
+        { return (_stable[get_column(pad)] >> static_cast<uint8_t>(get_row(pad))) & 0x01; }
+
+    void reset()
+        {
+            for (uint8_t x=0; x<COLUMNS_COUNT; ++x)
+                { _stable[x] = _cnt0[x] = _cnt1[x] = 0; }
+        }
+
+private:
+    word_type _stable[COLUMNS_COUNT];
+    word_type _cnt0[COLUMNS_COUNT];
+    word_type _cnt1[COLUMNS_COUNT];
+};
+
+/**
+ * Pending debounced edges, accumulated by columns until polled by the main loop
+ * @note a press and release both happening between two polls cancel each other,
+ *  which can't happen as long as the loop polls faster than the debounce delay
+ */
+class EdgesQueue
+{
+public:
+    using word_type = Debouncer::word_type;
+
+    EdgesQueue()
+        : _edges{}, _pending{0}
+        {}
+
+    void push(uint8_t column, word_type edges)
+        {
+            column &= leds_driver::MULTIPLEX_COLUMN_BITMASK;
+            _edges[column] ^= edges;
+            _pending = _edges[column] ? _pending | (1 << column) : _pending & ~(1 << column);
+        }
+
+    bool is_empty() const           { return _pending == 0; }
+
+    /**
+     * Pops next edge, reading pressed state from the debouncer,
+     *  returns false if there is no pending edge
+     */
+    bool pop(const Debouncer& debouncer, pad_event& event)
+        {
+            if (_pending == 0)
+                { return false; }
+
+            const uint8_t column = __builtin_ctz(_pending);
+            const uint8_t row = __builtin_ctz(_edges[column]);
+            _edges[column] &= _edges[column] -1;
+            if (_edges[column] == 0)
+                { _pending &= ~(1 << column); }
+
+            event.pad = static_cast<pads::Pad>((row << 3) | column);
+            event.pressed = debouncer.is_pressed(event.pad);
+            LATENCY_MARK(static_cast<uint8_t>(event.pad), EventQueue);
+            return true;
+        }
+
+    void clear()
+        {
+            for (auto& e: _edges) { e = 0; }
+            _pending = 0;
+        }
+
+private:
+    word_type _edges[COLUMNS_COUNT];
+    uint8_t _pending;   ///< one bit per column with pending edges
+};
+
+/**
+ * Marks a latency stage for every pad of @c lanes in given column
+ */
+static inline void mark_lanes(uint8_t column, uint16_t lanes, latency::stage s)
+    {
+#ifdef MYCELIUM_LATENCY_PROBES
+        if (!latency::probe)
+            { return; }
+        for (; lanes; lanes &= lanes -1)
+            { latency::probe((__builtin_ctz(lanes) << 3) | column, s); }
+#endif
+    }
+
+/**
+ * 
+ */
+struct DriverDefaultSettings
+{
+    /**
+     * Target frequency to scan whole pads matrix in Hz
+     *  multiplied by columns count to obtain the column step rate
+     *
+     *  @note defaults to 250Hz: a pad is sampled every 4ms, debounced in 12 to 16ms
+     */
+    static unsigned long ScanRate;
+};
+
+/**
+ * Standalone pads scanner, selects a sink column on each step
+ *  and reads the rows of the column selected by the previous step,
+ *  leaving a whole step for the lines to settle.
+ * @note the columns addressing is shared with the leds cathodes,
+ *  use @c matrix_driver::MatrixDriver to scan pads while the leds are refreshed
+ * 
+ * Context must provide the following static members:
+ *  - @c void pin_mode_output(uint8_t pin)
+ *  - @c void pin_mode_input_pullup(uint8_t pin)
+ *  - @c void digital_write(uint8_t pin, bool level)
+ *  - @c uint16_t read_rows(): bit R is the level of @c ROWS_PINS[R]
+ *  - @c unsigned long micros()
+ */
+template <typename _Context, typename _Settings=DriverDefaultSettings>
+class PadsDriver
+{
+public:
+    using Settings = _Settings;
+    using Context = _Context;
+
+    PadsDriver();
+
+    error::status_byte setup();
+
+    /**
+     * Runs a column step if it's time to, never blocks
+     */
+    error::status_byte update();
+
+    /**
+     * Samples selected column and selects next one,
+     *  used by @c update and by callers sequencing columns themselves
+     */
+    void step();
+
+    /** Pops next debounced edge, returns false if none */
+    bool poll(pad_event& event)     { return _edges.pop(_debouncer, event); }
+
+    const Debouncer& debouncer() const          { return _debouncer; }
+    unsigned long steps_count() const           { return _steps_count; }
+
+private:
+    unsigned long column_period() const
+        { return 1000000UL / (Settings::ScanRate * COLUMNS_COUNT); }
+
+    Debouncer _debouncer;
+    EdgesQueue _edges;
+
+    uint8_t _column;            ///< currently selected column
+    unsigned long _last_step;
+    unsigned long _steps_count;
+};
+
+} /* endof namespace pads_driver */
+} /* endof namespace hw */
+
+#include "pads_driver.hpp"
+
+#endif /* DEF_PADS_DRIVER_HXX */
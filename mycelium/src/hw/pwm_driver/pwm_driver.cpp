@@ -0,0 +1,16 @@
+/**
+ * 
+ */
+
+#include "pwm_driver.hxx"
+
+namespace hw
+{
+namespace pwm_driver
+{
+
+unsigned long PwmDefaultSettings::PwmFrequency = 1526;
+unsigned long PwmDefaultSettings::I2CFrequency = 400000;
+
+} /* endof namespace pwm_driver */
+} /* endof namespace hw */
@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "pwm_driver.hxx"
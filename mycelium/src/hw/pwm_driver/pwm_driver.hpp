@@ -0,0 +1,187 @@
+/**
+ * 
+ */
+
+#include "pwm_driver.hxx"
+
+namespace hw
+{
+namespace pwm_driver
+{
+
+template <typename C, typename S>
+PwmDriver<C, S>::PwmDriver()
+    : _values{}, _dirty{0}, _in_flight{0}, _configuration{}, _write_buffer{},
+    _state{DriverState::CONFIGURING}, _pending{false}, _step{0}, _woken{0}, _counters{}
+    {}
+
+template <typename C, typename S>
+    error::status_byte
+PwmDriver<C, S>::setup()
+    {
+        /* sleep is required to write the prescaler, waking up enables the outputs */
+        const uint8_t configuration[CONFIGURATION_STEPS][2] = {
+            {PCA_MODE1, PCA_MODE1_SLEEP | PCA_MODE1_AI},
+            {PCA_PRE_SCALE, prescale_of(Settings::PwmFrequency)},
+            {PCA_MODE2, PCA_MODE2_OUTDRV},
+            {PCA_MODE1, PCA_MODE1_AI},
+        };
+        for (uint8_t i=0; i<CONFIGURATION_STEPS; ++i)
+            {
+                _configuration[i][0] = configuration[i][0];
+                _configuration[i][1] = configuration[i][1];
+            }
+
+        /* registers content is unknown, whole cache is written once configured */
+        _dirty = static_cast<channels_mask>((1UL << PWM_CHANNELS_COUNT) -1);
+        _in_flight = 0;
+        _state = DriverState::CONFIGURING;
+        _step = 0;
+        _counters = pwm_counters{};
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+PwmDriver<C, S>::update(unsigned long budget)
+    {
+        master_type& master = Context::i2c_master();
+
+        /* own transaction is collected before anything else uses the bus */
+        if (_pending)
+            {
+                if (!master.finished())
+                    { return error::status_byte{}; }
+                _pending = false;
+
+                if (master.has_error())
+                    {
+                        _counters.errors += 1;
+                        if (_state == DriverState::CONFIGURING)
+                            {
+                                /* chip might not be powered yet, retry whole configuration */
+                                _step = 0;
+                            }
+                        else
+                            {
+                                _dirty |= _in_flight;
+                                _in_flight = 0;
+                                _state = DriverState::READY;
+                            }
+                        return error::errcode::HWERROR | error::severity::ERROR;
+                    }
+
+                if (_state == DriverState::WRITING)
+                    {
+                        _in_flight = 0;
+                        _state = DriverState::READY;
+                    }
+                else if (_state == DriverState::CONFIGURING && _step == CONFIGURATION_STEPS)
+                    {
+                        _woken = Context::micros();
+                        _state = DriverState::WAKING;
+                    }
+            }
+
+        switch (_state)
+        {
+        case DriverState::CONFIGURING:
+            if (master.finished() && transaction_time(2) <= budget)
+                { configure(); }
+            return error::status_byte{};
+
+        case DriverState::WAKING:
+            if (Context::micros() - _woken < PCA_OSCILLATOR_STARTUP)
+                { return error::status_byte{}; }
+            _state = DriverState::READY;
+            break;
+
+        case DriverState::READY:
+            break;
+
+        case DriverState::WRITING:
+            return error::status_byte{};
+
+        default:
+            return error::errcode::INVALID_STATE | error::severity::CRITICAL;
+        }
+
+        /* bus is free: next burst starts right away, if a channel fits in the time left */
+        if (_dirty != 0 && master.finished() && transaction_time(1 + PCA_REGISTERS_PER_CHANNEL) <= budget)
+            { write_burst(budget); }
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+PwmDriver<C, S>::set(uint8_t channel, uint16_t value)
+    {
+        if (PWM_CHANNELS_COUNT <= channel || PWM_FULL_ON < value)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+        if (_values[channel] == value)
+            { return error::status_byte{}; }
+        _values[channel] = value;
+        _dirty |= static_cast<channels_mask>(1 << channel);
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+PwmDriver<C, S>::set(uint8_t first, const uint16_t* values, uint8_t count)
+    {
+        if (PWM_CHANNELS_COUNT < first + count)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+        for (uint8_t i=0; i<count; ++i)
+            {
+                if (PWM_FULL_ON < values[i])
+                    { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+            }
+        for (uint8_t i=0; i<count; ++i)
+            { set(first + i, values[i]); }
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+void
+PwmDriver<C, S>::configure()
+    {
+        Context::i2c_master().write_async(PCA_I2C_ADDRESS, _configuration[_step], 2, true);
+        _counters.bytes += 3;
+        _step += 1;
+        _pending = true;
+    }
+
+template <typename C, typename S>
+void
+PwmDriver<C, S>::write_burst(unsigned long budget)
+    {
+        uint8_t first = 0;
+        while (!(_dirty & (1 << first)))
+            { first += 1; }
+        uint8_t last = first;
+        while (last + 1 < PWM_CHANNELS_COUNT && (_dirty & (1 << (last + 1)))
+            && transaction_time(1 + (last + 2 - first) * PCA_REGISTERS_PER_CHANNEL) <= budget)
+            { last += 1; }
+
+        /* values are copied, so that they can change while the burst is on the wire */
+        _write_buffer[0] = PCA_LED0_ON_L + first * PCA_REGISTERS_PER_CHANNEL;
+        uint8_t* registers = _write_buffer + 1;
+        for (uint8_t c=first; c<=last; ++c)
+            {
+                encode_channel(c, _values[c], registers);
+                registers += PCA_REGISTERS_PER_CHANNEL;
+            }
+
+        const size_t size = registers - _write_buffer;
+        _in_flight = static_cast<channels_mask>(((1UL << (last + 1)) -1) & ~((1UL << first) -1));
+        _dirty &= ~_in_flight;
+
+        Context::i2c_master().write_async(PCA_I2C_ADDRESS, _write_buffer, size, true);
+        _counters.bursts += 1;
+        _counters.bytes += 1 + size;
+        _state = DriverState::WRITING;
+        _pending = true;
+    }
+
+} /* endof namespace pwm_driver */
+} /* endof namespace hw */
@@ -0,0 +1,234 @@
+/**
+ * 
+ */
+
+#ifndef DEF_PWM_DRIVER_HXX
+#define DEF_PWM_DRIVER_HXX
+
+#include "error.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace hw
+{
+namespace pwm_driver
+{
+
+/**
+ * PCA9685 outputs, each one with a 12 bits duty cycle
+ */
+static constexpr const uint8_t PWM_CHANNELS_COUNT = 16;
+
+/**
+ * Duty cycles are given in 4096th of period, @c PWM_FULL_ON keeps the output high
+ *  and zero keeps it low, without any glitch
+ */
+static constexpr const uint16_t PWM_FULL_ON = 4096;
+
+/**
+ * PCA9685 i2c address (all address pins low) and registers
+ */
+static constexpr const uint8_t PCA_I2C_ADDRESS  = 0x40;
+static constexpr const uint8_t PCA_MODE1        = 0x00;
+static constexpr const uint8_t PCA_MODE2        = 0x01;
+static constexpr const uint8_t PCA_LED0_ON_L    = 0x06;     ///< followed by ON_H, OFF_L and OFF_H, then next channel
+static constexpr const uint8_t PCA_PRE_SCALE    = 0xFE;     ///< only writable while sleeping
+
+static constexpr const uint8_t PCA_REGISTERS_PER_CHANNEL = 4;
+
+static constexpr const uint8_t PCA_MODE1_AI     = 0x20;     ///< register auto-increment
+static constexpr const uint8_t PCA_MODE1_SLEEP  = 0x10;     ///< oscillator off, power-on default
+static constexpr const uint8_t PCA_MODE2_OUTDRV = 0x04;     ///< totem pole outputs
+static constexpr const uint8_t PCA_FULL_BIT     = 0x10;     ///< bit 4 of ON_H and OFF_H
+
+/**
+ * Internal oscillator in Hz, and time in us it needs to start after sleep is cleared
+ */
+static constexpr const unsigned long PCA_OSCILLATOR = 25000000;
+static constexpr const unsigned long PCA_OSCILLATOR_STARTUP = 500;
+
+/**
+ * Returns the prescaler giving the closest output frequency,
+ *  bounded to the chip range from 24Hz to 1526Hz
+ */
+static constexpr uint8_t prescale_of(unsigned long frequency)
+    {
+        const unsigned long prescale = frequency == 0 ? 255
+            : (PCA_OSCILLATOR + 2048 * frequency) / (4096 * frequency) -1;
+        return prescale < 3 ? 3 : 255 < prescale ? 255 : static_cast<uint8_t>(prescale);
+    }
+
+static_assert(prescale_of(200) == 30);
+static_assert(prescale_of(1526) == 3);
+static_assert(prescale_of(10) == 255);
+
+/**
+ * Writes the four registers of a channel for given duty cycle,
+ *  channels are phase shifted by a 16th of period so that their edges do not all fall together
+ */
+static constexpr void encode_channel(uint8_t channel, uint16_t value, uint8_t registers[PCA_REGISTERS_PER_CHANNEL])
+    {
+        const uint16_t on = static_cast<uint16_t>(channel) * (PWM_FULL_ON / PWM_CHANNELS_COUNT);
+        const uint16_t off = (on + value) & (PWM_FULL_ON -1);
+        registers[0] = value == 0 || value >= PWM_FULL_ON ? 0 : on & 0xFF;
+        registers[1] = value >= PWM_FULL_ON ? PCA_FULL_BIT : value == 0 ? 0 : on >> 8;
+        registers[2] = value == 0 || value >= PWM_FULL_ON ? 0 : off & 0xFF;
+        registers[3] = value == 0 ? PCA_FULL_BIT : value >= PWM_FULL_ON ? 0 : off >> 8;
+    }
+
+/**
+ * Bitmask of channels, bit N selects channel N
+ */
+using channels_mask = uint16_t;
+
+/**
+ * Bus statistics since setup
+ */
+struct pwm_counters
+{
+    unsigned long bursts;       ///< channels writes transactions
+    unsigned long bytes;        ///< bytes on the wire, address bytes included
+    unsigned long errors;       ///< failed transactions
+};
+
+/**
+ * 
+ */
+struct PwmDefaultSettings
+{
+    /**
+     * PWM frequency of every output in Hz
+     *  @note defaults to 1526Hz, the highest one, which eases filtering of CV outputs
+     */
+    static unsigned long PwmFrequency;
+
+    /**
+     * Clock of the i2c bus in Hz, as begun by the owner of the master,
+     *  used to size transactions to the time left on a shared bus
+     *  @note defaults to 400kHz, the clock of the leds driver buses
+     */
+    static unsigned long I2CFrequency;
+};
+
+/**
+ * Time left on a bus by nobody else, see @c PwmDriver::update
+ */
+static constexpr const unsigned long DEDICATED_BUS = ~0UL;
+
+/**
+ * PCA9685 driver for PWM and CV outputs, fed by the main loop without ever blocking it.
+ *
+ *  Channel values are cached and marked dirty when they change, each update
+ *  writes the first run of consecutive dirty channels as a single auto-increment burst:
+ *  one register byte then four bytes per channel. A clean channel in between
+ *  costs four bytes while a new transaction costs less than three (start, address,
+ *  register and stop), so runs are not merged across clean channels.
+ *  Values changed several times while the bus is busy are written once, with the latest value.
+ *
+ *  The bus is shared with one of the @c LedsDriver MCPs: the master is begun by its owner,
+ *  never by this driver, and transactions only start while the bus is idle, sized to end
+ *  before the next leds column step. Runs too long for the time left are split.
+ *  On a shared bus the driver is polled twice per loop:
+ *  @code
+ *  leds.update([](uint8_t) { pwm.update(0); });     // collects the burst before the column step
+ *  pwm.update(leds.bus_time_left());
+ *  @endcode
+ *
+ * Context must provide the following static members:
+ *  - @c master_type: i2c master following teensy4_i2c @c I2CMaster interface
+ *  - @c master_type& i2c_master()
+ *  - @c unsigned long micros()
+ */
+template <typename _Context, typename _Settings=PwmDefaultSettings>
+class PwmDriver
+{
+public:
+    using Settings = _Settings;
+    using Context = _Context;
+    using master_type = typename Context::master_type;
+
+    PwmDriver();
+
+    /**
+     * Resets chip configuration, launched by next update, every channel is written once it is done.
+     *  Cached values are kept, so that a driver can be setup again after a chip reset
+     */
+    error::status_byte setup();
+
+    /**
+     * Polls the pending transaction and launches the next one if the bus is idle,
+     *  never blocks and should be called on each loop. @c budget is the time in us
+     *  other devices leave the bus unused, no transaction starts unless it ends within it.
+     *  Returns an HWERROR if an i2c transaction failed, failed channels are written again
+     */
+    error::status_byte update(unsigned long budget=DEDICATED_BUS);
+
+    /**
+     * Changes the duty cycle of a channel, up to @c PWM_FULL_ON,
+     *  fails with INVALID_ARGUMENT out of range
+     */
+    error::status_byte set(uint8_t channel, uint16_t value);
+
+    /** Changes @c count consecutive channels starting at @c first */
+    error::status_byte set(uint8_t first, const uint16_t* values, uint8_t count);
+
+    /** Last value given to a channel, written or not */
+    uint16_t get(uint8_t channel) const         { return _values[channel % PWM_CHANNELS_COUNT]; }
+
+    /** Channels changed since their last successful write, in flight ones included */
+    channels_mask dirty() const                 { return _dirty | _in_flight; }
+
+    /** Returns true once configured, with every value written */
+    bool is_idle() const                        { return _state == DriverState::READY && dirty() == 0; }
+
+    const pwm_counters& counters() const        { return _counters; }
+
+private:
+    static constexpr const uint8_t CONFIGURATION_STEPS = 4;
+
+    static constexpr const size_t WRITE_BUFFER_SIZE = 1 + PWM_CHANNELS_COUNT * PCA_REGISTERS_PER_CHANNEL;
+
+    enum class DriverState: uint8_t
+    {
+        CONFIGURING,        ///< Writing mode and prescaler registers, one at a time
+        WAKING,             ///< Waiting for the oscillator to start
+        READY,              ///< No transaction pending
+        WRITING,            ///< Waiting for a channels burst ACK
+    };
+
+    /**
+     * Time in us a write of @c num_bytes holds the bus, rounded up:
+     *  address and data bytes with their ack, start, stop and bus free time
+     */
+    static unsigned long transaction_time(size_t num_bytes)
+        { return (9 * (num_bytes + 1) + 3) * 1000000ULL / Settings::I2CFrequency + 1; }
+
+    /** Sends next configuration step */
+    void configure();
+
+    /** Writes the first run of dirty channels, as much of it as @c budget allows */
+    void write_burst(unsigned long budget);
+
+    uint16_t _values[PWM_CHANNELS_COUNT];
+    channels_mask _dirty;       ///< channels changed since their last write began
+    channels_mask _in_flight;   ///< channels of the pending burst
+
+    uint8_t _configuration[CONFIGURATION_STEPS][2];
+    uint8_t _write_buffer[WRITE_BUFFER_SIZE];
+
+    DriverState _state;
+    bool _pending;              ///< a transaction of this driver is on the wire
+    uint8_t _step;              ///< configuration steps sent
+    unsigned long _woken;       ///< timestamp of sleep exit in us
+
+    pwm_counters _counters;
+
+}; /* endof class PwmDriver */
+
+} /* endof namespace pwm_driver */
+} /* endof namespace hw */
+
+#include "pwm_driver.hpp"
+
+#endif /* DEF_PWM_DRIVER_HXX */
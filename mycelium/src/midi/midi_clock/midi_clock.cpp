@@ -0,0 +1,20 @@
+/**
+ * 
+ */
+
+#include "midi_clock.hxx"
+
+namespace midi
+{
+namespace midi_clock
+{
+
+uint8_t FollowerDefaultSettings::PhaseShift = 3;
+uint8_t FollowerDefaultSettings::PeriodShift = 7;
+uint8_t FollowerDefaultSettings::ResyncShift = 1;
+uint8_t FollowerDefaultSettings::LockTicks = 24;
+uint16_t FollowerDefaultSettings::MinTempo = 20;
+uint16_t FollowerDefaultSettings::MaxTempo = 400;
+
+} /* endof namespace midi_clock */
+} /* endof namespace midi */
@@ -0,0 +1,208 @@
+/**
+ * 
+ */
+
+#include "midi_clock.hxx"
+
+namespace midi
+{
+namespace midi_clock
+{
+
+template <typename S>
+void
+ClockFollower<S>::reset()
+    {
+        _anchor = _last_tick = 0;
+        _offset = 0;
+        _period = 0;
+        _acquired = _good_ticks = 0;
+        _locked = false;
+        _running = _waiting_tick = false;
+        _ticks = _next = _reported = 0;
+        _counters = follower_counters{};
+    }
+
+template <typename S>
+bool
+ClockFollower<S>::feed(const midi_input::event& e)
+    {
+        switch (static_cast<status>(e.status))
+            {
+            case status::Clock:         tick(e.timestamp);      return true;
+            case status::Start:         start();                return true;
+            case status::Continue:      resume();               return true;
+            case status::Stop:          stop();                 return true;
+            case status::SongPosition:
+                song_position(e.data1 | (static_cast<uint16_t>(e.data2) << 7));
+                return true;
+            default:
+                return false;
+            }
+    }
+
+template <typename S>
+void
+ClockFollower<S>::acquire(unsigned long timestamp)
+    {
+        _anchor = timestamp;
+        _offset = 0;
+        _acquired = 1;
+        _good_ticks = 0;
+        _locked = false;
+    }
+
+template <typename S>
+void
+ClockFollower<S>::tick(unsigned long timestamp)
+    {
+        _counters.ticks += 1;
+        const uint32_t min_period = period_of(Settings::MaxTempo);
+        const uint32_t max_period = period_of(Settings::MinTempo);
+
+        if (_acquired == 0)
+            { acquire(timestamp); }
+        else if (_acquired == 1)
+            {
+                /* first interval gives the initial period */
+                const uint64_t interval = static_cast<uint64_t>(timestamp - _last_tick) << PERIOD_FRACTION_BITS;
+                if (interval < min_period || max_period < interval)
+                    { acquire(timestamp); }
+                else
+                    {
+                        _period = static_cast<uint32_t>(interval);
+                        _anchor = timestamp;
+                        _offset = 0;
+                        _acquired = 2;
+                    }
+            }
+        else
+            {
+                const int64_t predicted = static_cast<int64_t>(_offset) + _period;
+                const int64_t error = (static_cast<int64_t>(static_cast<long>(timestamp - _anchor)) << PERIOD_FRACTION_BITS)
+                    - predicted;
+                const int64_t magnitude = error < 0 ? -error : error;
+
+                if (magnitude > (_period >> Settings::ResyncShift))
+                    {
+                        _counters.resyncs += 1;
+                        acquire(timestamp);
+                    }
+                else
+                    {
+                        const int64_t offset = predicted + error / (1 << Settings::PhaseShift);
+                        int64_t period = static_cast<int64_t>(_period) + error / (1 << Settings::PeriodShift);
+                        period = period < min_period ? min_period : (period > max_period ? max_period : period);
+                        _period = static_cast<uint32_t>(period);
+
+                        /* keep the sub-microsecond fraction only */
+                        _anchor += static_cast<long>(offset >> PERIOD_FRACTION_BITS);
+                        _offset = static_cast<int32_t>(offset & ((1 << PERIOD_FRACTION_BITS) -1));
+
+                        _good_ticks = magnitude < (_period >> 4)
+                            ? (_good_ticks < UINT8_MAX ? _good_ticks + 1 : _good_ticks)
+                            : 0;
+                        _locked = _good_ticks >= Settings::LockTicks;
+                    }
+            }
+        _last_tick = timestamp;
+
+        if (!_running)
+            { return; }
+        _waiting_tick = false;
+        _ticks = _next;
+        _next += 1;
+    }
+
+template <typename S>
+void
+ClockFollower<S>::start()
+    {
+        _ticks = _next = _reported = 0;
+        _running = _waiting_tick = true;
+    }
+
+template <typename S>
+void
+ClockFollower<S>::stop()
+    {
+        _running = false;
+        _reported = _ticks << SUBTICK_BITS;
+    }
+
+template <typename S>
+void
+ClockFollower<S>::resume()
+    {
+        if (_running)
+            { return; }
+        _running = _waiting_tick = true;
+    }
+
+template <typename S>
+void
+ClockFollower<S>::song_position(uint16_t sixteenths)
+    {
+        if (_running)
+            { return; }
+        _ticks = _next = static_cast<position_type>(sixteenths) * TICKS_PER_SIXTEENTH;
+        _reported = _ticks << SUBTICK_BITS;
+    }
+
+template <typename S>
+void
+ClockFollower<S>::update(unsigned long now)
+    {
+        if (_acquired == 0 || _period == 0)
+            { return; }
+        /* four periods without tick: the clock stopped or is lost */
+        if (static_cast<uint64_t>(now - _last_tick) << PERIOD_FRACTION_BITS > 4 * static_cast<uint64_t>(_period))
+            {
+                if (_locked)
+                    { _counters.timeouts += 1; }
+                _acquired = 0;
+                _good_ticks = 0;
+                _locked = false;
+            }
+    }
+
+template <typename S>
+position_type
+ClockFollower<S>::position(unsigned long now)
+    {
+        if (!_running || _waiting_tick || _period == 0)
+            { return _ticks << SUBTICK_BITS; }
+
+        /* the position follows the estimated ticks: an early tick does not make it jump forward,
+         *  late ticks are absorbed up to a whole period, then the position waits for the clock */
+        const int64_t tick = static_cast<int64_t>(TICK);
+        int64_t fraction = since_tick(now) * tick / static_cast<int64_t>(_period);
+        fraction = fraction < -tick ? -tick : (fraction < 2 * tick ? fraction : 2 * tick -1);
+
+        const int64_t signed_p = static_cast<int64_t>(_ticks << SUBTICK_BITS) + fraction;
+        const position_type p = signed_p < 0 ? 0 : static_cast<position_type>(signed_p);
+        if (p > _reported)
+            { _reported = p; }
+        return _reported;
+    }
+
+template <typename S>
+unsigned long
+ClockFollower<S>::time_of(position_type p) const
+    {
+        const int64_t ahead = static_cast<int64_t>(p) - static_cast<int64_t>(_ticks << SUBTICK_BITS);
+        const int64_t offset = _offset + ahead * static_cast<int64_t>(_period) / static_cast<int64_t>(TICK);
+        return _anchor + static_cast<long>(offset >> PERIOD_FRACTION_BITS);
+    }
+
+template <typename S>
+uint32_t
+ClockFollower<S>::tempo() const
+    {
+        if (_period == 0)
+            { return 0; }
+        return (6000000000ULL << PERIOD_FRACTION_BITS) / (static_cast<uint64_t>(_period) * TICKS_PER_QUARTER);
+    }
+
+} /* endof namespace midi_clock */
+} /* endof namespace midi */
@@ -0,0 +1,188 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_CLOCK_HXX
+#define DEF_MIDI_CLOCK_HXX
+
+#include "error.hpp"
+#include "../midi_defines.hxx"
+#include "../midi_input/midi_input.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+namespace midi_clock
+{
+
+/**
+ * MIDI clock resolution: ticks per quarter note, and per song position unit (a sixteenth note)
+ */
+static constexpr const uint8_t TICKS_PER_QUARTER = 24;
+static constexpr const uint8_t TICKS_PER_SIXTEENTH = 6;
+
+/**
+ * Positions are counted in ticks since song start, with 16 bits of sub-tick fraction
+ */
+using position_type = uint64_t;
+static constexpr const uint8_t SUBTICK_BITS = 16;
+static constexpr const position_type TICK = static_cast<position_type>(1) << SUBTICK_BITS;
+
+/**
+ * Tick periods are kept in microseconds with 8 bits of fraction
+ */
+static constexpr const uint8_t PERIOD_FRACTION_BITS = 8;
+
+/**
+ * 
+ */
+struct FollowerDefaultSettings
+{
+    /**
+     * Phase correction gain of the tempo PLL, as a right shift of the tick error:
+     *  higher values filter more jitter and track tempo changes slower
+     *  @note defaults to 3, 1/8 of the error
+     */
+    static uint8_t PhaseShift;
+
+    /**
+     * Period correction gain of the tempo PLL, as a right shift of the tick error,
+     *  about twice @c PhaseShift plus one for a critically damped loop
+     *  @note defaults to 7, 1/128 of the error
+     */
+    static uint8_t PeriodShift;
+
+    /**
+     * Ticks farther than this fraction of a period from their prediction
+     *  restart the acquisition, as a right shift of the period
+     *  @note defaults to 1, half a period
+     */
+    static uint8_t ResyncShift;
+
+    /**
+     * Consecutive ticks within a sixteenth of a period from their prediction to declare the lock
+     *  @note defaults to 24, a quarter note
+     */
+    static uint8_t LockTicks;
+
+    /**
+     * Accepted tempo range in beats per minute, ticks out of range restart the acquisition
+     *  @note defaults to 20 and 400
+     */
+    static uint16_t MinTempo;
+    static uint16_t MaxTempo;
+};
+
+/**
+ * Transport counters
+ */
+struct follower_counters
+{
+    unsigned long ticks;        ///< clock ticks received
+    unsigned long resyncs;      ///< acquisitions restarted by a tick out of the loop range
+    unsigned long timeouts;     ///< locks lost by missing ticks
+};
+
+/**
+ * Follows an external 24 ppqn MIDI clock:
+ *  ticks reception times feed a fixed-point second order PLL estimating the tick period and phase,
+ *  positions between ticks are interpolated from the estimates, so events can be scheduled
+ *  between ticks with the jitter of the loop instead of the one of the received ticks.
+ *
+ * Transport follows Start, Stop, Continue and Song Position Pointer:
+ *  - Start rewinds to zero, the position starts moving on the first tick after it
+ *  - Stop freezes the position on the last received tick
+ *  - Continue resumes from the frozen position, on the next tick
+ *  - Song Position Pointer moves the position while stopped
+ * Tempo tracking goes on while stopped.
+ *
+ * Interpolated positions keep moving up to a period past the next expected tick
+ *  before it is received, so late ticks do not hold scheduled events,
+ *  and never move backward while running.
+ */
+template <typename _Settings=FollowerDefaultSettings>
+class ClockFollower
+{
+public:
+    using Settings = _Settings;
+
+    ClockFollower()         { reset(); }
+
+    /** Forgets the tempo and rewinds the transport */
+    void reset();
+
+    /**
+     * Handles clock and transport events, as polled from @c midi_input::Parser,
+     *  returns false for other events
+     */
+    bool feed(const midi_input::event& e);
+
+    /** Clock tick received at @c timestamp in us */
+    void tick(unsigned long timestamp);
+
+    void start();
+    void stop();
+    void resume();
+
+    /** Moves the position to given count of sixteenth notes, ignored while running */
+    void song_position(uint16_t sixteenths);
+
+    /** Drops the lock when ticks are missing, to be called on each loop */
+    void update(unsigned long now);
+
+    /** Interpolated position at @c now, in ticks with @c SUBTICK_BITS of fraction */
+    position_type position(unsigned long now);
+
+    /** Predicted time in us at which given position is reached, meaningless unless running */
+    unsigned long time_of(position_type p) const;
+
+    bool running() const                    { return _running; }
+    bool locked() const                     { return _locked; }
+
+    /** Estimated tick period in us, with @c PERIOD_FRACTION_BITS of fraction, zero until measured */
+    uint32_t period() const                 { return _period; }
+
+    /** Estimated tempo in hundredths of beats per minute, zero until measured */
+    uint32_t tempo() const;
+
+    const follower_counters& counters() const   { return _counters; }
+
+private:
+    /** Tick period in Q8 us of a tempo in beats per minute */
+    static uint32_t period_of(uint16_t tempo)
+        { return (60000000ULL << PERIOD_FRACTION_BITS) / (static_cast<uint32_t>(tempo) * TICKS_PER_QUARTER); }
+
+    /** Restarts the PLL from a tick received at @c timestamp */
+    void acquire(unsigned long timestamp);
+
+    /** Time elapsed since the estimated last tick in Q8 us, negative if not reached yet */
+    int64_t since_tick(unsigned long now) const
+        { return (static_cast<int64_t>(static_cast<long>(now - _anchor)) << PERIOD_FRACTION_BITS) - _offset; }
+
+    /** Estimated last tick: @c _anchor us plus @c _offset Q8 us, @c _offset is kept small */
+    unsigned long _anchor;
+    int32_t _offset;
+    uint32_t _period;
+
+    unsigned long _last_tick;       ///< raw timestamp of last tick
+    uint8_t _acquired;              ///< ticks received since acquisition start, saturated
+    uint8_t _good_ticks;            ///< consecutive ticks close to their prediction
+    bool _locked;
+
+    bool _running;
+    bool _waiting_tick;             ///< started or resumed, position moves on next tick
+    position_type _ticks;           ///< position of last tick
+    position_type _next;            ///< position of next tick
+    position_type _reported;        ///< last interpolated position
+
+    follower_counters _counters;
+};
+
+} /* endof namespace midi_clock */
+} /* endof namespace midi */
+
+#include "midi_clock.hpp"
+
+#endif /* DEF_MIDI_CLOCK_HXX */
@@ -0,0 +1,122 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_DEFINES_HXX
+#define DEF_MIDI_DEFINES_HXX
+
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+
+/**
+ * Serial MIDI ports: RX1/TX1 and RX2/TX2
+ */
+enum class bus: uint8_t
+{
+    Bus1,
+    Bus2,
+    __BUSES_COUNT__
+};
+
+static constexpr const uint8_t BUSES_COUNT = static_cast<uint8_t>(bus::__BUSES_COUNT__);
+
+/**
+ * Status bytes, channel messages carry the channel in their low nibble
+ */
+enum class status: uint8_t
+{
+    /* channel voice */
+    NoteOff             = 0x80,
+    NoteOn              = 0x90,
+    PolyPressure        = 0xA0,
+    ControlChange       = 0xB0,
+    ProgramChange       = 0xC0,
+    ChannelPressure     = 0xD0,
+    PitchBend           = 0xE0,
+
+    /* system common */
+    SysExStart          = 0xF0,
+    TimeCodeQuarter     = 0xF1,
+    SongPosition        = 0xF2,
+    SongSelect          = 0xF3,
+    TuneRequest         = 0xF6,
+    SysExEnd            = 0xF7,
+
+    /* system realtime */
+    Clock               = 0xF8,
+    Start               = 0xFA,
+    Continue            = 0xFB,
+    Stop                = 0xFC,
+    ActiveSensing       = 0xFE,
+    Reset               = 0xFF,
+};
+
+static constexpr const uint8_t STATUS_BIT       = 0x80;
+static constexpr const uint8_t TYPE_BITMASK     = 0xF0;
+static constexpr const uint8_t CHANNEL_BITMASK  = 0x0F;
+static constexpr const uint8_t DATA_BITMASK     = 0x7F;
+
+/** Microseconds per byte on a 31250 bauds line: start bit, 8 data bits, stop bit */
+static constexpr const unsigned long BYTE_DURATION_US = 320;
+
+static constexpr bool is_status(uint8_t byte)      { return byte & STATUS_BIT; }
+static constexpr bool is_channel(uint8_t byte)     { return STATUS_BIT <= byte && byte < 0xF0; }
+static constexpr bool is_common(uint8_t byte)      { return 0xF0 <= byte && byte < 0xF8; }
+static constexpr bool is_realtime(uint8_t byte)    { return 0xF8 <= byte; }
+
+static constexpr uint8_t make_status(status s, uint8_t channel)
+    { return static_cast<uint8_t>(s) | (channel & CHANNEL_BITMASK); }
+
+static constexpr status type_of(uint8_t byte)
+    { return static_cast<status>(is_channel(byte) ? byte & TYPE_BITMASK : byte); }
+
+static constexpr uint8_t channel_of(uint8_t byte)  { return byte & CHANNEL_BITMASK; }
+
+/**
+ * Number of data bytes following given status byte,
+ *  SysEx data is unbounded and reported as zero
+ */
+static constexpr uint8_t data_size(uint8_t byte)
+    {
+        switch (type_of(byte))
+            {
+            case status::ProgramChange:
+            case status::ChannelPressure:
+            case status::TimeCodeQuarter:
+            case status::SongSelect:
+                return 1;
+            case status::NoteOff:
+            case status::NoteOn:
+            case status::PolyPressure:
+            case status::ControlChange:
+            case status::PitchBend:
+            case status::SongPosition:
+                return 2;
+            default:
+                return 0;
+            }
+    }
+
+/**
+ * A complete short message, unused data bytes are ignored
+ */
+struct message
+{
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+
+    uint8_t size() const    { return 1 + data_size(status); }
+};
+
+static_assert(data_size(make_status(status::NoteOn, 3)) == 2);
+static_assert(data_size(make_status(status::ProgramChange, 15)) == 1);
+static_assert(data_size(static_cast<uint8_t>(status::Clock)) == 0);
+static_assert(type_of(0x9F) == status::NoteOn && channel_of(0x9F) == 15);
+
+} /* endof namespace midi */
+
+#endif /* DEF_MIDI_DEFINES_HXX */
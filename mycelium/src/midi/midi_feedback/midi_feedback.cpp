@@ -0,0 +1,116 @@
+/**
+ * 
+ */
+
+#include "midi_feedback.hxx"
+
+namespace midi
+{
+namespace midi_feedback
+{
+
+using hw::leds_driver::pad_color;
+using hw::leds_driver::ledring_state;
+using midi_mapping::control;
+using midi_mapping::control_kind;
+
+/** Last index of a ring led, leds 0 to 14 */
+static constexpr const uint8_t RING_LAST_LED = 14;
+static constexpr const uint8_t RING_CENTER_LED = 7;
+
+pad_color
+color_of(uint8_t velocity)
+    {
+        switch (velocity)
+            {
+            case 0:             return pad_color::OFF;
+            case 1: case 2:     return pad_color::GREEN;
+            case 3: case 4:     return pad_color::RED;
+            case 5: case 6:     return pad_color::ORANGE;
+            default:            return pad_color::GREEN;
+            }
+    }
+
+ledring_state
+ring_of(ring_style style, uint8_t value)
+    {
+        const uint8_t position = (value & DATA_BITMASK) * RING_LAST_LED / DATA_BITMASK;
+        switch (style)
+            {
+            case ring_style::Single:
+                return ledring_state{position, 1};
+            case ring_style::Volume:
+                return ledring_state{0, static_cast<uint8_t>(position + 1)};
+            case ring_style::Pan:
+                return position < RING_CENTER_LED
+                    ? ledring_state{position, static_cast<uint8_t>(RING_CENTER_LED - position + 1)}
+                    : ledring_state{RING_CENTER_LED, static_cast<uint8_t>(position - RING_CENTER_LED + 1)};
+            default:
+                return ledring_state{0, 0};
+            }
+    }
+
+void
+LedsFeedback::reset()
+    {
+        _frame.clear();
+        for (uint8_t e=0; e<ENCODERS_COUNT; ++e)
+            {
+                _styles[e] = ring_style::Single;
+                _values[e] = 0;
+            }
+        _counters = feedback_counters{};
+    }
+
+bool
+LedsFeedback::stage(const midi_input::event& e, const midi_mapping::MappingTable& table)
+    {
+        _counters.events += 1;
+        const control target = table.input(e.status, e.data1);
+        const status type = type_of(e.status);
+
+        bool staged = false;
+        switch (target.kind)
+            {
+            case control_kind::Pad:
+                {
+                    const hw::pads::Pad pad = static_cast<hw::pads::Pad>(target.index);
+                    const uint8_t velocity = type == status::NoteOff ? 0 : e.data2;
+                    /* monochrome pads are lit by any color */
+                    const pad_color color = hw::pads::is_bichrome(pad)
+                        ? color_of(velocity)
+                        : (velocity ? pad_color::ON : pad_color::OFF);
+                    staged = _frame.set(pad, color);
+                    break;
+                }
+
+            case control_kind::Encoder:
+                if (type != status::ControlChange)
+                    { break; }
+                _values[target.index] = e.data2;
+                staged = _frame.set(static_cast<hw::analog::Encoder>(target.index), ring_of(_styles[target.index], e.data2));
+                break;
+
+            case control_kind::RingStyle:
+                if (type != status::ControlChange)
+                    { break; }
+                _styles[target.index] = e.data2 < static_cast<uint8_t>(ring_style::__STYLES_COUNT__)
+                    ? static_cast<ring_style>(e.data2)
+                    : ring_style::Single;
+                staged = _frame.set(static_cast<hw::analog::Encoder>(target.index),
+                    ring_of(_styles[target.index], _values[target.index]));
+                break;
+
+            default:
+                break;
+            }
+
+        if (staged)
+            { _counters.applied += 1; }
+        else
+            { _counters.forwarded += 1; }
+        return staged;
+    }
+
+} /* endof namespace midi_feedback */
+} /* endof namespace midi */
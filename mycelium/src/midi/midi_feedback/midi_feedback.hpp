@@ -0,0 +1,41 @@
+/**
+ * 
+ */
+
+#include "midi_feedback.hxx"
+
+namespace midi
+{
+namespace midi_feedback
+{
+
+template <typename Leds>
+bool
+LedsFeedback::commit(Leds& leds)
+    {
+        if (_frame.is_empty())
+            { return false; }
+        leds.commit(_frame);
+        _frame.clear();
+        _counters.frames += 1;
+        return true;
+    }
+
+template <typename Source, typename Leds, typename OtherFn>
+size_t
+LedsFeedback::process(Source& source, const midi_mapping::MappingTable& table, Leds& leds, OtherFn&& on_other)
+    {
+        midi_input::event e;
+        size_t count = 0;
+        while (source.poll(e))
+            {
+                count += 1;
+                if (!stage(e, table))
+                    { on_other(e); }
+            }
+        commit(leds);
+        return count;
+    }
+
+} /* endof namespace midi_feedback */
+} /* endof namespace midi */
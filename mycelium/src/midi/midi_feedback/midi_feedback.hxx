@@ -0,0 +1,112 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_FEEDBACK_HXX
+#define DEF_MIDI_FEEDBACK_HXX
+
+#include "error.hpp"
+#include "../midi_defines.hxx"
+#include "../midi_input/midi_input.hxx"
+#include "../midi_mapping/midi_mapping.hxx"
+#include "../../hw/leds_driver/leds_driver.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+namespace midi_feedback
+{
+
+using midi_mapping::ENCODERS_COUNT;
+
+/**
+ * Led-ring display styles, selected by the value of the ring style controller
+ */
+enum class ring_style: uint8_t
+{
+    Off     = 0,
+    Single  = 1,        ///< a single led at the value position
+    Volume  = 2,        ///< leds from the first one up to the value position
+    Pan     = 3,        ///< leds from the center to the value position
+    __STYLES_COUNT__
+};
+
+/**
+ * Pad color of a note velocity, following the APC40 palette:
+ *  0 off, 1 green, 3 red, 5 yellow, even values blink their odd neighbour,
+ *  blinking is rendered steady, higher velocities are green
+ */
+hw::leds_driver::pad_color color_of(uint8_t velocity);
+
+/**
+ * Leds of a ring displaying a 7 bits controller value with given style
+ */
+hw::leds_driver::ledring_state ring_of(ring_style style, uint8_t value);
+
+/**
+ * Feedback counters
+ */
+struct feedback_counters
+{
+    unsigned long events;       ///< events staged or forwarded
+    unsigned long applied;      ///< led changes staged
+    unsigned long forwarded;    ///< events not driving a led
+    unsigned long frames;       ///< frames committed to the leds driver
+};
+
+/**
+ * Fast path from received led messages to the leds driver:
+ *  events are looked up in the active mapping table and staged in a @c leds_frame,
+ *  committed once per reception batch. No allocation nor indirect call on the way.
+ *
+ * Notes drive pads, note offs turning them off, control changes drive led-rings
+ *  according to their style, other events are handed back to the caller.
+ */
+class LedsFeedback
+{
+public:
+    LedsFeedback()      { reset(); }
+
+    /** Drops staged edits, restores default ring styles and values */
+    void reset();
+
+    /**
+     * Stages the led change of a single event,
+     *  returns false if the event does not drive any led
+     */
+    bool stage(const midi_input::event& e, const midi_mapping::MappingTable& table);
+
+    /** Applies staged changes to @c leds, returns true if a frame was committed */
+    template <typename Leds>
+    bool commit(Leds& leds);
+
+    /**
+     * Stages every event available from @c source then commits them as a single frame,
+     *  @c on_other(event) is called in order for events not driving a led.
+     *  Source must provide @c bool poll(midi_input::event&), as @c midi_input::Parser.
+     *  Returns the count of polled events.
+     */
+    template <typename Source, typename Leds, typename OtherFn>
+    size_t process(Source& source, const midi_mapping::MappingTable& table, Leds& leds, OtherFn&& on_other);
+
+    ring_style style(hw::analog::Encoder e) const   { return _styles[static_cast<uint8_t>(e)]; }
+    uint8_t value(hw::analog::Encoder e) const      { return _values[static_cast<uint8_t>(e)]; }
+
+    const hw::leds_driver::leds_frame& frame() const    { return _frame; }
+    const feedback_counters& counters() const           { return _counters; }
+
+private:
+    hw::leds_driver::leds_frame _frame;
+    ring_style _styles[ENCODERS_COUNT];
+    uint8_t _values[ENCODERS_COUNT];
+    feedback_counters _counters;
+};
+
+} /* endof namespace midi_feedback */
+} /* endof namespace midi */
+
+#include "midi_feedback.hpp"
+
+#endif /* DEF_MIDI_FEEDBACK_HXX */
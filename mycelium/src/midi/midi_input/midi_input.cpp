@@ -0,0 +1,157 @@
+/**
+ * 
+ */
+
+#include "midi_input.hxx"
+
+namespace midi
+{
+namespace midi_input
+{
+
+Parser::Parser()
+    : _events{}, _sysex{}, _release{0},
+    _running{0}, _expected{0}, _received{0}, _data{0, 0}, _in_sysex{false}, _sysex_overflow{false},
+    _counters{}
+    {}
+
+void
+Parser::reset()
+    {
+        if (_in_sysex)
+            { _sysex.abort(); }
+        _running = _expected = _received = 0;
+        _in_sysex = _sysex_overflow = false;
+    }
+
+void
+Parser::feed(uint8_t byte, unsigned long timestamp)
+    {
+        _counters.bytes += 1;
+
+        /* realtime bytes may appear anywhere and leave the parser state untouched */
+        if (is_realtime(byte))
+            {
+                if (byte != 0xF9 && byte != 0xFD)
+                    { emit(byte, 0, 0, timestamp); }
+                return;
+            }
+
+        if (!is_status(byte))
+            {
+                if (_in_sysex)
+                    {
+                        if (!_sysex_overflow && !_sysex.append(byte))
+                            { _sysex_overflow = true; }
+                        return;
+                    }
+                if (_running == 0)
+                    {
+                        _counters.errors += 1;
+                        return;
+                    }
+
+                _data[_received++] = byte;
+                if (_received < _expected)
+                    { return; }
+
+                emit(_running, _data[0], _expected > 1 ? _data[1] : 0, timestamp);
+                _received = 0;
+                /* system common messages have no running status */
+                if (is_common(_running))
+                    { _running = 0; }
+                return;
+            }
+
+        if (_in_sysex)
+            {
+                if (byte == static_cast<uint8_t>(status::SysExEnd))
+                    {
+                        end_sysex(timestamp);
+                        return;
+                    }
+                /* any other status byte interrupts the message */
+                _counters.errors += 1;
+                _sysex.abort();
+                _in_sysex = false;
+            }
+
+        /* a status byte interrupts any incomplete message */
+        if (_received != 0)
+            { _counters.errors += 1; }
+        _received = 0;
+        _running = 0;
+        switch (type_of(byte))
+            {
+            case status::SysExStart:
+                _in_sysex = true;
+                _sysex_overflow = false;
+                _sysex.begin();
+                if (!_sysex.append(byte))
+                    { _sysex_overflow = true; }
+                return;
+
+            case status::SysExEnd:
+                _counters.errors += 1;
+                return;
+
+            default:
+                break;
+            }
+
+        _expected = data_size(byte);
+        if (_expected != 0)
+            { _running = byte; }
+        else if (byte == static_cast<uint8_t>(status::TuneRequest))
+            { emit(byte, 0, 0, timestamp); }
+    }
+
+bool
+Parser::poll(event& e)
+    {
+        _sysex.release(_release);
+        if (!_events.pop(e))
+            { return false; }
+        if (e.is_sysex())
+            { _release = e.sysex_begin + e.sysex_size; }
+        return true;
+    }
+
+void
+Parser::emit(uint8_t status, uint8_t data1, uint8_t data2, unsigned long timestamp)
+    {
+        if (!_events.push(event{status, data1, data2, 0, 0, timestamp}))
+            {
+                _counters.dropped += 1;
+                return;
+            }
+        _counters.events += 1;
+    }
+
+void
+Parser::end_sysex(unsigned long timestamp)
+    {
+        _in_sysex = false;
+        if (_sysex_overflow || !_sysex.append(static_cast<uint8_t>(status::SysExEnd)))
+            {
+                _counters.sysex_overflows += 1;
+                _sysex.abort();
+                return;
+            }
+
+        /* bytes are written before the event is published, and published after it,
+         *  so that a dropped event never leaves unreleased bytes */
+        const event e{static_cast<uint8_t>(status::SysExStart), 0, 0,
+            static_cast<uint16_t>(_sysex.message_size()), _sysex.message_begin(), timestamp};
+        if (!_events.push(e))
+            {
+                _counters.dropped += 1;
+                _sysex.abort();
+                return;
+            }
+        _sysex.commit();
+        _counters.events += 1;
+    }
+
+} /* endof namespace midi_input */
+} /* endof namespace midi */
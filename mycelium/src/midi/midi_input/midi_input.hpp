@@ -0,0 +1,58 @@
+/**
+ * 
+ */
+
+#include "midi_input.hxx"
+
+namespace midi
+{
+namespace midi_input
+{
+
+template <size_t Z>
+bool
+SysExBuffer<Z>::append(uint8_t byte)
+    {
+        if (_write - _tail.load(std::memory_order_acquire) == Size)
+            { return false; }
+        _bytes[_write & (Size -1)] = byte;
+        _write += 1;
+        return true;
+    }
+
+template <size_t Z>
+sysex_span
+SysExBuffer<Z>::span(size_t begin, size_t size) const
+    {
+        const size_t index = begin & (Size -1);
+        const size_t first = size < Size - index ? size : Size - index;
+        return sysex_span{{&_bytes[index], &_bytes[0]}, {first, size - first}};
+    }
+
+
+template <typename C>
+size_t
+MidiInput<C>::update()
+    {
+        size_t total = 0;
+        uint8_t bytes[RX_CHUNK_SIZE];
+        for (uint8_t i=0; i<BUSES_COUNT; ++i)
+            {
+                const bus b = static_cast<bus>(i);
+                const unsigned long now = Context::micros();
+
+                /* bounded: at most a serial receive buffer per loop */
+                for (uint8_t chunk=0; chunk<4; ++chunk)
+                    {
+                        const size_t count = Context::read(b, bytes, RX_CHUNK_SIZE);
+                        _parsers[i].feed(bytes, count, now);
+                        total += count;
+                        if (count < RX_CHUNK_SIZE)
+                            { break; }
+                    }
+            }
+        return total;
+    }
+
+} /* endof namespace midi_input */
+} /* endof namespace midi */
@@ -0,0 +1,223 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_INPUT_HXX
+#define DEF_MIDI_INPUT_HXX
+
+#include "../midi_defines.hxx"
+#include "../../utils/containers/ring.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+namespace midi_input
+{
+
+/**
+ * Bytes of received system exclusive messages per bus, framing bytes included
+ */
+static constexpr const size_t SYSEX_BUFFER_SIZE = 512;
+
+/**
+ * Parsed events waiting to be polled per bus
+ */
+static constexpr const size_t EVENTS_QUEUE_SIZE = 64;
+
+/**
+ * Bytes read at once from a serial port
+ */
+static constexpr const size_t RX_CHUNK_SIZE = 32;
+
+/**
+ * A complete message received on a bus:
+ *  short messages carry their data bytes, system exclusive messages
+ *  locate their bytes in the parser SysEx buffer
+ */
+struct event
+{
+    uint8_t status;             ///< status byte, SysExStart for system exclusive messages
+    uint8_t data1;
+    uint8_t data2;
+    uint16_t sysex_size;        ///< size of the system exclusive message, framing included
+    size_t sysex_begin;         ///< free-running position of the system exclusive message
+    unsigned long timestamp;    ///< reception timestamp in us
+
+    bool is_sysex() const       { return status == static_cast<uint8_t>(status::SysExStart); }
+};
+
+/**
+ * Read-only view over a system exclusive message laying in a ring,
+ *  in two contiguous chunks when it wraps around the ring end
+ */
+struct sysex_span
+{
+    const uint8_t* chunks[2];
+    size_t sizes[2];
+
+    size_t size() const                     { return sizes[0] + sizes[1]; }
+    uint8_t operator[] (size_t i) const     { return i < sizes[0] ? chunks[0][i] : chunks[1][i - sizes[0]]; }
+};
+
+/**
+ * Parsing counters of a single bus
+ */
+struct parser_counters
+{
+    unsigned long bytes;            ///< bytes fed
+    unsigned long events;           ///< events queued
+    unsigned long dropped;          ///< events refused by a full queue
+    unsigned long sysex_overflows;  ///< system exclusive messages larger than the free buffer room
+    unsigned long errors;           ///< stray data bytes, unterminated system exclusive messages
+};
+
+/**
+ * Storage of received system exclusive messages, written in place while received:
+ *  a message is only published when complete, consumers release messages in reception order
+ */
+template <size_t _Size>
+class SysExBuffer
+{
+public:
+    static constexpr const size_t Size = _Size;
+    static_assert(Size != 0 && (Size & (Size -1)) == 0, "SysEx buffer size must be a power of two");
+
+    SysExBuffer(): _bytes{}, _head{0}, _tail{0}, _write{0}, _begin{0}     {}
+
+    /** Producer side: starts a new message at the end of the published ones */
+    void begin()                    { _begin = _write = _head.load(std::memory_order_relaxed); }
+
+    /** Producer side: appends a byte to current message, returns false on overflow */
+    bool append(uint8_t byte);
+
+    /** Producer side: first position and size of current message */
+    size_t message_begin() const    { return _begin; }
+    size_t message_size() const     { return _write - _begin; }
+
+    /** Producer side: publishes current message */
+    void commit()                   { _head.store(_write, std::memory_order_release); }
+
+    /** Producer side: forgets current message */
+    void abort()                    { _write = _begin = _head.load(std::memory_order_relaxed); }
+
+    /** Consumer side: view over a published message */
+    sysex_span span(size_t begin, size_t size) const;
+
+    /** Consumer side: releases messages up to given position */
+    void release(size_t end)        { _tail.store(end, std::memory_order_release); }
+
+    /** Published bytes not released yet */
+    size_t size() const             { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+
+private:
+    uint8_t _bytes[Size];
+    std::atomic<size_t> _head;      ///< end of published messages, free-running
+    std::atomic<size_t> _tail;      ///< end of released messages, free-running
+    size_t _write;                  ///< end of current message
+    size_t _begin;                  ///< begin of current message
+};
+
+/**
+ * Incremental MIDI parser of a single bus:
+ *  bytes are fed as they are received, complete messages are queued as events.
+ *  Handles running status, realtime bytes interleaved anywhere, even inside other messages,
+ *  and system exclusive messages, which are kept in place in the SysEx buffer.
+ *
+ * Feeding and polling may run in different contexts, an interrupt handler and the main loop,
+ *  as long as each of them only runs in a single one
+ */
+class Parser
+{
+public:
+    using events_type = containers::Ring<event, EVENTS_QUEUE_SIZE>;
+    using sysex_type = SysExBuffer<SYSEX_BUFFER_SIZE>;
+
+    Parser();
+
+    /** Producer side: forgets any partial message and running status */
+    void reset();
+
+    /** Producer side: parses a received byte */
+    void feed(uint8_t byte, unsigned long timestamp);
+
+    /** Producer side: parses received bytes */
+    void feed(const uint8_t* bytes, size_t count, unsigned long timestamp)
+        { for (size_t i=0; i<count; ++i) { feed(bytes[i], timestamp); } }
+
+    /**
+     * Consumer side: pops next event, returns false if none.
+     *  A system exclusive message remains readable through @c sysex until next call
+     */
+    bool poll(event& e);
+
+    /** Consumer side: bytes of the system exclusive message of last polled event */
+    sysex_span sysex(const event& e) const      { return _sysex.span(e.sysex_begin, e.sysex_size); }
+
+    size_t pending() const                      { return _events.size(); }
+    const parser_counters& counters() const     { return _counters; }
+
+private:
+    /** Queues a short message completed at @c timestamp */
+    void emit(uint8_t status, uint8_t data1, uint8_t data2, unsigned long timestamp);
+
+    /** Closes current system exclusive message */
+    void end_sysex(unsigned long timestamp);
+
+    events_type _events;
+    sysex_type _sysex;
+    size_t _release;            ///< end of the system exclusive message handed to the consumer
+
+    uint8_t _running;           ///< status of the message being received, zero if none
+    uint8_t _expected;          ///< data bytes of current status
+    uint8_t _received;          ///< data bytes received for the message being received
+    uint8_t _data[2];
+    bool _in_sysex;
+    bool _sysex_overflow;       ///< current system exclusive message is being discarded
+
+    parser_counters _counters;
+};
+
+/**
+ * MIDI input of all serial buses: reads available bytes without blocking and parses them.
+ *  Received bytes are timestamped when read, at the loop resolution.
+ *
+ * Context must provide:
+ *  - size_t read(bus, uint8_t* bytes, size_t count): reads up to @c count available bytes,
+ *      returns the count of read bytes, never blocks
+ *  - unsigned long micros(): current timestamp in microseconds
+ */
+template <typename _Context>
+class MidiInput
+{
+public:
+    using Context = _Context;
+
+    MidiInput(): _parsers{}     {}
+
+    void setup()                { for (auto& p: _parsers) { p.reset(); } }
+
+    /**
+     * Reads and parses bytes available on all buses, never blocks
+     *  and should be called on each loop, returns the count of bytes read
+     */
+    size_t update();
+
+    bool poll(bus b, event& e)                  { return parser(b).poll(e); }
+    sysex_span sysex(bus b, const event& e) const   { return parser(b).sysex(e); }
+
+    Parser& parser(bus b)                       { return _parsers[static_cast<uint8_t>(b)]; }
+    const Parser& parser(bus b) const           { return _parsers[static_cast<uint8_t>(b)]; }
+
+private:
+    Parser _parsers[BUSES_COUNT];
+};
+
+} /* endof namespace midi_input */
+} /* endof namespace midi */
+
+#include "midi_input.hpp"
+
+#endif /* DEF_MIDI_INPUT_HXX */
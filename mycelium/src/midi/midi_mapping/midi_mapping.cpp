@@ -0,0 +1,211 @@
+/**
+ * 
+ */
+
+#include "midi_mapping.hxx"
+
+#include <algorithm>
+#include <iterator>
+
+namespace midi
+{
+namespace midi_mapping
+{
+
+using hw::pads::Pad;
+using hw::analog::Encoder;
+using hw::analog::Fader;
+
+namespace
+{
+
+uint8_t elements_count(control_kind kind)
+    {
+        switch (kind)
+            {
+            case control_kind::Pad:         return PADS_COUNT;
+            case control_kind::Encoder:     return ENCODERS_COUNT;
+            case control_kind::Fader:       return FADERS_COUNT;
+            case control_kind::RingStyle:   return ENCODERS_COUNT;
+            default:                        return 0;
+            }
+    }
+
+/**
+ * Appends bindings to an output array
+ */
+struct writer
+{
+    binding* out;
+    size_t count;
+
+    void add(control_kind kind, uint8_t index, status s, uint8_t channel, uint8_t data1, uint8_t flags=Both)
+        {
+            if (count < BINDINGS_MAX_COUNT)
+                { out[count++] = binding{{kind, index}, make_status(s, channel), data1, flags}; }
+        }
+
+    void pad(Pad p, uint8_t channel, uint8_t note)
+        {
+            /* blind pads have no led to drive */
+            add(control_kind::Pad, static_cast<uint8_t>(p), status::NoteOn, channel, note,
+                hw::is_blind(p) ? Outgoing : Both);
+        }
+};
+
+/**
+ * Akai APC40 MKI communication protocol
+ */
+size_t apc40_bindings(writer& w)
+    {
+        using namespace hw::pads;
+        using namespace hw::analog;
+
+        for (uint8_t track=0; track<hw::COLUMNS_COUNT; ++track)
+            {
+                for (uint8_t row=0; row<CLIP_ROWS; ++row)
+                    { w.pad(CLIP_Y_X[row][track], track, 0x35 + row); }
+                w.pad(CLIP_STOP_X[track],       track, 0x34);
+                w.pad(TRACK_SELECT_X[track],    track, 0x33);
+                w.pad(ACTIVATOR_X[track],       track, 0x32);
+                w.pad(SOLO_CUE_X[track],        track, 0x31);
+                w.pad(RECORD_ARM_X[track],      track, 0x30);
+
+                w.add(control_kind::Fader, static_cast<uint8_t>(TRACK_LEVEL_X[track]), status::ControlChange, track, 0x07, Outgoing);
+                w.add(control_kind::Encoder, static_cast<uint8_t>(TRACK_ENCODER_X[track]), status::ControlChange, 0, 0x30 + track);
+                w.add(control_kind::Encoder, static_cast<uint8_t>(DEVICE_ENCODER_X[track]), status::ControlChange, 0, 0x10 + track);
+                w.add(control_kind::RingStyle, static_cast<uint8_t>(TRACK_ENCODER_X[track]), status::ControlChange, 0, 0x38 + track, Incoming);
+                w.add(control_kind::RingStyle, static_cast<uint8_t>(DEVICE_ENCODER_X[track]), status::ControlChange, 0, 0x18 + track, Incoming);
+                w.pad(DEVICE_CONTROL_X[track],  0, 0x3A + track);
+            }
+
+        for (uint8_t scene=0; scene<CLIP_ROWS; ++scene)
+            { w.pad(SCENE_LAUNCH_Y[scene], 0, 0x52 + scene); }
+        w.pad(Pad::STOP_ALL_CLIPS,  0, 0x51);
+        w.pad(Pad::SELECT_MASTER,   0, 0x50);
+
+        for (uint8_t i=0; i<TRACK_CONTROL_COUNT; ++i)
+            { w.pad(TRACK_CONTROL_X[i], 0, 0x57 + i); }
+        w.pad(Pad::PLAY,            0, 0x5B);
+        w.pad(Pad::STOP,            0, 0x5C);
+        w.pad(Pad::REC,             0, 0x5D);
+        w.pad(Pad::BANK_UP,         0, 0x5E);
+        w.pad(Pad::BANK_DOWN,       0, 0x5F);
+        w.pad(Pad::BANK_RIGHT,      0, 0x60);
+        w.pad(Pad::BANK_LEFT,       0, 0x61);
+        w.pad(Pad::SHIFT,           0, 0x62);
+        w.pad(Pad::TAP_TEMPO,       0, 0x63);
+        w.pad(Pad::NUDGE_PLUS,      0, 0x64);
+        w.pad(Pad::NUDGE_MINUS,     0, 0x65);
+
+        w.add(control_kind::Fader, static_cast<uint8_t>(Fader::MASTER_LEVEL), status::ControlChange, 0, 0x0E, Outgoing);
+        w.add(control_kind::Fader, static_cast<uint8_t>(Fader::CROSSFADE), status::ControlChange, 0, 0x0F, Outgoing);
+        w.add(control_kind::Encoder, static_cast<uint8_t>(Encoder::CUE_LEVEL), status::ControlChange, 0, 0x2F, Outgoing);
+        return w.count;
+    }
+
+size_t extended_bindings(writer& w)
+    {
+        for (uint8_t p=0; p<PADS_COUNT; ++p)
+            {
+                const Pad pad = static_cast<Pad>(p);
+                /* unwired positions of the matrix */
+                if (pad == Pad::__UNUSED_33_7__ || pad == Pad::__UNUSED_39_4__)
+                    { continue; }
+                w.pad(pad, 0, p);
+            }
+        for (uint8_t e=0; e<ENCODERS_COUNT; ++e)
+            {
+                const bool blind = hw::is_blind(static_cast<Encoder>(e));
+                w.add(control_kind::Encoder, e, status::ControlChange, 1, e, blind ? Outgoing : Both);
+                if (!blind)
+                    { w.add(control_kind::RingStyle, e, status::ControlChange, 1, 0x40 + e, Incoming); }
+            }
+        for (uint8_t f=0; f<FADERS_COUNT; ++f)
+            { w.add(control_kind::Fader, f, status::ControlChange, 1, 0x20 + f, Outgoing); }
+        return w.count;
+    }
+
+} /* endof namespace */
+
+error::status_byte
+compile(const binding* bindings, size_t count, MappingTable& table, size_t* failed)
+    {
+        /* in place, a table is too large for a temporary */
+        std::fill(std::begin(table.pads), std::end(table.pads), outgoing{0, 0});
+        std::fill(std::begin(table.encoders), std::end(table.encoders), outgoing{0, 0});
+        std::fill(std::begin(table.faders), std::end(table.faders), outgoing{0, 0});
+        std::fill(&table.inputs[0][0][0], &table.inputs[0][0][0] + INPUT_KINDS_COUNT * CHANNELS_COUNT * DATA_VALUES_COUNT,
+            control{control_kind::None, 0});
+
+        for (size_t i=0; i<count; ++i)
+            {
+                const binding& b = bindings[i];
+                const status type = type_of(b.status);
+                const bool valid = is_channel(b.status) && !is_status(b.data1)
+                    && (type == status::NoteOn || type == status::ControlChange)
+                    && b.target.index < elements_count(b.target.kind)
+                    && (b.flags & Both) != 0
+                    /* led-ring styles are never sent */
+                    && !(b.target.kind == control_kind::RingStyle && (b.flags & Outgoing));
+
+                control* input = nullptr;
+                if (valid && (b.flags & Incoming))
+                    {
+                        const uint8_t kind = static_cast<uint8_t>(type == status::NoteOn ? input_kind::Note : input_kind::ControlChange);
+                        input = &table.inputs[kind][channel_of(b.status)][b.data1];
+                    }
+
+                if (!valid || (input && !input->is_none()))
+                    {
+                        if (failed)
+                            { *failed = i; }
+                        return error::errcode::INVALID_ARGUMENT | error::severity::ERROR;
+                    }
+
+                if (input)
+                    { *input = b.target; }
+                if (!(b.flags & Outgoing))
+                    { continue; }
+
+                const outgoing out{b.status, b.data1};
+                switch (b.target.kind)
+                    {
+                    case control_kind::Pad:     table.pads[b.target.index] = out;       break;
+                    case control_kind::Encoder: table.encoders[b.target.index] = out;   break;
+                    case control_kind::Fader:   table.faders[b.target.index] = out;     break;
+                    default:                    break;
+                    }
+            }
+        return error::status_byte{};
+    }
+
+size_t
+default_bindings(mode m, binding out[BINDINGS_MAX_COUNT])
+    {
+        writer w{out, 0};
+        switch (m)
+            {
+            case mode::Apc40:       return apc40_bindings(w);
+            case mode::Extended:    return extended_bindings(w);
+            default:                return 0;
+            }
+    }
+
+error::status_byte
+Mappings::setup()
+    {
+        binding bindings[BINDINGS_MAX_COUNT];
+        for (uint8_t m=0; m<MODES_COUNT; ++m)
+            {
+                const size_t count = default_bindings(static_cast<mode>(m), bindings);
+                const error::status_byte status = compile(bindings, count, _tables[m]);
+                if (!status)
+                    { return status; }
+            }
+        select(mode::Apc40);
+        return error::status_byte{};
+    }
+
+} /* endof namespace midi_mapping */
+} /* endof namespace midi */
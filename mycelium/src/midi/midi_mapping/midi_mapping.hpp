@@ -0,0 +1,41 @@
+/**
+ * 
+ */
+
+#include "midi_mapping.hxx"
+
+namespace midi
+{
+namespace midi_mapping
+{
+
+inline control
+MappingTable::input(uint8_t status, uint8_t data1) const
+    {
+        /* note on, note off and control change: 0x8n, 0x9n, 0xBn */
+        const uint8_t type = (status >> 4) & 0x07;
+        if (!is_status(status) || type > 3 || type == 2)
+            { return control{control_kind::None, 0}; }
+        return inputs[type >> 1][status & CHANNEL_BITMASK][data1 & DATA_BITMASK];
+    }
+
+inline bool
+Mappings::pad_message(hw::pads::Pad p, bool pressed, message& out) const
+    {
+        const outgoing& bound = _active->output(p);
+        if (!bound.is_bound())
+            { return false; }
+
+        if (type_of(bound.status) == status::NoteOn)
+            {
+                const status s = pressed ? status::NoteOn : status::NoteOff;
+                out = message{make_status(s, channel_of(bound.status)), bound.data1, DATA_BITMASK};
+            }
+        else
+            { out = message{bound.status, bound.data1, static_cast<uint8_t>(pressed ? DATA_BITMASK : 0)}; }
+        LATENCY_MARK(static_cast<uint8_t>(p), Mapping);
+        return true;
+    }
+
+} /* endof namespace midi_mapping */
+} /* endof namespace midi */
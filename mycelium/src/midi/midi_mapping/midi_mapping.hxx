@@ -0,0 +1,204 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_MAPPING_HXX
+#define DEF_MIDI_MAPPING_HXX
+
+#include "error.hpp"
+#include "../midi_defines.hxx"
+#include "../../hw/hw_defines.hxx"
+#include "../../utils/latency/latency.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+namespace midi_mapping
+{
+
+static constexpr const uint8_t PADS_COUNT       = static_cast<uint8_t>(hw::pads::Pad::__PADS_COUNT__);
+static constexpr const uint8_t ENCODERS_COUNT   = static_cast<uint8_t>(hw::analog::Encoder::__ENCODERS_COUNT__);
+static constexpr const uint8_t FADERS_COUNT     = static_cast<uint8_t>(hw::analog::Fader::__FADERS_COUNT__);
+
+static constexpr const uint8_t CHANNELS_COUNT   = 16;
+static constexpr const uint8_t DATA_VALUES_COUNT = 128;
+
+/**
+ * Kind of the device element bound to a message
+ */
+enum class control_kind: uint8_t
+{
+    None,
+    Pad,            ///< pad presses and led state
+    Encoder,        ///< encoder values and led-ring value
+    Fader,          ///< fader values
+    RingStyle,      ///< encoder led-ring display style, incoming only
+    __KINDS_COUNT__
+};
+
+/**
+ * A device element: kind and index in its enumeration
+ */
+struct control
+{
+    control_kind kind;
+    uint8_t index;
+
+    bool is_none() const            { return kind == control_kind::None; }
+};
+
+/**
+ * Message family of incoming lookups, note on and note off share their bindings
+ */
+enum class input_kind: uint8_t
+{
+    Note,
+    ControlChange,
+    __INPUT_KINDS_COUNT__
+};
+
+static constexpr const uint8_t INPUT_KINDS_COUNT = static_cast<uint8_t>(input_kind::__INPUT_KINDS_COUNT__);
+
+/**
+ * Directions a binding applies to
+ */
+enum binding_flags: uint8_t
+{
+    Outgoing    = 0x01,     ///< device element sends the message
+    Incoming    = 0x02,     ///< message drives the device element feedback
+    Both        = 0x03,
+};
+
+/**
+ * Source form of a mapping, as written in configurations:
+ *  binds a device element to a note or control change, with its channel, in given directions
+ */
+struct binding
+{
+    control target;
+    uint8_t status;         ///< NoteOn or ControlChange status byte, with channel
+    uint8_t data1;          ///< note or controller number
+    uint8_t flags;          ///< @c binding_flags
+};
+
+/**
+ * Message sent by a device element, a zero status when unbound
+ */
+struct outgoing
+{
+    uint8_t status;
+    uint8_t data1;
+
+    bool is_bound() const           { return status != 0; }
+};
+
+/**
+ * Compiled mapping: flat arrays indexed by device element for outgoing messages,
+ *  and by message family, channel and note or controller number for incoming ones.
+ *  Every lookup is a single array access, about 8KB per table.
+ */
+struct MappingTable
+{
+    outgoing pads[PADS_COUNT];
+    outgoing encoders[ENCODERS_COUNT];
+    outgoing faders[FADERS_COUNT];
+    control inputs[INPUT_KINDS_COUNT][CHANNELS_COUNT][DATA_VALUES_COUNT];
+
+    const outgoing& output(hw::pads::Pad p) const           { return pads[static_cast<uint8_t>(p)]; }
+    const outgoing& output(hw::analog::Encoder e) const     { return encoders[static_cast<uint8_t>(e)]; }
+    const outgoing& output(hw::analog::Fader f) const       { return faders[static_cast<uint8_t>(f)]; }
+
+    /** Device element driven by given channel message, none if unbound or not a note or control change */
+    control input(uint8_t status, uint8_t data1) const;
+};
+
+/**
+ * Compiles @c count bindings into @c table, previous content is discarded.
+ *  Fails with INVALID_ARGUMENT on out of range elements or data, on messages other than
+ *  notes and control changes, and when two bindings drive a device element from the same message,
+ *  @c failed is then set to the index of the faulty binding
+ */
+error::status_byte compile(const binding* bindings, size_t count, MappingTable& table, size_t* failed=nullptr);
+
+/**
+ * Built-in mappings
+ */
+enum class mode: uint8_t
+{
+    /**
+     * Akai APC40 MKI layout: per track elements on the track channel,
+     *  global buttons and knobs on channel 0, led feedback on the same notes and controllers.
+     *  Device control knobs are bound on channel 0: the MKI moves them to the selected track channel,
+     *  which is left to the surface logic
+     */
+    Apc40,
+
+    /**
+     * Every pad on its own note of channel 0, numbered as @c hw::pads::Pad,
+     *  encoders and faders on channel 1: encoders on controllers 0 to 16,
+     *  faders on controllers 32 to 41, led-ring styles on controllers 64 to 80
+     */
+    Extended,
+
+    __MODES_COUNT__
+};
+
+static constexpr const uint8_t MODES_COUNT = static_cast<uint8_t>(mode::__MODES_COUNT__);
+
+/**
+ * Upper bound of the number of bindings of a mapping
+ */
+static constexpr const size_t BINDINGS_MAX_COUNT = 256;
+
+/**
+ * Writes the bindings of a built-in mapping, returns their count
+ */
+size_t default_bindings(mode m, binding out[BINDINGS_MAX_COUNT]);
+
+/**
+ * Compiled tables of all modes and the active one:
+ *  switching mode swaps the active table pointer
+ */
+class Mappings
+{
+public:
+    Mappings(): _tables{}, _active{&_tables[0]}, _mode{mode::Apc40}     {}
+
+    /** Compiles built-in mappings and selects the compatibility mode */
+    error::status_byte setup();
+
+    /** Replaces the mapping of given mode, by a configured one */
+    error::status_byte load(mode m, const binding* bindings, size_t count, size_t* failed=nullptr)
+        { return compile(bindings, count, _tables[static_cast<uint8_t>(m)], failed); }
+
+    void select(mode m)
+        {
+            _active = &_tables[static_cast<uint8_t>(m)];
+            _mode = m;
+        }
+
+    mode selected() const                       { return _mode; }
+    const MappingTable& active() const          { return *_active; }
+    const MappingTable& table(mode m) const     { return _tables[static_cast<uint8_t>(m)]; }
+
+    /**
+     * Turns a pad press or release into its message with the active mapping:
+     *  note on and note off, or control change to 127 and 0. Returns false if the pad is unbound.
+     *  Marks the @c latency::stage::Mapping of the pad trace
+     */
+    bool pad_message(hw::pads::Pad p, bool pressed, message& out) const;
+
+private:
+    MappingTable _tables[MODES_COUNT];
+    const MappingTable* _active;
+    mode _mode;
+};
+
+} /* endof namespace midi_mapping */
+} /* endof namespace midi */
+
+#include "midi_mapping.hpp"
+
+#endif /* DEF_MIDI_MAPPING_HXX */
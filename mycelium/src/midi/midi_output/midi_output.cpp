@@ -0,0 +1,16 @@
+/**
+ * 
+ */
+
+#include "midi_output.hxx"
+
+namespace midi
+{
+namespace midi_output
+{
+
+bool OutputDefaultSettings::NoteOffAsNoteOn = true;
+unsigned long OutputDefaultSettings::StatusRefreshPeriod = 1000000;
+
+} /* endof namespace midi_output */
+} /* endof namespace midi */
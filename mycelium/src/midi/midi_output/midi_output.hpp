@@ -0,0 +1,189 @@
+/**
+ * 
+ */
+
+#include "midi_output.hxx"
+
+namespace midi
+{
+namespace midi_output
+{
+
+template <typename S>
+uint8_t
+RunningStatus<S>::encode(const message& msg, unsigned long now, uint8_t out[MESSAGE_MAX_SIZE]) const
+    {
+        if (!is_status(msg.status) || type_of(msg.status) == status::SysExStart || type_of(msg.status) == status::SysExEnd)
+            { return 0; }
+        const uint8_t size = msg.size();
+        if ((1 < size && is_status(msg.data1)) || (2 < size && is_status(msg.data2)))
+            { return 0; }
+
+        uint8_t status_byte = msg.status;
+        uint8_t data2 = msg.data2;
+        if (Settings::NoteOffAsNoteOn && type_of(status_byte) == status::NoteOff)
+            {
+                status_byte = make_status(status::NoteOn, channel_of(status_byte));
+                data2 = 0;
+            }
+
+        const bool omit = is_channel(status_byte) && status_byte == _running
+            && (Settings::StatusRefreshPeriod == 0 || now - _refreshed < Settings::StatusRefreshPeriod);
+
+        uint8_t count = 0;
+        if (!omit)
+            { out[count++] = status_byte; }
+        if (1 < size)
+            { out[count++] = msg.data1; }
+        if (2 < size)
+            { out[count++] = data2; }
+        return count;
+    }
+
+template <typename S>
+bool
+RunningStatus<S>::commit(const uint8_t* bytes, uint8_t size, unsigned long now)
+    {
+        if (size == 0)
+            { return false; }
+        if (!is_status(bytes[0]))
+            { return true; }
+
+        if (is_channel(bytes[0]))
+            {
+                _running = bytes[0];
+                _refreshed = now;
+            }
+        else if (is_common(bytes[0]))
+            { _running = 0; }
+        return false;
+    }
+
+
+template <typename C, typename S>
+MidiOutput<C, S>::MidiOutput()
+    : _ports{}
+    {}
+
+template <typename C, typename S>
+void
+MidiOutput<C, S>::setup()
+    {
+        for (auto& p: _ports)
+            {
+                p.ring.clear();
+                p.ring.reset_peak();
+                p.running.cancel();
+                p.traces.clear();
+                p.queued = 0;
+                p.sent = 0;
+            }
+        reset_counters();
+    }
+
+template <typename C, typename S>
+void
+MidiOutput<C, S>::reset_counters()
+    {
+        for (auto& p: _ports)
+            { p.counters = bus_counters{}; }
+    }
+
+template <typename C, typename S>
+    error::status_byte
+MidiOutput<C, S>::send(bus b, const message& msg, uint8_t trace)
+    {
+        port& p = _ports[index(b)];
+        const unsigned long now = Context::micros();
+
+        uint8_t bytes[MESSAGE_MAX_SIZE];
+        const uint8_t size = p.running.encode(msg, now, bytes);
+        if (size == 0)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+
+        if (!p.ring.push(bytes, size))
+            {
+                p.counters.dropped += 1;
+                return error::errcode::MEMORY_ERROR | error::severity::WARNING;
+            }
+
+        p.counters.saved += p.running.commit(bytes, size, now);
+        p.counters.messages += 1;
+        p.counters.queued += size;
+        p.queued += size;
+
+        if (trace != NO_TRACE && p.traces.push(traced{p.queued, trace}))
+            { LATENCY_MARK(trace, TxEnqueue); }
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+    error::status_byte
+MidiOutput<C, S>::send_sysex(bus b, const uint8_t* bytes, size_t size)
+    {
+        if (size < 2
+            || bytes[0] != static_cast<uint8_t>(status::SysExStart)
+            || bytes[size -1] != static_cast<uint8_t>(status::SysExEnd))
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+        for (size_t i=1; i<size -1; ++i)
+            {
+                if (is_status(bytes[i]))
+                    { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+            }
+
+        port& p = _ports[index(b)];
+        if (!p.ring.push(bytes, size))
+            {
+                p.counters.dropped += 1;
+                return error::errcode::MEMORY_ERROR | error::severity::WARNING;
+            }
+
+        p.running.cancel();
+        p.counters.messages += 1;
+        p.counters.queued += size;
+        p.queued += size;
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+size_t
+MidiOutput<C, S>::flush()
+    {
+        size_t written = 0;
+        for (uint8_t i=0; i<BUSES_COUNT; ++i)
+            {
+                port& p = _ports[i];
+                const bus b = static_cast<bus>(i);
+
+                /* the ring content may wrap around: two contiguous chunks at most */
+                for (uint8_t chunk=0; chunk<2; ++chunk)
+                    {
+                        size_t count = 0;
+                        const uint8_t* bytes = p.ring.peek(count);
+                        const size_t room = count ? Context::available_for_write(b) : 0;
+                        if (room == 0)
+                            { break; }
+
+                        const size_t sent = Context::write(b, bytes, count < room ? count : room);
+                        p.ring.consume(sent);
+                        p.counters.sent += sent;
+                        p.sent += sent;
+                        written += sent;
+                        if (sent < count)
+                            { break; }
+                    }
+
+                /* traced messages whose last byte was handed over */
+                size_t count = 0;
+                for (const traced* t = p.traces.peek(count);
+                    count && static_cast<long>(p.sent - t->end) >= 0; t = p.traces.peek(count))
+                    {
+                        LATENCY_MARK(t->key, TxComplete);
+                        p.traces.consume(1);
+                    }
+            }
+        return written;
+    }
+
+} /* endof namespace midi_output */
+} /* endof namespace midi */
@@ -0,0 +1,212 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_OUTPUT_HXX
+#define DEF_MIDI_OUTPUT_HXX
+
+#include "error.hpp"
+#include "../midi_defines.hxx"
+#include "../../utils/containers/ring.hpp"
+#include "../../utils/latency/latency.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+namespace midi_output
+{
+
+/**
+ * Bytes queued per bus, about 80ms of a saturated 31250 bauds line
+ */
+static constexpr const size_t TX_BUFFER_SIZE = 256;
+
+/**
+ * Longest encoded short message
+ */
+static constexpr const uint8_t MESSAGE_MAX_SIZE = 3;
+
+/**
+ * Latency traces followed per bus, messages sent while it is full are not traced
+ */
+static constexpr const size_t TX_TRACES_COUNT = 16;
+
+/**
+ * Trace key of messages not followed by latency probes
+ */
+static constexpr const uint8_t NO_TRACE = 0xFF;
+
+struct OutputDefaultSettings
+{
+    /**
+     * Sends note off messages as note on with a zero velocity,
+     *  so notes releases share the running status of notes presses,
+     *  release velocities are lost
+     *
+     *  @note defaults to true, receivers must treat both forms the same way
+     */
+    static bool NoteOffAsNoteOn;
+
+    /**
+     * Maximum delay in microseconds between two explicit channel status bytes,
+     *  allows a receiver plugged in the middle of a stream to synchronize. Zero disables the refresh
+     *
+     *  @note defaults to 1s, costs a single byte per second under steady traffic
+     */
+    static unsigned long StatusRefreshPeriod;
+};
+
+/**
+ * Running status of a single transmitter:
+ *  channel messages repeating the last channel status byte are sent without it,
+ *  system common messages cancel the running status, realtime messages leave it untouched
+ */
+template <typename _Settings=OutputDefaultSettings>
+class RunningStatus
+{
+public:
+    using Settings = _Settings;
+
+    RunningStatus(): _running{0}, _refreshed{0}   {}
+
+    /**
+     * Encodes @c msg as it would be transmitted at @c now,
+     *  returns its size, or zero for invalid messages.
+     *  Transmitter state is only updated by @c commit
+     */
+    uint8_t encode(const message& msg, unsigned long now, uint8_t out[MESSAGE_MAX_SIZE]) const;
+
+    /**
+     * Updates the transmitter state once the @c size bytes encoded at @c now were queued,
+     *  returns true if the status byte was omitted
+     */
+    bool commit(const uint8_t* bytes, uint8_t size, unsigned long now);
+
+    /** Forgets the running status: next channel message carries its status */
+    void cancel()                   { _running = 0; }
+
+    uint8_t running() const         { return _running; }
+
+private:
+    uint8_t _running;               ///< last channel status byte sent, zero if none
+    unsigned long _refreshed;       ///< timestamp of the last explicit channel status byte in us
+};
+
+/**
+ * Transmission counters of a single bus
+ */
+struct bus_counters
+{
+    unsigned long messages;         ///< messages queued, SysEx included
+    unsigned long queued;           ///< bytes queued
+    unsigned long sent;             ///< bytes handed to the serial port
+    unsigned long saved;            ///< status bytes omitted by the running status
+    unsigned long dropped;          ///< messages refused by a full buffer
+};
+
+/**
+ * Non-blocking MIDI output on all serial buses:
+ *  messages are encoded with running status into a TX ring per bus,
+ *  and @c flush hands as much as each serial port accepts without waiting.
+ *  Messages, realtime included, are transmitted in the order they were sent on each bus,
+ *  a message either fits whole in the ring or is dropped, keeping the stream consistent.
+ *
+ * Messages sent with a trace key are marked @c TxEnqueue once queued,
+ *  and @c TxComplete once their last byte is handed to the serial port.
+ *
+ * Context must provide:
+ *  - size_t available_for_write(bus): free room in the serial port transmit buffer
+ *  - size_t write(bus, const uint8_t* bytes, size_t count): writes to the serial port,
+ *      returns the count of written bytes
+ *  - unsigned long micros(): current timestamp in microseconds
+ */
+template <typename _Context, typename _Settings=OutputDefaultSettings>
+class MidiOutput
+{
+public:
+    using Settings = _Settings;
+    using Context = _Context;
+    using ring_type = containers::Ring<uint8_t, TX_BUFFER_SIZE>;
+
+    MidiOutput();
+
+    /** Empties all buffers and resets counters and running status */
+    void setup();
+
+    /**
+     * Queues a short message, channel voice, system common or realtime,
+     *  fails with MEMORY_ERROR if it does not fit in the bus buffer.
+     *  @c trace is the latency trace key of the message, e.g. the pad which triggered it
+     */
+    error::status_byte send(bus b, const message& msg, uint8_t trace=NO_TRACE);
+
+    error::status_byte note_on(bus b, uint8_t channel, uint8_t note, uint8_t velocity, uint8_t trace=NO_TRACE)
+        { return send(b, {make_status(status::NoteOn, channel), note, velocity}, trace); }
+
+    error::status_byte note_off(bus b, uint8_t channel, uint8_t note, uint8_t velocity=0, uint8_t trace=NO_TRACE)
+        { return send(b, {make_status(status::NoteOff, channel), note, velocity}, trace); }
+
+    error::status_byte control_change(bus b, uint8_t channel, uint8_t control, uint8_t value, uint8_t trace=NO_TRACE)
+        { return send(b, {make_status(status::ControlChange, channel), control, value}, trace); }
+
+    error::status_byte program_change(bus b, uint8_t channel, uint8_t program)
+        { return send(b, {make_status(status::ProgramChange, channel), program, 0}); }
+
+    error::status_byte pitch_bend(bus b, uint8_t channel, uint16_t value)
+        { return send(b, {make_status(status::PitchBend, channel),
+            static_cast<uint8_t>(value & DATA_BITMASK), static_cast<uint8_t>((value >> 7) & DATA_BITMASK)}); }
+
+    error::status_byte realtime(bus b, status s)
+        { return send(b, {static_cast<uint8_t>(s), 0, 0}); }
+
+    /**
+     * Queues a whole system exclusive message, including its 0xF0 and 0xF7 framing bytes,
+     *  fails with MEMORY_ERROR if it does not fit in the bus buffer
+     */
+    error::status_byte send_sysex(bus b, const uint8_t* bytes, size_t size);
+
+    /**
+     * Hands queued bytes of all buses to the serial ports, as much as they accept,
+     *  never blocks and should be called on each loop, returns the count of bytes written
+     */
+    size_t flush();
+
+    /** Bytes waiting in the bus buffer */
+    size_t occupancy(bus b) const               { return _ports[index(b)].ring.size(); }
+    size_t peak_occupancy(bus b) const          { return _ports[index(b)].ring.peak(); }
+    static constexpr size_t capacity()          { return TX_BUFFER_SIZE; }
+
+    const bus_counters& counters(bus b) const   { return _ports[index(b)].counters; }
+    void reset_counters();
+
+private:
+    static constexpr uint8_t index(bus b)       { return static_cast<uint8_t>(b); }
+
+    /** Traced message, by the position of its last byte in the bus stream */
+    struct traced
+    {
+        unsigned long end;
+        uint8_t key;
+    };
+
+    struct port
+    {
+        ring_type ring;
+        RunningStatus<Settings> running;
+        bus_counters counters;
+        containers::Ring<traced, TX_TRACES_COUNT> traces;
+        unsigned long queued;       ///< bytes queued since setup, free-running
+        unsigned long sent;         ///< bytes handed to the serial port since setup, free-running
+    };
+
+    port _ports[BUSES_COUNT];
+};
+
+} /* endof namespace midi_output */
+} /* endof namespace midi */
+
+#include "midi_output.hpp"
+
+#endif /* DEF_MIDI_OUTPUT_HXX */
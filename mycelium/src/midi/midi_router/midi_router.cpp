@@ -0,0 +1,43 @@
+/**
+ * 
+ */
+
+#include "midi_router.hxx"
+
+namespace midi
+{
+namespace midi_router
+{
+
+unsigned long RouterDefaultSettings::MaxDelay = 10000;
+unsigned long RouterDefaultSettings::RealtimeMaxDelay = 20000;
+
+uint16_t
+class_of(uint8_t byte)
+    {
+        switch (type_of(byte))
+            {
+            case status::NoteOff:
+            case status::NoteOn:            return Notes;
+            case status::PolyPressure:      return PolyPressure;
+            case status::ControlChange:     return ControlChange;
+            case status::ProgramChange:     return ProgramChange;
+            case status::ChannelPressure:   return ChannelPressure;
+            case status::PitchBend:         return PitchBend;
+            case status::SysExStart:        return SysEx;
+            case status::TimeCodeQuarter:
+            case status::SongPosition:
+            case status::SongSelect:
+            case status::TuneRequest:       return Common;
+            case status::Clock:             return Clock;
+            case status::Start:
+            case status::Continue:
+            case status::Stop:              return Transport;
+            case status::ActiveSensing:
+            case status::Reset:             return Sensing;
+            default:                        return 0;
+            }
+    }
+
+} /* endof namespace midi_router */
+} /* endof namespace midi */
@@ -0,0 +1,106 @@
+/**
+ * 
+ */
+
+#include "midi_router.hxx"
+
+#include <cstring>
+
+namespace midi
+{
+namespace midi_router
+{
+
+template <typename O, typename S>
+Router<O, S>::Router(Output& output)
+    : _output{output}, _routes{}, _counters{}, _scratch{}
+    {}
+
+template <typename O, typename S>
+void
+Router<O, S>::clear()
+    {
+        for (uint8_t s=0; s<SOURCES_COUNT; ++s)
+            for (uint8_t k=0; k<SINKS_COUNT; ++k)
+                {
+                    _routes[s][k] = route{0, 0};
+                    _counters[s][k] = route_counters{};
+                }
+    }
+
+template <typename O, typename S>
+bool
+Router<O, S>::forward(sink k, const midi_input::event& e, const midi_input::sysex_span& sysex)
+    {
+        const bus b = bus_of(k);
+        const unsigned long bound = is_realtime(e.status) ? Settings::RealtimeMaxDelay : Settings::MaxDelay;
+        if (delay(b) > bound)
+            { return false; }
+
+        if (!e.is_sysex())
+            { return static_cast<bool>(_output.send(b, message{e.status, e.data1, e.data2})); }
+
+        if (sysex.sizes[1] == 0)
+            { return static_cast<bool>(_output.send_sysex(b, sysex.chunks[0], sysex.sizes[0])); }
+        std::memcpy(_scratch, sysex.chunks[0], sysex.sizes[0]);
+        std::memcpy(_scratch + sysex.sizes[0], sysex.chunks[1], sysex.sizes[1]);
+        return static_cast<bool>(_output.send_sysex(b, _scratch, sysex.size()));
+    }
+
+template <typename O, typename S>
+template <typename InternalFn>
+    uint8_t
+Router<O, S>::dispatch(source s, const midi_input::event& e, const midi_input::sysex_span& sysex, InternalFn&& internal)
+    {
+        uint8_t reached = 0;
+        for (uint8_t k=0; k<SINKS_COUNT; ++k)
+            {
+                const route& r = _routes[index(s)][k];
+                if (!r.is_connected())
+                    { continue; }
+                route_counters& counters = _counters[index(s)][k];
+                if (!r.accepts(e.status))
+                    {
+                        counters.filtered += 1;
+                        continue;
+                    }
+
+                if (static_cast<sink>(k) == sink::Internal)
+                    { internal(s, e); }
+                else if (!forward(static_cast<sink>(k), e, sysex))
+                    {
+                        counters.dropped += 1;
+                        continue;
+                    }
+                counters.forwarded += 1;
+                reached += 1;
+            }
+        return reached;
+    }
+
+template <typename O, typename S>
+template <typename InternalFn>
+    uint8_t
+Router<O, S>::dispatch(source s, const message& msg, unsigned long timestamp, InternalFn&& internal)
+    {
+        const midi_input::event e{msg.status, msg.data1, msg.data2, 0, 0, timestamp};
+        return dispatch(s, e, midi_input::sysex_span{{nullptr, nullptr}, {0, 0}}, internal);
+    }
+
+template <typename O, typename S>
+template <typename Parser, typename InternalFn>
+    size_t
+Router<O, S>::process(source s, Parser& parser, InternalFn&& internal)
+    {
+        midi_input::event e;
+        size_t count = 0;
+        while (parser.poll(e))
+            {
+                count += 1;
+                dispatch(s, e, e.is_sysex() ? parser.sysex(e) : midi_input::sysex_span{{nullptr, nullptr}, {0, 0}}, internal);
+            }
+        return count;
+    }
+
+} /* endof namespace midi_router */
+} /* endof namespace midi */
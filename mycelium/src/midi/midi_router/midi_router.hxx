@@ -0,0 +1,203 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_ROUTER_HXX
+#define DEF_MIDI_ROUTER_HXX
+
+#include "error.hpp"
+#include "../midi_defines.hxx"
+#include "../midi_input/midi_input.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+namespace midi_router
+{
+
+/**
+ * Messages origins: both serial inputs and the control surface
+ */
+enum class source: uint8_t
+{
+    Rx1,
+    Rx2,
+    Surface,
+    __SOURCES_COUNT__
+};
+
+/**
+ * Messages destinations: both serial outputs and the firmware handlers
+ */
+enum class sink: uint8_t
+{
+    Tx1,
+    Tx2,
+    Internal,
+    __SINKS_COUNT__
+};
+
+static constexpr const uint8_t SOURCES_COUNT = static_cast<uint8_t>(source::__SOURCES_COUNT__);
+static constexpr const uint8_t SINKS_COUNT = static_cast<uint8_t>(sink::__SINKS_COUNT__);
+
+/**
+ * Message classes selected by a route, as a bitmask
+ */
+enum message_class: uint16_t
+{
+    Notes           = 0x0001,   ///< note on and note off
+    PolyPressure    = 0x0002,
+    ControlChange   = 0x0004,
+    ProgramChange   = 0x0008,
+    ChannelPressure = 0x0010,
+    PitchBend       = 0x0020,
+    SysEx           = 0x0040,
+    Common          = 0x0080,   ///< time code, song position and select, tune request
+    Clock           = 0x0100,
+    Transport       = 0x0200,   ///< start, continue, stop
+    Sensing         = 0x0400,   ///< active sensing and reset
+
+    ChannelVoice    = 0x003F,
+    System          = 0x07C0,
+    AllClasses      = 0x07FF,
+};
+
+/** Class of a status byte, zero for data bytes and undefined statuses */
+uint16_t class_of(uint8_t status);
+
+/**
+ * Channels selected by a route, bit N selects channel N
+ */
+static constexpr const uint16_t ALL_CHANNELS = 0xFFFF;
+
+/**
+ * Filter of a route, a route with no class is disconnected,
+ *  channels only apply to channel voice messages
+ */
+struct route
+{
+    uint16_t classes;
+    uint16_t channels;
+
+    bool is_connected() const       { return classes != 0; }
+    bool accepts(uint8_t status) const
+        {
+            if (!(class_of(status) & classes))
+                { return false; }
+            return !is_channel(status) || (channels & (1 << channel_of(status)));
+        }
+};
+
+/**
+ * Counters of a single route
+ */
+struct route_counters
+{
+    unsigned long forwarded;    ///< messages handed to the sink
+    unsigned long filtered;     ///< messages refused by the route filter
+    unsigned long dropped;      ///< messages dropped to bound the sink queue delay, or not fitting in it
+};
+
+/**
+ * 
+ */
+struct RouterDefaultSettings
+{
+    /**
+     * Longest wait in microseconds of a message in an output queue before its first byte is sent,
+     *  messages which would wait longer are dropped whole.
+     *  Bounds the latency added by merging sources on a saturated output
+     *
+     *  @note defaults to 10ms, about 31 bytes on a 31250 bauds line
+     */
+    static unsigned long MaxDelay;
+
+    /**
+     * Same as @c MaxDelay for realtime messages, clock and transport,
+     *  a larger bound keeps them flowing when other messages get dropped
+     *
+     *  @note defaults to 20ms
+     */
+    static unsigned long RealtimeMaxDelay;
+};
+
+/**
+ * Static routing matrix from sources to sinks, with per route channel and class filters.
+ *  Serial sinks merge their sources in arrival order: each message is queued whole,
+ *  system exclusive messages included, or dropped whole when it would wait longer than allowed.
+ *  Internal sink is a functor given when dispatching, called synchronously.
+ *
+ * Output must follow @c midi_output::MidiOutput interface:
+ *  - error::status_byte send(bus, const message&)
+ *  - error::status_byte send_sysex(bus, const uint8_t*, size_t)
+ *  - size_t occupancy(bus): bytes waiting in the bus queue
+ *
+ * @note the delay bound only covers the output queue,
+ *  the serial port transmit buffer adds a constant delay
+ */
+template <typename _Output, typename _Settings=RouterDefaultSettings>
+class Router
+{
+public:
+    using Output = _Output;
+    using Settings = _Settings;
+
+    explicit Router(Output& output);
+
+    /** Disconnects every route and resets counters */
+    void clear();
+
+    void connect(source s, sink k, uint16_t classes=AllClasses, uint16_t channels=ALL_CHANNELS)
+        { _routes[index(s)][index(k)] = route{classes, channels}; }
+    void disconnect(source s, sink k)
+        { _routes[index(s)][index(k)] = route{0, 0}; }
+
+    const route& route_of(source s, sink k) const                   { return _routes[index(s)][index(k)]; }
+    const route_counters& counters(source s, sink k) const          { return _counters[index(s)][index(k)]; }
+
+    /**
+     * Routes a received event, @c sysex holds the bytes of system exclusive events.
+     *  @c internal(source, const midi_input::event&) is called when routed to the internal sink.
+     *  Returns the count of sinks which received the event
+     */
+    template <typename InternalFn>
+    uint8_t dispatch(source s, const midi_input::event& e, const midi_input::sysex_span& sysex, InternalFn&& internal);
+
+    /** Routes a short message, as sent by the control surface */
+    template <typename InternalFn>
+    uint8_t dispatch(source s, const message& msg, unsigned long timestamp, InternalFn&& internal);
+
+    /**
+     * Routes every event available from @c parser, following @c midi_input::Parser interface,
+     *  returns the count of polled events
+     */
+    template <typename Parser, typename InternalFn>
+    size_t process(source s, Parser& parser, InternalFn&& internal);
+
+    /** Predicted wait in microseconds of a message queued now on given bus */
+    unsigned long delay(bus b) const        { return _output.occupancy(b) * BYTE_DURATION_US; }
+
+private:
+    static constexpr uint8_t index(source s)    { return static_cast<uint8_t>(s); }
+    static constexpr uint8_t index(sink k)      { return static_cast<uint8_t>(k); }
+    static constexpr bus bus_of(sink k)         { return k == sink::Tx1 ? bus::Bus1 : bus::Bus2; }
+
+    /** Queues @c e on a serial sink if it would not wait longer than allowed */
+    bool forward(sink k, const midi_input::event& e, const midi_input::sysex_span& sysex);
+
+    Output& _output;
+    route _routes[SOURCES_COUNT][SINKS_COUNT];
+    route_counters _counters[SOURCES_COUNT][SINKS_COUNT];
+
+    /** Contiguous copy of system exclusive messages wrapping around the parser buffer */
+    uint8_t _scratch[midi_input::SYSEX_BUFFER_SIZE];
+};
+
+} /* endof namespace midi_router */
+} /* endof namespace midi */
+
+#include "midi_router.hpp"
+
+#endif /* DEF_MIDI_ROUTER_HXX */
@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "midi_sampler.hxx"
@@ -0,0 +1,196 @@
+/**
+ * 
+ */
+
+#include "midi_sampler.hxx"
+
+namespace midi
+{
+namespace midi_sampler
+{
+
+template <size_t S>
+void
+Recorder<S>::begin(slot_type& slot, uint16_t value)
+    {
+        _slot = &slot;
+        _slot->start = _value = value;
+        _slot->ticks = 1;
+        _slot->size = 0;
+        _run = Run::None;
+        _count = 0;
+        _delta = 0;
+        _has_delta = false;
+        _full = false;
+    }
+
+template <size_t S>
+bool
+Recorder<S>::write(const uint8_t* bytes, uint8_t size)
+    {
+        if (static_cast<size_t>(_slot->size) + size > slot_type::Size)
+            {
+                _full = true;
+                return false;
+            }
+        for (uint8_t i=0; i<size; ++i)
+            { _slot->bytes[_slot->size++] = bytes[i]; }
+        return true;
+    }
+
+template <size_t S>
+bool
+Recorder<S>::flush()
+    {
+        if (_run == Run::None)
+            { return true; }
+        const uint8_t code = (_run == Run::Hold ? HOLD : RAMP) | (_count -1);
+        if (!write(&code, 1))
+            { return false; }
+        _run = Run::None;
+        _count = 0;
+        return true;
+    }
+
+template <size_t S>
+bool
+Recorder<S>::tick(uint16_t value)
+    {
+        if (_slot == nullptr || _full || _slot->ticks == UINT16_MAX)
+            { return false; }
+
+        const int32_t delta = static_cast<int32_t>(value) - _value;
+        const Run run = delta == 0 ? Run::Hold : _has_delta && delta == _delta ? Run::Ramp : Run::None;
+        const uint8_t run_max = run == Run::Hold ? HOLD_MAX : RAMP_MAX;
+
+        if (run != Run::None && run == _run && _count < run_max)
+            {
+                /* the run byte is already accounted for */
+                _count += 1;
+            }
+        else if (run != Run::None)
+            {
+                /* room for the pending run and the new one, written later */
+                if (!fits(1) || !flush())
+                    {
+                        _full = true;
+                        return false;
+                    }
+                _run = run;
+                _count = 1;
+            }
+        else
+            {
+                uint8_t code[CODE_MAX_SIZE];
+                uint8_t size;
+                if (-static_cast<int32_t>(DELTA_BIAS) <= delta && delta < DELTA_BIAS)
+                    {
+                        code[0] = static_cast<uint8_t>(delta + DELTA_BIAS);
+                        size = 1;
+                    }
+                else
+                    {
+                        code[0] = ABSOLUTE;
+                        code[1] = value >> 8;
+                        code[2] = value & 0xFF;
+                        size = 3;
+                    }
+                if (!fits(size) || !flush() || !write(code, size))
+                    {
+                        _full = true;
+                        return false;
+                    }
+                _has_delta = size == 1;
+                _delta = _has_delta ? delta : 0;
+            }
+
+        _value = value;
+        _slot->ticks += 1;
+        return true;
+    }
+
+template <size_t S>
+void
+Recorder<S>::end()
+    {
+        if (_slot == nullptr)
+            { return; }
+        /* room for the pending run is always kept */
+        flush();
+        _slot = nullptr;
+    }
+
+template <size_t S>
+void
+Player<S>::begin(const slot_type& slot)
+    {
+        _slot = &slot;
+        rewind();
+    }
+
+template <size_t S>
+void
+Player<S>::rewind()
+    {
+        _position = 0;
+        _elapsed = 0;
+        _value = _slot->start;
+        _delta = 0;
+        _remaining = 0;
+        _ramp = false;
+    }
+
+template <size_t S>
+uint16_t
+Player<S>::tick()
+    {
+        _changed = false;
+        if (_slot == nullptr || _slot->ticks == 0)
+            { return _value; }
+
+        const uint16_t previous = _value;
+        if (_elapsed == _slot->ticks)
+            { rewind(); }
+
+        if (_elapsed == 0)
+            {
+                /* first tick is the start value */
+            }
+        else if (_remaining > 0)
+            {
+                _remaining -= 1;
+                if (_ramp)
+                    { _value += _delta; }
+            }
+        else if (_position < _slot->size)
+            {
+                const uint8_t code = _slot->bytes[_position];
+                if (code < HOLD)
+                    {
+                        _delta = static_cast<int16_t>(code) - DELTA_BIAS;
+                        _value += _delta;
+                        _position += 1;
+                    }
+                else if (code == ABSOLUTE)
+                    {
+                        _value = (static_cast<uint16_t>(_slot->bytes[_position + 1]) << 8) | _slot->bytes[_position + 2];
+                        _delta = 0;
+                        _position += 3;
+                    }
+                else
+                    {
+                        _ramp = code >= RAMP;
+                        _remaining = code & (_ramp ? RAMP_MAX -1 : HOLD_MAX -1);
+                        if (_ramp)
+                            { _value += _delta; }
+                        _position += 1;
+                    }
+            }
+
+        _elapsed += 1;
+        _changed = _value != previous;
+        return _value;
+    }
+
+} /* endof namespace midi_sampler */
+} /* endof namespace midi */
@@ -0,0 +1,145 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_SAMPLER_HXX
+#define DEF_MIDI_SAMPLER_HXX
+
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+namespace midi_sampler
+{
+
+/**
+ * Encoded motion codes, each one covers one or more ticks:
+ *  - @c 0x00 to @c 0x7F: value moves by the code minus @c DELTA_BIAS, one tick
+ *  - @c 0x80 to @c 0xBF: value holds for the 6 low bits plus one ticks, up to @c HOLD_MAX
+ *  - @c 0xC0 to @c 0xDF: last delta repeats for the 5 low bits plus one ticks, up to @c RAMP_MAX
+ *  - @c 0xFF followed by two bytes: absolute value, most significant byte first, one tick
+ * Other codes are reserved.
+ */
+static constexpr const uint8_t DELTA_BIAS = 64;
+static constexpr const uint8_t HOLD = 0x80;
+static constexpr const uint8_t RAMP = 0xC0;
+static constexpr const uint8_t ABSOLUTE = 0xFF;
+
+static constexpr const uint8_t HOLD_MAX = 64;
+static constexpr const uint8_t RAMP_MAX = 32;
+
+/** Longest code, a tick never reads more */
+static constexpr const uint8_t CODE_MAX_SIZE = 3;
+
+/**
+ * Bytes of a pattern slot, a 40 pads matrix holds 20kB of motion
+ */
+static constexpr const size_t SLOT_SIZE = 512;
+
+/**
+ * Motion of a single controller, recorded once per tick:
+ *  the first value is kept aside, following ones are encoded as codes.
+ *  Playback loops after @c ticks.
+ */
+template <size_t _Size=SLOT_SIZE>
+struct motion_slot
+{
+    static constexpr const size_t Size = _Size;
+
+    uint16_t start;             ///< value on first tick
+    uint16_t ticks;             ///< recorded ticks, zero for an empty slot
+    uint16_t size;              ///< encoded bytes
+    uint8_t bytes[Size];
+};
+
+/**
+ * Records a controller into a slot, one value per tick:
+ *  changes are delta-encoded and runs of holds or of equal deltas are collapsed, as a slow
+ *  knob turn or a held fader costs a byte per run instead of a byte per tick.
+ *  Recording stops when the slot is full.
+ */
+template <size_t _Size=SLOT_SIZE>
+class Recorder
+{
+public:
+    using slot_type = motion_slot<_Size>;
+
+    Recorder(): _slot{nullptr}, _value{0}, _run{Run::None}, _count{0}, _delta{0}, _has_delta{false}, _full{false}   {}
+
+    /** Empties the slot and records its first tick */
+    void begin(slot_type& slot, uint16_t value);
+
+    /** Records next tick, returns false once the slot is full: the tick is not recorded */
+    bool tick(uint16_t value);
+
+    /** Writes the pending run, the slot is ready for playback */
+    void end();
+
+    bool is_full() const            { return _full; }
+
+private:
+    enum class Run: uint8_t { None, Hold, Ramp };
+
+    /** Writes @c size bytes if they fit with the pending run, else marks the slot full */
+    bool write(const uint8_t* bytes, uint8_t size);
+
+    /** Writes the pending run, returns false if it does not fit */
+    bool flush();
+
+    /** Returns true if @c size bytes fit after the pending run */
+    bool fits(size_t size) const
+        { return _slot->size + (_run != Run::None ? 1U : 0U) + size <= slot_type::Size; }
+
+    slot_type* _slot;
+    uint16_t _value;
+    Run _run;
+    uint8_t _count;             ///< ticks of the pending run
+    int16_t _delta;             ///< delta of the last delta code
+    bool _has_delta;
+    bool _full;
+};
+
+/**
+ * Plays a slot back, one value per tick, looping after its length:
+ *  each tick reads at most one code, its cost does not depend on the motion.
+ */
+template <size_t _Size=SLOT_SIZE>
+class Player
+{
+public:
+    using slot_type = motion_slot<_Size>;
+
+    Player(): _slot{nullptr}, _position{0}, _elapsed{0}, _value{0}, _delta{0}, _remaining{0}, _ramp{false}, _changed{false}  {}
+
+    /** Rewinds to the first tick of @c slot */
+    void begin(const slot_type& slot);
+
+    /** Value of next tick, the last value forever for an empty slot */
+    uint16_t tick();
+
+    /** Returns true if last tick changed the value */
+    bool changed() const            { return _changed; }
+
+    /** Ticks played since the beginning of the loop */
+    uint16_t elapsed() const        { return _elapsed; }
+
+private:
+    void rewind();
+
+    const slot_type* _slot;
+    uint16_t _position;
+    uint16_t _elapsed;
+    uint16_t _value;
+    int16_t _delta;
+    uint8_t _remaining;         ///< ticks left in current run
+    bool _ramp;                 ///< current run repeats the delta, else holds
+    bool _changed;
+};
+
+} /* endof namespace midi_sampler */
+} /* endof namespace midi */
+
+#include "midi_sampler.hpp"
+
+#endif /* DEF_MIDI_SAMPLER_HXX */
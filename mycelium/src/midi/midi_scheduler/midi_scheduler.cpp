@@ -0,0 +1,38 @@
+/**
+ * 
+ */
+
+#include "midi_scheduler.hxx"
+
+namespace midi
+{
+namespace midi_scheduler
+{
+
+uint8_t SchedulerDefaultSettings::QueueDepth = 3;
+unsigned long SchedulerDefaultSettings::RateCap = 1500;
+unsigned long SchedulerDefaultSettings::RateBurst = 32;
+
+level
+level_of(uint8_t byte)
+    {
+        switch (type_of(byte))
+            {
+            case status::NoteOff:
+            case status::NoteOn:
+            case status::SongPosition:
+            case status::Clock:
+            case status::Start:
+            case status::Continue:
+            case status::Stop:
+            case status::Reset:
+                return level::Urgent;
+            case status::ControlChange:
+                return level::Controls;
+            default:
+                return level::Others;
+            }
+    }
+
+} /* endof namespace midi_scheduler */
+} /* endof namespace midi */
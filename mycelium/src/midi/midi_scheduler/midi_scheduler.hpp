@@ -0,0 +1,184 @@
+/**
+ * 
+ */
+
+#include "midi_scheduler.hxx"
+
+namespace midi
+{
+namespace midi_scheduler
+{
+
+template <typename O, typename S>
+Scheduler<O, S>::Scheduler(Output& output)
+    : _output{output}, _buses{}, _last_refill{0}
+    {}
+
+template <typename O, typename S>
+void
+Scheduler<O, S>::setup(unsigned long now)
+    {
+        for (auto& p: _buses)
+            {
+                p.urgent.clear();
+                p.others.clear();
+                p.controls.clear();
+                for (auto& channel: p.slots)
+                    for (auto& slot: channel)
+                        { slot = control_slot{0, 0, false}; }
+                for (auto& t: p.tokens)
+                    { t = Settings::RateBurst * TOKENS_PER_BYTE; }
+                p.counters = scheduler_counters{};
+            }
+        _last_refill = now;
+    }
+
+template <typename O, typename S>
+    error::status_byte
+Scheduler<O, S>::send(bus b, const message& msg, uint8_t source)
+    {
+        if (SOURCES_COUNT <= source || !is_status(msg.status) || type_of(msg.status) == status::SysExStart)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+
+        port& p = _buses[index(b)];
+        bool queued = false;
+        switch (level_of(msg.status))
+            {
+            case level::Urgent:
+                queued = p.urgent.push(msg);
+                break;
+
+            case level::Others:
+                queued = p.others.push(queued_message{msg, source});
+                break;
+
+            case level::Controls:
+                {
+                    control_slot& slot = p.slots[channel_of(msg.status)][msg.data1 & DATA_BITMASK];
+                    if (slot.pending)
+                        {
+                            /* still waiting: only the latest value matters */
+                            slot.value = msg.data2;
+                            slot.source = source;
+                            p.counters.merged += 1;
+                            return error::status_byte{};
+                        }
+                    queued = p.controls.push(static_cast<uint16_t>((channel_of(msg.status) << 7) | (msg.data1 & DATA_BITMASK)));
+                    if (queued)
+                        { slot = control_slot{msg.data2, source, true}; }
+                    break;
+                }
+
+            default:
+                break;
+            }
+
+        if (!queued)
+            {
+                p.counters.dropped += 1;
+                return error::errcode::MEMORY_ERROR | error::severity::WARNING;
+            }
+        p.counters.queued += 1;
+        return error::status_byte{};
+    }
+
+template <typename O, typename S>
+void
+Scheduler<O, S>::refill(port& p, unsigned long now)
+    {
+        /* long idle periods saturate the buckets anyway */
+        const unsigned long elapsed = now - _last_refill < 1000000 ? now - _last_refill : 1000000;
+        const unsigned long long full = Settings::RateBurst * TOKENS_PER_BYTE;
+        for (auto& t: p.tokens)
+            {
+                t += static_cast<unsigned long long>(elapsed) * Settings::RateCap;
+                t = t < full ? t : full;
+            }
+    }
+
+template <typename O, typename S>
+bool
+Scheduler<O, S>::spend(port& p, uint8_t source, uint8_t size)
+    {
+        if (Settings::RateCap == 0)
+            { return true; }
+        const unsigned long long cost = size * TOKENS_PER_BYTE;
+        if (p.tokens[source] < cost)
+            {
+                p.counters.throttled += 1;
+                return false;
+            }
+        p.tokens[source] -= cost;
+        return true;
+    }
+
+template <typename O, typename S>
+bool
+Scheduler<O, S>::release(bus b, port& p)
+    {
+        message msg;
+        if (p.urgent.pop(msg))
+            {
+                _output.send(b, msg);
+                return true;
+            }
+
+        size_t count = 1;
+        const queued_message* other = p.others.peek(count);
+        if (count != 0 && spend(p, other->source, other->msg.size()))
+            {
+                _output.send(b, other->msg);
+                p.others.consume(1);
+                return true;
+            }
+
+        /* throttled controllers go back to the end of the queue, keeping their slot */
+        for (uint8_t i=0; i<ROTATIONS_MAX; ++i)
+            {
+                uint16_t key;
+                if (!p.controls.pop(key))
+                    { return false; }
+                control_slot& slot = p.slots[key >> 7][key & DATA_BITMASK];
+                if (spend(p, slot.source, 3))
+                    {
+                        slot.pending = false;
+                        _output.send(b, message{make_status(status::ControlChange, key >> 7), static_cast<uint8_t>(key & DATA_BITMASK), slot.value});
+                        return true;
+                    }
+                p.controls.push(key);
+            }
+        return false;
+    }
+
+template <typename O, typename S>
+size_t
+Scheduler<O, S>::flush(unsigned long now)
+    {
+        size_t written = _output.flush();
+        for (uint8_t i=0; i<BUSES_COUNT; ++i)
+            {
+                port& p = _buses[i];
+                refill(p, now);
+                while (_output.occupancy(static_cast<bus>(i)) < Settings::QueueDepth && release(static_cast<bus>(i), p))
+                    { p.counters.released += 1; }
+            }
+        _last_refill = now;
+        return written + _output.flush();
+    }
+
+template <typename O, typename S>
+size_t
+Scheduler<O, S>::pending(bus b, level l) const
+    {
+        const port& p = _buses[index(b)];
+        switch (l)
+            {
+            case level::Urgent:     return p.urgent.size();
+            case level::Others:     return p.others.size();
+            case level::Controls:   return p.controls.size();
+            default:                return 0;
+            }
+    }
+
+} /* endof namespace midi_scheduler */
+} /* endof namespace midi */
@@ -0,0 +1,190 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_SCHEDULER_HXX
+#define DEF_MIDI_SCHEDULER_HXX
+
+#include "error.hpp"
+#include "../midi_defines.hxx"
+#include "../../utils/containers/ring.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+namespace midi_scheduler
+{
+
+/**
+ * Independent producers sharing the outputs, each one has its own rate cap
+ */
+static constexpr const uint8_t SOURCES_COUNT = 4;
+
+/**
+ * Messages waiting per bus in the urgent and in the other messages queues
+ */
+static constexpr const size_t URGENT_QUEUE_SIZE = 64;
+static constexpr const size_t OTHERS_QUEUE_SIZE = 64;
+
+/**
+ * Distinct controllers waiting per bus, each one holds its latest value
+ */
+static constexpr const size_t CONTROLS_QUEUE_SIZE = 256;
+
+static constexpr const uint8_t CHANNELS_COUNT = 16;
+static constexpr const uint8_t CONTROLLERS_COUNT = 128;
+
+/**
+ * Priority levels, served in order
+ */
+enum class level: uint8_t
+{
+    Urgent,         ///< notes, realtime and transport messages, never delayed by rate caps
+    Others,         ///< other channel and system common messages, in order
+    Controls,       ///< control changes, collapsed to the latest value of each controller
+    __LEVELS_COUNT__
+};
+
+static constexpr const uint8_t LEVELS_COUNT = static_cast<uint8_t>(level::__LEVELS_COUNT__);
+
+/** Priority level of a status byte */
+level level_of(uint8_t status);
+
+/**
+ * 
+ */
+struct SchedulerDefaultSettings
+{
+    /**
+     * Bytes allowed in the output buffer before messages stop being released,
+     *  bounds the wait of an urgent message behind already released ones
+     *
+     *  @note defaults to 3, a single short message
+     */
+    static uint8_t QueueDepth;
+
+    /**
+     * Bytes per second each source may send on each bus for non urgent messages,
+     *  zero disables the cap
+     *
+     *  @note defaults to 1500, about half of a 31250 bauds line
+     */
+    static unsigned long RateCap;
+
+    /**
+     * Bytes a source may send at once after being idle
+     *  @note defaults to 32
+     */
+    static unsigned long RateBurst;
+};
+
+/**
+ * Scheduling counters of a single bus
+ */
+struct scheduler_counters
+{
+    unsigned long queued;       ///< messages accepted
+    unsigned long released;     ///< messages handed to the output
+    unsigned long merged;       ///< control changes overwritten by a newer value while waiting
+    unsigned long dropped;      ///< messages refused by a full queue
+    unsigned long throttled;    ///< releases postponed by a rate cap
+};
+
+/**
+ * Bandwidth aware transmission scheduler sitting in front of a MIDI output:
+ *  messages wait in priority levels and are released only while the output buffer is almost empty,
+ *  so that notes never queue behind a flood of controllers.
+ *
+ * Control changes waiting for the line are collapsed per channel and controller,
+ *  only the latest value is sent, in the order controllers were first queued.
+ *  Non urgent messages of each source are limited by a token bucket.
+ *
+ * Output must follow @c midi_output::MidiOutput interface:
+ *  - error::status_byte send(bus, const message&)
+ *  - size_t occupancy(bus): bytes waiting in the bus buffer
+ *  - size_t flush(): hands buffered bytes to the serial ports
+ */
+template <typename _Output, typename _Settings=SchedulerDefaultSettings>
+class Scheduler
+{
+public:
+    using Output = _Output;
+    using Settings = _Settings;
+
+    explicit Scheduler(Output& output);
+
+    /** Empties every queue, refills every token bucket and resets counters */
+    void setup(unsigned long now);
+
+    /**
+     * Queues a short message from given source,
+     *  fails with MEMORY_ERROR if the level queue is full and INVALID_ARGUMENT for SysEx or bad sources
+     */
+    error::status_byte send(bus b, const message& msg, uint8_t source=0);
+
+    /**
+     * Releases waiting messages to the output while its buffers stay shallow,
+     *  flushing it before and after, should be called on each loop.
+     *  Returns the count of bytes handed to the serial ports
+     */
+    size_t flush(unsigned long now);
+
+    /** Messages waiting in a level of given bus */
+    size_t pending(bus b, level l) const;
+
+    const scheduler_counters& counters(bus b) const     { return _buses[index(b)].counters; }
+
+private:
+    static constexpr uint8_t index(bus b)       { return static_cast<uint8_t>(b); }
+
+    /** Tokens are counted in millionths of byte */
+    static constexpr const unsigned long long TOKENS_PER_BYTE = 1000000;
+    /** Waiting controllers looked at per release before giving up on throttled sources */
+    static constexpr const uint8_t ROTATIONS_MAX = 16;
+
+    struct queued_message
+    {
+        message msg;
+        uint8_t source;
+    };
+
+    /** Latest value of a waiting controller */
+    struct control_slot
+    {
+        uint8_t value;
+        uint8_t source;
+        bool pending;
+    };
+
+    struct port
+    {
+        containers::Ring<message, URGENT_QUEUE_SIZE> urgent;
+        containers::Ring<queued_message, OTHERS_QUEUE_SIZE> others;
+        containers::Ring<uint16_t, CONTROLS_QUEUE_SIZE> controls;  ///< waiting controllers: channel << 7 | controller
+        control_slot slots[CHANNELS_COUNT][CONTROLLERS_COUNT];
+        unsigned long long tokens[SOURCES_COUNT];
+        scheduler_counters counters;
+    };
+
+    /** Refills sources tokens of a bus */
+    void refill(port& p, unsigned long now);
+
+    /** Spends tokens of a source for a message, returns false if not enough */
+    bool spend(port& p, uint8_t source, uint8_t size);
+
+    /** Releases next message of a bus, returns false if nothing could be released */
+    bool release(bus b, port& p);
+
+    Output& _output;
+    port _buses[BUSES_COUNT];
+    unsigned long _last_refill;
+};
+
+} /* endof namespace midi_scheduler */
+} /* endof namespace midi */
+
+#include "midi_scheduler.hpp"
+
+#endif /* DEF_MIDI_SCHEDULER_HXX */
@@ -0,0 +1,50 @@
+/**
+ * 
+ */
+
+#include "midi_sequencer.hxx"
+
+namespace midi
+{
+namespace midi_sequencer
+{
+
+unsigned long SequencerDefaultSettings::Lookahead = 20000;
+unsigned long SequencerDefaultSettings::TickPeriod = 250;
+
+void
+pattern::clear()
+    {
+        for (uint8_t t=0; t<TRACKS_COUNT; ++t)
+            {
+                for (uint8_t s=0; s<STEPS_MAX; ++s)
+                    {
+                        notes[t][s] = 60;
+                        velocities[t][s] = 100;
+                        gates[t][s] = GATE_UNIT / 2;
+                        probabilities[t][s] = PROBABILITY_MAX;
+                    }
+                active[t] = 0;
+                lengths[t] = 16;
+                channels[t] = t;
+            }
+        swing = SWING_MIN;
+    }
+
+error::status_byte
+pattern::set(uint8_t track, uint8_t step, uint8_t note, uint8_t velocity, uint8_t gate, uint8_t probability)
+    {
+        if (!(track < TRACKS_COUNT) || !(step < STEPS_MAX) || note > DATA_BITMASK || velocity > DATA_BITMASK
+            || gate == 0 || probability > PROBABILITY_MAX)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+
+        notes[track][step] = note;
+        velocities[track][step] = velocity;
+        gates[track][step] = gate;
+        probabilities[track][step] = probability;
+        active[track] |= static_cast<uint64_t>(1) << step;
+        return error::status_byte{};
+    }
+
+} /* endof namespace midi_sequencer */
+} /* endof namespace midi */
@@ -0,0 +1,351 @@
+/**
+ * 
+ */
+
+#include "midi_sequencer.hxx"
+
+namespace midi
+{
+namespace midi_sequencer
+{
+
+template <size_t E, size_t S>
+TimerWheel<E, S>::TimerWheel()
+    { setup(0, 1); }
+
+template <size_t E, size_t S>
+void
+TimerWheel<E, S>::setup(unsigned long now, unsigned long resolution)
+    {
+        _cursor = now;
+        _current = 0;
+        _resolution = resolution ? resolution : 1;
+        clear();
+    }
+
+template <size_t E, size_t S>
+void
+TimerWheel<E, S>::clear()
+    {
+        for (size_t i=0; i<SlotsCount; ++i)
+            { _slots[i] = NONE; }
+        for (size_t i=0; i<EventsMax; ++i)
+            { _nodes[i].next = i + 1 < EventsMax ? i + 1 : NONE; }
+        _free = 0;
+        _size = 0;
+    }
+
+template <size_t E, size_t S>
+template <typename Fn>
+size_t
+TimerWheel<E, S>::drain(Fn&& fn)
+    {
+        const size_t count = _size;
+        for (size_t i=0; i<SlotsCount; ++i)
+            {
+                for (uint8_t n=_slots[i]; n!=NONE; n=_nodes[n].next)
+                    { fn(_nodes[n].msg, _nodes[n].time); }
+            }
+        clear();
+        return count;
+    }
+
+template <size_t E, size_t S>
+bool
+TimerWheel<E, S>::insert(unsigned long time, const message& msg)
+    {
+        if (_free == NONE)
+            { return false; }
+
+        const uint8_t n = _free;
+        _free = _nodes[n].next;
+        _nodes[n].time = time;
+        _nodes[n].msg = msg;
+        _size += 1;
+
+        /* slots are found relative to the current one, so that wrapping times need no care */
+        const long ahead = static_cast<long>(time - _cursor);
+        const size_t slot = (_current + (ahead > 0 ? ahead / _resolution : 0)) & (SlotsCount -1);
+
+        uint8_t* link = &_slots[slot];
+        while (*link != NONE && static_cast<long>(_nodes[*link].time - time) <= 0)
+            { link = &_nodes[*link].next; }
+        _nodes[n].next = *link;
+        *link = n;
+        return true;
+    }
+
+template <size_t E, size_t S>
+template <typename Fn>
+size_t
+TimerWheel<E, S>::expire(unsigned long now, Fn&& fn)
+    {
+        size_t count = 0;
+        /* a whole turn sees every slot, late expiries skip the remaining ones */
+        for (size_t walked=0; ; ++walked)
+            {
+                uint8_t& head = _slots[_current];
+                while (head != NONE && static_cast<long>(_nodes[head].time - now) <= 0)
+                    {
+                        const uint8_t n = head;
+                        head = _nodes[n].next;
+                        fn(_nodes[n].msg, _nodes[n].time);
+                        _nodes[n].next = _free;
+                        _free = n;
+                        _size -= 1;
+                        count += 1;
+                    }
+
+                if (static_cast<long>(now - _cursor) < static_cast<long>(_resolution))
+                    { break; }
+                if (walked == SlotsCount)
+                    {
+                        const unsigned long skipped = (now - _cursor) / _resolution;
+                        _cursor += skipped * _resolution;
+                        _current = (_current + skipped) & (SlotsCount -1);
+                        break;
+                    }
+                _cursor += _resolution;
+                _current = (_current + 1) & (SlotsCount -1);
+            }
+        return count;
+    }
+
+template <typename C, typename S>
+Sequencer<C, S>::Sequencer()
+    : _running{false}, _next_step{0}, _anchor_step{0}, _anchor_time{0}, _step_period{0},
+      _tempo{0}, _ticks_per_step{TICKS_PER_STEP_DEFAULT}, _random{1}, _playing{}, _generation{0}, _wheel_generation{0}, _counters{}
+    {
+        _pattern.clear();
+        set_tempo(12000);
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::setup(uint32_t seed)
+    {
+        _pattern.clear();
+        _running = false;
+        _next_step = _anchor_step = 0;
+        retime(_tempo, TICKS_PER_STEP_DEFAULT);
+        _random = seed ? seed : 1;
+        for (playing_note& p: _playing)
+            { p.pending = false; }
+        _queue.clear();
+        _wheel.setup(Context::micros(), Settings::TickPeriod);
+        _generation.store(0, std::memory_order_release);
+        _wheel_generation = 0;
+        _counters.scheduled = _counters.sent = _counters.late = _counters.dropped = _counters.skipped = 0;
+    }
+
+template <typename C, typename S>
+error::status_byte
+Sequencer<C, S>::set_tempo(uint32_t tempo)
+    {
+        if (tempo < 2000 || 40000 < tempo)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+
+        retime(tempo, _ticks_per_step);
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+error::status_byte
+Sequencer<C, S>::set_resolution(uint8_t ticks_per_step)
+    {
+        if (ticks_per_step == 0 || TICKS_PER_STEP_MAX < ticks_per_step)
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+
+        retime(_tempo, ticks_per_step);
+        return error::status_byte{};
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::retime(uint32_t tempo, uint8_t ticks_per_step)
+    {
+        static_assert((60000000ULL * 100 * TICKS_PER_STEP_MAX << PERIOD_FRACTION_BITS) / (2000 * 24ULL) <= UINT32_MAX,
+            "longest step at 20 BPM must fit the step period");
+
+        /* steps already scheduled keep their time, following ones move at the new period */
+        if (_running)
+            {
+                _anchor_time += ((static_cast<uint64_t>(_next_step - _anchor_step) * _step_period) >> PERIOD_FRACTION_BITS);
+                _anchor_step = _next_step;
+            }
+        _tempo = tempo;
+        _ticks_per_step = ticks_per_step;
+        _step_period = (60000000ULL * 100 * ticks_per_step << PERIOD_FRACTION_BITS) / (tempo * 24ULL);
+    }
+
+template <typename C, typename S>
+unsigned long
+Sequencer<C, S>::time_of(uint32_t step) const
+    {
+        unsigned long time = _anchor_time
+            + ((static_cast<uint64_t>(step - _anchor_step) * _step_period) >> PERIOD_FRACTION_BITS);
+        if (step & 1)
+            { time += (static_cast<uint64_t>(_step_period) * (2 * _pattern.swing - 100) / 100) >> PERIOD_FRACTION_BITS; }
+        return time;
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::start(unsigned long now)
+    {
+        if (_running)
+            { stop(now); }
+        _running = true;
+        _next_step = _anchor_step = 0;
+        _anchor_time = now + Settings::Lookahead;
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::stop(unsigned long now)
+    {
+        _running = false;
+        _generation.store(_generation.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+        /* note offs not queued yet are sent right away, the interrupt sends queued ones */
+        for (playing_note& p: _playing)
+            {
+                if (p.pending)
+                    { queue(now, make_status(status::NoteOff, p.channel), p.note, 0); }
+                p.pending = false;
+            }
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::update(unsigned long now)
+    {
+        if (!_running)
+            { return; }
+
+        const unsigned long horizon = now + Settings::Lookahead;
+        while (before(time_of(_next_step), horizon))
+            { schedule(_next_step++); }
+        close(horizon);
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::schedule(uint32_t step)
+    {
+        const unsigned long time = time_of(step);
+        for (uint8_t t=0; t<TRACKS_COUNT; ++t)
+            {
+                if (_pattern.lengths[t] == 0)
+                    { continue; }
+                const uint8_t s = step % _pattern.lengths[t];
+                if (!_pattern.is_active(t, s))
+                    { continue; }
+                if (_pattern.probabilities[t][s] < PROBABILITY_MAX && random() % PROBABILITY_MAX >= _pattern.probabilities[t][s])
+                    {
+                        _counters.skipped.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+
+                /* monophonic tracks: previous note ends at the latest when this one starts */
+                playing_note& p = _playing[t];
+                if (p.pending)
+                    {
+                        queue(before(p.off, time) ? p.off : time, make_status(status::NoteOff, p.channel), p.note, 0);
+                        p.pending = false;
+                    }
+
+                if (!queue(time, make_status(status::NoteOn, _pattern.channels[t]), _pattern.notes[t][s], _pattern.velocities[t][s]))
+                    { continue; }
+                const unsigned long gate = (static_cast<uint64_t>(_step_period) * _pattern.gates[t][s] / GATE_UNIT) >> PERIOD_FRACTION_BITS;
+                p = playing_note{time + (gate ? gate : 1), _pattern.channels[t], _pattern.notes[t][s], true};
+            }
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::close(unsigned long horizon)
+    {
+        for (playing_note& p: _playing)
+            {
+                if (p.pending && before(p.off, horizon) && queue(p.off, make_status(status::NoteOff, p.channel), p.note, 0))
+                    { p.pending = false; }
+            }
+    }
+
+template <typename C, typename S>
+bool
+Sequencer<C, S>::queue(unsigned long time, uint8_t status, uint8_t data1, uint8_t data2)
+    {
+        const timed_message m{time, message{status, data1, data2}, _generation.load(std::memory_order_relaxed)};
+        if (!_queue.push(m))
+            {
+                _counters.dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        _counters.scheduled.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::cancel(const message& msg)
+    {
+        if (type_of(msg.status) != status::NoteOff)
+            { return; }
+        Context::send(msg);
+        _counters.sent.fetch_add(1, std::memory_order_relaxed);
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::sync()
+    {
+        const uint8_t generation = _generation.load(std::memory_order_acquire);
+        if (generation != _wheel_generation)
+            {
+                _wheel.drain([this](const message& msg, unsigned long) { cancel(msg); });
+                _wheel_generation = generation;
+            }
+    }
+
+template <typename C, typename S>
+void
+Sequencer<C, S>::on_tick()
+    {
+        const unsigned long now = Context::micros();
+        sync();
+
+        timed_message m;
+        while (_queue.pop(m))
+            {
+                /* a message of a newer run than the wheel means a stop happened meanwhile */
+                if (m.generation != _wheel_generation)
+                    { sync(); }
+                if (m.generation != _wheel_generation)
+                    {
+                        cancel(m.msg);
+                        continue;
+                    }
+                if (before(m.time, now))
+                    { _counters.late.fetch_add(1, std::memory_order_relaxed); }
+                if (!_wheel.insert(m.time, m.msg))
+                    { _counters.dropped.fetch_add(1, std::memory_order_relaxed); }
+            }
+
+        const size_t sent = _wheel.expire(now, [](const message& msg, unsigned long) { Context::send(msg); });
+        _counters.sent.fetch_add(sent, std::memory_order_relaxed);
+    }
+
+template <typename C, typename S>
+uint32_t
+Sequencer<C, S>::random()
+    {
+        _random ^= _random << 13;
+        _random ^= _random >> 17;
+        _random ^= _random << 5;
+        return _random;
+    }
+
+} /* endof namespace midi_sequencer */
+} /* endof namespace midi */
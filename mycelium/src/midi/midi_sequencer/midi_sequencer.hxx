@@ -0,0 +1,334 @@
+/**
+ * 
+ */
+
+#ifndef DEF_MIDI_SEQUENCER_HXX
+#define DEF_MIDI_SEQUENCER_HXX
+
+#include "error.hpp"
+#include "../midi_defines.hxx"
+#include "../../utils/containers/ring.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace midi
+{
+namespace midi_sequencer
+{
+
+static constexpr const uint8_t TRACKS_COUNT = 8;
+static constexpr const uint8_t STEPS_MAX = 64;
+
+/**
+ * Gates are counted in sixteenths of step, up to 255: almost 16 steps
+ */
+static constexpr const uint8_t GATE_UNIT = 16;
+
+/**
+ * Probabilities are percents, steps at @c PROBABILITY_MAX always play
+ */
+static constexpr const uint8_t PROBABILITY_MAX = 100;
+
+/**
+ * Swing is the percent of a pair of steps given to the first one:
+ *  50 plays straight, 75 delays odd steps by half a step
+ */
+static constexpr const uint8_t SWING_MIN = 50;
+static constexpr const uint8_t SWING_MAX = 75;
+
+/**
+ * Step periods are kept in microseconds with 8 bits of fraction
+ */
+static constexpr const uint8_t PERIOD_FRACTION_BITS = 8;
+
+/**
+ * Step lengths in 24 ppqn clock ticks, 6 for sixteenth notes up to a 4/4 bar:
+ *  the longest step at the slowest tempo must fit the fixed point period
+ */
+static constexpr const uint8_t TICKS_PER_STEP_DEFAULT = 6;
+static constexpr const uint8_t TICKS_PER_STEP_MAX = 96;
+
+/**
+ * Events waiting between the main loop and the tick interrupt, and in the timer wheel
+ */
+static constexpr const size_t EVENTS_QUEUE_SIZE = 64;
+static constexpr const size_t WHEEL_EVENTS_MAX = 128;
+static constexpr const size_t WHEEL_SLOTS_COUNT = 128;
+
+/**
+ * Steps of every track, as parallel arrays so that scheduling a step reads a column
+ *  and editing a parameter of a track reads a row, about 2kB
+ */
+struct pattern
+{
+    uint8_t notes[TRACKS_COUNT][STEPS_MAX];
+    uint8_t velocities[TRACKS_COUNT][STEPS_MAX];
+    uint8_t gates[TRACKS_COUNT][STEPS_MAX];             ///< in @c GATE_UNIT of step
+    uint8_t probabilities[TRACKS_COUNT][STEPS_MAX];     ///< in percents
+    uint64_t active[TRACKS_COUNT];                      ///< bit N set if step N plays
+    uint8_t lengths[TRACKS_COUNT];                      ///< steps before a track loops, zero mutes it
+    uint8_t channels[TRACKS_COUNT];
+    uint8_t swing;                                      ///< in percents, see @c SWING_MIN
+
+    /** Empty tracks of 16 sixteenth notes, on channels 0 to 7 */
+    void clear();
+
+    /**
+     * Sets and activates a step,
+     *  fails with INVALID_ARGUMENT if an index or a value is out of range
+     */
+    error::status_byte set(uint8_t track, uint8_t step, uint8_t note, uint8_t velocity,
+        uint8_t gate=GATE_UNIT / 2, uint8_t probability=PROBABILITY_MAX);
+
+    bool is_active(uint8_t track, uint8_t step) const
+        { return (active[track] >> step) & 1; }
+
+    void toggle(uint8_t track, uint8_t step)
+        { active[track] ^= static_cast<uint64_t>(1) << step; }
+};
+
+/**
+ * Message due at a given time, in us
+ */
+struct timed_message
+{
+    unsigned long time;
+    message msg;
+    uint8_t generation;     ///< sequencer run that scheduled it, see @c Sequencer::stop
+};
+
+/**
+ * Hashed timer wheel: slots cover @c resolution us each, messages are kept sorted by time in their slot,
+ *  those farther than a whole turn wait in their slot for the following turns.
+ *  Inserting and expiring cost does not depend on the count of waiting messages,
+ *  beyond the ones sharing a slot.
+ *
+ * @note not thread safe, a single context inserts and expires
+ */
+template <size_t _EventsMax, size_t _SlotsCount>
+class TimerWheel
+{
+public:
+    static constexpr const size_t EventsMax = _EventsMax;
+    static constexpr const size_t SlotsCount = _SlotsCount;
+
+    static_assert(EventsMax < 0xFF, "nodes are indexed on a byte");
+    static_assert((SlotsCount & (SlotsCount -1)) == 0, "slots count must be a power of two");
+
+    TimerWheel();
+
+    /** Empties the wheel, its first slot begins at @c now */
+    void setup(unsigned long now, unsigned long resolution);
+
+    /** Drops every waiting message */
+    void clear();
+
+    /**
+     * Hands every waiting message to @c fn(const message&, unsigned long time), slot by slot, then empties the wheel.
+     *  Returns their count
+     */
+    template <typename Fn>
+    size_t drain(Fn&& fn);
+
+    /**
+     * Inserts a message due at @c time, after the ones due at the same time,
+     *  messages already due are sent on next expiry. Returns false if the wheel is full
+     */
+    bool insert(unsigned long time, const message& msg);
+
+    /**
+     * Hands messages due at @c now to @c fn(const message&, unsigned long time), in time order,
+     *  returns their count
+     */
+    template <typename Fn>
+    size_t expire(unsigned long now, Fn&& fn);
+
+    size_t size() const                 { return _size; }
+
+private:
+    static constexpr const uint8_t NONE = 0xFF;
+
+    struct node
+    {
+        unsigned long time;
+        message msg;
+        uint8_t next;
+    };
+
+    node _nodes[EventsMax];
+    uint8_t _slots[SlotsCount];     ///< first node of each slot
+    uint8_t _free;                  ///< first free node
+    size_t _size;
+
+    unsigned long _cursor;          ///< beginning of current slot
+    size_t _current;                ///< index of current slot
+    unsigned long _resolution;
+};
+
+/**
+ * 
+ */
+struct SequencerDefaultSettings
+{
+    /**
+     * Time in us steps are scheduled ahead of their playing time,
+     *  must cover the longest main loop iteration
+     *  @note defaults to 20000, 20ms
+     */
+    static unsigned long Lookahead;
+
+    /**
+     * Period in us of the tick interrupt, and resolution of the timer wheel
+     *  @note defaults to 250
+     */
+    static unsigned long TickPeriod;
+};
+
+/**
+ * Scheduling counters, written by both contexts
+ */
+struct sequencer_counters
+{
+    std::atomic<unsigned long> scheduled;   ///< messages queued by the main loop
+    std::atomic<unsigned long> sent;        ///< messages sent by the tick interrupt
+    std::atomic<unsigned long> late;        ///< messages already due when inserted in the wheel
+    std::atomic<unsigned long> dropped;     ///< messages refused by a full queue or wheel
+    std::atomic<unsigned long> skipped;     ///< steps not played by probability
+};
+
+/**
+ * Step sequencer: 8 tracks of up to 64 steps, each one with its own length,
+ *  steps have a note, a velocity, a gate and a probability, odd steps are delayed by the swing.
+ *  Tracks are monophonic: a note is cut when the next one of its track starts.
+ *
+ * The main loop computes steps ahead of time, up to @c Lookahead, and queues their messages
+ *  stamped with their playing time. A timer interrupt moves them to a timer wheel and sends the due ones:
+ *  output timing depends on the tick period, not on the main loop jitter.
+ *
+ * Stopping cancels every note already scheduled and closes playing ones:
+ *  messages are tagged with a run generation, the interrupt drops note ons of older runs
+ *  and sends their note offs right away.
+ *
+ * Context must provide the following static members:
+ *  - @c unsigned long micros()
+ *  - @c void send(const message&): called from the tick interrupt
+ */
+template <typename _Context, typename _Settings=SequencerDefaultSettings>
+class Sequencer
+{
+public:
+    using Context = _Context;
+    using Settings = _Settings;
+
+    Sequencer();
+
+    /** Clears the pattern and every queue, the tick interrupt should be started after, with @c tick_period */
+    void setup(uint32_t seed=1);
+
+    /** Period of the tick interrupt in microseconds */
+    unsigned long tick_period() const       { return Settings::TickPeriod; }
+
+    /** Edited pattern, changes are heard from the next scheduled step */
+    pattern& steps()                        { return _pattern; }
+    const pattern& steps() const            { return _pattern; }
+
+    /**
+     * Sets the tempo in hundredths of beats per minute, as given by @c midi_clock::ClockFollower::tempo,
+     *  fails with INVALID_ARGUMENT out of 20 to 400 BPM
+     */
+    error::status_byte set_tempo(uint32_t tempo);
+
+    /**
+     * Sets the length of a step in 24 ppqn clock ticks, heard from the next scheduled step,
+     *  fails with INVALID_ARGUMENT out of 1 to @c TICKS_PER_STEP_MAX
+     */
+    error::status_byte set_resolution(uint8_t ticks_per_step);
+
+    uint8_t resolution() const              { return _ticks_per_step; }
+
+    /** Starts from step zero, played @c Lookahead after @c now */
+    void start(unsigned long now);
+
+    /** Cancels scheduled notes and closes playing ones */
+    void stop(unsigned long now);
+
+    /** Schedules steps starting before @c now plus @c Lookahead, to be called on each loop */
+    void update(unsigned long now);
+
+    /** Tick interrupt entry: moves queued messages to the wheel and sends due ones, never blocks */
+    void on_tick();
+
+    bool running() const                    { return _running; }
+
+    /** Count of steps scheduled since start */
+    uint32_t next_step() const              { return _next_step; }
+
+    /** Playing time in us of given step since start */
+    unsigned long time_of(uint32_t step) const;
+
+    const sequencer_counters& counters() const      { return _counters; }
+
+private:
+    /** Last note of a track, its note off is kept by the main loop until it enters the lookahead */
+    struct playing_note
+    {
+        unsigned long off;
+        uint8_t channel;
+        uint8_t note;
+        bool pending;       ///< note off not queued yet
+    };
+
+    static bool before(unsigned long a, unsigned long b)
+        { return static_cast<long>(a - b) < 0; }
+
+    /** Queues a message for the tick interrupt, returns false if the queue is full */
+    bool queue(unsigned long time, uint8_t status, uint8_t data1, uint8_t data2);
+
+    /** Schedules every track of given step */
+    void schedule(uint32_t step);
+
+    /** Queues note offs entering the lookahead */
+    void close(unsigned long horizon);
+
+    /** Tick interrupt side: sends the note offs of a cancelled message, drops the rest */
+    void cancel(const message& msg);
+
+    /** Tick interrupt side: adopts latest generation, sending note offs of older runs and dropping the rest */
+    void sync();
+
+    /** Moves the anchor to the next step, so that scheduled steps keep their time, then computes the step period */
+    void retime(uint32_t tempo, uint8_t ticks_per_step);
+
+    uint32_t random();
+
+    pattern _pattern;
+
+    /* main loop side */
+    bool _running;
+    uint32_t _next_step;
+    uint32_t _anchor_step;          ///< step at which tempo last changed
+    unsigned long _anchor_time;     ///< unswung time of @c _anchor_step
+    uint32_t _step_period;          ///< in us with @c PERIOD_FRACTION_BITS of fraction
+    uint32_t _tempo;
+    uint8_t _ticks_per_step;
+    uint32_t _random;
+    playing_note _playing[TRACKS_COUNT];
+    std::atomic<uint8_t> _generation;
+
+    containers::Ring<timed_message, EVENTS_QUEUE_SIZE> _queue;
+
+    /* tick interrupt side */
+    TimerWheel<WHEEL_EVENTS_MAX, WHEEL_SLOTS_COUNT> _wheel;
+    uint8_t _wheel_generation;
+
+    sequencer_counters _counters;
+};
+
+} /* endof namespace midi_sequencer */
+} /* endof namespace midi */
+
+#include "midi_sequencer.hpp"
+
+#endif /* DEF_MIDI_SEQUENCER_HXX */
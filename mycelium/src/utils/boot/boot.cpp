@@ -0,0 +1,38 @@
+/**
+ * 
+ */
+
+#include "boot.hxx"
+
+namespace boot
+{
+
+const node DEVICE_GRAPH[DEVICE_STEPS_COUNT] = {
+    /* InitLogger */                { "init_logger",                0, 0 },
+    /* BeginSerial */               { "begin_serial",               bit(device_step::InitLogger), 0 },
+    /* InitSdCard */                { "init_sd_card",               bit(device_step::InitLogger), 0 },
+    /* LogToSerial */               { "log_to_serial",              bit(device_step::BeginSerial), 0 },
+    /* LogToFile */                 { "log_to_file",                bit(device_step::InitSdCard), 0 },
+    /* LoadConfig */                { "load_config",                bit(device_step::InitLogger), bit(device_step::InitSdCard) },
+    /* ConfigureHardware */         { "configure_hardware",         bit(device_step::InitLogger), 0 },
+    /* SetupLedsDriver */           { "setup_leds_driver",          bit(device_step::ConfigureHardware), 0 },
+    /* ConfigureI2CBuses */         { "configure_i2c_buses",        bit(device_step::SetupLedsDriver), 0 },
+    /* ConfigureMcpRegisters */     { "configure_mcp_registers",    bit(device_step::ConfigureI2CBuses), 0 },
+    /* SetupPadsDriver */           { "setup_pads_driver",          bit(device_step::ConfigureHardware), 0 },
+    /* SetupEncodersDriver */       { "setup_encoders_driver",      bit(device_step::ConfigureHardware), 0 },
+    /* SetupAnalog */               { "setup_analog",               bit(device_step::ConfigureHardware), 0 },
+    /* SetupErrorLed */             { "setup_error_led",            bit(device_step::ConfigureHardware), 0 },
+    /* ConfigureRawGpio */          { "configure_raw_gpio",         bit(device_step::SetupLedsDriver) | bit(device_step::SetupPadsDriver)
+                                                                    | bit(device_step::SetupEncodersDriver) | bit(device_step::SetupAnalog)
+                                                                    | bit(device_step::SetupErrorLed), 0 },
+    /* InitState */                 { "init_state",                 bit(device_step::ConfigureRawGpio) | bit(device_step::ConfigureMcpRegisters), 0 },
+    /* InitControlSurface */        { "init_control_surface",       bit(device_step::ConfigureRawGpio), 0 },
+    /* SetupActionTimers */         { "setup_action_timers",        bit(device_step::InitControlSurface), 0 },
+    /* SetupActionsStack */         { "setup_actions_stack",        bit(device_step::InitControlSurface), 0 },
+    /* SetupQuadratureDecoders */   { "setup_quadrature_decoders",  bit(device_step::ConfigureRawGpio), 0 },
+    /* SetupMidi */                 { "setup_midi",                 bit(device_step::ConfigureHardware), 0 },
+    /* BeginMidi */                 { "begin_midi",                 bit(device_step::SetupMidi), 0 },
+    /* ConfigureSoftware */         { "configure_software",         bit(device_step::ConfigureHardware) | bit(device_step::LoadConfig), 0 },
+};
+
+} /* endof namespace boot */
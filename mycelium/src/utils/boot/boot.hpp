@@ -0,0 +1,248 @@
+/**
+ * 
+ */
+
+#include "boot.hxx"
+
+namespace boot
+{
+
+template <typename C>
+void
+Executor<C>::reset()
+    {
+        for (uint8_t i=0; i<STEPS_MAX; ++i)
+            {
+                _states[i] = step_state::Idle;
+                _timings[i] = step_timing{0, 0, 0, 0};
+            }
+        _over = 0;
+        _succeeded = 0;
+        _origin = 0;
+        _started = false;
+    }
+
+template <typename C>
+error::status_byte
+Executor<C>::setup()
+    {
+        reset();
+        if (_count > STEPS_MAX || (_count != 0 && (_graph == nullptr || _steps == nullptr)))
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+
+        for (uint8_t i=0; i<_count; ++i)
+            {
+                const mask dependencies = _graph[i].needs | _graph[i].after;
+                if ((dependencies & ~all()) || (dependencies & bit(i)) || _steps[i] == nullptr)
+                    { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+            }
+
+        /* topological sort: steps are removed once their dependencies are, a cycle stops the removal */
+        mask sorted = 0;
+        for (uint8_t pass=0; pass<_count; ++pass)
+            {
+                const mask before = sorted;
+                for (uint8_t i=0; i<_count; ++i)
+                    {
+                        if (!((_graph[i].needs | _graph[i].after) & ~sorted))
+                            { sorted |= bit(i); }
+                    }
+                if (sorted == before)
+                    { break; }
+            }
+        if (sorted != all())
+            { return error::errcode::INVALID_ARGUMENT | error::severity::ERROR; }
+        return error::status_byte{};
+    }
+
+template <typename C>
+void
+Executor<C>::poll(uint8_t index, bool launch)
+    {
+        step_timing& t = _timings[index];
+        const unsigned long begin = Context::micros();
+        const step_result r = _steps[index](launch);
+        const unsigned long end = Context::micros();
+        t.busy += end - begin;
+        t.polls += 1;
+
+        step_state s = step_state::Failed;
+        switch (r)
+        {
+        case step_result::Running:
+            s = step_state::Running;
+            break;
+        case step_result::Retry:
+            s = step_state::Retrying;
+            break;
+        case step_result::Done:
+            s = step_state::Done;
+            _succeeded |= bit(index);
+            break;
+        default:
+            break;
+        }
+
+        const bool pending = s == step_state::Running || s == step_state::Retrying;
+        if (pending && end - _origin - t.launched > _timeout)
+            { s = step_state::Timedout; }
+        else if (pending)
+            {
+                _states[index] = s;
+                return;
+            }
+        _states[index] = s;
+        _over |= bit(index);
+        t.finished = end - _origin;
+    }
+
+template <typename C>
+step_state
+Executor<C>::update()
+    {
+        if (!_started)
+            {
+                _origin = Context::micros();
+                _started = true;
+            }
+
+        for (uint8_t i=0; i<_count; ++i)
+            {
+                if (_over & bit(i))
+                    { continue; }
+
+                const node& n = _graph[i];
+                switch (_states[i])
+                {
+                case step_state::Idle:
+                    if (n.needs & _over & ~_succeeded)
+                        {
+                            _states[i] = step_state::Skipped;
+                            _over |= bit(i);
+                            _timings[i].launched = _timings[i].finished = now();
+                            break;
+                        }
+                    if ((n.needs | n.after) & ~_over)
+                        { break; }
+                    _timings[i].launched = now();
+                    poll(i, true);
+                    break;
+
+                case step_state::Retrying:
+                    poll(i, true);
+                    break;
+
+                default:
+                    poll(i, false);
+                    break;
+                }
+            }
+
+        if (!is_over())
+            { return step_state::Running; }
+        return _succeeded == all() ? step_state::Done : step_state::Failed;
+    }
+
+template <typename C>
+step_state
+Executor<C>::run()
+    {
+        step_state s;
+        while ((s = update()) == step_state::Running)
+            { /* nothing */ }
+        return s;
+    }
+
+template <typename C>
+uint32_t
+Executor<C>::elapsed() const
+    {
+        uint32_t last = 0;
+        for (uint8_t i=0; i<_count; ++i)
+            {
+                if ((_over & bit(i)) && _timings[i].finished > last)
+                    { last = _timings[i].finished; }
+            }
+        return last;
+    }
+
+template <typename C>
+uint8_t
+Executor<C>::critical_path(uint8_t target, uint8_t path[STEPS_MAX]) const
+    {
+        if (!(target < _count))
+            { return 0; }
+
+        /* walked backward, then reversed */
+        uint8_t length = 0;
+        uint8_t current = target;
+        while (true)
+            {
+                path[length++] = current;
+                const mask dependencies = (_graph[current].needs | _graph[current].after) & _over;
+                if (dependencies == 0 || length == STEPS_MAX)
+                    { break; }
+
+                uint8_t latest = __builtin_ctz(dependencies);
+                for (uint8_t i=latest + 1; i<_count; ++i)
+                    {
+                        if ((dependencies & bit(i)) && _timings[i].finished > _timings[latest].finished)
+                            { latest = i; }
+                    }
+                current = latest;
+            }
+
+        for (uint8_t i=0; i<length / 2; ++i)
+            {
+                const uint8_t swap = path[i];
+                path[i] = path[length - 1 - i];
+                path[length - 1 - i] = swap;
+            }
+        return length;
+    }
+
+template <typename C>
+uint8_t
+Executor<C>::critical_path(uint8_t path[STEPS_MAX]) const
+    {
+        uint8_t last = 0;
+        for (uint8_t i=1; i<_count; ++i)
+            {
+                if (_timings[i].finished > _timings[last].finished)
+                    { last = i; }
+            }
+        return critical_path(last, path);
+    }
+
+template <typename C>
+template <typename Logger>
+error::status_byte
+Executor<C>::dump(Logger& logger, const char* facility) const
+    {
+        const unsigned long now = Context::micros();
+        const error::status_byte info = error::errcode::OK | error::severity::INFO;
+
+        uint8_t path[STEPS_MAX];
+        const uint8_t length = critical_path(path);
+        mask critical = 0;
+        for (uint8_t i=0; i<length; ++i)
+            { critical |= bit(path[i]); }
+
+        error::status_byte status{};
+        for (uint8_t i=0; i<_count; ++i)
+            {
+                const step_timing& t = _timings[i];
+                const char* outcome = step_state_name(_states[i]);
+                status = logger(logging::raw_header{facility, info, now},
+                    "%c%-24s %8lu -> %8lu us (busy %6lu us, %4u polls) %s\n",
+                    (critical & bit(i)) ? '*' : ' ', _graph[i].name,
+                    static_cast<unsigned long>(t.launched), static_cast<unsigned long>(t.finished),
+                    static_cast<unsigned long>(t.busy), static_cast<unsigned>(t.polls), outcome);
+            }
+        status = logger(logging::raw_header{facility, info, now},
+            "boot over in %lu us, %u steps on the critical path\n",
+            static_cast<unsigned long>(elapsed()), static_cast<unsigned>(length));
+        return status;
+    }
+
+} /* endof namespace boot */
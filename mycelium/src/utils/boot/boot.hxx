@@ -0,0 +1,232 @@
+/**
+ * Boot as a dependency graph:
+ *  steps are nodes polled until over, a step starts once its dependencies are over,
+ *  and every running step is polled once per update, so that independent branches interleave,
+ *  e.g. I2C buses are configured while the SD card mounts.
+ *
+ * Steps are timestamped, which gives the critical path of the boot:
+ *  the chain of steps which actually delayed a given one.
+ */
+
+#ifndef DEF_BOOT_HXX
+#define DEF_BOOT_HXX
+
+#include "../mycelium/error.hpp"
+#include "../logging/logging.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace boot
+{
+
+/**
+ * Set of steps, bit per step index
+ */
+using mask = uint32_t;
+
+static constexpr const uint8_t STEPS_MAX = 32;
+
+static constexpr mask bit(uint8_t index)
+    { return mask{1} << index; }
+
+/**
+ * Outcome of a step call
+ */
+enum class step_result: uint8_t
+{
+    Running,        ///< call again on next update
+    Done,           ///< success
+    Retry,          ///< failed, but launching it again may work
+    Failed,         ///< failed, launching it again is useless
+};
+
+/**
+ * A step, called with @c launch set on the first call and on retries.
+ *
+ * @warning a call must not block: waits are done by returning Running
+ */
+using step_fn = step_result (*)(bool launch);
+
+/**
+ * State of a step in the executor
+ */
+enum class step_state: uint8_t
+{
+    Idle,           ///< waiting for its dependencies
+    Running,
+    Retrying,       ///< launched again on next update
+    Done,
+    Failed,
+    Timedout,       ///< ran longer than the executor timeout
+    Skipped,        ///< a required step failed, never launched
+    __STATES_COUNT__
+};
+
+static constexpr const size_t STEP_STATES_COUNT = static_cast<size_t>(step_state::__STATES_COUNT__);
+
+static constexpr const char* step_state_name(step_state s)
+    {
+        constexpr const char* names[STEP_STATES_COUNT] = {
+            "idle", "running", "retrying", "done", "failed", "timeout", "skipped"
+        };
+        return static_cast<size_t>(s) < STEP_STATES_COUNT ? names[static_cast<size_t>(s)] : "?";
+    }
+
+/**
+ * A node of the boot graph
+ */
+struct node
+{
+    const char* name;
+    mask needs;         ///< steps which must succeed first, the step is skipped if one fails
+    mask after;         ///< steps which must be over first, successful or not
+};
+
+/**
+ * Timestamps of a step, in microseconds since the first update
+ */
+struct step_timing
+{
+    uint32_t launched;
+    uint32_t finished;
+    uint32_t busy;          ///< time spent in the step function
+    uint16_t polls;
+
+    uint32_t duration() const       { return finished - launched; }
+};
+
+/**
+ * Runs the steps of a graph, steps are polled in index order:
+ *  dependencies declared before their dependents are over in time for them to launch on the same update.
+ *
+ * Context must provide the following static members:
+ *  - @c unsigned long micros()
+ */
+template <typename _Context>
+class Executor
+{
+public:
+    using Context = _Context;
+
+    /**
+     * @param timeout: steps running longer than this are abandoned, in microseconds
+     */
+    Executor(const node* graph, const step_fn* steps, uint8_t count, unsigned long timeout=5000000)
+        : _graph{graph}, _steps{steps}, _count{count}, _timeout{timeout}
+        { reset(); }
+
+    /**
+     * Checks the graph and resets all steps:
+     *  fails with INVALID_ARGUMENT on too many steps, dependencies out of the graph or cycles
+     */
+    error::status_byte setup();
+
+    /**
+     * Launches steps whose dependencies are over, and polls running ones once.
+     *  Returns Running while steps remain, then Done if all of them succeeded, Failed otherwise
+     */
+    step_state update();
+
+    /** Updates until every step is over */
+    step_state run();
+
+    bool is_over() const                            { return _over == all(); }
+    bool is_over(uint8_t index) const               { return _over & bit(index); }
+    step_state state(uint8_t index) const           { return _states[index]; }
+    const step_timing& timing(uint8_t index) const  { return _timings[index]; }
+    uint8_t count() const                           { return _count; }
+    const char* name(uint8_t index) const           { return _graph[index].name; }
+
+    /** Time from the first update to the end of the last step */
+    uint32_t elapsed() const;
+
+    /**
+     * Writes the critical path leading to the end of @c target, from the first step:
+     *  each step is preceded by the dependency which ended last. Returns the path length
+     */
+    uint8_t critical_path(uint8_t target, uint8_t path[STEPS_MAX]) const;
+
+    /** Critical path of the step which ended last */
+    uint8_t critical_path(uint8_t path[STEPS_MAX]) const;
+
+    /**
+     * Dumps timings through a @c logging::Logger with @c logging::raw_header headers,
+     *  a line per step at INFO level, steps of the critical path are starred
+     */
+    template <typename Logger>
+    error::status_byte dump(Logger& logger, const char* facility) const;
+
+private:
+    mask all() const                                { return _count < STEPS_MAX ? bit(_count) -1 : ~mask{0}; }
+    uint32_t now() const                            { return Context::micros() - _origin; }
+
+    void reset();
+    void poll(uint8_t index, bool launch);
+
+    const node* _graph;
+    const step_fn* _steps;
+    uint8_t _count;
+    unsigned long _timeout;
+
+    step_state _states[STEPS_MAX];
+    step_timing _timings[STEPS_MAX];
+    mask _over;
+    mask _succeeded;
+    unsigned long _origin;
+    bool _started;
+};
+
+/**
+ * Boot steps of the device, as drawn in Teensy4.1-APC.dot
+ */
+enum class device_step: uint8_t
+    {
+    __FIRST_STEP__ = 0,
+
+        InitLogger = 0,             ///< in-memory log, before any transport
+        BeginSerial,
+        InitSdCard,
+        LogToSerial,
+        LogToFile,
+        LoadConfig,                 ///< configuration file when the card mounted, defaults otherwise
+        ConfigureHardware,
+        SetupLedsDriver,
+        ConfigureI2CBuses,
+        ConfigureMcpRegisters,
+        SetupPadsDriver,
+        SetupEncodersDriver,
+        SetupAnalog,
+        SetupErrorLed,
+        ConfigureRawGpio,
+        InitState,                  ///< first led frame
+        InitControlSurface,
+        SetupActionTimers,
+        SetupActionsStack,
+        SetupQuadratureDecoders,
+        SetupMidi,
+        BeginMidi,
+        ConfigureSoftware,          ///< applies the loaded configuration
+
+    __STEPS_COUNT__
+    }; /* endof enum device_step */
+
+static constexpr const uint8_t DEVICE_STEPS_COUNT = static_cast<uint8_t>(device_step::__STEPS_COUNT__);
+
+static constexpr mask bit(device_step s)
+    { return bit(static_cast<uint8_t>(s)); }
+
+/**
+ * Dependencies of the device boot steps, indexed by @c device_step.
+ *
+ * Hardware is configured from compiled defaults and does not wait for the configuration:
+ *  loading it mounts the SD card, which takes longer than bringing up the leds.
+ *  Loaded settings (refresh rates, I2C frequency, mappings) are applied by ConfigureSoftware
+ */
+extern const node DEVICE_GRAPH[DEVICE_STEPS_COUNT];
+
+} /* endof namespace boot */
+
+#include "boot.hpp"
+
+#endif /* DEF_BOOT_HXX */
@@ -0,0 +1,75 @@
+/**
+ * 
+ */
+
+#include "ring.hpp"
+
+namespace containers
+{
+
+template <typename ValueT, size_t SMax>
+bool
+Ring<ValueT, SMax>::push(const value_type& val)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        const size_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail == MaxSize)
+            { return false; }
+
+        _datas[head & (MaxSize -1)] = val;
+        _head.store(head + 1, std::memory_order_release);
+        update_peak(head + 1 - tail);
+        return true;
+    }
+
+template <typename ValueT, size_t SMax>
+bool
+Ring<ValueT, SMax>::push(const value_type* vals, size_t count)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        const size_t tail = _tail.load(std::memory_order_acquire);
+        if (MaxSize - (head - tail) < count)
+            { return false; }
+
+        for (size_t i=0; i<count; ++i)
+            { _datas[(head + i) & (MaxSize -1)] = vals[i]; }
+        _head.store(head + count, std::memory_order_release);
+        update_peak(head + count - tail);
+        return true;
+    }
+
+template <typename ValueT, size_t SMax>
+bool
+Ring<ValueT, SMax>::pop(value_type& val)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (_head.load(std::memory_order_acquire) == tail)
+            { return false; }
+
+        val = _datas[tail & (MaxSize -1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+template <typename ValueT, size_t SMax>
+const typename Ring<ValueT, SMax>::value_type*
+Ring<ValueT, SMax>::peek(size_t& count) const
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t size = _head.load(std::memory_order_acquire) - tail;
+        const size_t index = tail & (MaxSize -1);
+
+        count = size < MaxSize - index ? size : MaxSize - index;
+        return &_datas[index];
+    }
+
+template <typename ValueT, size_t SMax>
+void
+Ring<ValueT, SMax>::consume(size_t count)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t size = _head.load(std::memory_order_acquire) - tail;
+        _tail.store(tail + (count < size ? count : size), std::memory_order_release);
+    }
+
+} /* endof namespace containers */
@@ -4,4 +4,5 @@
 
 #include "double_linked_list.hpp"
 #include "queues.hpp"
+#include "ring.hpp"
 #include "set.hpp"
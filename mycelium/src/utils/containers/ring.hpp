@@ -0,0 +1,82 @@
+/**
+ * 
+ */
+
+#ifndef DEF_RING_HXX
+#define DEF_RING_HXX
+
+#include <atomic>
+#include <cstddef>
+
+namespace containers
+{
+
+/**
+ * Fixed size circular buffer with a single producer and a single consumer,
+ *  either side can run in an interrupt handler: indexes are free-running
+ *  and each of them is only written by its own side.
+ * A full ring refuses pushes, it never overwrites unread values.
+ */
+template <typename ValueT, size_t SMax>
+class Ring
+{
+public:
+    static constexpr const size_t MaxSize = SMax;
+    static_assert(MaxSize != 0 && (MaxSize & (MaxSize -1)) == 0, "Ring size must be a power of two");
+
+    using value_type = ValueT;
+
+    Ring(): _datas{}, _head{0}, _tail{0}, _peak{0}   {}
+
+    Ring(const Ring&)               = delete;
+    Ring& operator= (const Ring&)   = delete;
+
+    /** Producer side: appends a value, returns false if the ring is full */
+    bool push(const value_type& val);
+
+    /**
+     * Producer side: appends @c count values or none of them,
+     *  returns false if they don't fit
+     */
+    bool push(const value_type* vals, size_t count);
+
+    /** Consumer side: pops the oldest value, returns false if the ring is empty */
+    bool pop(value_type& val);
+
+    /**
+     * Consumer side: returns the oldest values laying contiguously in memory,
+     *  sets @c count to their number, which is zero when the ring is empty.
+     *  Values remain in the ring until released by @c consume
+     */
+    const value_type* peek(size_t& count) const;
+
+    /** Consumer side: releases @c count values returned by @c peek */
+    void consume(size_t count);
+
+    /** Consumer side: drops all values */
+    void clear()                    { _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+    size_t size() const             { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+    size_t free() const             { return MaxSize - size(); }
+    bool is_empty() const           { return size() == 0; }
+    bool is_full() const            { return size() == MaxSize; }
+
+    /** Highest number of values held at once since construction or @c reset_peak */
+    size_t peak() const             { return _peak; }
+    void reset_peak()               { _peak = size(); }
+
+private:
+    void update_peak(size_t size)   { if (_peak < size) { _peak = size; } }
+
+    value_type _datas[MaxSize];
+    std::atomic<size_t> _head;      ///< next write index, free-running
+    std::atomic<size_t> _tail;      ///< next read index, free-running
+    size_t _peak;
+
+}; /* endof class Ring */
+
+} /* endof namespace containers */
+
+#include "_ring.hpp"
+
+#endif /* DEF_RING_HXX */
@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "latency.hxx"
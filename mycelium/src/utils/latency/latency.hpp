@@ -0,0 +1,141 @@
+/**
+ * 
+ */
+
+#include "latency.hxx"
+
+namespace latency
+{
+
+inline void
+Histogram::reset()
+    {
+        for (auto& b: _buckets)
+            { b = 0; }
+        _count = 0;
+        _min = UINT32_MAX;
+        _max = 0;
+        _sum = 0;
+    }
+
+inline void
+Histogram::add(uint32_t us)
+    {
+        _buckets[bucket_of(us)] += 1;
+        _count += 1;
+        _sum += us;
+        if (us < _min) { _min = us; }
+        if (us > _max) { _max = us; }
+    }
+
+inline uint32_t
+Histogram::percentile(uint8_t p) const
+    {
+        if (_count == 0)
+            { return 0; }
+
+        /* rank of the sample, rounded up */
+        const uint64_t rank = (static_cast<uint64_t>(_count) * p + 99) / 100;
+        uint64_t seen = 0;
+        for (size_t i=0; i<BUCKETS_COUNT; ++i)
+            {
+                seen += _buckets[i];
+                if (seen >= rank && seen != 0)
+                    {
+                        const uint32_t upper = (i + 1 < BUCKETS_COUNT) ? lower_bound(i + 1) -1 : UINT32_MAX;
+                        return upper < _max ? upper : _max;
+                    }
+            }
+        return _max;
+    }
+
+template <typename C, size_t N>
+void
+Collector<C, N>::reset()
+    {
+        for (auto& t: _traces)
+            { t.marked = 0; }
+        for (auto& h: _stages)
+            { h.reset(); }
+        _total.reset();
+        _abandoned = 0;
+    }
+
+template <typename C, size_t N>
+void
+Collector<C, N>::mark(uint8_t key, stage s)
+    {
+        const size_t index = static_cast<size_t>(s);
+        if (!(index < STAGES_COUNT))
+            { return; }
+
+        const uint32_t now = Context::micros();
+        trace& t = _traces[key & (TracesCount -1)];
+        const uint32_t first = t.marked ? t.stamps[__builtin_ctz(t.marked)] : now;
+
+        /* stale traces are restarted: bounces which never debounced, unmapped events...
+         *  as are traces in flight when the same key is sampled again */
+        if (t.marked && (now - first > _timeout || (s == stage::ScanSample && (t.marked & ~1U))))
+            {
+                _abandoned += 1;
+                t.marked = 0;
+            }
+
+        /* keep the first occurrence: first contact of a bouncing pad */
+        if (t.marked & (1 << index))
+            { return; }
+        t.stamps[index] = now;
+        t.marked |= 1 << index;
+
+        if (s != stage::TxComplete)
+            { return; }
+
+        size_t previous = __builtin_ctz(t.marked);
+        for (size_t i=previous + 1; i<STAGES_COUNT; ++i)
+            {
+                if (!(t.marked & (1 << i)))
+                    { continue; }
+                _stages[i].add(t.stamps[i] - t.stamps[previous]);
+                previous = i;
+            }
+        _total.add(now - t.stamps[__builtin_ctz(t.marked)]);
+        t.marked = 0;
+    }
+
+template <typename C, size_t N>
+template <typename Logger>
+error::status_byte
+Collector<C, N>::dump(Logger& logger, const char* facility) const
+    {
+        const unsigned long now = Context::micros();
+        const error::status_byte info = error::errcode::OK | error::severity::INFO;
+        const error::status_byte debug = error::errcode::OK | error::severity::DEBUG;
+
+        auto line = [&](const char* name, const Histogram& h) {
+                return logger(logging::raw_header{facility, info, now},
+                    "%-12s n=%lu min=%lu p50=%lu p90=%lu p99=%lu max=%lu mean=%lu us\n",
+                    name, static_cast<unsigned long>(h.count()), static_cast<unsigned long>(h.min()),
+                    static_cast<unsigned long>(h.percentile(50)), static_cast<unsigned long>(h.percentile(90)),
+                    static_cast<unsigned long>(h.percentile(99)), static_cast<unsigned long>(h.max()),
+                    static_cast<unsigned long>(h.mean()));
+            };
+
+        error::status_byte status{};
+        for (size_t i=1; i<STAGES_COUNT; ++i)
+            { status = line(stage_name(static_cast<stage>(i)), _stages[i]); }
+        status = line("total", _total);
+
+        for (size_t i=0; i<Histogram::BUCKETS_COUNT; ++i)
+            {
+                if (_total.bucket(i) == 0)
+                    { continue; }
+                status = logger(logging::raw_header{facility, debug, now},
+                    "total [%lu, %lu) us: %lu\n",
+                    static_cast<unsigned long>(Histogram::lower_bound(i)),
+                    static_cast<unsigned long>(i + 1 < Histogram::BUCKETS_COUNT ? Histogram::lower_bound(i + 1) : UINT32_MAX),
+                    static_cast<unsigned long>(_total.bucket(i)));
+            }
+        return status;
+    }
+
+} /* endof namespace latency */
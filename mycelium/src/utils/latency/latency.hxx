@@ -0,0 +1,206 @@
+/**
+ * Latency measurement from pad scan to MIDI transmission:
+ *  drivers mark each stage a trace goes through with @c LATENCY_MARK,
+ *  a collector timestamps the marks and builds per-stage and total histograms.
+ *
+ * Marks are compiled in only if @c MYCELIUM_LATENCY_PROBES is defined,
+ *  and cost a null pointer check until a collector is installed.
+ */
+
+#ifndef DEF_LATENCY_HXX
+#define DEF_LATENCY_HXX
+
+#include "../mycelium/error.hpp"
+#include "../logging/logging.hxx"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace latency
+{
+
+/**
+ * Stages of an input trace, in pipeline order
+ */
+enum class stage: uint8_t
+    {
+    __FIRST_STAGE__ = 0,
+
+        ScanSample  = 0,    ///< first raw sample differing from the debounced state
+        DebounceEdge,       ///< debounced edge
+        EventQueue,         ///< edge popped by the main loop
+        Mapping,            ///< event mapped to a MIDI message
+        TxEnqueue,          ///< message queued for transmission
+        TxComplete,         ///< last byte of the message handed to the serial port
+
+    __STAGES_COUNT__
+    }; /* endof enum stage */
+
+static constexpr const size_t STAGES_COUNT = static_cast<size_t>(stage::__STAGES_COUNT__);
+
+static constexpr const char* stage_name(stage s)
+    {
+        constexpr const char* names[STAGES_COUNT] = {
+            "scan", "debounce", "queue", "mapping", "tx-enqueue", "tx-complete"
+        };
+        return static_cast<size_t>(s) < STAGES_COUNT ? names[static_cast<size_t>(s)] : "?";
+    }
+
+/**
+ * Traces are identified by a key, e.g. the pad index
+ */
+using mark_fn = void (*)(uint8_t key, stage s);
+
+/**
+ * Installed collector entry point, null when nobody listens
+ */
+inline mark_fn probe = nullptr;
+
+#ifdef MYCELIUM_LATENCY_PROBES
+#define LATENCY_MARK(KEY, STAGE) \
+    do { if (::latency::probe) { ::latency::probe((KEY), ::latency::stage::STAGE); } } while (0)
+#else
+#define LATENCY_MARK(KEY, STAGE) \
+    do { } while (0)
+#endif
+
+/**
+ * Log-linear histogram of durations in microseconds:
+ *  exact below 16us, then 4 buckets per power of two (less than 19% relative error)
+ */
+class Histogram
+{
+public:
+    static constexpr const size_t BUCKETS_COUNT = 128;
+
+    Histogram()
+        { reset(); }
+
+    void reset();
+
+    void add(uint32_t us);
+
+    uint32_t count() const      { return _count; }
+    uint32_t min() const        { return _count ? _min : 0; }
+    uint32_t max() const        { return _max; }
+    uint32_t mean() const       { return _count ? _sum / _count : 0; }
+
+    /** Returns upper bound of the bucket holding given percentile (0 to 100) */
+    uint32_t percentile(uint8_t p) const;
+
+    uint32_t bucket(size_t index) const         { return _buckets[index]; }
+
+    /** Returns index of the bucket holding given duration */
+    static constexpr size_t bucket_of(uint32_t us)
+        {
+            if (us < 16)
+                { return us; }
+            const uint8_t octave = 31 - __builtin_clz(us);
+            const uint8_t sub = (us >> (octave - 2)) & 0b11;
+            return 16 + (octave - 4) * 4 + sub;
+        }
+
+    /** Returns lowest duration of given bucket */
+    static constexpr uint32_t lower_bound(size_t index)
+        {
+            if (index < 16)
+                { return index; }
+            const uint8_t octave = (index - 16) / 4 + 4;
+            const uint8_t sub = (index - 16) % 4;
+            return (1UL << octave) | (static_cast<uint32_t>(sub) << (octave - 2));
+        }
+
+private:
+    uint32_t _buckets[BUCKETS_COUNT];
+    uint32_t _count;
+    uint32_t _min;
+    uint32_t _max;
+    uint64_t _sum;
+};
+
+/**
+ * Collects marks into traces, a trace is complete once marked @c TxComplete.
+ *  Each stage histogram holds the time spent since the previous marked stage,
+ *  the total histogram the time from the first to the last mark.
+ *
+ * Context must provide the following static members:
+ *  - @c unsigned long micros()
+ *
+ * @note marks and dumps are expected from the same execution context
+ */
+template <typename _Context, size_t _TracesCount=128>
+class Collector
+{
+public:
+    using Context = _Context;
+    static constexpr const size_t TracesCount = _TracesCount;
+
+    static_assert((TracesCount & (TracesCount -1)) == 0, "traces count must be a power of two");
+
+    /**
+     * @param timeout: traces older than this are restarted by a new scan sample,
+     *  e.g. bounces which never debounced
+     */
+    explicit Collector(unsigned long timeout=100000)
+        : _timeout{timeout}
+        { reset(); }
+
+    /** Makes this collector the target of @c LATENCY_MARK */
+    void install()
+        {
+            _installed = this;
+            probe = &Collector::trampoline;
+        }
+
+    /** Detaches the probes if this collector is installed */
+    void uninstall()
+        {
+            if (_installed != this)
+                { return; }
+            _installed = nullptr;
+            probe = nullptr;
+        }
+
+    void reset();
+
+    /** Timestamps a stage of given trace */
+    void mark(uint8_t key, stage s);
+
+    const Histogram& histogram(stage s) const       { return _stages[static_cast<size_t>(s)]; }
+    const Histogram& total() const                  { return _total; }
+
+    /** Returns count of traces restarted before completion */
+    uint32_t abandoned_count() const                { return _abandoned; }
+
+    /**
+     * Dumps statistics through a @c logging::Logger with @c logging::raw_header headers,
+     *  one line per stage and for the total at INFO level,
+     *  and non empty buckets of the total histogram at DEBUG level
+     */
+    template <typename Logger>
+    error::status_byte dump(Logger& logger, const char* facility) const;
+
+private:
+    struct trace
+    {
+        uint32_t stamps[STAGES_COUNT];
+        uint8_t marked;     ///< bit per marked stage, 0 when idle
+    };
+
+    static void trampoline(uint8_t key, stage s)
+        { if (_installed) { _installed->mark(key, s); } }
+
+    static inline Collector* _installed = nullptr;
+
+    trace _traces[TracesCount];
+    Histogram _stages[STAGES_COUNT];
+    Histogram _total;
+    uint32_t _abandoned;
+    unsigned long _timeout;
+};
+
+} /* endof namespace latency */
+
+#include "latency.hpp"
+
+#endif /* DEF_LATENCY_HXX */
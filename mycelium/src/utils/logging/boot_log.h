@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "boot_log.hxx"
@@ -0,0 +1,127 @@
+/**
+ * 
+ */
+
+#include "boot_log.hxx"
+
+#include <cstdio>
+#include <algorithm>
+
+namespace logging
+{
+
+template <size_t S>
+void
+LogRing<S>::append(const char* bytes, size_t size)
+    {
+        if (size > Size)
+            {
+                bytes += size - Size;
+                size = Size;
+            }
+
+        /* room is made by whole lines, unless a single one fills the ring */
+        if (_head + size - _tail > Size)
+            {
+                _tail = _head + size - Size;
+                while (_tail != _head && at(_tail -1) != '\n')
+                    { _tail += 1; }
+            }
+
+        for (size_t i=0; i<size; ++i)
+            { _bytes[(_head + i) & (Size -1)] = bytes[i]; }
+        _head += size;
+    }
+
+template <size_t S>
+size_t
+LogRing<S>::read(uint32_t from, char* out, size_t size) const
+    {
+        if (from < _tail || from >= _head)
+            { return 0; }
+        if (size > _head - from)
+            { size = _head - from; }
+
+        /* at most two contiguous chunks */
+        const size_t begin = from & (Size -1);
+        const size_t first = size < Size - begin ? size : Size - begin;
+        std::copy(_bytes + begin, _bytes + begin + first, out);
+        std::copy(_bytes, _bytes + (size - first), out + first);
+        return size;
+    }
+
+template <size_t S, typename ...T>
+template <typename ...Args>
+error::status_byte
+BootLog<S, T...>::operator() (const char* fmt, Args... args)
+    {
+        char line[BOOT_LOG_LINE_MAX_SIZE];
+        int size;
+        if constexpr (sizeof...(Args) == 0)
+            { size = snprintf(line, sizeof(line), "%s", fmt); }
+        else
+            { size = snprintf(line, sizeof(line), fmt, args...); }
+        if (size < 0)
+            { return error::errcode::GENERIC_ERROR | error::severity::ERROR; }
+
+        _ring.append(line, static_cast<size_t>(size) < sizeof(line) ? size : sizeof(line) -1);
+        pump();
+        return error::status_byte{};
+    }
+
+template <size_t S, typename ...T>
+void
+BootLog<S, T...>::pump()
+    { forward_all(std::index_sequence_for<T...>{}); }
+
+template <size_t S, typename ...T>
+error::status_byte
+BootLog<S, T...>::flush()
+    {
+        pump();
+        error::status_byte status{};
+        std::apply([&status](auto& ...t) {
+                ((t.is_available() ? (void)(status = t.flush()) : (void)0), ...);
+            }, _transports);
+        return status;
+    }
+
+template <size_t S, typename ...T>
+template <size_t I>
+void
+BootLog<S, T...>::forward()
+    {
+        auto& transport = std::get<I>(_transports);
+        if (!transport.is_available())
+            { return; }
+
+        /* first attachment replays the whole ring */
+        if (!_attached[I])
+            {
+                _attached[I] = true;
+                _positions[I] = _ring.tail();
+            }
+
+        if (_positions[I] < _ring.tail())
+            {
+                char notice[48];
+                const int size = snprintf(notice, sizeof(notice), "... %lu log bytes lost\n",
+                    static_cast<unsigned long>(_ring.tail() - _positions[I]));
+                if (transport.write(notice, size) != static_cast<size_t>(size))
+                    { return; }
+                _lost[I] += _ring.tail() - _positions[I];
+                _positions[I] = _ring.tail();
+            }
+
+        char chunk[64];
+        while (_positions[I] != _ring.head())
+            {
+                const size_t size = _ring.read(_positions[I], chunk, sizeof(chunk));
+                const size_t written = transport.write(chunk, size);
+                _positions[I] += written;
+                if (written < size)
+                    { return; }
+            }
+    }
+
+} /* endof namespace logging */
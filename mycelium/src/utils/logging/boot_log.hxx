@@ -0,0 +1,148 @@
+/**
+ * Log output buffered until a transport is there to read it:
+ *  the device starts without waiting for an USB host or a SD card,
+ *  messages logged meanwhile are kept in a fixed ring and replayed to each transport once it attaches.
+ */
+
+#ifndef DEF_LOGGING_BOOT_LOG_HXX
+#define DEF_LOGGING_BOOT_LOG_HXX
+
+#include "../mycelium/error.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+namespace logging
+{
+
+/**
+ * Longest formatted output of a single print call, longer ones are truncated
+ */
+static constexpr const size_t BOOT_LOG_LINE_MAX_SIZE = 192;
+
+/**
+ * Fixed ring of log text, addressed by absolute positions:
+ *  the count of bytes appended since the beginning.
+ *  When full, oldest lines are dropped whole.
+ */
+template <size_t _Size>
+class LogRing
+{
+public:
+    static constexpr const size_t Size = _Size;
+
+    static_assert((Size & (Size -1)) == 0, "ring size must be a power of two");
+    static_assert(Size >= 2 * BOOT_LOG_LINE_MAX_SIZE, "ring must hold a couple of lines");
+
+    LogRing(): _head{0}, _tail{0}     {}
+
+    /** Appends @c size bytes, dropping oldest lines to make room */
+    void append(const char* bytes, size_t size);
+
+    /**
+     * Copies up to @c size bytes from the absolute position @c from, returns the copied count.
+     *  Positions before @c tail() are lost, nothing is copied from them
+     */
+    size_t read(uint32_t from, char* out, size_t size) const;
+
+    uint32_t head() const           { return _head; }   ///< position of next appended byte
+    uint32_t tail() const           { return _tail; }   ///< position of oldest byte kept
+
+private:
+    char at(uint32_t position) const        { return _bytes[position & (Size -1)]; }
+
+    char _bytes[Size];
+    uint32_t _head;
+    uint32_t _tail;
+};
+
+/**
+ * Printer of a @c logging::Logger writing to a ring, forwarded to every available transport:
+ *  each one reads the ring from its own position, starting with the oldest kept byte when it first attaches.
+ *  A transport too slow to follow or detached for too long misses the dropped lines,
+ *  which is reported in its output.
+ *
+ * Transports must provide the following members:
+ *  - @c bool is_available(): true when writing may succeed,
+ *  - @c size_t write(const char* bytes, size_t size): writes without blocking, returns the written count,
+ *  - @c error::status_byte flush().
+ *
+ * @note printing forwards buffered output, which should also be done from the main loop
+ *  with @c pump(), so that a transport attaching while nothing is logged gets the output
+ * @note loggers copy their printer, they should be given a @c printer() handle
+ */
+template <size_t _Size, typename ...Transports>
+class BootLog
+{
+public:
+    static constexpr const size_t Size = _Size;
+    static constexpr const size_t TransportsCount = sizeof...(Transports);
+
+    explicit BootLog(Transports... transports)
+        : _transports{transports...}, _positions{}, _attached{}, _lost{}
+        {}
+
+    BootLog(const BootLog&) = delete;
+    BootLog& operator= (const BootLog&) = delete;
+
+    /**
+     * Printer handle on a boot log
+     */
+    struct printer_type
+    {
+        template <typename ...Args>
+        error::status_byte operator() (const char* fmt, Args... args) const
+            { return (*log)(fmt, args...); }
+
+        error::status_byte flush() const
+            { return log->flush(); }
+
+        BootLog* log;
+    };
+
+    printer_type printer()                  { return printer_type{this}; }
+
+    /**
+     * Printf-like output appended to the ring, then forwarded to available transports
+     */
+    template <typename ...Args>
+    error::status_byte operator() (const char* fmt, Args... args);
+
+    /** Forwards buffered output to available transports */
+    void pump();
+
+    /** Forwards buffered output and flushes transports */
+    error::status_byte flush();
+
+    /** Returns true if given transport received everything buffered */
+    bool is_drained(size_t index) const     { return _positions[index] == _ring.head(); }
+
+    /** Returns count of bytes given transport missed */
+    uint32_t lost_count(size_t index) const { return _lost[index]; }
+
+    const LogRing<Size>& ring() const       { return _ring; }
+
+    template <size_t I>
+    auto& transport()                       { return std::get<I>(_transports); }
+
+private:
+    template <size_t I>
+    void forward();
+
+    template <size_t ...I>
+    void forward_all(std::index_sequence<I...>)     { (forward<I>(), ...); }
+
+    LogRing<Size> _ring;
+    std::tuple<Transports...> _transports;
+    uint32_t _positions[TransportsCount];
+    bool _attached[TransportsCount];
+    uint32_t _lost[TransportsCount];
+};
+
+} /* endof namespace logging */
+
+#include "boot_log.hpp"
+
+#endif /* DEF_LOGGING_BOOT_LOG_HXX */
@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "deferred_log.hxx"
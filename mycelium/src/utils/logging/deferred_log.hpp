@@ -0,0 +1,380 @@
+/**
+ * 
+ */
+
+#include "deferred_log.hxx"
+
+#include <cstdio>
+#include <cstring>
+
+namespace logging
+{
+
+template <typename T>
+T
+record_view::load(size_t word) const
+    {
+        T value;
+        std::memcpy(&value, words + word, sizeof(T));
+        return value;
+    }
+
+namespace detail
+{
+
+/** printf length modifiers */
+enum class length_modifier: uint8_t
+    { None, Char, Short, Long, LongLong, IntMax, Size, PtrDiff, LongDouble };
+
+/**
+ * Returns true if a conversion prints an argument of given kind: integer conversions take both sizes,
+ *  their length modifier sizes the argument where it was recorded, not where it is printed
+ */
+static inline bool accepts(char conversion, length_modifier length, arg_kind kind)
+    {
+        switch (conversion)
+        {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+            return length != length_modifier::LongDouble
+                && (kind == arg_kind::Int32 || (kind == arg_kind::Int64 && conversion != 'c'));
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            return kind == arg_kind::Double && (length == length_modifier::None || length == length_modifier::Long);
+        case 's': case 'p':
+            return kind == arg_kind::Pointer && length == length_modifier::None;
+        default:
+            return false;
+        }
+    }
+
+} /* endof namespace detail */
+
+template <typename Resolve>
+size_t
+format_record(const record_view& record, char* out, size_t size, Resolve&& resolve)
+    {
+        if (size == 0)
+            { return 0; }
+
+        size_t written = 0;
+        /* snprintf results are clamped to the remaining room, keeping the terminator */
+        auto advance = [&written, size](int count) {
+                if (count > 0)
+                    { written += static_cast<size_t>(count) < size - written ? count : size - written -1; }
+            };
+
+        out[0] = '\0';
+        if (record.format() == 0)
+            {
+                advance(snprintf(out, size, "... %lu log records dropped\n", static_cast<unsigned long>(record.timestamp())));
+                return written;
+            }
+
+        const char* fmt = resolve(record.format());
+        size_t arg = 0;
+        size_t word = RECORD_ARGS_WORD;
+
+        /* reads a star argument, false on mismatch */
+        auto next_star = [&record, &arg]() {
+                if (arg >= record.args_count() || record.kind(arg) != arg_kind::Int32)
+                    { return false; }
+                arg += 1;
+                return true;
+            };
+
+        while (*fmt != '\0' && written < size -1)
+            {
+                if (*fmt != '%' || fmt[1] == '%')
+                    {
+                        out[written++] = *fmt;
+                        fmt += *fmt == '%' ? 2 : 1;
+                        continue;
+                    }
+
+                /* a conversion is copied, stars replaced by their recorded value
+                 *  and integer lengths by the recorded size */
+                char spec[48];
+                size_t n = 0;
+                bool valid = true;
+                spec[n++] = *fmt++;
+                while (*fmt != '\0' && std::strchr("-+ #0", *fmt) && n < 8)
+                    { spec[n++] = *fmt++; }
+                for (int field=0; field<2 && valid; ++field)
+                    {
+                        if (field == 1)
+                            {
+                                if (*fmt != '.')
+                                    { break; }
+                                spec[n++] = *fmt++;
+                            }
+                        if (*fmt == '*')
+                            {
+                                valid = next_star();
+                                if (valid)
+                                    {
+                                        n += snprintf(spec + n, 12, "%d", record.load<int32_t>(word));
+                                        word += 1;
+                                    }
+                                fmt += 1;
+                            }
+                        while (*fmt >= '0' && *fmt <= '9' && n < 20)
+                            { spec[n++] = *fmt++; }
+                    }
+
+                detail::length_modifier length = detail::length_modifier::None;
+                const char* lengths = "hlLjzt";
+                if (*fmt != '\0' && std::strchr(lengths, *fmt))
+                    {
+                        const bool twice = fmt[1] == fmt[0];
+                        switch (*fmt)
+                        {
+                        case 'h':   length = twice ? detail::length_modifier::Char : detail::length_modifier::Short; break;
+                        case 'l':   length = twice ? detail::length_modifier::LongLong : detail::length_modifier::Long; break;
+                        case 'L':   length = detail::length_modifier::LongDouble; break;
+                        case 'j':   length = detail::length_modifier::IntMax; break;
+                        case 'z':   length = detail::length_modifier::Size; break;
+                        default:    length = detail::length_modifier::PtrDiff; break;
+                        }
+                        const bool narrow = *fmt == 'h';
+                        const size_t count = twice && (*fmt == 'h' || *fmt == 'l') ? 2 : 1;
+                        for (size_t i=0; i<count; ++i, ++fmt)
+                            {
+                                if (narrow)
+                                    { spec[n++] = *fmt; }
+                            }
+                    }
+
+                const char conversion = *fmt;
+                const arg_kind kind = arg < record.args_count() ? record.kind(arg) : arg_kind::Int32;
+                valid = valid && conversion != '\0' && arg < record.args_count() && detail::accepts(conversion, length, kind);
+                if (!valid)
+                    {
+                        advance(snprintf(out + written, size - written, "<?>"));
+                        return written;
+                    }
+                arg += 1;
+
+                /* 64 bits integers are printed as long long, unless narrowed to a char or a short */
+                const bool narrowed = length == detail::length_modifier::Char || length == detail::length_modifier::Short;
+                if (kind == arg_kind::Int64 && !narrowed)
+                    {
+                        spec[n++] = 'l';
+                        spec[n++] = 'l';
+                    }
+                spec[n++] = *fmt++;
+                spec[n] = '\0';
+
+                char* at = out + written;
+                const size_t room = size - written;
+                switch (kind)
+                {
+                case arg_kind::Int32:
+                    advance(snprintf(at, room, spec, record.load<int32_t>(word)));
+                    break;
+                case arg_kind::Int64:
+                    if (narrowed)
+                        { advance(snprintf(at, room, spec, static_cast<int>(record.load<int64_t>(word)))); }
+                    else
+                        { advance(snprintf(at, room, spec, static_cast<long long>(record.load<int64_t>(word)))); }
+                    break;
+                case arg_kind::Double:
+                    advance(snprintf(at, room, spec, record.load<double>(word)));
+                    break;
+                case arg_kind::Pointer:
+                    if (conversion == 's')
+                        {
+                            const uint64_t string = record.load<uint64_t>(word);
+                            advance(snprintf(at, room, spec, string == 0 ? "(null)" : resolve(string)));
+                        }
+                    else
+                        { advance(snprintf(at, room, spec, reinterpret_cast<void*>(static_cast<uintptr_t>(record.load<uint64_t>(word))))); }
+                    break;
+                }
+                word += words_of(kind);
+            }
+
+        out[written] = '\0';
+        return written;
+    }
+
+template <typename C, size_t S>
+DeferredLog<C, S>::DeferredLog()
+    : _head{0}, _tail{0}, _dropped{0}, _records{0}, _reported{0}, _pending{}, _pending_size{0}, _pending_sent{0}
+    {
+        for (std::atomic<uint32_t>& w: _words)
+            { w.store(0, std::memory_order_relaxed); }
+    }
+
+template <typename C, size_t S>
+template <typename T>
+void
+DeferredLog<C, S>::store(uint32_t position, T value)
+    {
+        uint32_t words[(sizeof(T) + 3) / 4] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i=0; i<sizeof(words) / 4; ++i)
+            { _words[(position + i) & (Words -1)].store(words[i], std::memory_order_relaxed); }
+    }
+
+template <typename C, size_t S>
+template <typename ...Args>
+error::status_byte
+DeferredLog<C, S>::operator() (const char* fmt, Args... args)
+    {
+        static_assert(sizeof...(Args) <= DEFERRED_LOG_ARGS_MAX, "too many arguments for a record");
+        constexpr uint32_t size = RECORD_ARGS_WORD + (0 + ... + words_of(kind_of<Args>()));
+
+        /* reserves words, unless the reader did not free enough of them */
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        do
+            {
+                if (head + size - _tail.load(std::memory_order_acquire) > Words)
+                    {
+                        _dropped.fetch_add(1, std::memory_order_relaxed);
+                        return error::errcode::MEMORY_ERROR | error::severity::WARNING;
+                    }
+            }
+        while (!_head.compare_exchange_weak(head, head + size, std::memory_order_relaxed));
+
+        store<uint32_t>(head + RECORD_TIMESTAMP_WORD, static_cast<uint32_t>(Context::micros()));
+        store<uint64_t>(head + RECORD_FORMAT_WORD, reinterpret_cast<uintptr_t>(fmt));
+
+        uint32_t kinds = 0;
+        [[maybe_unused]] uint32_t shift = 0;
+        ((kinds |= static_cast<uint32_t>(kind_of<Args>()) << shift, shift += 2), ...);
+        store<uint32_t>(head + RECORD_KINDS_WORD, kinds);
+
+        [[maybe_unused]] uint32_t word = head + RECORD_ARGS_WORD;
+        [[maybe_unused]] auto push = [this, &word](auto value) {
+                using T = decltype(value);
+                constexpr arg_kind kind = kind_of<T>();
+                if constexpr (kind == arg_kind::Double)
+                    { store<double>(word, static_cast<double>(value)); }
+                else if constexpr (kind == arg_kind::Pointer)
+                    { store<uint64_t>(word, reinterpret_cast<uintptr_t>(static_cast<const void*>(value))); }
+                else if constexpr (std::is_enum_v<T>)
+                    { store<std::conditional_t<kind == arg_kind::Int64, uint64_t, uint32_t>>(word, static_cast<std::underlying_type_t<T>>(value)); }
+                else
+                    { store<std::conditional_t<kind == arg_kind::Int64, uint64_t, uint32_t>>(word, value); }
+                word += words_of(kind);
+            };
+        (push(args), ...);
+
+        /* publishing the header hands the record to the reader */
+        _words[head & (Words -1)].store(size | (sizeof...(Args) << 8), std::memory_order_release);
+        _records.fetch_add(1, std::memory_order_relaxed);
+        return error::status_byte{};
+    }
+
+template <typename C, size_t S>
+bool
+DeferredLog<C, S>::pop(uint32_t record[RECORD_WORDS_MAX])
+    {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        const uint32_t header = _words[tail & (Words -1)].load(std::memory_order_acquire);
+        if (header == 0)
+            { return false; }
+
+        /* freed words are cleared, so that a header is only seen once published */
+        const size_t size = header & 0xFF;
+        for (size_t i=0; i<size; ++i)
+            {
+                std::atomic<uint32_t>& w = _words[(tail + i) & (Words -1)];
+                record[i] = w.load(std::memory_order_relaxed);
+                w.store(0, std::memory_order_relaxed);
+            }
+        _tail.store(tail + size, std::memory_order_release);
+        return true;
+    }
+
+template <typename C, size_t S>
+bool
+DeferredLog<C, S>::notice_drops()
+    {
+        const uint32_t dropped = _dropped.load(std::memory_order_relaxed);
+        if (dropped == _reported)
+            { return false; }
+
+        /* a record without format carries the count of dropped ones */
+        uint32_t record[RECORD_ARGS_WORD] = {};
+        record[RECORD_HEADER_WORD] = RECORD_ARGS_WORD;
+        record[RECORD_TIMESTAMP_WORD] = dropped - _reported;
+        std::memcpy(_pending, record, sizeof(record));
+        _pending_size = sizeof(record);
+        _pending_sent = 0;
+        _reported = dropped;
+        return true;
+    }
+
+template <typename C, size_t S>
+template <typename Transport>
+bool
+DeferredLog<C, S>::write_pending(Transport& transport)
+    {
+        if (_pending_sent < _pending_size)
+            {
+                _pending_sent += transport.write(_pending + _pending_sent, _pending_size - _pending_sent);
+                if (_pending_sent < _pending_size)
+                    { return false; }
+            }
+        _pending_size = _pending_sent = 0;
+        return true;
+    }
+
+template <typename C, size_t S>
+template <typename Transport>
+size_t
+DeferredLog<C, S>::drain(Transport& transport, size_t max)
+    {
+        if (!transport.is_available() || !write_pending(transport))
+            { return 0; }
+
+        auto identity = [](uint64_t pointer) { return reinterpret_cast<const char*>(static_cast<uintptr_t>(pointer)); };
+        uint32_t record[RECORD_WORDS_MAX];
+        size_t count = 0;
+        while (count < max)
+            {
+                if (pop(record))
+                    { count += 1; }
+                else if (notice_drops())
+                    { std::memcpy(record, _pending, _pending_size); }
+                else
+                    { break; }
+
+                _pending_size = format_record(record_view{record}, _pending, sizeof(_pending), identity);
+                _pending_sent = 0;
+                if (!write_pending(transport))
+                    { break; }
+            }
+        return count;
+    }
+
+template <typename C, size_t S>
+template <typename Transport>
+size_t
+DeferredLog<C, S>::ship(Transport& transport, size_t max)
+    {
+        static_assert(sizeof(_pending) >= RECORD_WORDS_MAX * 4, "a whole record must fit the pending buffer");
+
+        if (!transport.is_available() || !write_pending(transport))
+            { return 0; }
+
+        uint32_t record[RECORD_WORDS_MAX];
+        size_t count = 0;
+        while (count < max)
+            {
+                if (pop(record))
+                    {
+                        count += 1;
+                        _pending_size = record_view{record}.size() * 4;
+                        _pending_sent = 0;
+                        std::memcpy(_pending, record, _pending_size);
+                    }
+                else if (!notice_drops())
+                    { break; }
+                if (!write_pending(transport))
+                    { break; }
+            }
+        return count;
+    }
+
+} /* endof namespace logging */
@@ -0,0 +1,235 @@
+/**
+ * Log output recorded in binary and formatted later:
+ *  callers only copy the format pointer, a timestamp and their raw arguments in a lock-free ring,
+ *  a low priority task turns records into text or ships them untouched to a host decoder.
+ */
+
+#ifndef DEF_LOGGING_DEFERRED_LOG_HXX
+#define DEF_LOGGING_DEFERRED_LOG_HXX
+
+#include "../mycelium/error.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace logging
+{
+
+/**
+ * Longest formatted record, longer ones are truncated
+ */
+static constexpr const size_t DEFERRED_LOG_LINE_MAX_SIZE = 192;
+
+/**
+ * Arguments of a single record, each one is tagged on two bits of a word
+ */
+static constexpr const size_t DEFERRED_LOG_ARGS_MAX = 16;
+
+/**
+ * Argument kinds, as printf reads them after default promotions
+ */
+enum class arg_kind: uint8_t
+    { Int32=0, Int64=1, Double=2, Pointer=3 };
+
+/**
+ * Words taken by an argument of given kind in a record:
+ *  pointers always take two, so that records read the same on the device and on a 64 bits host
+ */
+static constexpr size_t words_of(arg_kind kind)
+    { return kind == arg_kind::Int32 ? 1 : 2; }
+
+/**
+ * Kind an argument is stored as: small integers and enums are promoted to 32 bits,
+ *  floats to double, arrays and strings are kept as pointers
+ */
+template <typename T>
+static constexpr arg_kind kind_of()
+    {
+        if constexpr (std::is_floating_point_v<T>)
+            { return arg_kind::Double; }
+        else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>)
+            { return arg_kind::Pointer; }
+        else
+            {
+                static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "only printf arguments can be recorded");
+                return sizeof(T) > 4 ? arg_kind::Int64 : arg_kind::Int32;
+            }
+    }
+
+/**
+ * Layout of a record, in 32 bits words:
+ *  - header: words count on the low byte, arguments count on the second one,
+ *      never zero once the record is committed
+ *  - timestamp, in us
+ *  - format pointer, on two words whatever the pointer size
+ *  - arguments kinds, two bits per argument starting from the low ones
+ *  - arguments, in call order
+ */
+static constexpr const size_t RECORD_HEADER_WORD = 0;
+static constexpr const size_t RECORD_TIMESTAMP_WORD = 1;
+static constexpr const size_t RECORD_FORMAT_WORD = 2;
+static constexpr const size_t RECORD_KINDS_WORD = RECORD_FORMAT_WORD + words_of(arg_kind::Pointer);
+static constexpr const size_t RECORD_ARGS_WORD = RECORD_KINDS_WORD + 1;
+static constexpr const size_t RECORD_WORDS_MAX = RECORD_ARGS_WORD + 2 * DEFERRED_LOG_ARGS_MAX;
+
+static_assert(RECORD_WORDS_MAX <= 0xFF, "words count is stored on a byte");
+
+/**
+ * Read-only view of a record, as copied out of the ring or received by a host decoder
+ */
+struct record_view
+{
+    const uint32_t* words;
+
+    size_t size() const                 { return words[RECORD_HEADER_WORD] & 0xFF; }
+    size_t args_count() const           { return (words[RECORD_HEADER_WORD] >> 8) & 0xFF; }
+    uint32_t timestamp() const          { return words[RECORD_TIMESTAMP_WORD]; }
+    uint64_t format() const             { return load<uint64_t>(RECORD_FORMAT_WORD); }
+
+    arg_kind kind(size_t arg) const
+        { return static_cast<arg_kind>((words[RECORD_KINDS_WORD] >> (2 * arg)) & 0b11); }
+
+    template <typename T>
+    T load(size_t word) const;
+};
+
+/**
+ * Formats a record the way printf would have at call time, returns the count of written characters,
+ *  output is truncated to @c size and always null terminated.
+ *  Pointers of the format and of %s arguments are turned into strings by @c resolve(uint64_t):
+ *  the identity on the device, an address lookup in the firmware image for a host decoder.
+ *
+ *  Conversions are matched against the recorded kinds, a mismatch writes @c <?> and ends the record:
+ *  an unsupported conversion or a wrong argument never reads out of the record.
+ *  Integers are printed with the size they were recorded with, whatever their length modifier:
+ *  a @c long takes 32 bits on the device and 64 on a host decoder.
+ */
+template <typename Resolve>
+size_t format_record(const record_view& record, char* out, size_t size, Resolve&& resolve);
+
+/**
+ * Printer of a @c logging::Logger that defers formatting: a call costs a few word copies,
+ *  whatever the format. Records are written in a ring shared by every context logging,
+ *  main loop and interrupts alike, and read by a single low priority task with @c drain or @c ship.
+ *
+ *  Producers reserve their words with a compare and swap, fill them, then publish the header.
+ *  The reader stops at the first record not published yet, which can only be delayed
+ *  by the interrupt that preempted its writer.
+ *
+ *  When the ring is full, new records are dropped: written ones are never overwritten,
+ *  so the reader never sees a torn record and callers never wait. Drops are counted,
+ *  the reader reports them once it caught up with the records kept: as a text line with @c drain,
+ *  as a record without format, carrying the count in its timestamp, with @c ship.
+ *
+ * Context must provide the following static members:
+ *  - @c unsigned long micros()
+ *
+ * Transports given to @c drain and @c ship follow the @c BootLog ones:
+ *  - @c bool is_available(): true when writing may succeed,
+ *  - @c size_t write(const char* bytes, size_t size): writes without blocking, returns the written count,
+ *  - @c error::status_byte flush().
+ *
+ * @warning arguments are formatted later: strings given to %s must outlive the record,
+ *  such as literals and names tables, never a buffer on the stack
+ * @note loggers copy their printer, they should be given a @c printer() handle
+ */
+template <typename _Context, size_t _Size>
+class DeferredLog
+{
+public:
+    using Context = _Context;
+
+    static constexpr const size_t Size = _Size;
+    static constexpr const size_t Words = Size / 4;
+
+    static_assert(Size % 4 == 0 && (Words & (Words -1)) == 0, "ring size must be a power of two of words");
+    static_assert(Words >= 2 * RECORD_WORDS_MAX, "ring must hold a couple of records");
+
+    DeferredLog();
+
+    DeferredLog(const DeferredLog&) = delete;
+    DeferredLog& operator= (const DeferredLog&) = delete;
+
+    /**
+     * Printer handle on a deferred log
+     */
+    struct printer_type
+    {
+        template <typename ...Args>
+        error::status_byte operator() (const char* fmt, Args... args) const
+            { return (*log)(fmt, args...); }
+
+        error::status_byte flush() const
+            { return error::status_byte{}; }
+
+        DeferredLog* log;
+    };
+
+    printer_type printer()                  { return printer_type{this}; }
+
+    /**
+     * Records a printf-like output, callable from any context and never blocks,
+     *  returns a MEMORY_ERROR warning if the ring is full and the record is dropped
+     */
+    template <typename ...Args>
+    error::status_byte operator() (const char* fmt, Args... args);
+
+    /**
+     * Formats up to @c max records and writes them to @c transport, returns the count of consumed records.
+     *  A line the transport could not take whole is kept and completed first on next call
+     */
+    template <typename Transport>
+    size_t drain(Transport& transport, size_t max=SIZE_MAX);
+
+    /**
+     * Writes up to @c max records untouched to @c transport, as little endian words,
+     *  to be formatted by a host decoder with @c format_record. Returns the count of consumed records
+     */
+    template <typename Transport>
+    size_t ship(Transport& transport, size_t max=SIZE_MAX);
+
+    /** Returns true if no record waits for the reader */
+    bool is_empty() const
+        { return _tail.load(std::memory_order_relaxed) == _head.load(std::memory_order_acquire) && _pending_size == 0; }
+
+    /** Count of records dropped since construction */
+    uint32_t dropped_count() const          { return _dropped.load(std::memory_order_relaxed); }
+
+    /** Count of records written since construction */
+    uint32_t records_count() const          { return _records.load(std::memory_order_relaxed); }
+
+private:
+    template <typename T>
+    void store(uint32_t position, T value);
+
+    /** Copies next published record out of the ring and frees its words, returns false if there is none */
+    bool pop(uint32_t record[RECORD_WORDS_MAX]);
+
+    /** Writes pending bytes, returns true once they are all written */
+    template <typename Transport>
+    bool write_pending(Transport& transport);
+
+    /** Queues a notice for records dropped since the last one, returns true if there was one */
+    bool notice_drops();
+
+    std::atomic<uint32_t> _words[Words];
+    std::atomic<uint32_t> _head;    ///< next reserved word, free-running
+    std::atomic<uint32_t> _tail;    ///< next word to read, free-running
+
+    std::atomic<uint32_t> _dropped;
+    std::atomic<uint32_t> _records;
+
+    /* reader side */
+    uint32_t _reported;             ///< drops already noticed in the output
+    char _pending[DEFERRED_LOG_LINE_MAX_SIZE];
+    size_t _pending_size;
+    size_t _pending_sent;
+};
+
+} /* endof namespace logging */
+
+#include "deferred_log.hpp"
+
+#endif /* DEF_LOGGING_DEFERRED_LOG_HXX */
@@ -6,7 +6,7 @@
 #ifndef DEF_LOGGING_HXX
 #define DEF_LOGGING_HXX
 
-#include "../../error.h"
+#include "../mycelium/error.hpp"
 #include "../mycelium/mycelium.h"
 
 #include <cstddef>
@@ -6,7 +6,7 @@
 #define DEF_MYCELIUM_HXX
 
 #include <cstddef>
-#include "../../error.h"
+#include "error.hpp"
 
 #ifndef ARDUINO_TEENSY41
     #include <cassert>
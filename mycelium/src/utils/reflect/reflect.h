@@ -0,0 +1,5 @@
+/**
+ * 
+ */
+
+#include "reflect.hxx"
@@ -0,0 +1,211 @@
+/**
+ * 
+ */
+
+#include "reflect.hxx"
+
+namespace reflect
+{
+namespace detail
+{
+
+/**
+ * Extracts the enumerator from a signature, e.g. "... [with E = hw::pads::Pad; E V = hw::pads::Pad::SHIFT]",
+ *  values without enumerator are printed as casts: "(hw::pads::Pad)39"
+ */
+constexpr std::string_view parse_enumerator(std::string_view signature)
+    {
+        const size_t begin = signature.find("V = ");
+        if (begin == std::string_view::npos)
+            { return {}; }
+        std::string_view value = signature.substr(begin + 4);
+        value = value.substr(0, value.find_first_of(";],"));
+        if (value.empty() || value.find('(') != std::string_view::npos)
+            { return {}; }
+
+        const size_t scope = value.rfind(':');
+        if (scope != std::string_view::npos)
+            { value = value.substr(scope + 1); }
+        if (value.size() >= 2 && value[0] == '_' && value[1] == '_')
+            { return {}; }
+        return value;
+    }
+
+template <typename E, size_t ...I>
+constexpr std::array<std::string_view, sizeof...(I)> make_names(std::index_sequence<I...>)
+    { return { enumerator_name<E, static_cast<E>(I)>()... }; }
+
+template <typename E>
+inline constexpr std::array<std::string_view, enum_size<E>::value> names =
+    make_names<E>(std::make_index_sequence<enum_size<E>::value>{});
+
+template <size_t N>
+constexpr size_t packed_size(const std::array<std::string_view, N>& names)
+    {
+        size_t bytes = 0;
+        for (const auto& n: names)
+            { bytes += n.empty() ? 0 : n.size() + 1; }
+        return bytes ? bytes : 1;
+    }
+
+template <size_t Bytes, size_t N>
+constexpr name_table<N, Bytes> pack(const std::array<std::string_view, N>& names)
+    {
+        name_table<N, Bytes> table{};
+        size_t offset = 0;
+        for (size_t i=0; i<N; ++i)
+            {
+                table.offsets[i] = offset;
+                table.sizes[i] = names[i].size();
+                if (names[i].empty())
+                    { continue; }
+                for (char c: names[i])
+                    { table.chars[offset++] = c; }
+                table.chars[offset++] = '\0';
+            }
+        return table;
+    }
+
+template <typename E>
+inline constexpr auto table = pack<packed_size(names<E>)>(names<E>);
+
+template <size_t N>
+constexpr name_index<N> make_index(const std::array<std::string_view, N>& names)
+    {
+        using index_type = name_index<N>;
+        index_type result{};
+        result.valid = true;
+
+        uint32_t hashes[N] = {};
+        uint8_t sizes[index_type::Buckets] = {};
+        for (size_t i=0; i<N; ++i)
+            {
+                if (names[i].empty())
+                    { continue; }
+                hashes[i] = hash_of(names[i].data(), names[i].size());
+                sizes[index_type::bucket_of(hashes[i])] += 1;
+            }
+
+        /* largest buckets first, while most slots are free */
+        for (size_t size=N; size>0; --size)
+            for (size_t b=0; b<index_type::Buckets; ++b)
+                {
+                    if (sizes[b] != size)
+                        { continue; }
+
+                    bool placed = false;
+                    for (uint32_t seed=0; seed<UINT16_MAX && !placed; ++seed)
+                        {
+                            uint16_t taken[N] = {};
+                            size_t count = 0;
+                            placed = true;
+                            for (size_t i=0; i<N && placed; ++i)
+                                {
+                                    if (names[i].empty() || index_type::bucket_of(hashes[i]) != b)
+                                        { continue; }
+                                    const size_t slot = mix(hashes[i], seed) & (index_type::Slots -1);
+                                    placed = result.slots[slot] == 0;
+                                    for (size_t k=0; k<count && placed; ++k)
+                                        { placed = taken[k] != slot; }
+                                    taken[count++] = slot;
+                                }
+                            if (!placed)
+                                { continue; }
+
+                            result.seeds[b] = seed;
+                            for (size_t i=0; i<N; ++i)
+                                {
+                                    if (!names[i].empty() && index_type::bucket_of(hashes[i]) == b)
+                                        { result.slots[mix(hashes[i], seed) & (index_type::Slots -1)] = i + 1; }
+                                }
+                        }
+                    result.valid = result.valid && placed;
+                }
+        return result;
+    }
+
+template <typename E>
+inline constexpr name_index<enum_size<E>::value> index = make_index(names<E>);
+
+} /* endof namespace detail */
+
+template <typename E, E V>
+constexpr std::string_view
+enumerator_name()
+    { return detail::parse_enumerator(__PRETTY_FUNCTION__); }
+
+constexpr uint32_t
+hash_of(const char* text, size_t size)
+    {
+        uint32_t hash = 0x811C9DC5;
+        for (size_t i=0; i<size; ++i)
+            {
+                hash ^= static_cast<uint8_t>(text[i]);
+                hash *= 0x01000193;
+            }
+        return hash;
+    }
+
+constexpr uint32_t
+mix(uint32_t hash, uint32_t seed)
+    {
+        hash ^= seed * 0x9E3779B9;
+        hash ^= hash >> 15;
+        hash *= 0x85EBCA6B;
+        hash ^= hash >> 13;
+        return hash;
+    }
+
+template <typename E>
+constexpr const char*
+name_of(E value)
+    {
+        const size_t i = static_cast<size_t>(value);
+        if (!(i < enum_size<E>::value) || detail::table<E>.sizes[i] == 0)
+            { return nullptr; }
+        return detail::table<E>.chars + detail::table<E>.offsets[i];
+    }
+
+template <typename E>
+constexpr bool
+from_name(const char* text, size_t size, E& out)
+    {
+        using index_type = name_index<enum_size<E>::value>;
+        const auto& index = detail::index<E>;
+        const uint32_t hash = hash_of(text, size);
+        const uint8_t slot = index.slots[mix(hash, index.seeds[index_type::bucket_of(hash)]) & (index_type::Slots -1)];
+        if (slot == 0)
+            { return false; }
+
+        const size_t i = slot -1;
+        const auto& table = detail::table<E>;
+        if (table.sizes[i] != size)
+            { return false; }
+        for (size_t k=0; k<size; ++k)
+            {
+                if (table.chars[table.offsets[i] + k] != text[k])
+                    { return false; }
+            }
+        out = static_cast<E>(i);
+        return true;
+    }
+
+template <typename E>
+constexpr bool
+is_round_trip()
+    {
+        if (!detail::index<E>.valid)
+            { return false; }
+        for (size_t i=0; i<enum_size<E>::value; ++i)
+            {
+                const std::string_view name = detail::names<E>[i];
+                E found{};
+                if (!name.empty() && !(from_name(name.data(), name.size(), found) && found == static_cast<E>(i)))
+                    { return false; }
+                if (name.empty() && name_of(static_cast<E>(i)) != nullptr)
+                    { return false; }
+            }
+        return true;
+    }
+
+} /* endof namespace reflect */
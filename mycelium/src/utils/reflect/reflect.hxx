@@ -0,0 +1,111 @@
+/**
+ * Compile-time reflection of enumerations: names of enumerators are read from
+ *  the signature of a function template instantiated for each value, so that name tables
+ *  follow enumerations, including enumerators generated by macros.
+ *
+ * Name to value lookups go through a perfect hash built at compile time,
+ *  value to name lookups index an array.
+ *
+ * @note relies on the GCC and Clang format of @c __PRETTY_FUNCTION__
+ * @note a value named by several enumerators is given the first one declared,
+ *  and enumerators starting with '__' are reserved: values only named by them have no name
+ */
+
+#ifndef DEF_REFLECT_HXX
+#define DEF_REFLECT_HXX
+
+#include <array>
+#include <string_view>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+namespace reflect
+{
+
+/**
+ * Count of values of an enumeration, to be specialised:
+ *  reflected values are 0 to @c value -1
+ */
+template <typename E>
+struct enum_size;
+
+/**
+ * Name of the enumerator of value @c V, empty if it has none
+ */
+template <typename E, E V>
+constexpr std::string_view enumerator_name();
+
+/**
+ * FNV-1a hash of a name
+ */
+constexpr uint32_t hash_of(const char* text, size_t size);
+
+/**
+ * Seeded variation of a name hash
+ */
+constexpr uint32_t mix(uint32_t hash, uint32_t seed);
+
+/**
+ * Names of an enumeration, packed as null terminated strings
+ */
+template <size_t Count, size_t Bytes>
+struct name_table
+{
+    char chars[Bytes];
+    uint16_t offsets[Count];
+    uint8_t sizes[Count];       ///< 0 for values without name
+};
+
+/**
+ * Perfect hash of the names of an enumeration, hash and displace:
+ *  names are spread over buckets, and each bucket has a seed placing its names in free slots.
+ *  A lookup is a hash of the name, two mixes and a single comparison.
+ */
+template <size_t Count>
+struct name_index
+{
+    static_assert(Count < 255, "too many values");
+
+    static constexpr size_t slots_count()
+        {
+            size_t slots = 8;
+            while (slots < 2 * Count)
+                { slots *= 2; }
+            return slots;
+        }
+
+    static constexpr const size_t Slots = slots_count();
+    static constexpr const size_t Buckets = Slots / 8;
+
+    uint16_t seeds[Buckets];
+    uint8_t slots[Slots];       ///< value +1, 0 for free slots
+    bool valid;                 ///< false if no seed was found for a bucket
+
+    static constexpr size_t bucket_of(uint32_t hash)
+        { return (hash >> 16) & (Buckets -1); }
+};
+
+/**
+ * Name of a value, null terminated, null if the value has no name
+ */
+template <typename E>
+constexpr const char* name_of(E value);
+
+/**
+ * Value named by the @c size first chars of @c text, returns false if no value has this name
+ */
+template <typename E>
+constexpr bool from_name(const char* text, size_t size, E& out);
+
+/**
+ * Returns true if every named value is found back from its name, and unnamed ones are not
+ */
+template <typename E>
+constexpr bool is_round_trip();
+
+} /* endof namespace reflect */
+
+#include "reflect.hpp"
+
+#endif /* DEF_REFLECT_HXX */
@@ -0,0 +1,106 @@
+/**
+ * Host tool printing a compiled configuration image,
+ *  values are written back in the configuration text syntax
+ *
+ *  usage: config_inspect <image file>
+ */
+
+#include "config/config_cache/config_cache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace config;
+using namespace config::config_cache;
+namespace mapping = midi::midi_mapping;
+
+static const char* name_of(const mapping::control& c)
+{
+    const char* name = config_parser::name_of(c);
+    return name != nullptr ? name : "?";
+}
+
+static const char* color_name(uint8_t color)
+{
+    switch (static_cast<hw::leds_driver::pad_color>(color))
+        {
+        case hw::leds_driver::pad_color::OFF:       return "off";
+        case hw::leds_driver::pad_color::GREEN:     return "green";
+        case hw::leds_driver::pad_color::RED:       return "red";
+        case hw::leds_driver::pad_color::ORANGE:    return "orange";
+        default:                                    return "?";
+        }
+}
+
+int main(int argc, char* const argv[])
+{
+    if (argc != 2)
+        {
+            fprintf(stderr, "usage: %s <image file>\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == nullptr)
+        {
+            fprintf(stderr, "%s: cannot open\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+    static config_image image;
+    const size_t size = fread(&image, 1, sizeof(image), file);
+    const bool longer = fgetc(file) != EOF;
+    fclose(file);
+
+    printf("# image %s: %lu bytes, layout of %lu bytes\n", argv[1], size + longer, sizeof(config_image));
+    if (size >= sizeof(image_header))
+        {
+            const image_header& h = image.header;
+            printf("# magic 0x%08X%s, version %u%s, size %u\n", h.magic, h.magic == IMAGE_MAGIC ? "" : " (unknown)",
+                h.version, h.version == IMAGE_VERSION ? "" : " (unsupported)", h.size);
+            printf("# text hash 0x%08X, checksum 0x%08X, %u faulty lines\n", h.text_hash, h.checksum, h.errors);
+        }
+    if (longer || !validate(&image, size))
+        {
+            printf("# invalid image%s\n", size == sizeof(image) && !longer
+                && image.header.checksum != checksum_of(image) ? ": checksum mismatch" : "");
+            return EXIT_FAILURE;
+        }
+
+    printf("\n[settings]\n");
+    for (uint8_t s=0; s<config_parser::SETTINGS_COUNT; ++s)
+        {
+            if (image.has(static_cast<config_parser::setting>(s)))
+                { printf("%s = %u\n", config_parser::SETTINGS_SCHEMA[s].name, image.settings[s]); }
+        }
+
+    for (uint8_t m=0; m<MODES_COUNT; ++m)
+        {
+            if (!image.has(static_cast<mapping::mode>(m)))
+                { continue; }
+            printf("\n[mapping %s]    # %u bindings\n", m == 0 ? "apc40" : "extended", image.bindings_count[m]);
+            for (uint16_t i=0; i<image.bindings_count[m]; ++i)
+                {
+                    const mapping::binding& b = image.bindings[m][i];
+                    printf("%s%s = %s %u %u%s\n",
+                        b.target.kind == mapping::control_kind::RingStyle ? "style " : "", name_of(b.target),
+                        midi::type_of(b.status) == midi::status::NoteOn ? "note" : "cc",
+                        midi::channel_of(b.status), b.data1,
+                        b.flags == mapping::Both ? "" : b.flags == mapping::Outgoing ? " out" : " in");
+                }
+        }
+
+    printf("\n[state]\n");
+    for (uint8_t p=0; p<PADS_COUNT; ++p)
+        {
+            if (image.pad_colors[p] != UNSET)
+                { printf("%s = %s\n", reflect::name_of(static_cast<hw::pads::Pad>(p)), color_name(image.pad_colors[p])); }
+        }
+    for (uint8_t e=0; e<ENCODERS_COUNT; ++e)
+        {
+            if (image.ring_values[e] != UNSET)
+                { printf("%s = %u\n", reflect::name_of(static_cast<hw::analog::Encoder>(e)), image.ring_values[e]); }
+        }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,293 @@
+
+#include "config/config_cache/config_cache.h"
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+
+using namespace config;
+using namespace config::config_cache;
+using hw::pads::Pad;
+namespace mapping = midi::midi_mapping;
+
+/**
+ * SD card stand-in: a text file and an image file,
+ *  read time is modelled from the bytes read at @c BYTES_PER_US
+ */
+struct Storage
+{
+    static constexpr double BYTES_PER_US = 20;     ///< about 20MB/s
+
+    std::string text;
+    std::vector<uint8_t> image;
+    bool has_image = false;
+    bool writable = true;
+
+    size_t text_position = 0;
+    size_t bytes_read = 0;
+    size_t writes = 0;
+
+    size_t read_text(char* buffer, size_t size)
+        {
+            size = std::min(size, text.size() - text_position);
+            std::memcpy(buffer, text.data() + text_position, size);
+            text_position += size;
+            bytes_read += size;
+            return size;
+        }
+    void rewind_text()      { text_position = 0; }
+
+    size_t read_image(void* buffer, size_t size)
+        {
+            if (!has_image)
+                { return 0; }
+            size = std::min(size, image.size());
+            std::memcpy(buffer, image.data(), size);
+            bytes_read += size;
+            return image.size();
+        }
+    bool write_image(const void* buffer, size_t size)
+        {
+            if (!writable)
+                { return false; }
+            const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+            image.assign(bytes, bytes + size);
+            has_image = true;
+            writes += 1;
+            return true;
+        }
+
+    /** Starts a boot: files are opened again */
+    void boot()
+        {
+            text_position = 0;
+            bytes_read = 0;
+        }
+};
+
+/** A full configuration: settings, both built-in mappings and the leds state, about 600 lines */
+static std::string full_text()
+{
+    std::string text = "# device configuration\n[settings]\nrefresh_rate = 250\nsweep_rate = 4000\nnote_off_as_note_on = 1\n";
+    char line[96];
+    for (mapping::mode m: {mapping::mode::Apc40, mapping::mode::Extended})
+        {
+            mapping::binding bindings[mapping::BINDINGS_MAX_COUNT];
+            const size_t count = mapping::default_bindings(m, bindings);
+            text += m == mapping::mode::Apc40 ? "\n[mapping apc40]\n" : "\n[mapping extended]\n";
+            for (size_t i=0; i<count; ++i)
+                {
+                    const mapping::binding& b = bindings[i];
+                    snprintf(line, sizeof(line), "%s%s = %s %u %u%s\n",
+                        b.target.kind == mapping::control_kind::RingStyle ? "style " : "", config_parser::name_of(b.target),
+                        midi::type_of(b.status) == midi::status::NoteOn ? "note" : "cc",
+                        midi::channel_of(b.status), b.data1,
+                        b.flags == mapping::Both ? "" : b.flags == mapping::Outgoing ? " out" : " in");
+                    text += line;
+                }
+        }
+    text += "\n[state]\n";
+    for (uint8_t i=0; i<PADS_COUNT; ++i)
+        {
+            const Pad pad = static_cast<Pad>(i);
+            if (reflect::name_of(pad) != nullptr && !hw::is_blind(pad))
+                { text += std::string(reflect::name_of(pad)) + (hw::pads::is_bichrome(pad) ? " = red\n" : " = on\n"); }
+        }
+    for (uint8_t i=0; i<16; ++i)
+        { text += std::string(reflect::name_of(static_cast<hw::analog::Encoder>(i))) + " = 64\n"; }
+    return text;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    static config_image image, other;
+    const std::string text = full_text();
+
+    std::cout << "Testing compilation" << std::endl;
+    {
+        Storage storage;
+        storage.text = text;
+        struct { Storage& s; size_t read(char* b, size_t n) { return s.read_text(b, n); } } reader{storage};
+        assert(compile(reader, image));
+        assert(validate(&image, sizeof(image)));
+        assert(image.header.errors == 0);
+
+        fnv1a hash;
+        hash.feed(text.data(), text.size());
+        assert(image.header.text_hash == hash.value);
+
+        assert(image.has(config_parser::setting::RefreshRate) && image.get(config_parser::setting::RefreshRate) == 250);
+        assert(!image.has(config_parser::setting::I2CFrequency));
+        assert(image.has(mapping::mode::Apc40) && image.has(mapping::mode::Extended));
+        assert(image.pad_colors[static_cast<uint8_t>(Pad::CLIP_1_1)] == static_cast<uint8_t>(hw::leds_driver::pad_color::RED));
+        assert(image.pad_colors[static_cast<uint8_t>(Pad::PLAY)] == UNSET);
+        assert(image.ring_values[static_cast<uint8_t>(hw::analog::Encoder::CTRL_7)] == 64);
+        assert(image.ring_values[static_cast<uint8_t>(hw::analog::Encoder::CUE_LEVEL)] == UNSET);
+
+        /* configured mappings match the built-in ones they were written from */
+        static mapping::Mappings built_in, loaded;
+        assert(built_in.setup() && loaded.setup());
+        assert(load_mappings(image, loaded));
+        for (mapping::mode m: {mapping::mode::Apc40, mapping::mode::Extended})
+            { assert(std::memcmp(&built_in.table(m), &loaded.table(m), sizeof(mapping::MappingTable)) == 0); }
+    }
+
+    std::cout << "Testing cache invalidation" << std::endl;
+    {
+        Storage storage;
+        storage.text = text;
+        load_report report;
+
+        /* first boot compiles and stores */
+        storage.boot();
+        assert(load(storage, image, &report));
+        assert(report.source == load_source::Text && report.stored && storage.writes == 1);
+        assert(report.text_bytes == text.size());
+
+        /* next boots only hash the text */
+        storage.boot();
+        std::memset(&other, 0, sizeof(other));
+        assert(load(storage, other, &report));
+        assert(report.source == load_source::Cache && !report.stored && storage.writes == 1);
+        assert(std::memcmp(&image, &other, sizeof(image)) == 0);
+
+        /* edited text */
+        storage.text.replace(storage.text.find("refresh_rate = 250"), 18, "refresh_rate = 500");
+        storage.boot();
+        assert(load(storage, other, &report));
+        assert(report.source == load_source::Text && storage.writes == 2);
+        assert(report.text_bytes == 2 * text.size());
+        assert(other.get(config_parser::setting::RefreshRate) == 500);
+        storage.boot();
+        assert(load(storage, other, &report) && report.source == load_source::Cache);
+
+        /* corrupted image */
+        storage.image[sizeof(image_header) + 40] ^= 0x10;
+        storage.boot();
+        assert(load(storage, other, &report) && report.source == load_source::Text && storage.writes == 3);
+
+        /* older layout or format */
+        config_image* stored = reinterpret_cast<config_image*>(storage.image.data());
+        stored->header.version = IMAGE_VERSION + 1;
+        stored->header.checksum = checksum_of(*stored);
+        storage.boot();
+        assert(load(storage, other, &report) && report.source == load_source::Text && storage.writes == 4);
+        storage.image.resize(storage.image.size() - 8);
+        storage.boot();
+        assert(load(storage, other, &report) && report.source == load_source::Text && storage.writes == 5);
+
+        /* read-only storage still boots, parsing every time */
+        storage.text += "\n";
+        storage.writable = false;
+        for (int i=0; i<2; ++i)
+            {
+                storage.boot();
+                assert(load(storage, other, &report));
+                assert(report.source == load_source::Text && !report.stored);
+            }
+
+        /* faulty lines are remembered by the image */
+        storage.writable = true;
+        storage.text += "[state]\nPLAY = on\nPAN_0 = 300\n";
+        storage.boot();
+        const error::status_byte status = load(storage, other, &report);
+        assert(!status && report.source == load_source::Text && report.errors == 2);
+        storage.boot();
+        assert(load(storage, other, &report) && report.source == load_source::Cache && report.errors == 2);
+    }
+
+    std::cout << "Testing images in place" << std::endl;
+    {
+        static config_image bytes[2];
+        std::memcpy(&bytes[0], &image, sizeof(image));
+        assert(map(&bytes[0], sizeof(image)) == &bytes[0]);
+        assert(map(&bytes[0], sizeof(image) - 1) == nullptr);
+        assert(map(reinterpret_cast<uint8_t*>(&bytes[0]) + 1, sizeof(image)) == nullptr);
+        bytes[0].bindings[0][3].data1 ^= 1;
+        assert(map(&bytes[0], sizeof(image)) == nullptr);
+    }
+
+    std::cout << "\nBoot time: configuration text against its compiled image" << std::endl;
+    {
+        Storage storage;
+        storage.text = text;
+        constexpr int RUNS = 2000;
+        load_report report;
+
+        auto measure = [&](auto&& boot) {
+                double read_us = 0;
+                auto begin = std::chrono::steady_clock::now();
+                for (int i=0; i<RUNS; ++i)
+                    {
+                        storage.boot();
+                        boot();
+                        read_us += storage.bytes_read / Storage::BYTES_PER_US;
+                    }
+                const double cpu_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+                return std::make_pair(cpu_us / RUNS, read_us / RUNS);
+            };
+
+        /* parsing every boot */
+        storage.writable = false;
+        const auto parse = measure([&]() { load(storage, image, &report); assert(report.source == load_source::Text); });
+        const size_t parse_bytes = storage.bytes_read;
+
+        /* cached image, text hashed to detect edits */
+        storage.writable = true;
+        storage.boot();
+        load(storage, image);
+        const auto cached = measure([&]() { load(storage, image, &report); assert(report.source == load_source::Cache); });
+        const size_t cached_bytes = storage.bytes_read;
+
+        /* image mapped in place, text not read */
+        alignas(config_image) static uint8_t sector[sizeof(config_image)];
+        const auto mapped = measure([&]() {
+                storage.read_image(sector, sizeof(sector));
+                const config_image* in_place = map(sector, sizeof(sector));
+                assert(in_place != nullptr);
+            });
+        const size_t mapped_bytes = storage.bytes_read;
+
+        printf("\t%lu bytes of text, %lu lines, image of %lu bytes\n",
+            text.size(), static_cast<unsigned long>(std::count(text.begin(), text.end(), '\n')), sizeof(config_image));
+        /* the 600MHz target is taken as 10 times slower than the host */
+        constexpr double TARGET_SLOWDOWN = 10;
+        printf("\t%24s | %10s %12s %12s | %12s\n", "boot", "read", "cpu (host)", "read (model)", "target (est)");
+        for (const auto& row: {std::make_tuple("parse text", parse_bytes, parse),
+                std::make_tuple("hash text, load image", cached_bytes, cached),
+                std::make_tuple("map image in place", mapped_bytes, mapped)})
+            {
+                const auto& t = std::get<2>(row);
+                printf("\t%24s | %8luB %10.1fus %10.1fus | %10.1fus\n", std::get<0>(row), std::get<1>(row),
+                    t.first, t.second, t.first * TARGET_SLOWDOWN + t.second);
+            }
+
+        /* host cpu times are only printed: the cached and mapped paths never parse,
+            they read the text once to hash it at most, and the image */
+        assert(parse_bytes == text.size());
+        assert(cached_bytes == text.size() + sizeof(config_image));
+        assert(mapped_bytes == sizeof(config_image) && mapped_bytes < parse_bytes);
+
+        if (argc > 1)
+            {
+                FILE* file = fopen(argv[1], "wb");
+                assert(file != nullptr);
+                fwrite(storage.image.data(), 1, storage.image.size(), file);
+                fclose(file);
+                printf("\timage written to %s\n", argv[1]);
+            }
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,307 @@
+
+#include "config/config_parser/config_parser.h"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <cassert>
+#include <new>
+
+using namespace config;
+using namespace config::config_parser;
+using hw::pads::Pad;
+using hw::analog::Encoder;
+using hw::leds_driver::pad_color;
+namespace mapping = midi::midi_mapping;
+
+/** Heap allocations counter, to check parsing never allocates */
+static size_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    allocations += 1;
+    if (void* p = std::malloc(size))
+        { return p; }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept                  { std::free(p); }
+void operator delete(void* p, size_t) noexcept          { std::free(p); }
+
+/**
+ * File stand-in handing the text in chunks of at most @c chunk bytes
+ */
+struct TextReader
+{
+    const std::string& text;
+    size_t chunk;
+    size_t position = 0;
+
+    size_t read(char* buffer, size_t size)
+        {
+            size = std::min(std::min(size, chunk), text.size() - position);
+            std::memcpy(buffer, text.data() + position, size);
+            position += size;
+            return size;
+        }
+};
+
+using parser_type = ConfigParser<TextReader>;
+
+static std::vector<entry> parse_all(const std::string& text, size_t chunk=READ_WINDOW_SIZE)
+{
+    TextReader reader{text, chunk};
+    parser_type parser(reader);
+    std::vector<entry> entries;
+    entry e;
+    while (parser.next(e))
+        { entries.push_back(e); }
+    return entries;
+}
+
+/** Parses a single line in a section, expecting a rejection at given column */
+static void expect_error(const char* header, const char* line, uint16_t column, const char* message)
+{
+    const std::string text = std::string(header) + "\n" + line + "\n";
+    const auto entries = parse_all(text);
+    const entry& e = entries.back();
+    if (e.kind != entry_kind::Error || e.at.line != 2 || e.at.column != column || std::strcmp(e.message, message) != 0)
+        {
+            printf("\t'%s': got line %u column %u '%s'\n", line, e.at.line, e.at.column,
+                e.kind == entry_kind::Error ? e.message : "no error");
+            fflush(stdout);
+            assert(false);
+        }
+}
+
+/** Writes a mapping section from bindings */
+static std::string mapping_text(mapping::mode m)
+{
+    mapping::binding bindings[mapping::BINDINGS_MAX_COUNT];
+    const size_t count = mapping::default_bindings(m, bindings);
+    std::string text = m == mapping::mode::Apc40 ? "[mapping apc40]\n" : "[mapping extended]\n";
+    char line[96];
+    for (size_t i=0; i<count; ++i)
+        {
+            const mapping::binding& b = bindings[i];
+            const char* flags = b.flags == mapping::Both ? "" : b.flags == mapping::Outgoing ? " out" : " in";
+            snprintf(line, sizeof(line), "%s%s = %s %u %u%s\n",
+                b.target.kind == mapping::control_kind::RingStyle ? "style " : "", name_of(b.target),
+                midi::type_of(b.status) == midi::status::NoteOn ? "note" : "cc",
+                midi::channel_of(b.status), b.data1, flags);
+            text += line;
+        }
+    return text;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing element names" << std::endl;
+    {
+        assert(std::strcmp(reflect::name_of(Pad::CLIP_4_7), "CLIP_4_7") == 0);
+        assert(std::strcmp(reflect::name_of(Pad::SELECT_MASTER), "SELECT_MASTER") == 0);
+        assert(reflect::name_of(Pad::__UNUSED_33_7__) == nullptr);
+        assert(std::strcmp(reflect::name_of(Pad::SEND_C), "SEND_C") == 0);
+        assert(reflect::name_of(Pad::__UNUSED_39_4__) == nullptr);
+        assert(std::strcmp(reflect::name_of(Pad::BANK_DOWN), "BANK_DOWN") == 0);
+        assert(std::strcmp(reflect::name_of(Encoder::CUE_LEVEL), "CUE_LEVEL") == 0);
+        assert(std::strcmp(reflect::name_of(hw::analog::Fader::CROSSFADE), "CROSSFADE") == 0);
+
+        const mapping::control c = find_control("CTRL_3", 6);
+        assert(c.kind == mapping::control_kind::Encoder && c.index == static_cast<uint8_t>(Encoder::CTRL_3));
+        assert(find_control("CTRL_3", 5).is_none());
+        assert(find_control("PAN", 3).kind == mapping::control_kind::Pad);
+    }
+
+    std::cout << "Testing a complete file" << std::endl;
+    {
+        const std::string text =
+            "# device configuration\n"
+            "\n"
+            "[settings]\n"
+            "refresh_rate = 250     # Hz\n"
+            "note_off_as_note_on=0\n"
+            "[mapping extended]\n"
+            "  CLIP_0_0 = note 0 53\n"
+            "\tPAN_0 = cc 1 48 out\r\n"
+            "style PAN_0 = cc 1 56 in\n"
+            "[ state ]\n"
+            "CLIP_2_3 = orange\n"
+            "TRACK_SELECT_1 = on\n"
+            "CTRL_7 = 127";
+
+        for (size_t chunk: {1UL, 3UL, 7UL, 128UL})
+            {
+                const auto entries = parse_all(text, chunk);
+                assert(entries.size() == 11);
+                for (const entry& e: entries)
+                    { assert(e.kind != entry_kind::Error); }
+
+                assert(entries[0].kind == entry_kind::Section && entries[0].in == section::Settings);
+                assert(entries[1].kind == entry_kind::Setting && entries[1].option.key == setting::RefreshRate);
+                assert(entries[1].option.value == 250 && entries[1].at.line == 4 && entries[1].at.column == 1);
+                assert(entries[2].option.key == setting::NoteOffAsNoteOn && entries[2].option.value == 0);
+
+                assert(entries[3].kind == entry_kind::Section && entries[3].mode == mapping::mode::Extended);
+                const mapping::binding& note = entries[4].binding;
+                assert(entries[4].kind == entry_kind::Binding && entries[4].at.column == 3);
+                assert(note.target.kind == mapping::control_kind::Pad && note.status == 0x90 && note.data1 == 53);
+                assert(note.flags == mapping::Both);
+                assert(entries[5].binding.status == 0xB1 && entries[5].binding.flags == mapping::Outgoing);
+                assert(entries[6].binding.target.kind == mapping::control_kind::RingStyle);
+                assert(entries[6].binding.flags == mapping::Incoming && entries[6].mode == mapping::mode::Extended);
+
+                assert(entries[7].in == section::State);
+                assert(entries[8].kind == entry_kind::PadState && entries[8].pad.pad == Pad::CLIP_2_3);
+                assert(entries[8].pad.color == pad_color::ORANGE);
+                assert(entries[9].pad.pad == Pad::TRACK_SELECT_1 && entries[9].pad.color == pad_color::ON);
+                assert(entries[10].kind == entry_kind::EncoderState && entries[10].encoder.value == 127);
+                assert(entries[10].at.line == 13);
+            }
+    }
+
+    std::cout << "Testing errors locations" << std::endl;
+    {
+        expect_error("", "refresh_rate = 250", 1, "entry outside of any section");
+        expect_error("", "[unknown]", 2, "unknown section");
+        expect_error("", "[mapping]", 9, "expected apc40 or extended mapping");
+        expect_error("", "[mapping apc41]", 10, "expected apc40 or extended mapping");
+        expect_error("", "[state", 7, "expected ']'");
+        expect_error("", "[state] x", 9, "unexpected value after section");
+
+        expect_error("[settings]", "refresh_rate 250", 14, "expected '='");
+        expect_error("[settings]", "refresh_rat = 250", 1, "unknown setting");
+        expect_error("[settings]", "refresh_rate = 0", 16, "value out of range");
+        expect_error("[settings]", "refresh_rate = 99999999999999999999", 16, "value out of range");
+        expect_error("[settings]", "refresh_rate =", 15, "expected a value");
+        expect_error("[settings]", "refresh_rate = 250 Hz", 20, "unexpected value");
+        expect_error("[settings]", "refresh_rate = 25O", 16, "malformed number");
+        expect_error("[settings]", "refresh_rate = -1", 16, "unexpected character");
+        expect_error("[settings]", "a_very_long_setting_name_indeed = 1", 1, "token too long");
+
+        expect_error("[state]", "CLIP_9_0 = red", 1, "unknown device element");
+        expect_error("[state]", "PLAY = on", 1, "pad has no led");
+        expect_error("[state]", "CLIP_STOP_0 = red", 15, "pad has a single led");
+        expect_error("[state]", "CLIP_0_0 = blue", 12, "expected off, on, green, red or orange");
+        expect_error("[state]", "CUE_LEVEL = 3", 1, "encoder has no led-ring");
+        expect_error("[state]", "PAN_1 = 128", 9, "value out of range");
+        expect_error("[state]", "MASTER_LEVEL = 1", 1, "expected a pad or an encoder");
+
+        expect_error("[mapping apc40]", "CLIP_0_0 note 0 53", 10, "expected '='");
+        expect_error("[mapping apc40]", "CLIP_0_0 = pc 0 53", 12, "expected note or cc");
+        expect_error("[mapping apc40]", "PAN_0 = note 0 53", 9, "only pads send notes");
+        expect_error("[mapping apc40]", "CLIP_0_0 = note 16 53", 17, "expected a channel from 0 to 15");
+        expect_error("[mapping apc40]", "CLIP_0_0 = note 0", 18, "expected a number from 0 to 127");
+        expect_error("[mapping apc40]", "CLIP_0_0 = note 0 53 sideways", 22, "expected in, out or both");
+        expect_error("[mapping apc40]", "CLIP_0_0 = note 0 53 in 1", 25, "unexpected value");
+        expect_error("[mapping apc40]", "style CUE_LEVEL = cc 0 1", 7, "style applies to encoders with a led-ring");
+        expect_error("[mapping apc40]", "= cc 0 1", 1, "expected a name");
+        expect_error("[mapping apc40]", "A = 1 2 3 4 5 6 7 8", 17, "too many values");
+
+        /* parsing goes on after a faulty line */
+        const std::string text = "[state]\nPAN_1 = 200\nPAN_1 = 20\nPLAY = on\n";
+        TextReader reader{text, 5};
+        parser_type parser(reader);
+        entry e;
+        assert(parser.next(e) && e.kind == entry_kind::Section);
+        assert(parser.next(e) && e.kind == entry_kind::Error);
+        assert(parser.next(e) && e.kind == entry_kind::EncoderState && e.encoder.value == 20);
+        assert(parser.next(e) && e.kind == entry_kind::Error && e.at.line == 4);
+        assert(!parser.next(e));
+        assert(parser.errors_count() == 2 && parser.lines_count() == 4);
+        assert(static_cast<error::errcode>(parser.status()) == error::errcode::INVALID_ARGUMENT);
+
+        /* faulty headers are reported in the section open before them */
+        const std::string headers = "[unknown]\n[mapping extended]\n[state\n[settings] x\n";
+        const auto entries = parse_all(headers);
+        assert(entries.size() == 4 && entries[1].kind == entry_kind::Section);
+        assert(entries[0].kind == entry_kind::Error && entries[0].in == section::None);
+        for (size_t i: {2, 3})
+            {
+                assert(entries[i].kind == entry_kind::Error);
+                assert(entries[i].in == (i == 2 ? section::Mapping : section::None));
+                assert(entries[i].mode == mapping::mode::Extended);
+            }
+    }
+
+    std::cout << "Testing built-in mappings round trip" << std::endl;
+    for (mapping::mode m: {mapping::mode::Apc40, mapping::mode::Extended})
+        {
+            mapping::binding expected[mapping::BINDINGS_MAX_COUNT];
+            const size_t count = mapping::default_bindings(m, expected);
+            const std::string text = mapping_text(m);
+
+            static mapping::binding parsed[mapping::BINDINGS_MAX_COUNT];
+            size_t parsed_count = 0;
+            const size_t before = allocations;
+            TextReader reader{text, 61};
+            parser_type parser(reader);
+            entry e;
+            while (parser.next(e))
+                {
+                    assert(e.kind != entry_kind::Error);
+                    if (e.kind == entry_kind::Binding && e.mode == m)
+                        { parsed[parsed_count++] = e.binding; }
+                }
+            assert(allocations == before);
+            assert(parsed_count == count);
+
+            static mapping::MappingTable a, b;
+            assert(mapping::compile(expected, count, a));
+            assert(mapping::compile(parsed, parsed_count, b));
+            assert(std::memcmp(&a, &b, sizeof(a)) == 0);
+        }
+
+    std::cout << "\nBenchmark: parsing a large configuration" << std::endl;
+    {
+        std::string text = "# generated\n[settings]\nrefresh_rate = 250\nsweep_rate = 4000\n";
+        const std::string apc40 = mapping_text(mapping::mode::Apc40);
+        const std::string extended = mapping_text(mapping::mode::Extended);
+        std::string state = "[state]\n";
+        for (uint8_t i=0; i<mapping::PADS_COUNT; ++i)
+            {
+                const Pad pad = static_cast<Pad>(i);
+                if (reflect::name_of(pad) != nullptr && !hw::is_blind(pad))
+                    { state += std::string(reflect::name_of(pad)) + (hw::pads::is_bichrome(pad) ? " = orange   # both leds\n" : " = on\n"); }
+            }
+        while (text.size() < 4 * 1024 * 1024)
+            { text += apc40 + extended + state; }
+
+        size_t lines = 0, entries = 0;
+        const size_t before = allocations;
+        auto begin = std::chrono::steady_clock::now();
+        constexpr int RUNS = 5;
+        for (int r=0; r<RUNS; ++r)
+            {
+                TextReader reader{text, SIZE_MAX};
+                parser_type parser(reader);
+                entry e;
+                while (parser.next(e))
+                    {
+                        assert(e.kind != entry_kind::Error);
+                        entries += 1;
+                    }
+                lines += parser.lines_count();
+            }
+        const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / RUNS;
+        assert(allocations == before);
+
+        printf("\t%.1f MB, %lu lines: %.1f ms, %.1f MB/s, %.1f ns/line, %lu heap allocations\n",
+            text.size() / 1e6, lines / RUNS, s * 1e3, text.size() / s / 1e6, s * 1e9 / (lines / RUNS),
+            allocations - before);
+        printf("\tparser footprint: %lu bytes\n", sizeof(parser_type));
+        /* a regular file, about 600 lines, is parsed well under a millisecond on a desktop */
+        assert(entries > 0);
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
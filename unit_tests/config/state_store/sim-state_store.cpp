@@ -0,0 +1,479 @@
+
+#include "config/state_store/state_store.h"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <unistd.h>
+
+using namespace config;
+using namespace config::state_store;
+namespace mapping = midi::midi_mapping;
+
+/**
+ * Files in a temporary directory, with power losses:
+ *  once @c budget is spent, writes stop in the middle and every later operation fails.
+ *  Appends spend their size, truncations and renames a single unit
+ */
+struct FileStorage
+{
+    std::string directory;
+    long budget = -1;           ///< negative for an endless supply
+    bool crashed = false;
+    unsigned long spent = 0;
+
+    std::string path(file f) const
+        {
+            switch (f)
+                {
+                case file::Snapshot:        return directory + "/state.txt";
+                case file::SnapshotTemp:    return directory + "/state.txt.new";
+                default:                    return directory + "/state.journal";
+                }
+        }
+
+    /** Spends budget for @c units, returns how many are granted */
+    size_t spend(size_t units)
+        {
+            if (crashed)
+                { return 0; }
+            if (budget >= 0 && static_cast<long>(units) > budget)
+                {
+                    units = budget;
+                    crashed = true;
+                }
+            if (budget >= 0)
+                { budget -= units; }
+            spent += units;
+            return units;
+        }
+
+    size_t size(file f) const
+        {
+            FILE* fp = fopen(path(f).c_str(), "rb");
+            if (fp == nullptr)
+                { return 0; }
+            fseek(fp, 0, SEEK_END);
+            const long size = ftell(fp);
+            fclose(fp);
+            return size;
+        }
+
+    size_t read(file f, size_t offset, void* buffer, size_t size) const
+        {
+            FILE* fp = fopen(path(f).c_str(), "rb");
+            if (fp == nullptr)
+                { return 0; }
+            fseek(fp, offset, SEEK_SET);
+            const size_t count = fread(buffer, 1, size, fp);
+            fclose(fp);
+            return count;
+        }
+
+    bool append(file f, const void* bytes, size_t size)
+        {
+            const size_t granted = spend(size);
+            FILE* fp = fopen(path(f).c_str(), "ab");
+            fwrite(bytes, 1, granted, fp);
+            fclose(fp);
+            return granted == size;
+        }
+
+    bool truncate(file f, size_t size)
+        {
+            if (spend(1) != 1)
+                { return false; }
+            fclose(fopen(path(f).c_str(), "ab"));
+            return ::truncate(path(f).c_str(), size) == 0;
+        }
+
+    bool replace(file from, file to)
+        {
+            if (spend(1) != 1)
+                { return false; }
+            return std::rename(path(from).c_str(), path(to).c_str()) == 0;
+        }
+
+    void erase()
+        {
+            for (file f: {file::Snapshot, file::SnapshotTemp, file::Journal})
+                { std::remove(path(f).c_str()); }
+        }
+};
+
+struct TestSettings
+{
+    static size_t CompactionThreshold;
+};
+size_t TestSettings::CompactionThreshold = 1024;
+
+using store_type = StateStore<FileStorage, TestSettings>;
+
+/**
+ * Device state: leds of pads and rings, sequencer patterns and the configured mapping
+ */
+struct State
+{
+    uint8_t leds[mapping::PADS_COUNT + mapping::ENCODERS_COUNT];
+    uint8_t patterns[8][64];
+    mapping::binding bindings[mapping::BINDINGS_MAX_COUNT];
+
+    bool operator==(const State& other) const   { return std::memcmp(this, &other, sizeof(State)) == 0; }
+};
+
+enum region_index: uint8_t { Leds, Patterns, Mappings };
+
+static void attach(store_type& store, State& state)
+{
+    assert(store.add("leds", state.leds, sizeof(state.leds), nullptr, &LEDS_STATE_TEXT));
+    assert(store.add("patterns", state.patterns, sizeof(state.patterns)));
+    assert(store.add("mappings", state.bindings, sizeof(state.bindings)));
+}
+
+/**
+ * Leds entries of the state: pads and encoders with leds
+ */
+static bool has_led(uint16_t led)
+{
+    if (led < mapping::PADS_COUNT)
+        {
+            const hw::pads::Pad pad = static_cast<hw::pads::Pad>(led);
+            return reflect::name_of(pad) != nullptr && !hw::is_blind(pad);
+        }
+    return !hw::is_blind(static_cast<hw::analog::Encoder>(led - mapping::PADS_COUNT));
+}
+
+/**
+ * Edits made by the user between two saves: a few leds, a pattern step, sometimes the whole mapping
+ */
+template <typename Rand>
+static void edit(State& state, store_type& store, Rand& rand)
+{
+    for (int i=0, n=1 + rand() % 4; i<n; ++i)
+        {
+            uint16_t led = rand() % sizeof(state.leds);
+            while (!has_led(led))
+                { led = rand() % sizeof(state.leds); }
+            if (led >= mapping::PADS_COUNT)
+                { state.leds[led] = rand() & 0x7F; }
+            else
+                { state.leds[led] = rand() & (hw::pads::is_monochrome(static_cast<hw::pads::Pad>(led)) ? 0x01 : 0x03); }
+            store.touch(Leds, led, 1);
+        }
+    const uint8_t track = rand() % 8, step = rand() % 64;
+    state.patterns[track][step] = rand();
+    store.touch(Patterns, track * 64 + step, 1);
+    if (rand() % 16 == 0)
+        {
+            for (auto& b: state.bindings)
+                { b.data1 = rand() & 0x7F; }
+            store.touch(Mappings);
+        }
+}
+
+struct Scenario
+{
+    std::vector<State> committed;       ///< state after each save, first is the default state
+    size_t interrupted = 0;             ///< save running when power was lost
+};
+
+/** Edits and saves @c saves times from empty files, until the storage loses power */
+static Scenario run(FileStorage& storage, size_t saves, uint32_t seed)
+{
+    std::mt19937 rand(seed);
+    static State state;
+    std::memset(&state, 0, sizeof(state));
+    store_type store(storage);
+    attach(store, state);
+    store.load();
+
+    Scenario scenario;
+    scenario.committed.push_back(state);
+    for (size_t i=0; i<saves; ++i)
+        {
+            edit(state, store, rand);
+            scenario.interrupted = i + 1;
+            const bool saved = store.save();
+            if (storage.crashed)
+                {
+                    /* a save either commits whole or not at all */
+                    scenario.committed.push_back(state);
+                    return scenario;
+                }
+            assert(saved);
+            scenario.committed.push_back(state);
+        }
+    scenario.interrupted = 0;
+    return scenario;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    char directory[] = "/tmp/state_store.XXXXXX";
+    assert(mkdtemp(directory) != nullptr);
+    FileStorage storage;
+    storage.directory = directory;
+
+    std::cout << "Testing regions" << std::endl;
+    {
+        storage.erase();
+        static uint8_t data[REGION_MAX_SIZE + 1];
+        store_type store(storage);
+        uint8_t index = 0xFF;
+        assert(store.add("leds", data, 16, &index) && index == 0);
+        assert(!store.add("leds", data, 16));
+        assert(!store.add("Leds", data, 16));
+        assert(!store.add("", data, 16));
+        assert(!store.add("a_very_long_region", data, 16));
+        assert(!store.add("big", data, REGION_MAX_SIZE + 1));
+        assert(!store.add("empty", data, 0));
+        assert(!store.add("ring", data, 16, nullptr, &LEDS_STATE_TEXT));
+        for (uint8_t i=1; i<REGIONS_MAX; ++i)
+            {
+                char name[8];
+                snprintf(name, sizeof(name), "r%u", i);
+                assert(store.add(name, data, 16, &index) && index == i);
+            }
+        assert(static_cast<error::errcode>(store.add("more", data, 16)) == error::errcode::MEMORY_ERROR);
+    }
+
+    std::cout << "Testing incremental saves" << std::endl;
+    {
+        storage.erase();
+        static State state, loaded;
+        std::memset(&state, 0, sizeof(state));
+        store_type store(storage);
+        attach(store, state);
+        assert(store.load() && store.sequence() == 0 && !store.is_dirty());
+        assert(store.save() && store.journal_size() == 0);
+
+        /* two bytes of a single block, and a range across two blocks */
+        state.leds[3] = 2;
+        state.leds[4] = 1;
+        store.touch(Leds, 3, 2);
+        std::memset(&state.patterns[1][30], 0x7F, 4);
+        store.touch(Patterns, 64 + 30, 4);
+        assert(store.is_dirty());
+        assert(store.save() && !store.is_dirty());
+        assert(store.counters().blocks == 3);
+        assert(store.journal_size() == 3 * (sizeof(record_header) + BLOCK_SIZE) + sizeof(record_header));
+        assert(storage.size(file::Snapshot) == 0);
+
+        std::memset(&loaded, 0, sizeof(loaded));
+        store_type reloaded(storage);
+        attach(reloaded, loaded);
+        assert(reloaded.load());
+        assert(loaded == state && reloaded.sequence() == 1 && reloaded.counters().replayed == 1);
+
+        /* regions registered in another order, after a new one of the same size, still get their blocks */
+        {
+            static uint8_t tempo[sizeof(state.patterns)];
+            std::memset(&loaded, 0, sizeof(loaded));
+            std::memset(tempo, 0, sizeof(tempo));
+            store_type reordered(storage);
+            assert(reordered.add("tempo", tempo, sizeof(tempo)));
+            assert(reordered.add("mappings", loaded.bindings, sizeof(loaded.bindings)));
+            assert(reordered.add("patterns", loaded.patterns, sizeof(loaded.patterns)));
+            assert(reordered.add("leds", loaded.leds, sizeof(loaded.leds), nullptr, &LEDS_STATE_TEXT));
+            assert(reordered.load() && reordered.counters().replayed == 1);
+            assert(loaded == state);
+            for (uint8_t b: tempo)
+                { assert(b == 0); }
+        }
+
+        /* out of range touches are ignored */
+        store.touch(Leds, sizeof(state.leds), 1);
+        store.touch(7, 0, 1);
+        assert(!store.is_dirty());
+    }
+
+    std::cout << "Testing readable snapshots" << std::endl;
+    {
+        storage.erase();
+        static State state, loaded;
+        std::memset(&state, 0, sizeof(state));
+        store_type store(storage);
+        attach(store, state);
+        store.load();
+
+        state.leds[0] = 0x03;
+        state.leds[40] = 0x01;
+        state.leds[mapping::PADS_COUNT + 2] = 64;
+        state.patterns[7][63] = 0xA5;
+        store.touch(Leds);
+        store.touch(Patterns);
+        assert(store.compact());
+        assert(store.journal_size() == 0 && storage.size(file::Journal) == 0);
+
+        std::string text(storage.size(file::Snapshot), '\0');
+        storage.read(file::Snapshot, 0, &text[0], text.size());
+        /* leds in the [state] syntax of the configuration, other regions as blocks */
+        assert(text.find("# mycelium device state\nsequence = 1\n[leds]\nCLIP_0_0 = orange\nCLIP_0_1 = off\n") == 0);
+        assert(text.find("\nCLIP_STOP_0 = on\n") != std::string::npos);
+        assert(text.find("\nPAN_2 = 64\n") != std::string::npos);
+        assert(text.find("STOP_ALL_CLIPS") == std::string::npos && text.find("CUE_LEVEL") == std::string::npos);
+        assert(text.find("\n[patterns]\n0 = 00 00") != std::string::npos);
+        assert(text.find(" a5\n[mappings]\n") != std::string::npos);
+        assert(text.find("\nchecksum = ") != std::string::npos);
+        printf("\tsnapshot: %lu bytes for %lu bytes of state\n", text.size(), sizeof(State));
+
+        /* later saves go to the journal, on top of the snapshot */
+        state.leds[1] = 1;
+        store.touch(Leds, 1, 1);
+        assert(store.save() && store.sequence() == 2);
+
+        std::memset(&loaded, 0, sizeof(loaded));
+        store_type reloaded(storage);
+        attach(reloaded, loaded);
+        assert(reloaded.load() && loaded == state);
+
+        /* leds written as blocks, before they had a text form, are still read */
+        {
+            const std::string leds = text.substr(text.find("[leds]\n"), text.find("[patterns]") - text.find("[leds]\n"));
+            std::string blocks = "[leds]\n";
+            char line[SNAPSHOT_LINE_MAX_SIZE];
+            for (uint8_t b=0; b * BLOCK_SIZE < sizeof(state.leds); ++b)
+                {
+                    const size_t size = std::min<size_t>(BLOCK_SIZE, sizeof(state.leds) - b * BLOCK_SIZE);
+                    blocks.append(line, format_block(line, b, state.leds + b * BLOCK_SIZE, size));
+                }
+            std::string old = text.substr(0, text.find("\nchecksum = ") + 1);
+            old.replace(old.find(leds), leds.size(), blocks);
+            config_cache::fnv1a hash;
+            hash.feed(old.data(), old.size());
+            snprintf(line, sizeof(line), "checksum = %08lx\n", static_cast<unsigned long>(hash.value));
+            old += line;
+            storage.truncate(file::Snapshot, 0);
+            storage.append(file::Snapshot, old.data(), old.size());
+            std::memset(&loaded, 0, sizeof(loaded));
+            store_type previous(storage);
+            attach(previous, loaded);
+            assert(previous.load() && loaded == state);
+        }
+
+        /* a corrupted snapshot is reported */
+        text[text.find("a5")] = 'b';
+        storage.truncate(file::Snapshot, 0);
+        storage.append(file::Snapshot, text.data(), text.size());
+        std::memset(&loaded, 0, sizeof(loaded));
+        store_type corrupted(storage);
+        attach(corrupted, loaded);
+        assert(static_cast<error::errcode>(corrupted.load()) == error::errcode::INVALID_ARGUMENT);
+        assert(loaded.patterns[7][63] == 0 && loaded.leds[1] == 1);
+    }
+
+    std::cout << "Testing crash consistency" << std::endl;
+    {
+        constexpr size_t SAVES = 60;
+        storage.erase();
+        storage.budget = -1;
+        storage.spent = 0;
+        const Scenario complete = run(storage, SAVES, 0xc0ffee);
+        const unsigned long total = storage.spent;
+
+        /* power losses at random points, about 2000 of them */
+        std::mt19937 rand(0xdead);
+        std::uniform_int_distribution<unsigned long> gap(1, total / 1000);
+        unsigned long crashes = 0, rolled_back = 0, committed = 0;
+        for (unsigned long budget=0; budget<total; budget += gap(rand))
+            {
+                storage.erase();
+                storage.budget = budget;
+                storage.crashed = false;
+                const Scenario s = run(storage, SAVES, 0xc0ffee);
+                assert(storage.crashed && s.interrupted > 0);
+
+                /* power back */
+                storage.budget = -1;
+                storage.crashed = false;
+                static State loaded;
+                std::memset(&loaded, 0, sizeof(loaded));
+                store_type store(storage);
+                attach(store, loaded);
+                assert(store.load());
+
+                const State& before = s.committed[s.interrupted - 1];
+                const State& after = s.committed[s.interrupted];
+                assert(after == complete.committed[s.interrupted]);
+                if (loaded == before)
+                    { rolled_back += 1; }
+                else
+                    {
+                        assert(loaded == after);
+                        committed += 1;
+                    }
+                crashes += 1;
+
+                /* the store keeps working after recovery */
+                loaded.leds[5] ^= 0x01;
+                store.touch(Leds, 5, 1);
+                assert(store.save());
+                static State again;
+                std::memset(&again, 0, sizeof(again));
+                store_type next(storage);
+                attach(next, again);
+                assert(next.load() && again == loaded);
+            }
+        printf("\t%lu power losses over %lu written bytes: %lu saves rolled back, %lu kept\n",
+            crashes, total, rolled_back, committed);
+        assert(rolled_back > 0 && committed > 0);
+    }
+
+    std::cout << "\nWrites per save: journal against rewriting the whole state" << std::endl;
+    {
+        storage.erase();
+        storage.budget = -1;
+        std::mt19937 rand(7);
+        static State state;
+        std::memset(&state, 0, sizeof(state));
+        TestSettings::CompactionThreshold = 8192;
+        store_type store(storage);
+        attach(store, state);
+        store.load();
+        assert(store.compact());
+        const unsigned long snapshot = storage.size(file::Snapshot);
+
+        constexpr int SAVES = 2000;
+        const unsigned long before = store.counters().bytes_written;
+        double save_us = 0, worst_us = 0;
+        for (int i=0; i<SAVES; ++i)
+            {
+                edit(state, store, rand);
+                auto begin = std::chrono::steady_clock::now();
+                assert(store.save());
+                const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+                save_us += us;
+                worst_us = std::max(worst_us, us);
+            }
+        const store_counters& c = store.counters();
+        const double per_save = static_cast<double>(c.bytes_written - before) / SAVES;
+
+        printf("\t%d saves, %lu blocks, %lu compactions\n", SAVES, c.blocks, c.compactions - 1);
+        printf("\t%24s | %12s %12s\n", "", "bytes/save", "time/save");
+        printf("\t%24s | %12lu %12s\n", "whole state rewrite", snapshot, "");
+        printf("\t%24s | %12.1f %10.1fus (worst %.0fus, host files)\n", "journal and compactions", per_save, save_us / SAVES, worst_us);
+        assert(per_save < snapshot / 4.0);
+
+        static State loaded;
+        std::memset(&loaded, 0, sizeof(loaded));
+        store_type reloaded(storage);
+        attach(reloaded, loaded);
+        assert(reloaded.load() && loaded == state);
+    }
+
+    storage.erase();
+    rmdir(directory);
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,243 @@
+
+#include "hw/analog_driver/analog_driver.h"
+
+#include "../sim/clock.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <cassert>
+
+using namespace hw;
+using namespace hw::analog_driver;
+
+/**
+ * ADC stand-in: conversions take @c conversion_ns,
+ *  samples encode their channel and the sweep they belong to
+ */
+struct Adc
+{
+    sim::Clock::time_point conversion_ns = 2000;
+    uint8_t address = 0;
+    sim::Clock::time_point started = 0;
+    bool converting = false;
+    unsigned long conversions = 0;
+
+    /** 5 bits of channel, 5 bits of sweep index: a whole 10 bits sample */
+    static uint16_t encode(uint8_t channel, unsigned long sweep)
+        { return (channel << 5) | (sweep & 0x1F); }
+
+    static uint8_t channel_of(uint16_t sample)      { return sample >> 5; }
+    static uint8_t sweep_of(uint16_t sample)        { return sample & 0x1F; }
+
+    /** Optional signal overriding the encoded samples, as a function of channel and time */
+    uint16_t (*signal)(uint8_t channel, sim::Clock::time_point t) = nullptr;
+};
+static Adc adc;
+
+struct SimContext
+{
+    static void select_address(uint8_t address)     { adc.address = address; }
+    static void start_conversions()
+        {
+            adc.started = sim::Clock::now();
+            adc.converting = true;
+        }
+    static bool read_conversions(uint16_t values[MUX_COUNT])
+        {
+            if (!adc.converting || sim::Clock::now() < adc.started + adc.conversion_ns)
+                { return false; }
+            adc.converting = false;
+            for (uint8_t mux=0; mux<MUX_COUNT; ++mux)
+                {
+                    const uint8_t channel = mux * MUX_CHANNELS_COUNT + adc.address;
+                    values[mux] = adc.signal
+                        ? adc.signal(channel, adc.started)
+                        : Adc::encode(channel, adc.conversions / MUX_CHANNELS_COUNT);
+                }
+            adc.conversions += 1;
+            return true;
+        }
+    static unsigned long micros()       { return sim::Clock::micros(); }
+};
+
+using driver_type = AnalogDriver<SimContext>;
+
+/**
+ * Timer interrupt: fires every tick period and preempts the main loop
+ */
+struct Timer
+{
+    driver_type* driver = nullptr;
+    double period_ns = 0;
+    double next_ns = 0;
+    unsigned long ticks = 0;
+
+    /** Advances virtual time by @c ns, firing due ticks on the way */
+    void advance(sim::Clock::time_point ns)
+        {
+            const sim::Clock::time_point end = sim::Clock::now() + ns;
+            while (next_ns <= end)
+                {
+                    if (next_ns > sim::Clock::now())
+                        { sim::Clock::advance(static_cast<sim::Clock::time_point>(next_ns) - sim::Clock::now()); }
+                    driver->on_tick();
+                    ticks += 1;
+                    next_ns += period_ns;
+                }
+            sim::Clock::advance(end - sim::Clock::now());
+        }
+};
+static Timer timer;
+
+struct Report
+{
+    float sweep_rate = 0;
+    unsigned long consumed = 0;
+    unsigned long dropped = 0;
+    unsigned long overruns = 0;
+    unsigned long torn = 0;         ///< blocks mixing samples of several sweeps
+    unsigned long corrupted = 0;    ///< blocks modified while held by the main loop
+};
+
+/**
+ * Runs the engine against a main loop busy for @c loop_ns per iteration,
+ *  consuming a sweep costs @c process_ns, during which ticks keep firing
+ */
+static Report run(unsigned long sweep_rate, sim::Clock::time_point loop_ns, sim::Clock::time_point process_ns,
+    sim::Clock::time_point duration_ns)
+{
+    DriverDefaultSettings::SweepRate = sweep_rate;
+    sim::Clock::reset();
+    adc = Adc{};
+
+    driver_type driver;
+    driver.setup();
+    timer = Timer{&driver, driver.tick_period() * 1000.0, driver.tick_period() * 1000.0, 0};
+
+    Report report;
+    while (sim::Clock::now() < duration_ns)
+        {
+            driver.consume([&](const sample_block& block) {
+                    sample_block copy;
+                    std::memcpy(&copy, &block, sizeof(block));
+                    timer.advance(process_ns);
+
+                    report.consumed += 1;
+                    if (std::memcmp(&copy, &block, sizeof(block)) != 0)
+                        { report.corrupted += 1; }
+                    for (uint8_t c=0; c<CHANNELS_COUNT; ++c)
+                        {
+                            if (Adc::channel_of(block.samples[c]) != c
+                                || Adc::sweep_of(block.samples[c]) != Adc::sweep_of(block.samples[0]))
+                                { report.torn += 1; break; }
+                        }
+                });
+            driver.update();
+            timer.advance(loop_ns);
+        }
+
+    report.sweep_rate = driver.sweep_rate();
+    report.dropped = driver.dropped_count();
+    report.overruns = driver.overruns_count();
+    return report;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing sweeps hand-off" << std::endl;
+    {
+        DriverDefaultSettings::SweepRate = 4000;
+        sim::Clock::reset();
+        adc = Adc{};
+        driver_type driver;
+        driver.setup();
+        timer = Timer{&driver, driver.tick_period() * 1000.0, driver.tick_period() * 1000.0, 0};
+
+        assert(!driver.consume([](const sample_block&) {}));
+        timer.advance(250000);      /* a single sweep */
+        assert(driver.sweeps_count() == 1);
+
+        bool called = false;
+        assert(driver.consume([&](const sample_block& block) {
+                called = true;
+                for (uint8_t c=0; c<CHANNELS_COUNT; ++c)
+                    { assert(block.samples[c] == Adc::encode(c, 0)); }
+            }));
+        assert(called);
+        assert(!driver.consume([](const sample_block&) {}));
+
+        /* sweeps completed while the first one is held are dropped */
+        timer.advance(3 * 250000);
+        assert(driver.sweeps_count() == 4 && driver.dropped_count() == 2);
+        assert(driver.consume([&](const sample_block& block) {
+                assert(Adc::sweep_of(block.samples[0]) == 1);
+            }));
+    }
+
+    std::cout << "Testing filters feeding" << std::endl;
+    {
+        DriverDefaultSettings::SweepRate = 4000;
+        sim::Clock::reset();
+        adc = Adc{};
+        adc.signal = [](uint8_t channel, sim::Clock::time_point) -> uint16_t { return channel * 32 + 4; };
+
+        driver_type driver;
+        driver.setup();
+        timer = Timer{&driver, driver.tick_period() * 1000.0, driver.tick_period() * 1000.0, 0};
+
+        FadersFilters<> faders;
+        for (int i=0; i<100; ++i)
+            {
+                timer.advance(250000);
+                assert(driver.consume(faders));
+            }
+        for (uint8_t c=0; c<FadersFilters<>::Size; ++c)
+            { assert(faders[c].value() == (c * 32) >> 3); }
+    }
+
+    std::cout << "\nMain loop load against the acquisition, 2s per configuration" << std::endl;
+    printf("%8s %8s %8s | %10s %9s %9s %9s | %5s %9s\n",
+        "target", "loop", "process", "sweeps", "consumed", "dropped", "overruns", "torn", "corrupted");
+
+    struct config { unsigned long rate; sim::Clock::time_point loop_ns; sim::Clock::time_point process_ns; };
+    const config configs[] = {
+        {  4000,      5000,   20000 },
+        {  4000,    100000,   20000 },
+        {  4000,    300000,   20000 },
+        {  4000,   1000000,   50000 },
+        {  4000,   5000000,   50000 },
+        { 10000,      5000,   20000 },
+        { 40000,      5000,    5000 },  /* ticks faster than conversions */
+    };
+
+    for (const auto& c: configs)
+        {
+            const Report r = run(c.rate, c.loop_ns, c.process_ns, 2000000000);
+            printf("%6luHz %6.0fus %6.0fus | %8.1fHz %9lu %9lu %9lu | %5lu %9lu\n",
+                c.rate, c.loop_ns / 1e3, c.process_ns / 1e3,
+                r.sweep_rate, r.consumed, r.dropped, r.overruns, r.torn, r.corrupted);
+
+            assert(r.torn == 0 && r.corrupted == 0);
+            const double sweep_ns = 1e9 / c.rate;
+            const double tick_ns = sweep_ns / MUX_CHANNELS_COUNT;
+            if (tick_ns > adc.conversion_ns)
+                {
+                    assert(r.overruns == 0);
+                    assert(r.sweep_rate > c.rate * 0.99 && r.sweep_rate < c.rate * 1.01);
+                }
+            else
+                { assert(r.overruns > 0 && r.sweep_rate < c.rate); }
+            if (c.loop_ns + c.process_ns < sweep_ns && tick_ns > adc.conversion_ns)
+                { assert(r.dropped == 0); }
+            if (c.loop_ns > 2 * sweep_ns)
+                { assert(r.dropped > 0); }
+        }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
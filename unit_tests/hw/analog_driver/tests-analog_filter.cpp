@@ -0,0 +1,271 @@
+
+#include "hw/analog_driver/analog_driver.h"
+
+#include <array>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <algorithm>
+
+using namespace hw;
+using namespace hw::analog_driver;
+
+using filter_type = AnalogFilter<>;
+
+/** Raw samples per second of a single channel */
+static constexpr double SAMPLE_RATE = 4000;
+
+/** Fader position against time, as a fraction of the full scale */
+struct segment
+{
+    double end_s;
+    double to;
+};
+
+static const std::vector<segment> SCENARIO = {
+    {  1.0, 0.30 },     /* rest */
+    {  1.5, 0.90 },     /* fast move up */
+    {  3.0, 0.90 },
+    {  8.0, 0.10 },     /* slow move down */
+    { 10.0, 0.10 },
+    { 10.2, 1.00 },     /* slammed to the top */
+    { 11.0, 1.00 },
+    { 11.2, 0.00 },     /* slammed to the bottom */
+    { 12.0, 0.00 },
+};
+
+static double position(double t)
+{
+    double begin = 0, from = SCENARIO.front().to;
+    for (const auto& s: SCENARIO)
+        {
+            if (t < s.end_s)
+                { return from + (s.to - from) * (t - begin) / (s.end_s - begin); }
+            begin = s.end_s;
+            from = s.to;
+        }
+    return SCENARIO.back().to;
+}
+
+static bool is_resting(double t, double settle_s)
+{
+    double begin = 0, from = SCENARIO.front().to;
+    for (const auto& s: SCENARIO)
+        {
+            if (t < s.end_s)
+                { return s.to == from && t - begin > settle_s; }
+            begin = s.end_s;
+            from = s.to;
+        }
+    return true;
+}
+
+struct Report
+{
+    size_t rest_events = 0;
+    size_t move_events = 0;
+    size_t reversals = 0;
+    size_t naive_rest_events = 0;
+    double rest_s = 0;
+    std::vector<double> lag_ms;
+    double max_overshoot = 0;   ///< distance past the step boundary on emission, in steps
+    uint16_t final_top = 0;
+    uint16_t final_bottom = 0;
+};
+
+/**
+ * Feeds the scenario as noisy 10 bits samples,
+ *  noise is gaussian with occasional spikes
+ */
+static Report run(double noise_lsb, double spikes_rate, uint32_t seed)
+{
+    std::mt19937 rand(seed);
+    std::normal_distribution<double> noise(0, noise_lsb);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    const double full_scale = (1 << FilterDefaultSettings::AdcBits) -1;
+    const uint16_t levels = 1 << FilterDefaultSettings::OutputBits;
+    auto sample_at = [&](double t) -> uint16_t {
+            double v = position(t) * full_scale + noise(rand);
+            if (uniform(rand) < spikes_rate)
+                { v += (uniform(rand) < 0.5 ? -8 : 8); }
+            return static_cast<uint16_t>(std::min(full_scale, std::max(0.0, std::round(v))));
+        };
+
+    Report report;
+    filter_type filter;
+    filter.reset(sample_at(0));
+
+    uint16_t naive = filter.value();
+    int direction = 0;
+    double previous_p = position(0);
+    const double duration = SCENARIO.back().end_s;
+    const double dt = 1.0 / SAMPLE_RATE;
+
+    for (double t=0; t<duration; t+=dt)
+        {
+            const double p = position(t);
+            const bool resting = is_resting(t, 0.05);
+            const uint16_t sample = sample_at(t);
+            if (resting)
+                { report.rest_s += dt; }
+
+            /* naive change-only emission of the truncated raw sample */
+            const uint16_t truncated = sample >> (FilterDefaultSettings::AdcBits - FilterDefaultSettings::OutputBits);
+            if (truncated != naive)
+                {
+                    naive = truncated;
+                    report.naive_rest_events += resting;
+                }
+
+            const uint16_t before = filter.value();
+            const int moving = (p > previous_p) - (p < previous_p);
+            if (moving != 0)
+                { direction = moving; }
+            previous_p = p;
+
+            if (t > 10.9 && t < 11.0)
+                { report.final_top = filter.value(); }
+
+            if (!filter.feed(sample))
+                { continue; }
+
+            const uint16_t value = filter.value();
+            (resting ? report.rest_events : report.move_events) += 1;
+            if ((value > before ? 1 : -1) != direction)
+                { report.reversals += 1; }
+
+            /* lag: time since the fader entered the emitted step */
+            const double boundary = (direction > 0 ? value : value + 1) / static_cast<double>(levels);
+            double crossed = t;
+            while (crossed > 0 && (direction > 0 ? position(crossed) >= boundary : position(crossed) < boundary))
+                { crossed -= 0.0001; }
+            if (value != 0 && value != levels -1)
+                {
+                    report.lag_ms.push_back((t - crossed) * 1000);
+                    report.max_overshoot = std::max(report.max_overshoot, std::fabs(p - boundary) * levels);
+                }
+        }
+    report.final_bottom = filter.value();
+    return report;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing steady inputs" << std::endl;
+    {
+        filter_type filter;
+        filter.reset(512);
+        assert(filter.value() == 64);
+        for (int i=0; i<1000; ++i)
+            { assert(!filter.feed(512)); }
+        assert(filter.filtered() == 512 << 6);
+
+        /* jitter around a step boundary is swallowed at rest */
+        filter.reset(504);
+        assert(filter.value() == 63);
+        for (int i=0; i<1000; ++i)
+            { assert(!filter.feed(i & 1 ? 504 : 503)); }
+
+        filter.reset(0);
+        for (int i=0; i<1000; ++i)
+            { filter.feed(1023); }
+        assert(filter.value() == 127);
+        for (int i=0; i<1000; ++i)
+            { filter.feed(0); }
+        assert(filter.value() == 0);
+    }
+
+    std::cout << "Testing hysteresis adapts to activity" << std::endl;
+    {
+        filter_type filter;
+        filter.reset(100);
+        const uint16_t rest = filter.hysteresis();
+        for (int i=0; i<400; ++i)
+            { filter.feed(100 + i); }
+        const uint16_t moving = filter.hysteresis();
+        assert(moving < rest);
+        for (int i=0; i<400; ++i)
+            { filter.feed(500); }
+        assert(filter.hysteresis() == rest);
+    }
+
+    std::cout << "Testing faders filters events" << std::endl;
+    {
+        FadersFilters<> faders;
+        for (uint8_t c=0; c<FadersFilters<>::Size; ++c)
+            { faders.reset(c, 0); }
+        analog_event event;
+        assert(!faders.poll(event));
+
+        const uint8_t master = static_cast<uint8_t>(analog::Fader::MASTER_LEVEL);
+        const uint8_t track = static_cast<uint8_t>(analog::Fader::TRACK_LEVEL_2);
+        for (int i=0; i<200; ++i)
+            {
+                faders.feed(master, 1023);
+                faders.feed(track, 256);
+            }
+        assert(faders.poll(event) && event.channel == track && event.value == faders[track].value());
+        assert(faders.poll(event) && event.channel == master && event.value == 127);
+        assert(!faders.poll(event));
+    }
+
+    std::cout << "\nNoisy fader scenario, 12s at " << SAMPLE_RATE << " samples/s" << std::endl;
+    printf("%8s %8s | %10s %10s | %8s %9s | %10s %10s %10s\n",
+        "noise", "spikes", "rest ev/s", "naive ev/s", "moves", "reversals", "lag.avg", "lag.max", "overshoot");
+    double steps_crossed = 0;
+    for (size_t i=1; i<SCENARIO.size(); ++i)
+        { steps_crossed += std::fabs(SCENARIO[i].to - SCENARIO[i-1].to) * (1 << FilterDefaultSettings::OutputBits); }
+    for (double noise: {0.5, 1.5, 3.0})
+        for (double spikes: {0.0, 0.01})
+            {
+                const Report r = run(noise, spikes, 7);
+                double sum = 0;
+                for (auto l: r.lag_ms) { sum += l; }
+                const double avg = r.lag_ms.empty() ? 0 : sum / r.lag_ms.size();
+                const double max = r.lag_ms.empty() ? 0 : *std::max_element(r.lag_ms.begin(), r.lag_ms.end());
+
+                printf("%6.1fLSB %7.0f%% | %10.2f %10.2f | %8lu %9lu | %8.2fms %8.2fms %6.2fstep\n",
+                    noise, spikes * 100, r.rest_events / r.rest_s, r.naive_rest_events / r.rest_s,
+                    r.move_events, r.reversals, avg, max, r.max_overshoot);
+
+                assert(r.final_top == 127 && r.final_bottom == 0);
+                assert(r.naive_rest_events > r.rest_events);
+                /* at most one event per step crossed while moving */
+                assert(r.move_events <= steps_crossed + r.reversals);
+                if (noise <= 1.5)
+                    {
+                        assert(r.rest_events == 0 && r.reversals == 0);
+                        /* filter delay is about 4ms: a few steps while slammed, less than one on slow moves */
+                        assert(r.max_overshoot < 4.0 && max < 50);
+                    }
+            }
+
+    std::cout << "\nBenchmark: AnalogFilter::feed" << std::endl;
+    {
+        constexpr size_t ITERATIONS = 8000000;
+        std::mt19937 rand(3);
+        std::vector<uint16_t> samples(4096);
+        for (size_t i=0; i<samples.size(); ++i)
+            { samples[i] = (i / 4) + (rand() & 0x03); }
+
+        FadersFilters<> faders;
+        volatile uint32_t sink = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t i=0; i<ITERATIONS; ++i)
+            { sink = sink + faders.feed(i % FadersFilters<>::Size, samples[i & 4095]); }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / ITERATIONS;
+        printf("\t%.2f ns/sample\n", ns);
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+
+#include "hw/encoders_driver/encoders_driver.h"
+
+#include "../sim/clock.hpp"
+
+#include <array>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <cassert>
+#include <random>
+
+using namespace hw;
+using namespace hw::encoders_driver;
+
+static std::array<phases, ENCODERS_COUNT> levels;
+
+struct SimContext
+{
+    static phases read_phases(analog::Encoder e)    { return levels[static_cast<uint8_t>(e)]; }
+    static unsigned long micros()                   { return sim::Clock::micros(); }
+};
+
+using driver_type = EncodersDriver<SimContext>;
+
+/** Gray sequence turning clockwise, A leading B */
+static constexpr const phases CW_SEQUENCE[4] = {0b00, 0b01, 0b11, 0b10};
+
+struct edge
+{
+    sim::Clock::time_point time;
+    phases state;
+};
+
+/**
+ * Timeline of an encoder turned by @c detents at a constant speed,
+ *  each quarter step chatters on the switching channel during @c bounce_ns
+ */
+template <typename Rand>
+static std::vector<edge> spin(sim::Clock::time_point begin, int detents, double detents_per_s,
+    sim::Clock::time_point bounce_ns, Rand& rand)
+{
+    std::vector<edge> edges;
+    const double quarter_ns = 1e9 / (4 * detents_per_s);
+    std::uniform_int_distribution<sim::Clock::time_point> chatter(0, bounce_ns);
+
+    int position = 0;
+    phases state = CW_SEQUENCE[0];
+    for (int i=0; i<4 * std::abs(detents); ++i)
+        {
+            position = (position + (detents > 0 ? 1 : 3)) & 0b11;
+            const phases next = CW_SEQUENCE[position];
+            const sim::Clock::time_point t = begin + static_cast<sim::Clock::time_point>((i + 1) * quarter_ns);
+
+            /* contact bounce: the switching channel toggles back and forth before settling */
+            sim::Clock::time_point b = t;
+            for (int k=0; bounce_ns && k<4; ++k)
+                {
+                    edges.push_back({b, next});
+                    b += chatter(rand) / 4 + 1;
+                    edges.push_back({b, state});
+                    b += chatter(rand) / 4 + 1;
+                }
+            edges.push_back({b, next});
+            state = next;
+        }
+    return edges;
+}
+
+/**
+ * Pin change interrupt model: the handler reads the pins @c latency_ns after the first pending edge,
+ *  edges happening before the read are merged into a single interrupt
+ */
+static int run_interrupts(QuadratureDecoder& decoder, const std::vector<edge>& edges,
+    sim::Clock::time_point latency_ns, sim::Clock::time_point service_ns, size_t* interrupts=nullptr)
+{
+    decoder.reset(CW_SEQUENCE[0]);
+    sim::Clock::time_point busy_until = 0;
+    size_t count = 0;
+    size_t i = 0;
+    while (i < edges.size())
+        {
+            const sim::Clock::time_point read = std::max(edges[i].time, busy_until) + latency_ns;
+            while (i + 1 < edges.size() && edges[i + 1].time <= read)
+                { ++i; }
+            decoder.update(edges[i].state);
+            busy_until = read + service_ns;
+            count += 1;
+            ++i;
+        }
+    if (interrupts)
+        { *interrupts = count; }
+    return decoder.take_detents(4) + decoder.pending_steps() / 4;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing transitions table" << std::endl;
+    for (phases from=0; from<4; ++from)
+        for (phases to=0; to<4; ++to)
+            {
+                const int8_t step = QUADRATURE_TRANSITIONS[(from << 2) | to];
+                const int8_t back = QUADRATURE_TRANSITIONS[(to << 2) | from];
+                if (from == to)
+                    { assert(step == 0); }
+                else if ((from ^ to) == 0b11)
+                    { assert(step == SKIPPED && back == SKIPPED); }
+                else
+                    { assert((step == 1 || step == -1) && back == -step); }
+            }
+    for (int i=0; i<4; ++i)
+        {
+            const phases from = CW_SEQUENCE[i];
+            const phases to = CW_SEQUENCE[(i + 1) & 0b11];
+            assert(QUADRATURE_TRANSITIONS[(from << 2) | to] == 1);
+        }
+
+    std::cout << "Testing skipped states follow last direction" << std::endl;
+    {
+        QuadratureDecoder decoder;
+        decoder.reset(0b00);
+        decoder.update(0b01);       /* +1 */
+        decoder.update(0b10);       /* skipped 11, +2 */
+        decoder.update(0b00);       /* +1 */
+        assert(decoder.pending_steps() == 4 && decoder.skipped_count() == 1);
+        assert(decoder.take_detents(4) == 1 && decoder.pending_steps() == 0);
+
+        decoder.update(0b10);       /* -1 */
+        decoder.update(0b01);       /* skipped 11, -2 */
+        assert(decoder.pending_steps() == -3);
+        assert(decoder.take_detents(4) == 0 && decoder.pending_steps() == -3);
+        decoder.update(0b00);
+        assert(decoder.take_detents(4) == -1);
+    }
+
+    std::mt19937 rand(0x5eed);
+
+    std::cout << "Testing bouncing slow spins" << std::endl;
+    for (double speed: {1.0, 5.0, 20.0, 60.0})
+        for (int detents: {1, -1, 24, -24, 97})
+            {
+                QuadratureDecoder decoder;
+                const auto edges = spin(0, detents, speed, 100000, rand);
+                assert(run_interrupts(decoder, edges, 2000, 1000) == detents);
+            }
+
+    std::cout << "\nSimulated fast spins, 240 detents, 2us interrupt latency, 1us service" << std::endl;
+    printf("%12s %10s | %10s %10s %10s | %8s\n", "detents/s", "quarter", "edges", "interrupts", "skipped", "decoded");
+    for (double speed: {100.0, 1000.0, 10000.0, 50000.0, 100000.0, 150000.0})
+        {
+            QuadratureDecoder decoder;
+            size_t interrupts = 0;
+            const auto edges = spin(0, 240, speed, 0, rand);
+            const int decoded = run_interrupts(decoder, edges, 2000, 1000, &interrupts);
+            const double quarter_us = 1e6 / (4 * speed);
+
+            printf("%12.0f %8.2fus | %10lu %10lu %10u | %8d\n",
+                speed, quarter_us, edges.size(), interrupts, decoder.skipped_count(), decoded);
+
+            /* a state is missed only when the encoder moves faster than the handler,
+             *  which is resolved as long as less than two quarter steps are missed */
+            if (quarter_us > 3.0)
+                { assert(decoded == 240 && decoder.skipped_count() == 0); }
+            else if (2 * quarter_us > 3.0)
+                { assert(decoded == 240 && decoder.skipped_count() > 0); }
+        }
+
+    std::cout << "\nTesting acceleration curve" << std::endl;
+    {
+        const acceleration_point* curve = DriverDefaultSettings::AccelerationCurve;
+        assert(driver_type::gain_of(0) == curve[0].gain);
+        assert(driver_type::gain_of(curve[1].velocity) == curve[1].gain);
+        assert(driver_type::gain_of(60000) == curve[ACCELERATION_POINTS_COUNT -1].gain);
+        uint16_t previous = 0;
+        for (uint32_t v=0; v<1000; ++v)
+            {
+                const uint16_t gain = driver_type::gain_of(v);
+                assert(gain >= previous);
+                previous = gain;
+            }
+
+        /* main loop reading every millisecond while spinning */
+        auto turn = [&](double speed, int detents) -> int {
+                sim::Clock::reset();
+                levels.fill(CW_SEQUENCE[0]);
+                driver_type driver;
+                driver.setup();
+                sim::Clock::advance(500000000);
+
+                const auto edges = spin(sim::Clock::now(), detents, speed, 0, rand);
+                int total = 0;
+                size_t i = 0;
+                const sim::Clock::time_point end = edges.back().time + 1000000;
+                while (sim::Clock::now() < end)
+                    {
+                        for (; i < edges.size() && edges[i].time <= sim::Clock::now(); ++i)
+                            { driver.on_pin_change(analog::Encoder::CTRL_3, edges[i].state); }
+                        total += driver.read(analog::Encoder::CTRL_3);
+                        sim::Clock::advance(1000000);
+                    }
+                return total;
+            };
+
+        printf("\t%10s %8s %10s\n", "detents/s", "turned", "read");
+        for (double speed: {2.0, 8.0, 25.0, 70.0, 150.0, 400.0})
+            {
+                const int slow = turn(speed, 48);
+                const int back = turn(speed, -48);
+                printf("\t%10.0f %8d %10d\n", speed, 48, slow);
+                assert(back == -slow);
+                if (speed < curve[0].velocity)
+                    { assert(slow == 48); }
+                if (speed > curve[ACCELERATION_POINTS_COUNT -1].velocity * 1.5)
+                    { assert(slow >= 48 * 6); }
+            }
+    }
+
+    std::cout << "\nTesting interrupt and main loop concurrency" << std::endl;
+    {
+        QuadratureDecoder decoder;
+        decoder.reset(CW_SEQUENCE[0]);
+        constexpr int QUARTERS = 4 * 500000;
+        std::atomic<bool> done{false};
+
+        std::thread isr([&]() {
+                for (int i=1; i<=QUARTERS; ++i)
+                    { decoder.update(CW_SEQUENCE[i & 0b11]); }
+                done = true;
+            });
+
+        long total = 0;
+        while (!done)
+            { total += decoder.take_detents(4); }
+        isr.join();
+        total += decoder.take_detents(4);
+
+        assert(total == QUARTERS / 4);
+        assert(decoder.pending_steps() == 0);
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,362 @@
+/**
+ * Host side timing simulator for the leds driver:
+ *  runs the real LedsDriver cycle against simulated i2c buses and MCPs,
+ *  then reports refresh rate, column on-time, bus load and frame latency.
+ *
+ * usage: sim-leds_timing [--rates 50,100] [--clocks 100000,400000] [--duration ms] [--loop-ns ns]
+ */
+
+#include "hw/leds_driver/leds_driver.h"
+
+#include "../sim/clock.hpp"
+#include "../sim/i2c.hpp"
+#include "../sim/mcp23017.hpp"
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <algorithm>
+
+using namespace hw;
+using namespace hw::leds_driver;
+
+/**
+ * Observes cathodes pins and MCPs outputs as the leds would
+ */
+struct Panel
+{
+    std::array<sim::I2CMaster, ANNODE_DRIVER_COUNT> masters;
+    std::array<sim::MCP23017, ANNODE_DRIVER_COUNT> mcps;
+    std::array<bool, 16> pins{};
+
+    bool lit = false;
+    uint8_t lit_column = 0;
+    sim::Clock::time_point lit_since = 0;
+    sim::Clock::time_point blank_since = 0;
+
+    uint64_t lit_ns = 0;
+    size_t lit_count = 0;
+    uint64_t blank_ns = 0;
+    uint64_t max_blank_ns = 0;
+    size_t blank_count = 0;
+
+    /** Pending led change waiting to be seen on the panel */
+    struct Probe
+    {
+        bool active = false;
+        pads::Pad pad;
+        pad_color color;
+        sim::Clock::time_point since;
+    } probe;
+
+    std::vector<uint64_t> latencies;
+
+    void reset()
+        {
+            for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+                {
+                    masters[i] = sim::I2CMaster{};
+                    mcps[i].reset();
+                    masters[i].attach(mcps[i]);
+                }
+            pins.fill(false);
+            lit = false;
+            lit_since = blank_since = sim::Clock::now();
+            lit_ns = blank_ns = max_blank_ns = 0;
+            lit_count = blank_count = 0;
+            probe.active = false;
+            latencies.clear();
+        }
+
+    uint8_t address() const
+        {
+            return (pins[CATHODE_ADDR_PINA0] ? 0b001 : 0)
+                | (pins[CATHODE_ADDR_PINA1] ? 0b010 : 0)
+                | (pins[CATHODE_ADDR_PINA2] ? 0b100 : 0);
+        }
+
+    bool led(annode_pin pin) const
+        { return (mcps[static_cast<uint8_t>(pin.driver)].outputs() >> pin.bit) & 0x01; }
+
+    pad_color displayed(pads::Pad pad) const
+        {
+            uint8_t color = led(annode_of(pad, false)) ? 0x01 : 0x00;
+            if (pads::is_bichrome(pad) && led(annode_of(pad, true)))
+                { color |= 0x02; }
+            return static_cast<pad_color>(color);
+        }
+
+    void on_pin(uint8_t pin, bool level)
+        {
+            pins[pin] = level;
+            if (pin != CATHODE_ENABLE_PIN)
+                { return; }
+
+            const sim::Clock::time_point now = sim::Clock::now();
+            if (level == CATHODE_ENABLE_LEVEL && !lit)
+                {
+                    lit = true;
+                    lit_column = address();
+                    lit_since = now;
+                    if (blank_count || lit_count)
+                        {
+                            blank_ns += now - blank_since;
+                            max_blank_ns = std::max<uint64_t>(max_blank_ns, now - blank_since);
+                            blank_count += 1;
+                        }
+                    check_probe(now);
+                }
+            else if (level != CATHODE_ENABLE_LEVEL && lit)
+                {
+                    lit = false;
+                    lit_ns += now - lit_since;
+                    lit_count += 1;
+                    blank_since = now;
+                }
+        }
+
+    void check_probe(sim::Clock::time_point now)
+        {
+            if (!probe.active || get_column(probe.pad) != lit_column)
+                { return; }
+            if (displayed(probe.pad) != probe.color)
+                { return; }
+            latencies.push_back(now - probe.since);
+            probe.active = false;
+        }
+};
+
+static Panel panel;
+
+struct SimContext
+{
+    using master_type = sim::I2CMaster;
+
+    static master_type& i2c_master(annode_driver d)
+        { return panel.masters[static_cast<uint8_t>(d)]; }
+
+    static void pin_mode_output(uint8_t pin)        {}
+    static void digital_write(uint8_t pin, bool level)
+        { panel.on_pin(pin, level); }
+
+    static unsigned long micros()
+        { return sim::Clock::micros(); }
+};
+
+using driver_type = LedsDriver<SimContext>;
+
+struct Result
+{
+    unsigned long rate;
+    unsigned long clock;
+    double achieved_hz;
+    double max_hz;
+    double on_us;
+    double lit_ratio;
+    double bus_duty;
+    double latency_mean_us;
+    double latency_max_us;
+    size_t probes_lost;
+    size_t errors;
+};
+
+static Result simulate(unsigned long rate, unsigned long clock, unsigned long duration_ms, uint64_t loop_ns)
+{
+    DriverDefaultSettings::RefreshRate = rate;
+    DriverDefaultSettings::I2CFrequency = clock;
+
+    sim::Clock::reset();
+    panel.reset();
+
+    static driver_type driver;
+    driver = driver_type{};
+    driver.setup();
+
+    std::mt19937 rand(0x5eed);
+    std::uniform_int_distribution<uint8_t> pad_dist(0, static_cast<uint8_t>(pads::Pad::__PADS_COUNT__) -1);
+    std::uniform_int_distribution<uint64_t> delay_dist(0, 2 * 1000000000ULL / rate);
+
+    const sim::Clock::time_point end = static_cast<uint64_t>(duration_ms) * 1000000ULL;
+    sim::Clock::time_point next_probe = 0;
+    size_t probes_count = 0;
+    size_t errors = 0;
+
+    while (sim::Clock::now() < end)
+        {
+            if (!driver.update())
+                { errors += 1; }
+
+            if (!panel.probe.active && next_probe <= sim::Clock::now())
+                {
+                    pads::Pad pad;
+                    do { pad = static_cast<pads::Pad>(pad_dist(rand)); } while (is_blind(pad));
+
+                    pad_color current;
+                    driver.get_state(pad, &current);
+                    const pad_color color = pads::is_bichrome(pad)
+                        ? static_cast<pad_color>((static_cast<uint8_t>(current) + 1) & 0x03)
+                        : (current == pad_color::OFF ? pad_color::ON : pad_color::OFF);
+
+                    driver.set_state(pad, color);
+                    panel.probe = Panel::Probe{true, pad, color, sim::Clock::now()};
+                    probes_count += 1;
+                    next_probe = sim::Clock::now() + delay_dist(rand);
+                }
+            else if (panel.probe.active)
+                { next_probe = sim::Clock::now() + delay_dist(rand); }
+
+            sim::Clock::advance(loop_ns);
+        }
+
+    Result r{};
+    r.rate = rate;
+    r.clock = clock;
+    r.achieved_hz = driver.steps_count() / static_cast<double>(MULTIPLEX_COLUMS_COUNT) / (duration_ms / 1000.0);
+    r.max_hz = 1e9 / (MULTIPLEX_COLUMS_COUNT * static_cast<double>(panel.max_blank_ns + loop_ns));
+    r.on_us = panel.lit_count ? panel.lit_ns / 1000.0 / panel.lit_count : 0.0;
+    r.lit_ratio = panel.lit_ns / static_cast<double>(end);
+
+    uint64_t busy = 0;
+    for (const auto& m: panel.masters)
+        { busy = std::max(busy, m.busy_ns()); }
+    r.bus_duty = busy / static_cast<double>(end);
+
+    if (!panel.latencies.empty())
+        {
+            uint64_t sum = 0;
+            for (auto l: panel.latencies) { sum += l; }
+            r.latency_mean_us = sum / 1000.0 / panel.latencies.size();
+            r.latency_max_us = *std::max_element(panel.latencies.begin(), panel.latencies.end()) / 1000.0;
+        }
+    r.probes_lost = probes_count - panel.latencies.size() - (panel.probe.active ? 1 : 0);
+    r.errors = errors;
+    return r;
+}
+
+static void print_header()
+{
+    printf("%6s %8s | %9s %9s | %8s %6s | %6s | %10s %10s | %s\n",
+        "rate", "i2c", "achieved", "max", "on(us)", "lit%", "bus%", "lat.avg", "lat.max", "status");
+}
+
+static bool print_result(const Result& r)
+{
+    const bool ok = r.achieved_hz >= 0.98 * r.rate && r.probes_lost == 0 && r.errors == 0;
+    printf("%6lu %8lu | %9.1f %9.1f | %8.1f %5.1f%% | %5.1f%% | %8.0fus %8.0fus | %s\n",
+        r.rate, r.clock, r.achieved_hz, r.max_hz, r.on_us, 100.0 * r.lit_ratio,
+        100.0 * r.bus_duty, r.latency_mean_us, r.latency_max_us, ok ? "ok" : "LATE");
+    return ok;
+}
+
+static std::vector<unsigned long> parse_list(const char* arg)
+{
+    std::vector<unsigned long> values;
+    std::string s{arg};
+    size_t pos = 0;
+    while (pos <= s.size())
+        {
+            size_t next = s.find(',', pos);
+            if (next == std::string::npos) { next = s.size(); }
+            if (next > pos) { values.push_back(std::strtoul(s.c_str() + pos, nullptr, 10)); }
+            pos = next + 1;
+        }
+    return values;
+}
+
+static void functional_tests()
+{
+    sim::Clock::reset();
+    panel.reset();
+    driver_type driver;
+    driver.setup();
+
+    for (size_t i=0; i<100; ++i)
+        { driver.update(); sim::Clock::advance(1000); }
+    for (const auto& mcp: panel.mcps)
+        {
+            assert(mcp.reg(sim::MCP23017::IODIRA) == 0x00);
+            assert(mcp.reg(sim::MCP23017::IODIRB) == 0x00);
+        }
+
+    pad_color color;
+    error::status_byte err;
+
+    err = driver.set_state(pads::Pad::CLIP_2_5, pad_color::ORANGE);
+    assert(err);
+    driver.get_state(pads::Pad::CLIP_2_5, &color);
+    assert(color == pad_color::ORANGE);
+
+    err = driver.set_state(pads::Pad::CLIP_2_5, pad_color::RED);
+    assert(err);
+    driver.get_state(pads::Pad::CLIP_2_5, &color);
+    assert(color == pad_color::RED);
+
+    err = driver.set_state(pads::Pad::DETAIL_VIEW, pad_color::ON);
+    assert(err);
+    err = driver.set_state(pads::Pad::STOP_ALL_CLIPS, pad_color::ON);
+    assert(!err);
+
+    ledring_state ring;
+    err = driver.set_state(analog::Encoder::CTRL_4, ledring_state{3, 5});
+    assert(err);
+    driver.get_state(analog::Encoder::CTRL_4, &ring);
+    assert(ring.start == 3 && ring.count == 5);
+
+    /* ring update preserves the push button led sharing it's MCP */
+    driver.get_state(pads::Pad::DETAIL_VIEW, &color);
+    assert(color == pad_color::ON);
+
+    err = driver.set_state(analog::Encoder::CUE_LEVEL, ledring_state::center());
+    assert(!err);
+}
+
+int main(int argc, char* const argv[])
+{
+    std::vector<unsigned long> rates{25, 50, 100, 200, 400};
+    std::vector<unsigned long> clocks{100000, 400000, 1000000};
+    unsigned long duration_ms = 2000;
+    uint64_t loop_ns = 2000;
+
+    for (int i=1; i+1<argc; i+=2)
+        {
+            if (0 == strcmp(argv[i], "--rates"))         { rates = parse_list(argv[i+1]); }
+            else if (0 == strcmp(argv[i], "--clocks"))   { clocks = parse_list(argv[i+1]); }
+            else if (0 == strcmp(argv[i], "--duration")) { duration_ms = std::strtoul(argv[i+1], nullptr, 10); }
+            else if (0 == strcmp(argv[i], "--loop-ns"))  { loop_ns = std::strtoull(argv[i+1], nullptr, 10); }
+            else
+                {
+                    std::cerr << "unknown option: " << argv[i] << std::endl;
+                    return EXIT_FAILURE;
+                }
+        }
+
+    const unsigned long default_rate = DriverDefaultSettings::RefreshRate;
+    const unsigned long default_clock = DriverDefaultSettings::I2CFrequency;
+
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+    functional_tests();
+
+    std::cout << "Leds refresh sweep: duration=" << duration_ms << "ms loop=" << loop_ns << "ns\n" << std::endl;
+    print_header();
+    for (auto clock: clocks)
+        for (auto rate: rates)
+            { print_result(simulate(rate, clock, duration_ms, loop_ns)); }
+
+    std::cout << "\nDefault settings" << std::endl;
+    print_header();
+    if (!print_result(simulate(default_rate, default_clock, duration_ms, loop_ns)))
+        {
+            std::cerr << "Default settings does not reach target refresh rate" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
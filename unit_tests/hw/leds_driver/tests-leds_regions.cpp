@@ -0,0 +1,237 @@
+
+#include "hw/leds_driver/leds_driver.h"
+
+#include "../sim/clock.hpp"
+#include "../sim/i2c.hpp"
+#include "../sim/mcp23017.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <cassert>
+#include <random>
+
+using namespace hw;
+using namespace hw::leds_driver;
+
+static std::array<sim::I2CMaster, ANNODE_DRIVER_COUNT> masters;
+static std::array<sim::MCP23017, ANNODE_DRIVER_COUNT> mcps;
+static std::array<bool, 16> pins;
+
+/** Annodes words latched by the MCPs each time a column is powered */
+static std::array<std::array<uint16_t, ANNODE_DRIVER_COUNT>, MULTIPLEX_COLUMS_COUNT> panel;
+
+struct SimContext
+{
+    using master_type = sim::I2CMaster;
+
+    static master_type& i2c_master(annode_driver d)
+        { return masters[static_cast<uint8_t>(d)]; }
+
+    static void pin_mode_output(uint8_t pin)        {}
+    static void digital_write(uint8_t pin, bool level)
+        {
+            pins[pin] = level;
+            if (pin != CATHODE_ENABLE_PIN || level != CATHODE_ENABLE_LEVEL)
+                { return; }
+            const uint8_t column = (pins[CATHODE_ADDR_PINA0] ? 1 : 0)
+                | (pins[CATHODE_ADDR_PINA1] ? 2 : 0)
+                | (pins[CATHODE_ADDR_PINA2] ? 4 : 0);
+            for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+                { panel[column][i] = mcps[i].outputs(); }
+        }
+
+    static unsigned long micros()
+        { return sim::Clock::micros(); }
+};
+
+using driver_type = LedsDriver<SimContext>;
+
+static void run_frames(driver_type& driver, size_t frames)
+{
+    const unsigned long target = driver.steps_count() + frames * MULTIPLEX_COLUMS_COUNT;
+    for (size_t i=0; driver.steps_count() < target && i < 1000000; ++i)
+        {
+            driver.update();
+            sim::Clock::advance(2000);
+        }
+    assert(driver.steps_count() >= target);
+}
+
+static void assert_same_pads(const driver_type& lhs, const driver_type& rhs)
+{
+    for (uint8_t i=0; i<static_cast<uint8_t>(pads::Pad::__PADS_COUNT__); ++i)
+        {
+            const pads::Pad pad = static_cast<pads::Pad>(i);
+            if (is_blind(pad))
+                { continue; }
+            pad_color a, b;
+            lhs.get_state(pad, &a);
+            rhs.get_state(pad, &b);
+            assert(a == b);
+        }
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::random_device rand;
+    std::uniform_int_distribution<uint8_t> color_dist(0, 3);
+
+    pad_color matrix[pads::CLIP_ROWS][pads::CLIP_COLS];
+    auto randomize = [&]() -> void
+        {
+            for (auto& row: matrix)
+                for (auto& color: row)
+                    { color = static_cast<pad_color>(color_dist(rand)); }
+        };
+
+    std::cout << "Testing set_matrix against set_state" << std::endl;
+    for (size_t pass=0; pass<16; ++pass)
+        {
+            driver_type single, bulk;
+            randomize();
+
+            for (uint8_t y=0; y<pads::CLIP_ROWS; ++y)
+                for (uint8_t x=0; x<pads::CLIP_COLS; ++x)
+                    { single.set_state(pads::CLIP_Y_X[y][x], matrix[y][x]); }
+            bulk.set_matrix(matrix);
+
+            assert_same_pads(single, bulk);
+        }
+
+    std::cout << "Testing set_column against set_state" << std::endl;
+    {
+        driver_type single, bulk;
+        randomize();
+        for (uint8_t x=0; x<pads::CLIP_COLS; ++x)
+            {
+                pad_color column[pads::CLIP_ROWS];
+                for (uint8_t y=0; y<pads::CLIP_ROWS; ++y)
+                    {
+                        column[y] = matrix[y][x];
+                        single.set_state(pads::CLIP_Y_X[y][x], matrix[y][x]);
+                    }
+                bulk.set_column(x, column);
+            }
+        assert_same_pads(single, bulk);
+    }
+
+    std::cout << "Testing set_row against set_state" << std::endl;
+    {
+        driver_type single, bulk;
+        for (uint8_t r=0; r<static_cast<uint8_t>(pads::PadRow::BankControl); ++r)
+            {
+                pad_color row[COLUMNS_COUNT];
+                for (uint8_t x=0; x<COLUMNS_COUNT; ++x)
+                    {
+                        row[x] = static_cast<pad_color>(color_dist(rand));
+                        single.set_state(static_cast<pads::Pad>(r << 3 | x), row[x]);
+                    }
+                bulk.set_row(static_cast<pads::PadRow>(r), row);
+            }
+        assert_same_pads(single, bulk);
+
+        /* ring leds sharing MCPs with pads are left untouched */
+        ledring_state ring;
+        single.set_state(analog::Encoder::PAN_2, ledring_state{2, 6});
+        single.set_row(pads::PadRow::TransportControl, matrix[0]);
+        single.get_state(analog::Encoder::PAN_2, &ring);
+        assert(ring.start == 2 && ring.count == 6);
+
+        pad_color dummy[COLUMNS_COUNT] = {};
+        assert(!bulk.set_row(pads::PadRow::BankControl, dummy));
+    }
+
+    std::cout << "Testing fill" << std::endl;
+    {
+        driver_type single, bulk;
+        const rows_mask mask = CLIP_ROWS_MASK | rows_mask_of(pads::PadRow::TrackSelect);
+        for (uint8_t r=0; r<static_cast<uint8_t>(pads::PadRow::BankControl); ++r)
+            {
+                for (uint8_t x=0; x<COLUMNS_COUNT; ++x)
+                    {
+                        const pads::Pad pad = static_cast<pads::Pad>(r << 3 | x);
+                        const pad_color color = static_cast<pad_color>(color_dist(rand));
+                        single.set_state(pad, (mask & (1 << r)) ? pad_color::ORANGE : color);
+                        bulk.set_state(pad, color);
+                    }
+            }
+        bulk.fill(mask, pad_color::ORANGE);
+        assert_same_pads(single, bulk);
+        assert(!bulk.fill(rows_mask_of(pads::PadRow::BankControl), pad_color::ON));
+    }
+
+    std::cout << "Testing dirty columns reach the wire" << std::endl;
+    {
+        sim::Clock::reset();
+        for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+            {
+                masters[i] = sim::I2CMaster{};
+                mcps[i].reset();
+                masters[i].attach(mcps[i]);
+            }
+
+        driver_type driver;
+        driver.setup();
+        randomize();
+        driver.set_matrix(matrix);
+        run_frames(driver, 2);
+
+        for (uint8_t y=0; y<pads::CLIP_ROWS; ++y)
+            for (uint8_t x=0; x<pads::CLIP_COLS; ++x)
+                {
+                    const uint16_t word = panel[x][static_cast<uint8_t>(annode_driver::PadsMatrix)];
+                    assert(((word >> (2*y)) & 0b11) == static_cast<uint8_t>(matrix[y][x]));
+                }
+
+        pad_color column[pads::CLIP_ROWS] = {
+            pad_color::RED, pad_color::RED, pad_color::RED, pad_color::RED, pad_color::RED };
+        driver.set_column(3, column);
+        run_frames(driver, 1);
+        assert((panel[3][static_cast<uint8_t>(annode_driver::PadsMatrix)] & 0x3FF) == 0b1010101010);
+    }
+
+    std::cout << "\nBenchmark: full launch matrix redraw" << std::endl;
+    {
+        constexpr size_t ITERATIONS = 200000;
+        driver_type driver;
+        randomize();
+
+        using clock = std::chrono::steady_clock;
+        volatile uint8_t sink = 0;
+        pad_color color;
+
+        auto begin = clock::now();
+        for (size_t i=0; i<ITERATIONS; ++i)
+            {
+                matrix[i % pads::CLIP_ROWS][i % pads::CLIP_COLS] = static_cast<pad_color>(i & 0x03);
+                for (uint8_t y=0; y<pads::CLIP_ROWS; ++y)
+                    for (uint8_t x=0; x<pads::CLIP_COLS; ++x)
+                        { driver.set_state(pads::CLIP_Y_X[y][x], matrix[y][x]); }
+                driver.get_state(pads::Pad::CLIP_0_0, &color);
+                sink = sink + static_cast<uint8_t>(color);
+            }
+        const double single_ns = std::chrono::duration<double, std::nano>(clock::now() - begin).count() / ITERATIONS;
+
+        begin = clock::now();
+        for (size_t i=0; i<ITERATIONS; ++i)
+            {
+                matrix[i % pads::CLIP_ROWS][i % pads::CLIP_COLS] = static_cast<pad_color>(i & 0x03);
+                driver.set_matrix(matrix);
+                driver.get_state(pads::Pad::CLIP_0_0, &color);
+                sink = sink + static_cast<uint8_t>(color);
+            }
+        const double bulk_ns = std::chrono::duration<double, std::nano>(clock::now() - begin).count() / ITERATIONS;
+
+        std::cout << "\t40x set_state: " << single_ns << " ns/redraw" << std::endl;
+        std::cout << "\tset_matrix:    " << bulk_ns << " ns/redraw" << std::endl;
+        std::cout << "\tspeedup:       " << single_ns / bulk_ns << "x" << std::endl;
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,263 @@
+
+#include "hw/matrix_driver/matrix_driver.h"
+
+#include "../sim/clock.hpp"
+#include "../sim/i2c.hpp"
+#include "../sim/mcp23017.hpp"
+#include "../sim/switch.hpp"
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <algorithm>
+
+using namespace hw;
+using namespace hw::leds_driver;
+using hw::matrix_driver::MatrixDriver;
+using settings_type = hw::matrix_driver::DriverDefaultSettings;
+
+static constexpr size_t PADS_COUNT = static_cast<size_t>(pads::Pad::__PADS_COUNT__);
+
+static std::array<sim::I2CMaster, ANNODE_DRIVER_COUNT> masters;
+static std::array<sim::MCP23017, ANNODE_DRIVER_COUNT> mcps;
+static std::array<sim::Switch, PADS_COUNT> switches;
+static std::array<bool, 64> pins;
+
+/** Wiring observations */
+struct Probe
+{
+    size_t address_toggles = 0;     ///< level changes of the column addressing pins
+    size_t dark_reads = 0;          ///< rows read while no column was powered
+    uint8_t last_read = 0xFF;       ///< column sinking the rows on last read
+    std::array<std::array<uint16_t, ANNODE_DRIVER_COUNT>, MULTIPLEX_COLUMS_COUNT> panel;
+};
+static Probe probe;
+
+static uint8_t selected_column()
+{
+    return (pins[CATHODE_ADDR_PINA0] ? 1 : 0)
+        | (pins[CATHODE_ADDR_PINA1] ? 2 : 0)
+        | (pins[CATHODE_ADDR_PINA2] ? 4 : 0);
+}
+
+struct SimContext
+{
+    using master_type = sim::I2CMaster;
+
+    static master_type& i2c_master(annode_driver d)
+        { return masters[static_cast<uint8_t>(d)]; }
+
+    static void pin_mode_output(uint8_t pin)            {}
+    static void pin_mode_input_pullup(uint8_t pin)      {}
+    static void digital_write(uint8_t pin, bool level)
+        {
+            if (pin >= CATHODE_ADDR_PINA0 && pin <= CATHODE_ADDR_PINA2 && pins[pin] != level)
+                { probe.address_toggles += 1; }
+            pins[pin] = level;
+
+            if (pin != CATHODE_ENABLE_PIN || level != CATHODE_ENABLE_LEVEL)
+                { return; }
+            for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+                { probe.panel[selected_column()][i] = mcps[i].outputs(); }
+        }
+
+    /** Rows are only sunk by the selected column while the demultiplexer is enabled */
+    static uint16_t read_rows()
+        {
+            if (pins[CATHODE_ENABLE_PIN] != CATHODE_ENABLE_LEVEL)
+                {
+                    probe.dark_reads += 1;
+                    return 0x3FFF;
+                }
+            const uint8_t column = selected_column();
+            probe.last_read = column;
+
+            uint16_t levels = 0;
+            for (uint8_t row=0; row<pads_driver::ROWS_COUNT; ++row)
+                {
+                    const bool closed = switches[(row << 3) | column].is_closed(sim::Clock::now());
+                    levels |= (closed ? 0 : 1) << row;
+                }
+            return levels;
+        }
+
+    static unsigned long micros()       { return sim::Clock::micros(); }
+};
+
+using driver_type = MatrixDriver<SimContext>;
+
+static void reset_bench(unsigned long refresh_rate, unsigned long i2c_frequency)
+{
+    settings_type::RefreshRate = refresh_rate;
+    settings_type::I2CFrequency = i2c_frequency;
+    sim::Clock::reset();
+    probe = Probe{};
+    pins.fill(false);
+    for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+        {
+            masters[i] = sim::I2CMaster{};
+            mcps[i].reset();
+            masters[i].attach(mcps[i]);
+        }
+    for (auto& s: switches)
+        { s = sim::Switch{}; }
+}
+
+static void run(driver_type& driver, uint64_t duration_ns, uint64_t loop_ns=2000)
+{
+    const uint64_t end = sim::Clock::now() + duration_ns;
+    while (sim::Clock::now() < end)
+        {
+            driver.update();
+            sim::Clock::advance(loop_ns);
+        }
+}
+
+struct ScanStats
+{
+    std::vector<double> latency_ms;
+    size_t spurious = 0;
+    size_t missed = 0;
+};
+
+/**
+ * Presses random pads with bouncing contacts while the leds are refreshed,
+ *  measures the delay between first contact and the polled edge
+ */
+static ScanStats scan_bouncing_pads(unsigned long refresh_rate, uint64_t duration_ns)
+{
+    reset_bench(refresh_rate, 400000);
+
+    sim::BounceModel bounce;
+    std::mt19937 rand(0xcafe);
+    std::uniform_int_distribution<uint64_t> hold(60000000, 300000000);
+    for (auto& s: switches)
+        {
+            uint64_t t = hold(rand);
+            bool closed = true;
+            while (t < duration_ns)
+                {
+                    s.schedule(t, closed, bounce, rand);
+                    closed = !closed;
+                    t += hold(rand);
+                }
+        }
+
+    std::array<size_t, PADS_COUNT> next_edge{};
+    ScanStats stats;
+
+    driver_type driver;
+    driver.setup();
+    while (sim::Clock::now() < duration_ns)
+        {
+            driver.update();
+
+            pads_driver::pad_event event;
+            while (driver.poll(event))
+                {
+                    const size_t index = static_cast<size_t>(event.pad);
+                    const auto& edges = switches[index].edges();
+                    if (edges.size() <= next_edge[index] || edges[next_edge[index]].closed != event.pressed)
+                        { stats.spurious += 1; continue; }
+                    stats.latency_ms.push_back((sim::Clock::now() - edges[next_edge[index]].time) / 1e6);
+                    next_edge[index] += 1;
+                }
+            sim::Clock::advance(5000);
+        }
+
+    const uint64_t horizon = duration_ns - 100000000;
+    for (size_t i=0; i<PADS_COUNT; ++i)
+        for (size_t e=next_edge[i]; e<switches[i].edges().size(); ++e)
+            { if (switches[i].edges()[e].time < horizon) { stats.missed += 1; } }
+
+    assert(probe.dark_reads == 0);
+    return stats;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing one column switch per step for leds and pads" << std::endl;
+    {
+        reset_bench(250, 400000);
+
+        driver_type driver;
+        driver.setup();
+        driver.leds().set_state(pads::Pad::CLIP_2_5, pad_color::RED);
+
+        /* hold a single pad, every sample must be taken on the powered column */
+        std::mt19937 rand(1);
+        switches[static_cast<size_t>(pads::Pad::CLIP_2_5)].schedule(0, true, sim::BounceModel{0, 1, 1}, rand);
+        run(driver, 1000000000);
+
+        const unsigned long steps = driver.leds().steps_count();
+        assert(steps >= 1999 && steps <= 2001);
+        assert(driver.samples_count() == steps -1 || driver.samples_count() == steps);
+        assert(probe.dark_reads == 0);
+        /* last sample was taken on the column powered before the current one */
+        assert(((probe.last_read + 1) & MULTIPLEX_COLUMN_BITMASK) == driver.leds().column());
+
+        /* 8 steps of a binary counter toggle 8+4+2 addressing pins */
+        const double toggles = static_cast<double>(probe.address_toggles) / steps;
+        std::cout << "\taddressing pins toggles per step: " << toggles << std::endl;
+        assert(toggles <= 14.0 / 8 + 0.01);
+
+        assert(driver.debouncer().is_pressed(pads::Pad::CLIP_2_5));
+        assert(!driver.debouncer().is_pressed(pads::Pad::CLIP_2_4));
+        pads_driver::pad_event event;
+        assert(driver.poll(event) && event.pad == pads::Pad::CLIP_2_5 && event.pressed);
+        assert(!driver.poll(event));
+
+        const uint16_t word = probe.panel[5][static_cast<uint8_t>(annode_driver::PadsMatrix)];
+        assert(((word >> 4) & 0b11) == static_cast<uint8_t>(pad_color::RED));
+    }
+
+    std::cout << "\nBouncing pads scanned by the leds refresh, 10s per rate" << std::endl;
+    printf("%8s | %10s %10s | %8s %8s\n", "refresh", "lat.avg", "lat.max", "spurious", "missed");
+    for (unsigned long rate: {125UL, 250UL, 500UL})
+        {
+            const ScanStats stats = scan_bouncing_pads(rate, 10000000000ULL);
+            double sum = 0;
+            for (auto l: stats.latency_ms) { sum += l; }
+            const double avg = stats.latency_ms.empty() ? 0 : sum / stats.latency_ms.size();
+            const double max = stats.latency_ms.empty() ? 0
+                : *std::max_element(stats.latency_ms.begin(), stats.latency_ms.end());
+
+            printf("%6luHz | %8.2fms %8.2fms | %8lu %8lu\n", rate, avg, max, stats.spurious, stats.missed);
+            assert(stats.spurious == 0 && stats.missed == 0);
+            assert(!stats.latency_ms.empty());
+            /* bounce + 4 samples + one frame to reach the column */
+            assert(max < 5.0 + 5 * 1000.0 / rate);
+        }
+
+    std::cout << "\nAchieved rates, 2s per configuration" << std::endl;
+    printf("%8s %8s | %10s %10s\n", "target", "i2c", "refresh", "scan");
+    for (unsigned long clock: {100000UL, 400000UL, 1000000UL})
+        for (unsigned long rate: {50UL, 125UL, 250UL, 500UL, 1000UL})
+            {
+                reset_bench(rate, clock);
+                driver_type driver;
+                driver.setup();
+                run(driver, 2000000000);
+
+                printf("%6luHz %5lukHz | %8.1fHz %8.1fHz\n",
+                    rate, clock / 1000, driver.refresh_rate(), driver.scan_rate());
+
+                /* scan always follows the refresh, both jobs share each step */
+                assert(std::fabs(driver.scan_rate() - driver.refresh_rate()) < 0.01f * rate);
+                assert(driver.refresh_rate() <= rate * 1.01f);
+                if (clock >= 400000 && rate <= 250)
+                    { assert(driver.refresh_rate() >= rate * 0.97f); }
+                assert(probe.dark_reads == 0);
+            }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
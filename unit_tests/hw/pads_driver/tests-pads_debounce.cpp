@@ -0,0 +1,211 @@
+
+#include "hw/pads_driver/pads_driver.h"
+
+#include "../sim/clock.hpp"
+#include "../sim/switch.hpp"
+
+#include <array>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <algorithm>
+
+using namespace hw;
+using namespace hw::pads_driver;
+
+static constexpr size_t PADS_COUNT = static_cast<size_t>(pads::Pad::__PADS_COUNT__);
+
+static std::array<sim::Switch, PADS_COUNT> switches;
+static std::array<bool, 64> pins;
+
+struct SimContext
+{
+    static void pin_mode_output(uint8_t pin)            {}
+    static void pin_mode_input_pullup(uint8_t pin)      {}
+    static void digital_write(uint8_t pin, bool level)  { pins[pin] = level; }
+
+    /** Rows of the selected column, pulled low by closed switches */
+    static uint16_t read_rows()
+        {
+            const uint8_t column = (pins[SINK_ADDR_PINA0] ? 1 : 0)
+                | (pins[SINK_ADDR_PINA1] ? 2 : 0)
+                | (pins[SINK_ADDR_PINA2] ? 4 : 0);
+            uint16_t levels = 0;
+            for (uint8_t row=0; row<ROWS_COUNT; ++row)
+                {
+                    const bool closed = switches[(row << 3) | column].is_closed(sim::Clock::now());
+                    levels |= (closed ? 0 : 1) << row;
+                }
+            return levels;
+        }
+
+    static unsigned long micros()       { return sim::Clock::micros(); }
+};
+
+using driver_type = PadsDriver<SimContext>;
+
+struct Stats
+{
+    std::vector<double> press_ms;
+    std::vector<double> release_ms;
+    size_t spurious = 0;
+    size_t missed = 0;
+};
+
+static double mean(const std::vector<double>& v)
+    { double s = 0; for (auto x: v) { s += x; } return v.empty() ? 0 : s / v.size(); }
+
+static double max(const std::vector<double>& v)
+    { return v.empty() ? 0 : *std::max_element(v.begin(), v.end()); }
+
+/**
+ * Presses random pads with bouncing contacts and measures the delay
+ *  between first contact and the debounced edge polled by the main loop
+ */
+static Stats simulate(unsigned long scan_rate, const sim::BounceModel& bounce, uint64_t duration_ns)
+{
+    DriverDefaultSettings::ScanRate = scan_rate;
+    sim::Clock::reset();
+
+    std::mt19937 rand(0xb0b0);
+    std::uniform_int_distribution<uint64_t> hold(60000000, 300000000);
+
+    for (auto& s: switches)
+        {
+            s = sim::Switch{};
+            uint64_t t = hold(rand);
+            bool closed = true;
+            while (t < duration_ns)
+                {
+                    s.schedule(t, closed, bounce, rand);
+                    closed = !closed;
+                    t += hold(rand);
+                }
+        }
+
+    std::array<size_t, PADS_COUNT> next_edge{};
+    Stats stats;
+
+    driver_type driver;
+    driver.setup();
+
+    while (sim::Clock::now() < duration_ns)
+        {
+            driver.update();
+
+            pad_event event;
+            while (driver.poll(event))
+                {
+                    const size_t index = static_cast<size_t>(event.pad);
+                    const auto& edges = switches[index].edges();
+                    if (edges.size() <= next_edge[index] || edges[next_edge[index]].closed != event.pressed)
+                        { stats.spurious += 1; continue; }
+
+                    const double latency = (sim::Clock::now() - edges[next_edge[index]].time) / 1e6;
+                    (event.pressed ? stats.press_ms : stats.release_ms).push_back(latency);
+                    next_edge[index] += 1;
+                }
+
+            sim::Clock::advance(5000);
+        }
+
+    /* edges close to the end may legitimately still be in debounce */
+    const uint64_t horizon = duration_ns - 50000000;
+    for (size_t i=0; i<PADS_COUNT; ++i)
+        for (size_t e=next_edge[i]; e<switches[i].edges().size(); ++e)
+            { if (switches[i].edges()[e].time < horizon) { stats.missed += 1; } }
+
+    return stats;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing vertical counters" << std::endl;
+    {
+        Debouncer debouncer;
+        /* lane 0 steady, lane 1 bouncing, lane 2 clean press */
+        const uint16_t samples[] = {0b110, 0b100, 0b110, 0b100, 0b110, 0b110, 0b110, 0b110};
+        uint16_t toggles[8];
+        for (size_t i=0; i<8; ++i)
+            { toggles[i] = debouncer.feed(3, samples[i]); }
+
+        assert(toggles[0] == 0 && toggles[1] == 0 && toggles[2] == 0);
+        assert(toggles[3] == 0b100);        /* 4th sample */
+        assert(toggles[7] == 0b010);        /* 4 consecutive samples after last bounce */
+        assert(debouncer.column_state(3) == 0b110);
+        assert(debouncer.column_state(2) == 0);
+        assert(debouncer.is_pressed(static_cast<pads::Pad>((2 << 3) | 3)));
+        assert(debouncer.row_state(pads::PadRow::Clip_1) == 0b1000);
+
+        for (size_t i=0; i<4; ++i)
+            { toggles[i] = debouncer.feed(3, 0b010); }
+        assert(toggles[3] == 0b100);        /* release of lane 2 */
+    }
+
+    std::cout << "Testing edges queue" << std::endl;
+    {
+        Debouncer debouncer;
+        EdgesQueue queue;
+        for (size_t i=0; i<4; ++i)
+            {
+                queue.push(0, debouncer.feed(0, 0b1));
+                queue.push(5, debouncer.feed(5, 0b1000));
+            }
+        pad_event event;
+        assert(queue.pop(debouncer, event) && event.pad == pads::Pad::CLIP_0_0 && event.pressed);
+        assert(queue.pop(debouncer, event) && event.pad == pads::Pad::CLIP_3_5 && event.pressed);
+        assert(!queue.pop(debouncer, event));
+    }
+
+    std::cout << "\nSimulated bouncing contacts, 20s per scan rate" << std::endl;
+    printf("%8s %8s | %10s %10s | %10s %10s | %8s %8s\n",
+        "scan", "sample", "press.avg", "press.max", "rel.avg", "rel.max", "spurious", "missed");
+
+    sim::BounceModel bounce;
+    bool failed = false;
+    for (unsigned long rate: {125UL, 250UL, 500UL, 1000UL})
+        {
+            const Stats stats = simulate(rate, bounce, 20000000000ULL);
+            printf("%6luHz %6.1fms | %8.2fms %8.2fms | %8.2fms %8.2fms | %8lu %8lu\n",
+                rate, 1000.0 / rate, mean(stats.press_ms), max(stats.press_ms),
+                mean(stats.release_ms), max(stats.release_ms), stats.spurious, stats.missed);
+
+            failed |= stats.spurious != 0 || stats.missed != 0;
+            /* worst case: bounce + 4 samples + one scan to reach the column */
+            failed |= max(stats.press_ms) > bounce.max_bounce_ns / 1e6 + 5 * 1000.0 / rate;
+        }
+    assert(!failed);
+
+    std::cout << "\nBenchmark: Debouncer::feed cost against held pads" << std::endl;
+    {
+        constexpr size_t ITERATIONS = 4000000;
+        using clock = std::chrono::steady_clock;
+        std::mt19937 rand(42);
+        std::vector<uint16_t> noise(1024);
+        for (auto& n: noise) { n = rand(); }
+
+        auto bench = [&](const char* label, auto sample_fn) {
+                Debouncer debouncer;
+                volatile uint16_t sink = 0;
+                auto begin = clock::now();
+                for (size_t i=0; i<ITERATIONS; ++i)
+                    { sink = sink ^ debouncer.feed(i & 0x07, sample_fn(i)); }
+                const double ns = std::chrono::duration<double, std::nano>(clock::now() - begin).count() / ITERATIONS;
+                printf("\t%-20s %6.2f ns/column\n", label, ns);
+            };
+
+        bench("no pad held", [](size_t) -> uint16_t { return 0; });
+        bench("all pads held", [](size_t) -> uint16_t { return 0x3FFF; });
+        bench("all pads bouncing", [&](size_t i) -> uint16_t { return noise[i & 1023]; });
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,423 @@
+/**
+ * Host side simulator for the PWM driver:
+ *  runs the real PwmDriver against a simulated i2c bus and PCA9685 register model,
+ *  then compares bus usage of batched bursts against one transaction per channel,
+ *  and shares the bus with a LedsDriver MCP.
+ */
+
+#include "hw/pwm_driver/pwm_driver.h"
+#include "hw/leds_driver/leds_driver.h"
+
+#include "../sim/clock.hpp"
+#include "../sim/i2c.hpp"
+#include "../sim/pca9685.hpp"
+#include "../sim/mcp23017.hpp"
+
+#include <chrono>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+#include <array>
+
+using namespace hw::pwm_driver;
+
+static sim::I2CMaster bus;
+static sim::PCA9685 chip;
+
+struct SimContext
+{
+    using master_type = sim::I2CMaster;
+
+    static master_type& i2c_master()        { return bus; }
+    static unsigned long micros()           { return sim::Clock::micros(); }
+};
+
+/** The master is begun by its owner, not by the driver */
+static void reset()
+{
+    sim::Clock::reset();
+    bus = sim::I2CMaster{};
+    chip.reset();
+    bus.attach(chip);
+    bus.begin(PwmDefaultSettings::I2CFrequency);
+}
+
+using driver_type = PwmDriver<SimContext>;
+
+/**
+ * Leds driver with its first MCP on the PWM bus, observes how long columns stay blank
+ */
+struct Leds
+{
+    std::array<sim::I2CMaster, hw::leds_driver::ANNODE_DRIVER_COUNT> masters;     ///< first one replaced by the PWM bus
+    std::array<sim::MCP23017, hw::leds_driver::ANNODE_DRIVER_COUNT> mcps;
+
+    bool lit = false;
+    bool blanked = false;           ///< a lit column has been blanked, the first one is not counted
+    sim::Clock::time_point blank_since = 0;
+    uint64_t max_blank_ns = 0;
+
+    sim::I2CMaster& master(hw::leds_driver::annode_driver d)
+        { return static_cast<uint8_t>(d) == 0 ? bus : masters[static_cast<uint8_t>(d)]; }
+
+    void reset()
+        {
+            for (size_t i=0; i<hw::leds_driver::ANNODE_DRIVER_COUNT; ++i)
+                {
+                    masters[i] = sim::I2CMaster{};
+                    mcps[i].reset();
+                    master(static_cast<hw::leds_driver::annode_driver>(i)).attach(mcps[i]);
+                }
+            lit = blanked = false;
+            max_blank_ns = 0;
+        }
+
+    void on_pin(uint8_t pin, bool level)
+        {
+            if (pin != hw::leds_driver::CATHODE_ENABLE_PIN || (level == hw::leds_driver::CATHODE_ENABLE_LEVEL) == lit)
+                { return; }
+            lit = !lit;
+            if (lit && blanked)
+                { max_blank_ns = std::max<uint64_t>(max_blank_ns, sim::Clock::now() - blank_since); }
+            if (!lit)
+                {
+                    blanked = true;
+                    blank_since = sim::Clock::now();
+                }
+        }
+};
+
+static Leds leds;
+
+struct LedsContext
+{
+    using master_type = sim::I2CMaster;
+
+    static master_type& i2c_master(hw::leds_driver::annode_driver d)   { return leds.master(d); }
+    static void pin_mode_output(uint8_t pin)                            {}
+    static void digital_write(uint8_t pin, bool level)                  { leds.on_pin(pin, level); }
+    static unsigned long micros()                                       { return sim::Clock::micros(); }
+};
+
+using leds_type = hw::leds_driver::LedsDriver<LedsContext>;
+
+/**
+ * Runs both drivers for @c duration_ns, 20us loops. With @c shared the PWM driver
+ *  collects its burst on column ends and only uses the time left by the leds, otherwise it
+ *  is updated as if it owned the bus. 16 LFOs are set every 250us if @c lfos.
+ *  Returns false if the leds driver reported a failure
+ */
+static bool run_shared(leds_type& leds_driver, driver_type& driver, uint64_t duration_ns, bool shared, bool lfos)
+{
+    constexpr uint64_t LOOP_NS = 20000;
+    bool ok = true;
+    const sim::Clock::time_point end = sim::Clock::now() + duration_ns;
+    for (size_t l=0; sim::Clock::now() < end; ++l)
+        {
+            if (lfos && l % 12 == 0)
+                {
+                    const double t = sim::Clock::now() / 1e9;
+                    for (uint8_t c=0; c<PWM_CHANNELS_COUNT; ++c)
+                        { driver.set(c, static_cast<uint16_t>(2048 + 2047 * std::sin(2 * M_PI * (0.5 + c * 0.37) * t))); }
+                }
+            if (shared)
+                {
+                    ok &= static_cast<bool>(leds_driver.update([&driver](uint8_t) { driver.update(0); }));
+                    driver.update(leds_driver.bus_time_left());
+                }
+            else
+                {
+                    ok &= static_cast<bool>(leds_driver.update());
+                    driver.update();
+                }
+            sim::Clock::advance(LOOP_NS);
+        }
+    return ok;
+}
+
+/** Calls update every @c loop_ns until every value is written, returns the elapsed time in ns */
+static uint64_t settle(driver_type& driver, uint64_t loop_ns=2000)
+{
+    const sim::Clock::time_point begin = sim::Clock::now();
+    for (int i=0; !driver.is_idle(); ++i)
+        {
+            assert(i < 100000);
+            assert(driver.update());
+            sim::Clock::advance(loop_ns);
+        }
+    return sim::Clock::now() - begin;
+}
+
+static void check_outputs(const driver_type& driver)
+{
+    for (uint8_t c=0; c<PWM_CHANNELS_COUNT; ++c)
+        { assert(chip.duty(c) == driver.get(c)); }
+}
+
+/** Writes a channel as its own transaction, as a naive driver would */
+static void write_single(uint8_t channel, uint16_t value)
+{
+    uint8_t buffer[1 + PCA_REGISTERS_PER_CHANNEL];
+    buffer[0] = PCA_LED0_ON_L + channel * PCA_REGISTERS_PER_CHANNEL;
+    encode_channel(channel, value, buffer + 1);
+    bus.write_async(PCA_I2C_ADDRESS, buffer, sizeof(buffer), true);
+    while (!bus.finished())
+        { sim::Clock::advance(1000); }
+    assert(!bus.has_error());
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing channel encoding" << std::endl;
+    {
+        uint8_t r[PCA_REGISTERS_PER_CHANNEL];
+        encode_channel(0, 0, r);
+        assert(r[0] == 0 && r[1] == 0 && r[2] == 0 && r[3] == PCA_FULL_BIT);
+        encode_channel(5, PWM_FULL_ON, r);
+        assert(r[0] == 0 && r[1] == PCA_FULL_BIT && r[2] == 0 && r[3] == 0);
+        /* channel 15 starts at 3840, a 1000 duty wraps around the period end */
+        encode_channel(15, 1000, r);
+        assert(r[0] == 0x00 && r[1] == 0x0F && r[2] == (744 & 0xFF) && r[3] == (744 >> 8));
+    }
+
+    std::cout << "Testing configuration" << std::endl;
+    {
+        reset();
+        driver_type driver;
+        assert(driver.setup());
+        assert(!driver.is_idle());
+        const uint64_t elapsed = settle(driver);
+
+        assert(chip.reg(sim::PCA9685::MODE1) == PCA_MODE1_AI);
+        assert(chip.reg(sim::PCA9685::MODE2) == PCA_MODE2_OUTDRV);
+        assert(chip.reg(sim::PCA9685::PRE_SCALE) == prescale_of(PwmDefaultSettings::PwmFrequency));
+        assert(std::fabs(chip.frequency() - 1526) < 1);
+        assert(chip.early_writes() == 0);
+        check_outputs(driver);
+        /* four configuration writes and a single burst of every channel */
+        assert(bus.transactions() == 5 && driver.counters().bursts == 1);
+        assert(driver.counters().bytes == bus.bytes());
+        printf("\tconfigured and written in %.0fus\n", elapsed / 1e3);
+
+        /* unanswered chip: configuration is retried until it acknowledges */
+        reset();
+        chip.set_nak(true);
+        driver_type retried;
+        retried.setup();
+        bool failed = false;
+        for (int i=0; i<50; ++i)
+            {
+                failed |= !retried.update();
+                sim::Clock::advance(100000);
+            }
+        assert(failed && !retried.is_idle() && retried.counters().errors > 0);
+        chip.set_nak(false);
+        settle(retried);
+        assert(chip.reg(sim::PCA9685::MODE1) == PCA_MODE1_AI);
+        check_outputs(retried);
+    }
+
+    std::cout << "Testing values" << std::endl;
+    {
+        reset();
+        driver_type driver;
+        driver.setup();
+        settle(driver);
+
+        assert(!driver.set(PWM_CHANNELS_COUNT, 0));
+        assert(!driver.set(0, PWM_FULL_ON + 1));
+        const uint16_t values[4] = {1, 2, 3, PWM_FULL_ON + 1};
+        assert(!driver.set(14, values, 4));
+        assert(!driver.set(0, values, 4) && driver.dirty() == 0);
+
+        for (uint8_t c=0; c<PWM_CHANNELS_COUNT; ++c)
+            { assert(driver.set(c, c * 273)); }
+        assert(driver.set(3, 1) && driver.set(4, 4095) && driver.set(5, PWM_FULL_ON) && driver.set(6, 0));
+        settle(driver);
+        check_outputs(driver);
+        assert(chip.duty(5) == PWM_FULL_ON && chip.duty(6) == 0);
+
+        /* unchanged values are not written again */
+        const size_t bursts = driver.counters().bursts;
+        assert(driver.set(3, 1) && driver.dirty() == 0);
+        assert(driver.update() && driver.counters().bursts == bursts);
+
+        /* values changed while the bus is busy are written once, with the latest one */
+        bus.reset_stats();
+        assert(driver.set(7, 100) && driver.update());
+        for (uint16_t v=0; v<50; ++v)
+            {
+                assert(driver.set(8, 1000 + v) && driver.update());
+                assert(bus.errors_count() == 0);
+            }
+        settle(driver);
+        check_outputs(driver);
+        assert(bus.transactions() == 2 && bus.errors_count() == 0);
+
+        /* failed bursts are written again */
+        chip.set_nak(true);
+        assert(driver.set(9, 42) && driver.update());
+        sim::Clock::advance(1000000);
+        assert(!driver.update() && driver.dirty() == (1 << 9));
+        chip.set_nak(false);
+        settle(driver);
+        check_outputs(driver);
+        assert(driver.counters().errors == 1);
+    }
+
+    std::cout << "Testing bus usage" << std::endl;
+    {
+        struct scenario
+        {
+            const char* name;
+            std::vector<uint8_t> channels;
+        };
+        const std::vector<scenario> scenarios = {
+            {"1 channel", {7}},
+            {"4 adjacent channels", {4, 5, 6, 7}},
+            {"4 scattered channels", {0, 5, 10, 15}},
+            {"16 channels", {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}},
+        };
+
+        printf("\t%.0fkHz bus, bytes on the wire and bus time per update:\n", PwmDefaultSettings::I2CFrequency / 1e3);
+        printf("\t%-22s %8s %8s %10s %12s %8s %8s %10s\n",
+            "", "bursts", "bytes", "bus(us)", "latency(us)", "naive", "bytes", "bus(us)");
+
+        for (const scenario& s: scenarios)
+            {
+                reset();
+                driver_type driver;
+                driver.setup();
+                settle(driver);
+
+                bus.reset_stats();
+                for (uint8_t c: s.channels)
+                    { assert(driver.set(c, 100 + c)); }
+                const uint64_t latency = settle(driver, 1000);
+                check_outputs(driver);
+                const size_t bursts = bus.transactions(), bytes = bus.bytes();
+                const uint64_t busy = bus.busy_ns();
+                assert(bus.errors_count() == 0);
+
+                bus.reset_stats();
+                for (uint8_t c: s.channels)
+                    { write_single(c, 200 + c); }
+                const size_t naive_bytes = bus.bytes();
+                assert(bus.transactions() == s.channels.size());
+
+                printf("\t%-22s %8lu %8lu %10.1f %12.1f %8lu %8lu %10.1f\n",
+                    s.name, bursts, bytes, busy / 1e3, latency / 1e3,
+                    s.channels.size(), naive_bytes, bus.busy_ns() / 1e3);
+                assert(bytes <= naive_bytes);
+                assert(bursts <= s.channels.size());
+            }
+    }
+
+    std::cout << "Testing CV outputs at audio control rate" << std::endl;
+    {
+        /* 16 LFOs recomputed on every 250us loop, for a second */
+        reset();
+        driver_type driver;
+        driver.setup();
+        settle(driver);
+        bus.reset_stats();
+
+        constexpr uint64_t LOOP_NS = 250000;
+        constexpr size_t LOOPS = 4000;
+        double update_ns = 0;
+        for (size_t l=0; l<LOOPS; ++l)
+            {
+                const double t = l * LOOP_NS / 1e9;
+                auto begin = std::chrono::steady_clock::now();
+                for (uint8_t c=0; c<PWM_CHANNELS_COUNT; ++c)
+                    {
+                        const double phase = 2 * M_PI * (0.5 + c * 0.37) * t;
+                        driver.set(c, static_cast<uint16_t>(2048 + 2047 * std::sin(phase)));
+                    }
+                assert(driver.update());
+                update_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+                sim::Clock::advance(LOOP_NS);
+            }
+        assert(bus.errors_count() == 0);
+        settle(driver);
+        check_outputs(driver);
+
+        const double seconds = LOOPS * LOOP_NS / 1e9;
+        const double naive_load = LOOPS * PWM_CHANNELS_COUNT
+            * bus.transaction_ns(1 + PCA_REGISTERS_PER_CHANNEL) / (seconds * 1e9);
+        printf("\t%.0f frames/s, %.1f%% bus load, %.0f ns per loop (16 LFOs computed and set, an update)\n",
+            bus.transactions() / seconds, 100.0 * bus.busy_ns() / (seconds * 1e9), update_ns / LOOPS);
+        printf("\tone transaction per channel would need %.0f%% of the bus\n", 100 * naive_load);
+        /* a whole frame takes about 1.5ms at 400kHz: bursts carry the latest values, every seventh loop */
+        assert(bus.transactions() >= LOOPS / 8);
+        assert(naive_load > 1);
+    }
+
+    std::cout << "Testing bus shared with the leds" << std::endl;
+    {
+        /* 500us column steps, the fastest refresh of the pads scan */
+        hw::leds_driver::DriverDefaultSettings::RefreshRate = 250;
+        constexpr uint64_t DURATION_NS = 1000000000;
+        const unsigned long period = 1000000UL / (250 * hw::leds_driver::MULTIPLEX_COLUMS_COUNT);
+
+        printf("\t%-22s %8s %10s %14s %8s\n", "", "bursts", "steps", "max blank(us)", "errors");
+        uint64_t blind_blank = 0;
+        for (bool shared: {false, true})
+            {
+                reset();
+                leds.reset();
+                leds_type leds_driver;
+                driver_type driver;
+                assert(leds_driver.setup() && driver.setup());
+
+                const bool ok = run_shared(leds_driver, driver, DURATION_NS, shared, true);
+                const unsigned long steps = leds_driver.steps_count();
+                printf("\t%-22s %8lu %10lu %14.1f %8lu\n", shared ? "within leds time left" : "whenever the bus is idle",
+                    driver.counters().bursts, steps, leds.max_blank_ns / 1e3, bus.errors_count());
+
+                assert(ok && bus.errors_count() == 0);
+                if (!shared)
+                    {
+                        blind_blank = leds.max_blank_ns;
+                        continue;
+                    }
+
+                /* bursts never delay a column step, values keep flowing */
+                assert(leds.max_blank_ns < 200000 && leds.max_blank_ns < blind_blank);
+                assert(steps >= DURATION_NS / 1000 / period - 2);
+                assert(driver.counters().bursts > 500);
+                for (int i=0; !driver.is_idle(); ++i)
+                    {
+                        assert(i < 100);
+                        run_shared(leds_driver, driver, period * 1000, true, false);
+                    }
+                check_outputs(driver);
+                for (const sim::MCP23017& mcp: leds.mcps)
+                    { assert(mcp.reg(sim::MCP23017::IODIRA) == 0x00); }
+
+                /* chip failures are reported by the PWM driver only */
+                chip.set_nak(true);
+                assert(driver.set(3, 42));
+                assert(run_shared(leds_driver, driver, 20000000, true, false));
+                assert(driver.counters().errors > 0 && driver.dirty() == (1 << 3));
+                chip.set_nak(false);
+                for (int i=0; !driver.is_idle(); ++i)
+                    {
+                        assert(i < 100);
+                        assert(run_shared(leds_driver, driver, period * 1000, true, false));
+                    }
+                check_outputs(driver);
+            }
+        assert(blind_blank > period * 1000);
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,34 @@
+/**
+ * Virtual time shared by every simulated peripheral
+ */
+
+#ifndef DEF_SIM_CLOCK_HPP
+#define DEF_SIM_CLOCK_HPP
+
+#include <cstdint>
+
+namespace sim
+{
+
+/**
+ * Simulated time only moves when the simulation advances it,
+ *  so results do not depend on the host machine
+ */
+struct Clock
+{
+    using time_point = uint64_t; /**< nanoseconds since reset */
+
+    static void reset()                     { _now = 0; }
+    static void advance(time_point ns)      { _now += ns; }
+
+    static time_point now()                 { return _now; }
+    static unsigned long micros()           { return static_cast<unsigned long>(_now / 1000); }
+    static unsigned long millis()           { return static_cast<unsigned long>(_now / 1000000); }
+
+private:
+    inline static time_point _now = 0;
+};
+
+} /* endof namespace sim */
+
+#endif /* DEF_SIM_CLOCK_HPP */
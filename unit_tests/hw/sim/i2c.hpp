@@ -0,0 +1,156 @@
+/**
+ * Cycle approximate model of an i2c bus, driven by the virtual clock
+ */
+
+#ifndef DEF_SIM_I2C_HPP
+#define DEF_SIM_I2C_HPP
+
+#include "clock.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace sim
+{
+
+/**
+ * Mirrors teensy4_i2c error codes used by the drivers
+ */
+enum class I2CError: uint8_t
+    { ok=0, master_not_ready, address_nak, data_nak };
+
+/**
+ * A slave attached to a simulated bus
+ */
+struct I2CDevice
+{
+    virtual ~I2CDevice()                    = default;
+
+    virtual uint16_t address() const        = 0;
+
+    /**
+     * Called when a write transaction completes on the wire,
+     *  returns false to NAK the first data byte
+     */
+    virtual bool on_write(const uint8_t* datas, size_t num_bytes) = 0;
+};
+
+/**
+ * Bus timings expressed in SCL periods, defaults follows fast-mode minimums
+ */
+struct I2CTiming
+{
+    double start_bits       = 1.0;  /**< tSU;STA + tHD;STA */
+    double stop_bits        = 1.0;  /**< tSU;STO */
+    double bus_free_bits    = 0.5;  /**< tBUF before next start */
+    uint32_t launch_ns      = 500;  /**< time to fill master FIFO before start */
+};
+
+/**
+ * Emulates teensy4_i2c @c I2CMaster: @c write_async returns immediately,
+ *  bytes reach the device once the virtual clock passes the end of transaction.
+ *
+ *  A write costs: start + (address + ack) + bytes * (8 bits + ack) + stop + bus free time
+ */
+class I2CMaster
+{
+public:
+    static constexpr const size_t MaxDevices = 8;
+
+    void begin(uint32_t frequency)          { _frequency = frequency; _end = 0; _busy = false; _error = I2CError::ok; }
+
+    void attach(I2CDevice& device)          { if (_devices_count < MaxDevices) { _devices[_devices_count++] = &device; } }
+
+    I2CTiming& timing()                     { return _timing; }
+
+    /** Returns transaction duration in ns for given payload, at given clock */
+    uint64_t transaction_ns(size_t num_bytes, bool send_stop=true) const
+        {
+            const double bits = _timing.start_bits + 9.0 * (num_bytes + 1)
+                + (send_stop ? _timing.stop_bits + _timing.bus_free_bits : 0.0);
+            return _timing.launch_ns + static_cast<uint64_t>(bits * 1e9 / _frequency);
+        }
+
+    void write_async(uint16_t address, const uint8_t* buffer, size_t num_bytes, bool send_stop)
+        {
+            if (!finished())
+                { _error = I2CError::master_not_ready; _errors_count += 1; return; }
+
+            _device = find(address);
+            _buffer = buffer;
+            _num_bytes = num_bytes;
+            _transferred = 0;
+            _error = I2CError::ok;
+            _busy = true;
+
+            /* unanswered address: stop right after the address byte */
+            const uint64_t duration = transaction_ns(_device ? num_bytes : 0, send_stop);
+            _end = Clock::now() + duration;
+
+            _busy_ns += duration;
+            _transactions += 1;
+            _bytes += 1 + (_device ? num_bytes : 0);
+        }
+
+    /** Polls the bus, completes the pending transaction once it's time is elapsed */
+    bool finished()
+        {
+            if (_busy && _end <= Clock::now())
+                { complete(); }
+            return !_busy;
+        }
+
+    bool has_error() const                  { return _error != I2CError::ok; }
+    I2CError error() const                  { return _error; }
+    size_t get_bytes_transferred() const    { return _transferred; }
+
+    /** Statistics */
+    uint64_t busy_ns() const                { return _busy_ns; }
+    size_t transactions() const             { return _transactions; }
+    size_t bytes() const                    { return _bytes; }
+    size_t errors_count() const             { return _errors_count; }
+
+    void reset_stats()                      { _busy_ns = 0; _transactions = 0; _bytes = 0; _errors_count = 0; }
+
+private:
+    I2CDevice* find(uint16_t address) const
+        {
+            for (size_t i=0; i<_devices_count; ++i)
+                { if (_devices[i]->address() == address) { return _devices[i]; } }
+            return nullptr;
+        }
+
+    void complete()
+        {
+            _busy = false;
+            if (nullptr == _device)
+                { _error = I2CError::address_nak; _errors_count += 1; return; }
+            if (!_device->on_write(_buffer, _num_bytes))
+                { _error = I2CError::data_nak; _errors_count += 1; return; }
+            _transferred = _num_bytes;
+        }
+
+    I2CTiming _timing{};
+    uint32_t _frequency = 400000;
+
+    std::array<I2CDevice*, MaxDevices> _devices{};
+    size_t _devices_count = 0;
+
+    I2CDevice* _device = nullptr;
+    const uint8_t* _buffer = nullptr;
+    size_t _num_bytes = 0;
+    size_t _transferred = 0;
+    I2CError _error = I2CError::ok;
+    bool _busy = false;
+    Clock::time_point _end = 0;
+
+    uint64_t _busy_ns = 0;
+    size_t _transactions = 0;
+    size_t _bytes = 0;
+    size_t _errors_count = 0;
+};
+
+} /* endof namespace sim */
+
+#endif /* DEF_SIM_I2C_HPP */
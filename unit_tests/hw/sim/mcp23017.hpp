@@ -0,0 +1,82 @@
+/**
+ * Register model of the MCP23017 i2c gpio expander
+ */
+
+#ifndef DEF_SIM_MCP23017_HPP
+#define DEF_SIM_MCP23017_HPP
+
+#include "i2c.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace sim
+{
+
+/**
+ * Models IOCON.BANK = 0 register map with sequential addressing:
+ *  first written byte selects the register, following ones auto-increment
+ */
+class MCP23017: public I2CDevice
+{
+public:
+    static constexpr const uint8_t IODIRA   = 0x00;
+    static constexpr const uint8_t IODIRB   = 0x01;
+    static constexpr const uint8_t GPIOA    = 0x12;
+    static constexpr const uint8_t GPIOB    = 0x13;
+    static constexpr const uint8_t OLATA    = 0x14;
+    static constexpr const uint8_t OLATB    = 0x15;
+    static constexpr const uint8_t REGISTERS_COUNT = 0x16;
+
+    explicit MCP23017(uint16_t address=0x20)
+        : _address{address}
+        { reset(); }
+
+    void reset()
+        {
+            _registers.fill(0x00);
+            _registers[IODIRA] = _registers[IODIRB] = 0xFF; /* power-on: all inputs */
+            _writes_count = 0;
+        }
+
+    uint16_t address() const override       { return _address; }
+
+    bool on_write(const uint8_t* datas, size_t num_bytes) override
+        {
+            if (num_bytes == 0)
+                { return true; }
+
+            uint8_t reg = datas[0];
+            for (size_t i=1; i<num_bytes; ++i)
+                {
+                    if (REGISTERS_COUNT <= reg)
+                        { return false; }
+                    /* writing GPIO writes the output latch */
+                    const uint8_t target = (reg == GPIOA || reg == GPIOB) ? reg + 2 : reg;
+                    _registers[target] = datas[i];
+                    reg += 1;
+                }
+            _writes_count += 1;
+            return true;
+        }
+
+    /** Returns levels driven on output pins, GPIOA on low significant byte */
+    uint16_t outputs() const
+        {
+            const uint16_t latch = (static_cast<uint16_t>(_registers[OLATB]) << 8) | _registers[OLATA];
+            const uint16_t dir = (static_cast<uint16_t>(_registers[IODIRB]) << 8) | _registers[IODIRA];
+            return latch & ~dir;
+        }
+
+    uint8_t reg(uint8_t r) const            { return _registers[r]; }
+    size_t writes_count() const             { return _writes_count; }
+
+private:
+    uint16_t _address;
+    std::array<uint8_t, REGISTERS_COUNT> _registers;
+    size_t _writes_count;
+};
+
+} /* endof namespace sim */
+
+#endif /* DEF_SIM_MCP23017_HPP */
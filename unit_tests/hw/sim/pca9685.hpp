@@ -0,0 +1,127 @@
+/**
+ * Register model of the PCA9685 i2c 16 channels PWM controller
+ */
+
+#ifndef DEF_SIM_PCA9685_HPP
+#define DEF_SIM_PCA9685_HPP
+
+#include "i2c.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace sim
+{
+
+/**
+ * Models the register map: first written byte selects the register,
+ *  following ones auto-increment only if MODE1.AI is set, otherwise they overwrite the same register.
+ *  Auto-increment rolls over from LED15_OFF_H to MODE1, as the chip does.
+ */
+class PCA9685: public I2CDevice
+{
+public:
+    static constexpr const uint8_t MODE1        = 0x00;
+    static constexpr const uint8_t MODE2        = 0x01;
+    static constexpr const uint8_t LED0_ON_L    = 0x06;
+    static constexpr const uint8_t LED15_OFF_H  = 0x45;
+    static constexpr const uint8_t PRE_SCALE    = 0xFE;
+
+    static constexpr const uint8_t MODE1_AI     = 0x20;
+    static constexpr const uint8_t MODE1_SLEEP  = 0x10;
+    static constexpr const uint8_t FULL_BIT     = 0x10;
+
+    static constexpr const uint64_t OSCILLATOR_STARTUP_NS = 500000;
+
+    explicit PCA9685(uint16_t address=0x40)
+        : _address{address}
+        { reset(); }
+
+    void reset()
+        {
+            _registers.fill(0x00);
+            _registers[MODE1] = MODE1_SLEEP | 0x01;     /* power-on: sleeping, answers all-call */
+            _registers[MODE2] = 0x04;
+            _registers[PRE_SCALE] = 0x1E;
+            for (uint8_t c=0; c<16; ++c)
+                { _registers[LED0_ON_L + 4 * c + 3] = FULL_BIT; }
+            _woken = 0;
+            _writes_count = 0;
+            _early_writes = 0;
+            _nak = false;
+        }
+
+    uint16_t address() const override       { return _address; }
+
+    bool on_write(const uint8_t* datas, size_t num_bytes) override
+        {
+            if (_nak)
+                { return false; }
+            if (num_bytes == 0)
+                { return true; }
+
+            uint8_t reg = datas[0];
+            for (size_t i=1; i<num_bytes; ++i)
+                {
+                    write(reg, datas[i]);
+                    if (_registers[MODE1] & MODE1_AI)
+                        { reg = reg == LED15_OFF_H ? MODE1 : reg + 1; }
+                }
+            _writes_count += 1;
+            return true;
+        }
+
+    /**
+     * Returns duty cycle of a channel in 4096th of period,
+     *  4096 for a full on output and 0 for a full off or sleeping one
+     */
+    uint16_t duty(uint8_t channel) const
+        {
+            const uint8_t* r = &_registers[LED0_ON_L + 4 * channel];
+            if (_registers[MODE1] & MODE1_SLEEP)
+                { return 0; }
+            if (r[3] & FULL_BIT)
+                { return 0; }
+            if (r[1] & FULL_BIT)
+                { return 4096; }
+            const uint16_t on = ((r[1] & 0x0F) << 8) | r[0];
+            const uint16_t off = ((r[3] & 0x0F) << 8) | r[2];
+            return (off - on) & 0x0FFF;
+        }
+
+    /** Output frequency in Hz */
+    double frequency() const                { return 25e6 / (4096.0 * (_registers[PRE_SCALE] + 1)); }
+
+    /** Makes every following transaction fail, as an unpowered chip would */
+    void set_nak(bool nak)                  { _nak = nak; }
+
+    uint8_t reg(uint8_t r) const            { return _registers[r]; }
+    size_t writes_count() const             { return _writes_count; }
+
+    /** Channel registers written before the oscillator had time to start */
+    size_t early_writes() const             { return _early_writes; }
+
+private:
+    void write(uint8_t reg, uint8_t value)
+        {
+            if (reg == PRE_SCALE && !(_registers[MODE1] & MODE1_SLEEP))
+                { return; }
+            if (reg == MODE1 && (_registers[MODE1] & MODE1_SLEEP) && !(value & MODE1_SLEEP))
+                { _woken = Clock::now(); }
+            if (LED0_ON_L <= reg && reg <= LED15_OFF_H && !(_registers[MODE1] & MODE1_SLEEP)
+                && Clock::now() < _woken + OSCILLATOR_STARTUP_NS)
+                { _early_writes += 1; }
+            _registers[reg] = value;
+        }
+
+    uint16_t _address;
+    std::array<uint8_t, 256> _registers;
+    Clock::time_point _woken;
+    size_t _writes_count;
+    size_t _early_writes;
+    bool _nak;
+};
+
+} /* endof namespace sim */
+
+#endif /* DEF_SIM_PCA9685_HPP */
@@ -0,0 +1,84 @@
+/**
+ * Mechanical switch model with contact bounce
+ */
+
+#ifndef DEF_SIM_SWITCH_HPP
+#define DEF_SIM_SWITCH_HPP
+
+#include "clock.hpp"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+namespace sim
+{
+
+/**
+ * Bounce parameters, a transition chatters during a random duration
+ *  with random intervals between contact toggles
+ */
+struct BounceModel
+{
+    Clock::time_point max_bounce_ns     = 5000000;  /**< bounce lasts up to 5ms */
+    Clock::time_point min_toggle_ns     = 20000;
+    Clock::time_point max_toggle_ns     = 400000;
+};
+
+/**
+ * Precomputed timeline of a switch contact, queried at any virtual time
+ */
+class Switch
+{
+public:
+    struct transition
+    {
+        Clock::time_point time;
+        bool closed;
+    };
+
+    /**
+     * Schedules a press or release at @c time, followed by bounce,
+     *  transitions must be scheduled in order and apart from more than the bounce duration
+     */
+    template <typename Rand>
+    void schedule(Clock::time_point time, bool closed, const BounceModel& model, Rand& rand)
+        {
+            _edges.push_back({time, closed});
+            _timeline.push_back({time, closed});
+
+            std::uniform_int_distribution<Clock::time_point> duration(0, model.max_bounce_ns);
+            std::uniform_int_distribution<Clock::time_point> toggle(model.min_toggle_ns, model.max_toggle_ns);
+
+            const Clock::time_point end = time + duration(rand);
+            Clock::time_point t = time + toggle(rand);
+            bool level = !closed;
+            while (t < end)
+                {
+                    _timeline.push_back({t, level});
+                    level = !level;
+                    t += toggle(rand);
+                }
+            /* settle on the requested state */
+            if (_timeline.back().closed != closed)
+                { _timeline.push_back({end, closed}); }
+        }
+
+    bool is_closed(Clock::time_point t) const
+        {
+            auto it = std::upper_bound(_timeline.begin(), _timeline.end(), t,
+                [](Clock::time_point v, const transition& tr) { return v < tr.time; });
+            return it == _timeline.begin() ? false : (it -1)->closed;
+        }
+
+    /** Clean transitions, as seen by the user */
+    const std::vector<transition>& edges() const    { return _edges; }
+
+private:
+    std::vector<transition> _timeline;
+    std::vector<transition> _edges;
+};
+
+} /* endof namespace sim */
+
+#endif /* DEF_SIM_SWITCH_HPP */
@@ -0,0 +1,62 @@
+/**
+ * Model of a MIDI serial transmitter, driven by the virtual clock
+ */
+
+#ifndef DEF_SIM_UART_HPP
+#define DEF_SIM_UART_HPP
+
+#include "clock.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+namespace sim
+{
+
+/**
+ * Transmitter at 31250 bauds, 10 bits per byte: bytes are accepted while @c capacity
+ *  is not reached by the ones not sent yet, then go on the wire one after the other.
+ *  Records when each byte starts on the wire
+ */
+struct Uart
+{
+    static constexpr const Clock::time_point BYTE_NS = 320000;
+
+    /** Transmit FIFO of the hardware serial ports */
+    static constexpr const size_t FIFO_SIZE = 4;
+
+    size_t capacity = FIFO_SIZE;            ///< bytes accepted ahead of the wire, FIFO and software buffer
+    std::vector<uint8_t> bytes;
+    std::vector<unsigned long> starts;      ///< wire start of each byte in us
+    Clock::time_point busy_until = 0;       ///< end of the last byte on the wire
+
+    /** Bytes accepted and not sent yet, the one on the wire included */
+    size_t pending() const
+        {
+            const Clock::time_point now = Clock::now();
+            if (busy_until <= now)
+                { return 0; }
+            return (busy_until - now + BYTE_NS -1) / BYTE_NS;
+        }
+
+    size_t available() const                { return capacity - std::min(capacity, pending()); }
+
+    size_t write(const uint8_t* data, size_t count)
+        {
+            count = std::min(count, available());
+            for (size_t i=0; i<count; ++i)
+                {
+                    const Clock::time_point start = std::max(Clock::now(), busy_until);
+                    bytes.push_back(data[i]);
+                    starts.push_back(static_cast<unsigned long>(start / 1000));
+                    busy_until = start + BYTE_NS;
+                }
+            return count;
+        }
+};
+
+} /* endof namespace sim */
+
+#endif /* DEF_SIM_UART_HPP */
@@ -0,0 +1,293 @@
+
+#include "midi/midi_clock/midi_clock.h"
+#include "midi/midi_input/midi_input.h"
+
+#include "../../hw/sim/clock.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <algorithm>
+
+using namespace midi;
+using namespace midi::midi_clock;
+
+using follower_type = ClockFollower<>;
+
+/** Tick period in us of a tempo in beats per minute */
+static double period_us(double bpm)
+{
+    return 60e6 / (bpm * TICKS_PER_QUARTER);
+}
+
+/**
+ * Clock source: ideal tick times follow a tempo curve,
+ *  ticks are received with a uniform jitter and read by a polling main loop
+ */
+struct Source
+{
+    std::vector<double> ideal;      ///< ideal tick times in us
+    std::vector<double> arrival;    ///< reception times in us, ordered
+
+    /** Tempo ramping linearly from @c from to @c to beats per minute during @c duration_s */
+    static Source make(double from, double to, double duration_s, double jitter_us, uint32_t seed)
+        {
+            std::mt19937 rand(seed);
+            std::uniform_real_distribution<double> jitter(-jitter_us, jitter_us);
+            Source source;
+            double t = 1000;
+            while (t < duration_s * 1e6)
+                {
+                    source.ideal.push_back(t);
+                    source.arrival.push_back(std::max(source.arrival.empty() ? 0 : source.arrival.back(), t + jitter(rand)));
+                    t += period_us(from + (to - from) * t / (duration_s * 1e6));
+                }
+            return source;
+        }
+};
+
+struct Stats
+{
+    double mean = 0;
+    double rms = 0;         ///< around the mean
+    double peak = 0;        ///< peak to peak
+
+    static Stats of(const std::vector<double>& values)
+        {
+            Stats s;
+            if (values.empty())
+                { return s; }
+            for (double v: values) { s.mean += v; }
+            s.mean /= values.size();
+            for (double v: values) { s.rms += (v - s.mean) * (v - s.mean); }
+            s.rms = std::sqrt(s.rms / values.size());
+            const auto range = std::minmax_element(values.begin(), values.end());
+            s.peak = *range.second - *range.first;
+            return s;
+        }
+};
+
+struct Report
+{
+    Stats input;            ///< reception time of ticks against ideal ticks
+    Stats output;           ///< interpolated quarter ticks against ideal positions
+    Stats tempo;            ///< estimated tempo against true tempo, in BPM
+    size_t lock_ticks = 0;  ///< ticks received before the lock
+};
+
+/**
+ * Main loop polling every @c loop_us: received ticks are timestamped when read,
+ *  events are scheduled every quarter of tick and fired when the interpolated position reaches them.
+ *  Statistics skip the first @c settle_ticks.
+ */
+static Report follow(const Source& source, double loop_us, size_t settle_ticks)
+{
+    sim::Clock::reset();
+    follower_type follower;
+    follower.start();
+
+    Report report;
+    std::vector<double> input, output, tempo;
+    size_t received = 0;
+    position_type target = 0;
+    const position_type step = TICK / 4;
+    const double end = source.arrival.back();
+
+    while (sim::Clock::micros() < end)
+        {
+            const unsigned long now = sim::Clock::micros();
+            while (received < source.arrival.size() && source.arrival[received] <= now)
+                {
+                    follower.tick(now);
+                    if (received >= settle_ticks)
+                        {
+                            input.push_back(now - source.ideal[received]);
+                            const double interval = source.ideal[received] - source.ideal[received -1];
+                            tempo.push_back(follower.tempo() / 100.0 - 60e6 / (interval * TICKS_PER_QUARTER));
+                        }
+                    if (!report.lock_ticks && follower.locked())
+                        { report.lock_ticks = received + 1; }
+                    received += 1;
+                }
+            follower.update(now);
+
+            const position_type p = follower.position(now);
+            while (target <= p)
+                {
+                    const size_t tick = target >> SUBTICK_BITS;
+                    if (tick >= settle_ticks && tick + 1 < source.ideal.size())
+                        {
+                            const double fraction = static_cast<double>(target & (TICK -1)) / TICK;
+                            const double ideal = source.ideal[tick] + fraction * (source.ideal[tick + 1] - source.ideal[tick]);
+                            output.push_back(now - ideal);
+                        }
+                    target += step;
+                }
+            sim::Clock::advance(static_cast<sim::Clock::time_point>(loop_us * 1000));
+        }
+
+    report.input = Stats::of(input);
+    report.output = Stats::of(output);
+    report.tempo = Stats::of(tempo);
+    return report;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing steady clock" << std::endl;
+    {
+        follower_type follower;
+        assert(follower.tempo() == 0 && follower.position(0) == 0);
+        follower.start();
+
+        /* 120 BPM: 20833.33us per tick */
+        const double period = period_us(120);
+        unsigned long t = 0;
+        for (int i=0; i<96; ++i)
+            {
+                t = static_cast<unsigned long>(1000000 + i * period);
+                follower.tick(t);
+                if (i == 0)
+                    { assert(follower.position(t) == 0); }
+            }
+        assert(follower.locked());
+        assert(follower.tempo() >= 11999 && follower.tempo() <= 12001);
+        assert(follower.position(t) >> SUBTICK_BITS == 95);
+
+        /* half way to next tick */
+        const position_type half = follower.position(t + period / 2) - (95 * TICK);
+        assert(half > TICK / 2 - TICK / 100 && half < TICK / 2 + TICK / 100);
+        assert(std::fabs(static_cast<double>(follower.time_of(96 * TICK)) - (t + period)) <= 2);
+
+        /* never more than a tick past the next one until it is received */
+        assert(follower.position(t + 10 * period) == 97 * TICK -1);
+        follower.update(t + 10 * period);
+        assert(!follower.locked() && follower.counters().timeouts == 1);
+
+        /* a first interval overflowing 32 bits once in fixed point is not taken as a tempo */
+        follower_type late;
+        late.start();
+        late.tick(1000);
+        late.tick(static_cast<unsigned long>(1000 + (1UL << 24) + period));
+        assert(late.period() == 0 && late.tempo() == 0);
+    }
+
+    std::cout << "Testing transport" << std::endl;
+    {
+        midi_input::Parser parser;
+        follower_type follower;
+        const unsigned long period = 20000;
+        unsigned long t = 0;
+        auto send = [&](std::vector<uint8_t> bytes, size_t ticks) {
+                parser.feed(bytes.data(), bytes.size(), t);
+                midi_input::event e;
+                while (parser.poll(e))
+                    { if (!follower.feed(e)) { assert(e.status == 0x90); } }
+                for (size_t i=0; i<ticks; ++i)
+                    {
+                        t += period;
+                        follower.tick(t);
+                    }
+            };
+
+        /* clock runs before start: tempo is tracked, position does not move */
+        send({}, 48);
+        assert(follower.locked() && !follower.running() && follower.position(t) == 0);
+
+        send({0xFA}, 0);
+        assert(follower.running() && follower.position(t + period / 2) == 0);
+        send({}, 1);
+        assert(follower.position(t) == 0 && follower.position(t + period / 2) == TICK / 2);
+        send({}, 24);
+        assert(follower.position(t) >> SUBTICK_BITS == 24);
+
+        /* stop freezes on the last tick, continue moves on next tick */
+        send({0xFC}, 10);
+        assert(!follower.running() && follower.position(t + period / 2) == 24 * TICK);
+        send({0xFB}, 0);
+        assert(follower.position(t + period / 2) == 24 * TICK);
+        send({}, 1);
+        assert(follower.position(t) == 25 * TICK);
+
+        /* song position while running is ignored, while stopped moves to sixteenth notes */
+        send({0xF2, 0x10, 0x00}, 0);
+        assert(follower.position(t) == 25 * TICK);
+        send({0xFC, 0xF2, 0x05, 0x01}, 3);
+        const position_type spp = (0x05 + (0x01 << 7)) * TICKS_PER_SIXTEENTH;
+        assert(follower.position(t) == spp * TICK);
+        send({0xFB}, 1);
+        assert(follower.position(t) == spp * TICK);
+        send({}, 1);
+        assert(follower.position(t) == (spp + 1) * TICK);
+
+        /* start rewinds, realtime bytes inside a message */
+        send({0x90, 0x3C, 0xFA, 0x7F}, 1);
+        assert(follower.position(t) == 0);
+
+        /* other events are left to the caller */
+        midi_input::event e{0x90, 0x3C, 0x7F, 0, 0, 0};
+        assert(!follower.feed(e));
+    }
+
+    std::cout << "Testing acquisition" << std::endl;
+    {
+        follower_type follower;
+        follower.tick(0);
+        follower.tick(500);         /* 5000 BPM */
+        assert(follower.period() == 0);
+        follower.tick(20500);
+        assert(follower.period() == 20000 << PERIOD_FRACTION_BITS);
+
+        /* a missing tick restarts the acquisition, tempo is kept meanwhile */
+        follower.tick(40500);
+        follower.tick(80500);
+        assert(follower.counters().resyncs == 1 && follower.period() != 0);
+        follower.tick(100500);
+        assert(follower.period() == 20000 << PERIOD_FRACTION_BITS);
+    }
+
+    std::cout << "\nJittery clocks at 120 BPM, 20s, events every quarter of tick, 50us main loop" << std::endl;
+    printf("%10s | %10s %10s | %10s %10s %10s | %10s %6s\n",
+        "jitter", "in.rms", "in.p2p", "out.rms", "out.p2p", "out.lag", "tempo.rms", "lock");
+    for (double jitter: {0.0, 250.0, 1000.0, 2000.0, 4000.0})
+        {
+            const Source source = Source::make(120, 120, 20, jitter, 7);
+            const Report r = follow(source, 50, 96);
+            printf("%8.0fus | %8.0fus %8.0fus | %8.0fus %8.0fus %8.0fus | %8.2fbpm %6lu\n",
+                jitter, r.input.rms, r.input.peak, r.output.rms, r.output.peak, r.output.mean, r.tempo.rms, r.lock_ticks);
+
+            /* interpolated events are at least three times steadier than received ticks */
+            assert(r.output.rms < std::max(r.input.rms / 3, 50.0));
+            assert(r.output.peak < std::max(r.input.peak * 0.6, 200.0));
+            assert(std::fabs(r.output.mean) < 2 * jitter + 100);
+        }
+
+    std::cout << "\nTempo changes with 1ms jitter" << std::endl;
+    printf("%16s | %10s %10s | %10s %10s\n", "tempo", "out.rms", "out.p2p", "tempo.err", "tempo.rms");
+    /* the period slope over the period gain is a steady phase error: steep decelerations lag */
+    struct change { double from; double to; double duration_s; double max_rms_us; };
+    const change changes[] = {
+        {100, 140, 20, 400},
+        {160,  60, 40, 2000},
+        {300, 300, 10, 300},
+        { 30,  30, 40, 300},
+    };
+    for (const change& c: changes)
+        {
+            const Source source = Source::make(c.from, c.to, c.duration_s, 1000, 9);
+            const Report r = follow(source, 50, 96);
+            printf("%6.0f -> %3.0fbpm | %8.0fus %8.0fus | %8.2fbpm %8.2fbpm\n",
+                c.from, c.to, r.output.rms, r.output.peak, r.tempo.mean, r.tempo.rms);
+            assert(r.output.rms < c.max_rms_us && std::fabs(r.tempo.mean) < 1.0);
+        }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
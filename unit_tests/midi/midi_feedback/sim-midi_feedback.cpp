@@ -0,0 +1,437 @@
+
+#include "midi/midi_feedback/midi_feedback.h"
+#include "midi/midi_mapping/midi_mapping.h"
+#include "midi/midi_input/midi_input.h"
+#include "hw/leds_driver/leds_driver.h"
+
+#include "../../hw/sim/clock.hpp"
+#include "../../hw/sim/i2c.hpp"
+#include "../../hw/sim/mcp23017.hpp"
+
+#include <array>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <algorithm>
+
+using namespace midi;
+using namespace midi::midi_feedback;
+using namespace hw::leds_driver;
+using hw::pads::Pad;
+using hw::analog::Encoder;
+using midi_mapping::PADS_COUNT;
+using midi_mapping::Mappings;
+using midi_mapping::MappingTable;
+using midi_mapping::control_kind;
+
+static std::array<sim::I2CMaster, ANNODE_DRIVER_COUNT> masters;
+static std::array<sim::MCP23017, ANNODE_DRIVER_COUNT> mcps;
+static std::array<bool, 16> pins;
+
+/** Annodes words latched by the MCPs each time a column is powered */
+static std::array<std::array<uint16_t, ANNODE_DRIVER_COUNT>, MULTIPLEX_COLUMS_COUNT> panel;
+static bool powered = false;
+
+struct SimContext
+{
+    using master_type = sim::I2CMaster;
+
+    static master_type& i2c_master(annode_driver d)
+        { return masters[static_cast<uint8_t>(d)]; }
+
+    static void pin_mode_output(uint8_t pin)        {}
+    static void digital_write(uint8_t pin, bool level)
+        {
+            pins[pin] = level;
+            if (pin != CATHODE_ENABLE_PIN || level != CATHODE_ENABLE_LEVEL)
+                { return; }
+            const uint8_t column = (pins[CATHODE_ADDR_PINA0] ? 1 : 0)
+                | (pins[CATHODE_ADDR_PINA1] ? 2 : 0)
+                | (pins[CATHODE_ADDR_PINA2] ? 4 : 0);
+            for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+                { panel[column][i] = mcps[i].outputs(); }
+            powered = true;
+        }
+
+    static unsigned long micros()
+        { return sim::Clock::micros(); }
+};
+
+using driver_type = LedsDriver<SimContext>;
+
+static void reset_bench(unsigned long refresh_rate)
+{
+    DriverDefaultSettings::RefreshRate = refresh_rate;
+    sim::Clock::reset();
+    pins.fill(false);
+    for (auto& column: panel)
+        { column.fill(0); }
+    for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+        {
+            masters[i] = sim::I2CMaster{};
+            mcps[i].reset();
+            masters[i].attach(mcps[i]);
+        }
+}
+
+/** Expected leds after a redraw */
+struct Display
+{
+    std::array<pad_color, PADS_COUNT> pads{};
+    std::array<ledring_state, midi_mapping::ENCODERS_COUNT> rings{};
+
+    /** Returns true if the latched annodes words show this display */
+    bool shown() const
+        {
+            for (uint8_t p=0; p<PADS_COUNT; ++p)
+                {
+                    const Pad pad = static_cast<Pad>(p);
+                    if (hw::is_blind(pad))
+                        { continue; }
+                    const annode_pin pin = annode_of(pad);
+                    const uint16_t mask = hw::pads::is_bichrome(pad) ? 0b11 : 0b01;
+                    const uint16_t word = panel[hw::get_column(pad)][static_cast<uint8_t>(pin.driver)];
+                    if (((word >> pin.bit) & mask) != static_cast<uint16_t>(pads[p]))
+                        { return false; }
+                }
+            for (uint8_t e=0; e<midi_mapping::ENCODERS_COUNT; ++e)
+                {
+                    const Encoder encoder = static_cast<Encoder>(e);
+                    if (hw::is_blind(encoder))
+                        { continue; }
+                    const uint16_t word = panel[hw::get_column(encoder)][static_cast<uint8_t>(annode_of(encoder))];
+                    if ((word & 0xFFFE) != rings[e].word())
+                        { return false; }
+                }
+            return true;
+        }
+};
+
+/**
+ * Session view redraw as sent by the DAW when the session box moves:
+ *  every pad led, then led-ring styles and values, with running status
+ */
+struct Redraw
+{
+    std::vector<message> messages;
+    std::vector<uint8_t> bytes;
+    Display display;
+};
+
+static Redraw make_redraw(const MappingTable& table, uint32_t seed)
+{
+    std::mt19937 rand(seed);
+    Redraw redraw;
+
+    for (uint8_t p=0; p<PADS_COUNT; ++p)
+        {
+            const Pad pad = static_cast<Pad>(p);
+            const midi_mapping::outgoing& out = table.output(pad);
+            if (!out.is_bound() || table.input(out.status, out.data1).is_none())
+                { continue; }
+            const uint8_t velocity = rand() % 7;
+            redraw.messages.push_back(message{out.status, out.data1, velocity});
+            redraw.display.pads[p] = hw::pads::is_bichrome(pad)
+                ? color_of(velocity)
+                : (velocity ? pad_color::ON : pad_color::OFF);
+        }
+
+    /* ring styles controllers are found from the table, then values are sent */
+    std::array<ring_style, midi_mapping::ENCODERS_COUNT> styles;
+    styles.fill(ring_style::Single);
+    for (uint8_t channel=0; channel<midi_mapping::CHANNELS_COUNT; ++channel)
+        for (uint8_t cc=0; cc<midi_mapping::DATA_VALUES_COUNT; ++cc)
+            {
+                const uint8_t status = make_status(status::ControlChange, channel);
+                const midi_mapping::control c = table.input(status, cc);
+                if (c.kind != control_kind::RingStyle)
+                    { continue; }
+                styles[c.index] = static_cast<ring_style>(rand() % 4);
+                redraw.messages.push_back(message{status, cc, static_cast<uint8_t>(styles[c.index])});
+            }
+    for (uint8_t e=0; e<midi_mapping::ENCODERS_COUNT; ++e)
+        {
+            const midi_mapping::outgoing& out = table.output(static_cast<Encoder>(e));
+            if (!out.is_bound() || table.input(out.status, out.data1).is_none())
+                { continue; }
+            const uint8_t value = rand() & DATA_BITMASK;
+            redraw.messages.push_back(message{out.status, out.data1, value});
+            redraw.display.rings[e] = ring_of(styles[e], value);
+        }
+
+    uint8_t running = 0;
+    for (const auto& m: redraw.messages)
+        {
+            if (m.status != running)
+                { redraw.bytes.push_back(m.status); }
+            running = m.status;
+            redraw.bytes.push_back(m.data1);
+            redraw.bytes.push_back(m.data2);
+        }
+    return redraw;
+}
+
+struct Report
+{
+    double wire_ms = 0;         ///< last byte received, since the first one
+    double display_ms = 0;      ///< whole redraw shown, since the first byte
+    size_t batches = 0;         ///< loop iterations which received bytes
+    size_t frames = 0;
+};
+
+/**
+ * Replays a redraw at 31250 bauds on a main loop iterating every @c loop_ns,
+ *  each iteration reads received bytes, runs the fast path and advances the leds refresh
+ */
+static Report replay(const Redraw& redraw, const MappingTable& table, unsigned long refresh_rate,
+    sim::Clock::time_point loop_ns)
+{
+    reset_bench(refresh_rate);
+    driver_type driver;
+    driver.setup();
+    for (int i=0; i<1000 && driver.steps_count() < 2 * MULTIPLEX_COLUMS_COUNT; ++i)
+        {
+            driver.update();
+            sim::Clock::advance(loop_ns);
+        }
+
+    midi_input::Parser parser;
+    LedsFeedback feedback;
+    Report report;
+
+    const sim::Clock::time_point begin = sim::Clock::now();
+    size_t received = 0;
+    while (true)
+        {
+            const size_t arrived = std::min<size_t>(redraw.bytes.size(),
+                (sim::Clock::now() - begin) / (BYTE_DURATION_US * 1000) + 1);
+            if (arrived > received)
+                {
+                    parser.feed(redraw.bytes.data() + received, arrived - received, sim::Clock::micros());
+                    received = arrived;
+                    report.batches += 1;
+                    if (received == redraw.bytes.size())
+                        { report.wire_ms = (sim::Clock::now() - begin) / 1e6; }
+                }
+            feedback.process(parser, table, driver, [](const midi_input::event&) { assert(false); });
+
+            powered = false;
+            driver.update();
+            if (powered && received == redraw.bytes.size() && redraw.display.shown())
+                { break; }
+            sim::Clock::advance(loop_ns);
+            assert(sim::Clock::now() - begin < 2000000000);
+        }
+
+    report.display_ms = (sim::Clock::now() - begin) / 1e6;
+    report.frames = feedback.counters().frames;
+    assert(feedback.counters().applied == redraw.messages.size());
+    return report;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing palette and led-rings" << std::endl;
+    {
+        assert(color_of(0) == pad_color::OFF && color_of(1) == pad_color::GREEN && color_of(2) == pad_color::GREEN);
+        assert(color_of(3) == pad_color::RED && color_of(4) == pad_color::RED);
+        assert(color_of(5) == pad_color::ORANGE && color_of(6) == pad_color::ORANGE && color_of(127) == pad_color::GREEN);
+
+        assert(ring_of(ring_style::Off, 64).word() == 0);
+        assert(ring_of(ring_style::Single, 0).word() == 0x0002 && ring_of(ring_style::Single, 127).word() == 0x8000);
+        assert(ring_of(ring_style::Volume, 0).word() == 0x0002 && ring_of(ring_style::Volume, 127).word() == 0xFFFE);
+        assert(ring_of(ring_style::Pan, 64).word() == ledring_state::center().word());
+        assert(ring_of(ring_style::Pan, 0).word() == 0x01FE && ring_of(ring_style::Pan, 127).word() == 0xFF00);
+        for (uint8_t v=0; v<128; ++v)
+            {
+                assert(__builtin_popcount(ring_of(ring_style::Single, v).word()) == 1);
+                assert(ring_of(ring_style::Pan, v).word() & ledring_state::center().word());
+            }
+    }
+
+    std::cout << "Testing frames match single edits" << std::endl;
+    {
+        reset_bench(50);
+        driver_type direct, staged;
+        std::mt19937 rand(11);
+        leds_frame frame;
+        frame.clear();
+        for (int i=0; i<2000; ++i)
+            {
+                if (rand() & 1)
+                    {
+                        const Pad pad = static_cast<Pad>(rand() % PADS_COUNT);
+                        const pad_color color = static_cast<pad_color>(rand() & 0b11);
+                        assert(static_cast<bool>(direct.set_state(pad, color)) == frame.set(pad, color));
+                    }
+                else
+                    {
+                        const Encoder encoder = static_cast<Encoder>(rand() % midi_mapping::ENCODERS_COUNT);
+                        const ledring_state ring{static_cast<uint8_t>(rand() % 15), static_cast<uint8_t>(rand() % 16)};
+                        assert(static_cast<bool>(direct.set_state(encoder, ring)) == frame.set(encoder, ring));
+                    }
+                if (rand() % 64 == 0)
+                    {
+                        staged.commit(frame);
+                        frame.clear();
+                        assert(frame.is_empty());
+                    }
+            }
+        staged.commit(frame);
+        for (uint8_t p=0; p<PADS_COUNT; ++p)
+            {
+                pad_color a, b;
+                const bool valid = direct.get_state(static_cast<Pad>(p), &a);
+                assert(valid == static_cast<bool>(staged.get_state(static_cast<Pad>(p), &b)));
+                assert(!valid || a == b);
+            }
+        for (uint8_t e=0; e<midi_mapping::ENCODERS_COUNT; ++e)
+            {
+                ledring_state a, b;
+                if (direct.get_state(static_cast<Encoder>(e), &a))
+                    {
+                        staged.get_state(static_cast<Encoder>(e), &b);
+                        assert(a.word() == b.word());
+                    }
+            }
+    }
+
+    Mappings mappings;
+    assert(mappings.setup());
+
+    std::cout << "Testing events staging" << std::endl;
+    {
+        reset_bench(50);
+        driver_type driver;
+        midi_input::Parser parser;
+        LedsFeedback feedback;
+        const MappingTable& table = mappings.active();
+
+        const uint8_t bytes[] = {
+            0x92, 0x35, 0x03,       /* clip 0 of track 2 red */
+            0x36, 0x05,             /* running status: clip 1 yellow */
+            0x82, 0x35, 0x00,       /* clip 0 off */
+            0xB0, 0x38, 0x03,       /* pan style for track 0 knob */
+            0x30, 0x40,             /* track 0 knob value, centered */
+            0x07, 0x10,             /* unbound controller */
+            0xF8,                   /* clock */
+            0x90, 0x51, 0x7F,       /* stop all clips is blind */
+        };
+        parser.feed(bytes, sizeof(bytes), 0);
+
+        std::vector<uint8_t> others;
+        assert(feedback.process(parser, table, driver, [&](const midi_input::event& e) { others.push_back(e.status); }) == 8);
+        assert((others == std::vector<uint8_t>{0xB0, 0xF8, 0x90}));
+        assert(feedback.counters().frames == 1 && feedback.counters().applied == 5 && feedback.counters().forwarded == 3);
+        assert(feedback.frame().is_empty());
+
+        pad_color color;
+        driver.get_state(hw::pads::CLIP_Y_X[0][2], &color);
+        assert(color == pad_color::OFF);
+        driver.get_state(hw::pads::CLIP_Y_X[1][2], &color);
+        assert(color == pad_color::ORANGE);
+        ledring_state ring;
+        driver.get_state(Encoder::PAN_0, &ring);
+        assert(ring.word() == ledring_state::center().word());
+        assert(feedback.style(Encoder::PAN_0) == ring_style::Pan && feedback.value(Encoder::PAN_0) == 0x40);
+
+        /* a style change redraws the current value */
+        const uint8_t style[] = {0xB0, 0x38, 0x02};
+        parser.feed(style, sizeof(style), 0);
+        feedback.process(parser, table, driver, [](const midi_input::event&) {});
+        driver.get_state(Encoder::PAN_0, &ring);
+        assert(ring.word() == ring_of(ring_style::Volume, 0x40).word());
+
+        /* nothing staged, nothing committed */
+        assert(feedback.process(parser, table, driver, [](const midi_input::event&) {}) == 0);
+        assert(feedback.counters().frames == 2);
+    }
+
+    std::cout << "\nSession redraw replayed at 31250 bauds" << std::endl;
+    printf("%10s %8s %8s | %8s %8s | %10s %10s %8s\n",
+        "mode", "loop", "refresh", "messages", "bytes", "wire", "display", "frames");
+    for (auto m: {midi_mapping::mode::Apc40, midi_mapping::mode::Extended})
+        for (sim::Clock::time_point loop_ns: {20000ULL, 500000ULL})
+            for (unsigned long rate: {50UL, 125UL, 250UL})
+                {
+                    mappings.select(m);
+                    const Redraw redraw = make_redraw(mappings.active(), 3);
+                    const Report r = replay(redraw, mappings.active(), rate, loop_ns);
+
+                    printf("%10s %6.0fus %6luHz | %8lu %8lu | %8.2fms %8.2fms %8lu\n",
+                        m == midi_mapping::mode::Apc40 ? "apc40" : "extended", loop_ns / 1e3, rate,
+                        redraw.messages.size(), redraw.bytes.size(), r.wire_ms, r.display_ms, r.frames);
+
+                    /* a frame per reception batch at most, display follows the wire by a refresh period,
+                     *  slow loops stretch column steps, which take three updates */
+                    const double step_ms = std::max(1000.0 / (rate * MULTIPLEX_COLUMS_COUNT), 3 * loop_ns / 1e6);
+                    assert(r.frames <= r.batches);
+                    assert(r.display_ms - r.wire_ms < MULTIPLEX_COLUMS_COUNT * step_ms + 2 * loop_ns / 1e6 + 1.0);
+                }
+
+    std::cout << "\nBenchmark: parse, map and commit a redraw" << std::endl;
+    {
+        mappings.select(midi_mapping::mode::Apc40);
+        const MappingTable& table = mappings.active();
+        const Redraw redraw = make_redraw(table, 5);
+        constexpr size_t ITERATIONS = 20000;
+
+        reset_bench(50);
+        driver_type driver;
+        midi_input::Parser parser;
+        LedsFeedback feedback;
+        size_t others = 0;
+
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t i=0; i<ITERATIONS; ++i)
+            {
+                /* reception chunks as read from the serial port */
+                for (size_t b=0; b<redraw.bytes.size(); b+=midi_input::RX_CHUNK_SIZE)
+                    {
+                        const size_t n = std::min(midi_input::RX_CHUNK_SIZE, redraw.bytes.size() - b);
+                        parser.feed(redraw.bytes.data() + b, n, 0);
+                        feedback.process(parser, table, driver, [&](const midi_input::event&) { others += 1; });
+                    }
+            }
+        const double fast_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count()
+            / (ITERATIONS * redraw.messages.size());
+        assert(others == 0);
+
+        /* same path, one driver edit per message */
+        begin = std::chrono::steady_clock::now();
+        for (size_t i=0; i<ITERATIONS; ++i)
+            {
+                for (size_t b=0; b<redraw.bytes.size(); b+=midi_input::RX_CHUNK_SIZE)
+                    {
+                        const size_t n = std::min(midi_input::RX_CHUNK_SIZE, redraw.bytes.size() - b);
+                        parser.feed(redraw.bytes.data() + b, n, 0);
+                        midi_input::event e;
+                        while (parser.poll(e))
+                            {
+                                const midi_mapping::control c = table.input(e.status, e.data1);
+                                if (c.kind == control_kind::Pad)
+                                    { driver.set_state(static_cast<Pad>(c.index), color_of(e.data2)); }
+                                else if (c.kind == control_kind::Encoder)
+                                    { driver.set_state(static_cast<Encoder>(c.index), ring_of(ring_style::Single, e.data2)); }
+                            }
+                    }
+            }
+        const double direct_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count()
+            / (ITERATIONS * redraw.messages.size());
+
+        printf("\t%lu messages in %lu bytes\n", redraw.messages.size(), redraw.bytes.size());
+        printf("\tfast path %.2f ns/message, per message edits %.2f ns/message\n", fast_ns, direct_ns);
+        printf("\tredraw processed in %.2f us, received in %.2f ms\n",
+            fast_ns * redraw.messages.size() / 1e3, redraw.bytes.size() * BYTE_DURATION_US / 1e3);
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,382 @@
+
+#include "midi/midi_input/midi_input.h"
+#include "midi/midi_output/midi_output.h"
+
+#include <array>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <cassert>
+#include <random>
+
+using namespace midi;
+using namespace midi::midi_input;
+
+using bytes = std::vector<uint8_t>;
+
+/** Parsed message, independent of the parser storage */
+struct parsed
+{
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+    bytes sysex;
+
+    bool operator== (const parsed& other) const
+        { return status == other.status && data1 == other.data1 && data2 == other.data2 && sysex == other.sysex; }
+};
+
+/**
+ * Straightforward reference parser, as described by the MIDI specification,
+ *  system exclusive messages completed within a chunk are held until the chunk end
+ */
+static std::vector<parsed> reference_parse(const bytes& stream, size_t chunk)
+{
+    std::vector<parsed> out;
+    uint8_t running = 0;
+    bytes pending;
+    bool sysex = false;
+    bytes message;
+    bool overflow = false;          ///< message once exceeded the room left by held ones
+    size_t held = 0;
+
+    for (size_t i=0; i<stream.size(); ++i)
+        {
+            const uint8_t byte = stream[i];
+            if (i % chunk == 0)
+                { held = 0; }
+            if (byte >= 0xF8)
+                {
+                    if (byte != 0xF9 && byte != 0xFD)
+                        { out.push_back({byte, 0, 0, {}}); }
+                    continue;
+                }
+            if (sysex)
+                {
+                    if (byte < 0x80 || byte == 0xF7)
+                        {
+                            message.push_back(byte);
+                            overflow |= SYSEX_BUFFER_SIZE < held + message.size();
+                        }
+                    if (byte < 0x80)
+                        { continue; }
+                    sysex = false;
+                    if (byte == 0xF7)
+                        {
+                            if (!overflow)
+                                {
+                                    out.push_back({0xF0, 0, 0, message});
+                                    held += message.size();
+                                }
+                            continue;
+                        }
+                }
+            if (byte >= 0x80)
+                {
+                    running = 0;
+                    pending.clear();
+                    if (byte == 0xF0)
+                        {
+                            sysex = true;
+                            message = {byte};
+                            overflow = SYSEX_BUFFER_SIZE < held + message.size();
+                        }
+                    else if (byte == 0xF6)
+                        { out.push_back({byte, 0, 0, {}}); }
+                    else if (data_size(byte) > 0)
+                        { running = byte; }
+                    continue;
+                }
+            if (!running)
+                { continue; }
+            pending.push_back(byte);
+            if (pending.size() == data_size(running))
+                {
+                    out.push_back({running, pending[0], pending.size() > 1 ? pending[1] : uint8_t(0), {}});
+                    pending.clear();
+                    if (running >= 0xF0)
+                        { running = 0; }
+                }
+        }
+    return out;
+}
+
+static parsed copy_of(const Parser& parser, const event& e)
+{
+    parsed p{e.status, e.data1, e.data2, {}};
+    if (e.is_sysex())
+        {
+            const sysex_span span = parser.sysex(e);
+            for (size_t i=0; i<span.size(); ++i)
+                { p.sysex.push_back(span[i]); }
+        }
+    return p;
+}
+
+/** Feeds the stream in chunks, draining events after each of them */
+static std::vector<parsed> parse(Parser& parser, const bytes& stream, size_t chunk=1)
+{
+    std::vector<parsed> out;
+    for (size_t i=0; i<stream.size(); i+=chunk)
+        {
+            parser.feed(stream.data() + i, std::min(chunk, stream.size() - i), 0);
+            event e;
+            while (parser.poll(e))
+                { out.push_back(copy_of(parser, e)); }
+        }
+    return out;
+}
+
+/**
+ * Valid traffic with realtime bytes interleaved anywhere,
+ *  channel messages are encoded with running status
+ */
+template <typename Rand>
+static bytes traffic(size_t size, Rand& rand, unsigned sysex_percent=2, size_t sysex_max=64)
+{
+    static const uint8_t REALTIME[] = {0xF8, 0xFA, 0xFB, 0xFC, 0xFE};
+    midi_output::OutputDefaultSettings::NoteOffAsNoteOn = false;
+    midi_output::OutputDefaultSettings::StatusRefreshPeriod = 0;
+    midi_output::RunningStatus<> encoder;
+
+    std::uniform_int_distribution<int> percent(0, 99);
+    bytes stream;
+    while (stream.size() < size)
+        {
+            bytes message;
+            const int kind = percent(rand);
+            if (kind < static_cast<int>(sysex_percent))
+                {
+                    message.push_back(0xF0);
+                    const size_t length = rand() % sysex_max;
+                    for (size_t i=0; i<length; ++i)
+                        { message.push_back(rand() & 0x7F); }
+                    message.push_back(0xF7);
+                    encoder.cancel();
+                }
+            else if (kind < 4)
+                {
+                    message = {0xF2, static_cast<uint8_t>(rand() & 0x7F), static_cast<uint8_t>(rand() & 0x7F)};
+                    encoder.cancel();
+                }
+            else
+                {
+                    static const status TYPES[] = {status::NoteOn, status::NoteOn, status::NoteOff, status::ControlChange,
+                        status::ControlChange, status::ProgramChange, status::PitchBend};
+                    const midi::message msg{make_status(TYPES[rand() % 7], rand() % 3),
+                        static_cast<uint8_t>(rand() & 0x7F), static_cast<uint8_t>(rand() & 0x7F)};
+                    uint8_t encoded[midi_output::MESSAGE_MAX_SIZE];
+                    const uint8_t count = encoder.encode(msg, 0, encoded);
+                    encoder.commit(encoded, count, 0);
+                    message.assign(encoded, encoded + count);
+                }
+            for (uint8_t byte: message)
+                {
+                    if (percent(rand) < 3)
+                        { stream.push_back(REALTIME[rand() % 5]); }
+                    stream.push_back(byte);
+                }
+        }
+    return stream;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing running status and interleaved realtime" << std::endl;
+    {
+        Parser parser;
+        const bytes stream = {
+            0x90, 0x3C, 0xF8, 0x64,     /* clock inside a note */
+            0x3E, 0x64,                 /* running status */
+            0xF8, 0xB1, 0x07, 0x10,
+            0x07, 0xFA, 0x11,
+            0xC2, 0x05, 0x06,
+            0xF2, 0x10, 0x00,
+            0x3C, 0x64,                 /* stray data, no running status after system common */
+            0xF6,
+            0x90, 0x3C,                 /* interrupted by a status byte */
+            0x80, 0x3C, 0x40,
+        };
+        const std::vector<parsed> expected = {
+            {0xF8, 0, 0, {}}, {0x90, 0x3C, 0x64, {}}, {0x90, 0x3E, 0x64, {}},
+            {0xF8, 0, 0, {}}, {0xB1, 0x07, 0x10, {}}, {0xFA, 0, 0, {}}, {0xB1, 0x07, 0x11, {}},
+            {0xC2, 0x05, 0, {}}, {0xC2, 0x06, 0, {}}, {0xF2, 0x10, 0x00, {}},
+            {0xF6, 0, 0, {}}, {0x80, 0x3C, 0x40, {}},
+        };
+        assert(parse(parser, stream) == expected);
+        assert(parser.counters().errors == 3 && parser.counters().events == expected.size());
+        assert(parser.counters().bytes == stream.size());
+    }
+
+    std::cout << "Testing system exclusive spans" << std::endl;
+    {
+        Parser parser;
+        const bytes sysex = {0xF0, 0x47, 0x7F, 0x73, 0x60, 0x00, 0x04, 0x41, 0x08, 0x02, 0x01, 0xF7};
+        bytes stream = sysex;
+        stream.insert(stream.begin() + 5, 0xF8);
+        assert(parse(parser, stream) == (std::vector<parsed>{{0xF8, 0, 0, {}}, {0xF0, 0, 0, sysex}}));
+
+        /* interrupted by a status byte */
+        assert(parse(parser, {0xF0, 0x01, 0x02, 0x90, 0x3C, 0x64})
+            == (std::vector<parsed>{{0x90, 0x3C, 0x64, {}}}));
+        assert(parser.counters().errors == 1);
+
+        /* a held span stays valid while bytes keep coming */
+        bytes large(300, 0x55);
+        large.front() = 0xF0;
+        large.back() = 0xF7;
+        parser.feed(large.data(), large.size(), 0);
+        event e;
+        assert(parser.poll(e) && e.is_sysex() && e.sysex_size == 300);
+        parser.feed(large.data(), large.size(), 0);     /* doesn't fit while the first one is held */
+        assert(!parser.poll(e) && parser.counters().sysex_overflows == 1);
+
+        /* ...and wraps around the buffer end */
+        parser.feed(large.data(), large.size(), 0);
+        assert(parser.poll(e) && e.sysex_size == 300);
+        const sysex_span held = parser.sysex(e);
+        assert(held.sizes[1] != 0 && held.size() == 300);
+
+        parser.feed(sysex.data(), sysex.size(), 0);
+        parser.feed(large.data(), large.size(), 0);
+        for (size_t i=0; i<held.size(); ++i)
+            { assert(held[i] == large[i]); }
+        assert(parser.counters().sysex_overflows == 2);
+
+        assert(parser.poll(e) && copy_of(parser, e).sysex == sysex);
+        assert(!parser.poll(e));
+        parser.feed(large.data(), large.size(), 0);     /* fits once released */
+        assert(parser.poll(e) && copy_of(parser, e).sysex == large);
+        assert(!parser.poll(e));
+
+        bytes huge(SYSEX_BUFFER_SIZE + 1, 0x01);
+        huge.front() = 0xF0;
+        huge.back() = 0xF7;
+        parser.feed(huge.data(), huge.size(), 0);
+        assert(!parser.poll(e) && parser.counters().sysex_overflows == 3);
+    }
+
+    std::cout << "Testing full events queue" << std::endl;
+    {
+        Parser parser;
+        for (size_t i=0; i<EVENTS_QUEUE_SIZE + 10; ++i)
+            { parser.feed(0xF8, i); }
+        const bytes sysex = {0xF0, 0x01, 0xF7};
+        parser.feed(sysex.data(), sysex.size(), 0);
+        assert(parser.pending() == EVENTS_QUEUE_SIZE && parser.counters().dropped == 11);
+
+        event e;
+        size_t count = 0;
+        while (parser.poll(e))
+            { assert(e.timestamp == count++); }
+        /* the dropped message didn't leak */
+        bytes large(SYSEX_BUFFER_SIZE, 0x02);
+        large.front() = 0xF0;
+        large.back() = 0xF7;
+        parser.feed(large.data(), large.size(), 0);
+        assert(parser.poll(e) && e.sysex_size == SYSEX_BUFFER_SIZE);
+    }
+
+    std::cout << "Testing reads from serial ports" << std::endl;
+    {
+        static std::array<bytes, BUSES_COUNT> received;
+        struct SimContext
+        {
+            static size_t read(bus b, uint8_t* out, size_t count)
+                {
+                    bytes& r = received[static_cast<uint8_t>(b)];
+                    const size_t n = std::min(count, r.size());
+                    std::copy(r.begin(), r.begin() + n, out);
+                    r.erase(r.begin(), r.begin() + n);
+                    return n;
+                }
+            static unsigned long micros()   { return 1234; }
+        };
+        received[0] = {0x90, 0x3C, 0x64};
+        received[1] = {0xB0, 0x07};
+        MidiInput<SimContext> input;
+        input.setup();
+        assert(input.update() == 5);
+        event e;
+        assert(input.poll(bus::Bus1, e) && e.status == 0x90 && e.timestamp == 1234);
+        assert(!input.poll(bus::Bus2, e));
+        received[1] = {0x7F};
+        input.update();
+        assert(input.poll(bus::Bus2, e) && e.status == 0xB0 && e.data2 == 0x7F);
+    }
+
+    std::mt19937 rand(0xf022);
+
+    std::cout << "Fuzzing against reference parser" << std::endl;
+    {
+        size_t events = 0;
+        for (int pass=0; pass<200; ++pass)
+            {
+                bytes stream;
+                if (pass % 2)
+                    {
+                        /* raw noise */
+                        stream.resize(4096);
+                        for (auto& b: stream)
+                            { b = rand(); }
+                    }
+                else
+                    {
+                        /* valid traffic, corrupted from place to place */
+                        stream = traffic(4096, rand, 4, 700);
+                        for (int k=0; k<8; ++k)
+                            {
+                                const size_t at = rand() % stream.size();
+                                if (rand() & 1)
+                                    { stream.erase(stream.begin() + at); }
+                                else
+                                    { stream[at] = rand(); }
+                            }
+                    }
+
+                Parser parser;
+                const size_t chunk = 1 + rand() % 40;
+                const auto reference = reference_parse(stream, chunk);
+                const auto result = parse(parser, stream, chunk);
+                assert(result == reference);
+                assert(parser.counters().dropped == 0);
+                events += result.size();
+            }
+        std::cout << "\t" << events << " events matched" << std::endl;
+    }
+
+    std::cout << "\nBenchmark: Parser::feed" << std::endl;
+    printf("\t%20s %12s %12s\n", "stream", "MB/s", "x31250bauds");
+    for (unsigned sysex_percent: {0u, 2u, 40u})
+        {
+            const bytes stream = traffic(1 << 20, rand, sysex_percent, 256);
+            Parser parser;
+            constexpr size_t PASSES = 16;
+            volatile uint32_t sink = 0;
+
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t pass=0; pass<PASSES; ++pass)
+                for (size_t i=0; i<stream.size(); i+=RX_CHUNK_SIZE)
+                    {
+                        parser.feed(stream.data() + i, std::min(RX_CHUNK_SIZE, stream.size() - i), i);
+                        event e;
+                        while (parser.poll(e))
+                            { sink = sink + e.data1 + e.sysex_size; }
+                    }
+            const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            const double rate = PASSES * stream.size() / s;
+            assert(parser.counters().dropped == 0);
+
+            char name[32];
+            snprintf(name, sizeof(name), "%u%% sysex", sysex_percent);
+            printf("\t%20s %12.1f %12.0f\n", name, rate / 1e6, rate / 3125);
+        }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,244 @@
+
+#include "midi/midi_mapping/midi_mapping.h"
+
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <cassert>
+#include <random>
+
+using namespace midi;
+using namespace midi::midi_mapping;
+using hw::pads::Pad;
+using hw::analog::Encoder;
+using hw::analog::Fader;
+
+/**
+ * APC40 MKI communication protocol, as documented by Akai:
+ *  buttons send note on 0x7F / note off, leds are driven by note on velocities on the same note
+ */
+struct documented
+{
+    Pad pad;
+    uint8_t channel;
+    uint8_t note;
+    bool led;
+};
+
+static std::vector<documented> apc40_buttons()
+{
+    using namespace hw::pads;
+    std::vector<documented> buttons;
+    for (uint8_t track=0; track<8; ++track)
+        {
+            buttons.push_back({CLIP_Y_X[0][track], track, 53, true});       /* clip launch, scene 1 */
+            buttons.push_back({CLIP_Y_X[1][track], track, 54, true});
+            buttons.push_back({CLIP_Y_X[2][track], track, 55, true});
+            buttons.push_back({CLIP_Y_X[3][track], track, 56, true});
+            buttons.push_back({CLIP_Y_X[4][track], track, 57, true});       /* clip launch, scene 5 */
+            buttons.push_back({CLIP_STOP_X[track], track, 52, true});
+            buttons.push_back({TRACK_SELECT_X[track], track, 51, true});
+            buttons.push_back({ACTIVATOR_X[track], track, 50, true});
+            buttons.push_back({SOLO_CUE_X[track], track, 49, true});
+            buttons.push_back({RECORD_ARM_X[track], track, 48, true});
+        }
+    const std::vector<documented> globals = {
+        {Pad::SELECT_MASTER, 0, 80, true},
+        {Pad::STOP_ALL_CLIPS, 0, 81, false},
+        {Pad::SCENE_LAUNCH_0, 0, 82, true}, {Pad::SCENE_LAUNCH_1, 0, 83, true}, {Pad::SCENE_LAUNCH_2, 0, 84, true},
+        {Pad::SCENE_LAUNCH_3, 0, 85, true}, {Pad::SCENE_LAUNCH_4, 0, 86, true},
+        {Pad::PAN, 0, 87, true}, {Pad::SEND_A, 0, 88, true}, {Pad::SEND_B, 0, 89, true}, {Pad::SEND_C, 0, 90, true},
+        {Pad::PLAY, 0, 91, false}, {Pad::STOP, 0, 92, false}, {Pad::REC, 0, 93, false},
+        {Pad::BANK_UP, 0, 94, false}, {Pad::BANK_DOWN, 0, 95, false},
+        {Pad::BANK_RIGHT, 0, 96, false}, {Pad::BANK_LEFT, 0, 97, false},
+        {Pad::SHIFT, 0, 98, false}, {Pad::TAP_TEMPO, 0, 99, false},
+        {Pad::NUDGE_PLUS, 0, 100, false}, {Pad::NUDGE_MINUS, 0, 101, false},
+        {Pad::CLIP_TRACK, 0, 58, true}, {Pad::DEVICE_ON_OFF, 0, 59, true},
+        {Pad::LEFT_ARROW, 0, 60, true}, {Pad::RIGHT_ARROW, 0, 61, true},
+        {Pad::DETAIL_VIEW, 0, 62, true}, {Pad::REC_QUANTIZE, 0, 63, true},
+        {Pad::MIDI_OVERDUB, 0, 64, true}, {Pad::METRONOME, 0, 65, true},
+    };
+    buttons.insert(buttons.end(), globals.begin(), globals.end());
+    return buttons;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    Mappings mappings;
+    assert(mappings.setup());
+    assert(mappings.selected() == mode::Apc40);
+
+    std::cout << "Testing APC40 MKI buttons and leds" << std::endl;
+    {
+        const MappingTable& table = mappings.active();
+        const auto buttons = apc40_buttons();
+        assert(buttons.size() == PADS_COUNT - 2);     /* every wired pad */
+        for (const auto& b: buttons)
+            {
+                const outgoing& out = table.output(b.pad);
+                assert(out.status == (0x90 | b.channel) && out.data1 == b.note);
+
+                message msg;
+                assert(mappings.pad_message(b.pad, true, msg));
+                assert(msg.status == (0x90 | b.channel) && msg.data1 == b.note && msg.data2 == 0x7F);
+                assert(mappings.pad_message(b.pad, false, msg));
+                assert(msg.status == (0x80 | b.channel) && msg.data1 == b.note && msg.data2 == 0x7F);
+
+                for (uint8_t s: {0x90, 0x80})
+                    {
+                        const control c = table.input(s | b.channel, b.note);
+                        if (b.led)
+                            { assert(c.kind == control_kind::Pad && c.index == static_cast<uint8_t>(b.pad)); }
+                        else
+                            { assert(c.is_none()); }
+                    }
+            }
+        message msg;
+        assert(!mappings.pad_message(Pad::__UNUSED_33_7__, true, msg));
+
+        /* pads bound to a control change send 127 and 0 */
+        Mappings custom;
+        const binding cc{control{control_kind::Pad, 5}, 0xB2, 20, binding_flags::Outgoing};
+        assert(custom.load(mode::Apc40, &cc, 1));
+        assert(custom.pad_message(static_cast<Pad>(5), true, msg) && msg.status == 0xB2 && msg.data1 == 20 && msg.data2 == 0x7F);
+        assert(custom.pad_message(static_cast<Pad>(5), false, msg) && msg.status == 0xB2 && msg.data2 == 0);
+    }
+
+    std::cout << "Testing APC40 MKI knobs and faders" << std::endl;
+    {
+        const MappingTable& table = mappings.active();
+        for (uint8_t track=0; track<8; ++track)
+            {
+                const Fader fader = hw::analog::TRACK_LEVEL_X[track];
+                assert(table.output(fader).status == (0xB0 | track) && table.output(fader).data1 == 7);
+
+                /* track control knobs: values and led-ring styles */
+                const Encoder upper = hw::analog::TRACK_ENCODER_X[track];
+                assert(table.output(upper).status == 0xB0 && table.output(upper).data1 == 48 + track);
+                control c = table.input(0xB0, 48 + track);
+                assert(c.kind == control_kind::Encoder && c.index == static_cast<uint8_t>(upper));
+                c = table.input(0xB0, 56 + track);
+                assert(c.kind == control_kind::RingStyle && c.index == static_cast<uint8_t>(upper));
+
+                /* device control knobs */
+                const Encoder device = hw::analog::DEVICE_ENCODER_X[track];
+                assert(table.output(device).status == 0xB0 && table.output(device).data1 == 16 + track);
+                c = table.input(0xB0, 16 + track);
+                assert(c.kind == control_kind::Encoder && c.index == static_cast<uint8_t>(device));
+                c = table.input(0xB0, 24 + track);
+                assert(c.kind == control_kind::RingStyle && c.index == static_cast<uint8_t>(device));
+            }
+        assert(table.output(Fader::MASTER_LEVEL).status == 0xB0 && table.output(Fader::MASTER_LEVEL).data1 == 14);
+        assert(table.output(Fader::CROSSFADE).status == 0xB0 && table.output(Fader::CROSSFADE).data1 == 15);
+        assert(table.output(Encoder::CUE_LEVEL).status == 0xB0 && table.output(Encoder::CUE_LEVEL).data1 == 47);
+        assert(table.input(0xB0, 47).is_none() && table.input(0xB3, 7).is_none());
+
+        /* other messages are never bound */
+        assert(table.input(0xA0, 53).is_none() && table.input(0xE0, 48).is_none());
+        assert(table.input(0x35, 0x7F).is_none() && table.input(0xF8, 0).is_none());
+    }
+
+    std::cout << "Testing extended mode and mode switch" << std::endl;
+    {
+        const MappingTable* apc40 = &mappings.active();
+        mappings.select(mode::Extended);
+        const MappingTable& table = mappings.active();
+        assert(&table != apc40 && &table == &mappings.table(mode::Extended));
+
+        for (uint8_t p=0; p<PADS_COUNT; ++p)
+            {
+                const Pad pad = static_cast<Pad>(p);
+                if (pad == Pad::__UNUSED_33_7__ || pad == Pad::__UNUSED_39_4__)
+                    {
+                        assert(!table.output(pad).is_bound());
+                        continue;
+                    }
+                assert(table.output(pad).status == 0x90 && table.output(pad).data1 == p);
+                const control c = table.input(0x90, p);
+                assert(hw::is_blind(pad) ? c.is_none() : c.index == p);
+            }
+        assert(table.output(Encoder::CTRL_3).status == 0xB1
+            && table.output(Encoder::CTRL_3).data1 == static_cast<uint8_t>(Encoder::CTRL_3));
+        assert(table.input(0xB1, 0x40 + static_cast<uint8_t>(Encoder::PAN_2)).kind == control_kind::RingStyle);
+        assert(table.output(Fader::CROSSFADE).data1 == 0x20 + static_cast<uint8_t>(Fader::CROSSFADE));
+
+        mappings.select(mode::Apc40);
+        assert(&mappings.active() == apc40);
+    }
+
+    std::cout << "Testing configured bindings" << std::endl;
+    {
+        MappingTable table;
+        const binding valid[] = {
+            {{control_kind::Pad, 0}, 0x9F, 0x00, Both},
+            {{control_kind::Pad, 1}, 0x9F, 0x00, Outgoing},         /* two pads sending the same note */
+            {{control_kind::Encoder, 0}, 0xB0, 0x01, Incoming},
+        };
+        assert(compile(valid, 3, table));
+        assert(table.input(0x9F, 0).index == 0 && table.output(static_cast<Pad>(1)).status == 0x9F);
+        assert(!table.output(Encoder::PAN_0).is_bound());
+
+        const binding invalid[][2] = {
+            {{{control_kind::Pad, 0}, 0x90, 0x00, Both}, {{control_kind::Pad, 1}, 0x80, 0x00, Both}},   /* same incoming note */
+            {{{control_kind::Pad, 0}, 0x90, 0x00, Both}, {{control_kind::Pad, PADS_COUNT}, 0x90, 0x01, Both}},
+            {{{control_kind::Pad, 0}, 0x90, 0x00, Both}, {{control_kind::Fader, 0}, 0xE0, 0x00, Outgoing}},
+            {{{control_kind::Pad, 0}, 0x90, 0x00, Both}, {{control_kind::Fader, 0}, 0xB0, 0x80, Outgoing}},
+            {{{control_kind::Pad, 0}, 0x90, 0x00, Both}, {{control_kind::RingStyle, 0}, 0xB0, 0x01, Both}},
+            {{{control_kind::Pad, 0}, 0x90, 0x00, Both}, {{control_kind::None, 0}, 0xB0, 0x01, Both}},
+        };
+        for (const auto& bindings: invalid)
+            {
+                size_t failed = 0;
+                assert(!compile(bindings, 2, table, &failed) && failed == 1);
+            }
+
+        Mappings custom;
+        custom.setup();
+        assert(custom.load(mode::Extended, valid, 3));
+        custom.select(mode::Extended);
+        assert(custom.active().input(0x9F, 0).kind == control_kind::Pad);
+    }
+
+    std::cout << "\nBenchmark: lookups" << std::endl;
+    {
+        constexpr size_t ITERATIONS = 20000000;
+        std::mt19937 rand(5);
+        std::vector<uint16_t> messages(4096);
+        for (auto& m: messages)
+            { m = ((0x80 | (rand() & 0x3F)) << 8) | (rand() & 0x7F); }
+
+        const MappingTable& table = mappings.active();
+        volatile uint32_t sink = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t i=0; i<ITERATIONS; ++i)
+            {
+                const uint16_t m = messages[i & 4095];
+                sink = sink + table.input(m >> 8, m & 0xFF).index;
+            }
+        const double input_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / ITERATIONS;
+
+        begin = std::chrono::steady_clock::now();
+        for (size_t i=0; i<ITERATIONS; ++i)
+            { sink = sink + table.output(static_cast<Pad>(messages[i & 4095] % PADS_COUNT)).data1; }
+        const double output_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / ITERATIONS;
+
+        binding bindings[BINDINGS_MAX_COUNT];
+        const size_t count = default_bindings(mode::Apc40, bindings);
+        MappingTable compiled;
+        begin = std::chrono::steady_clock::now();
+        for (size_t i=0; i<1000; ++i)
+            { compile(bindings, count, compiled); }
+        const double compile_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / 1000;
+
+        printf("\tincoming %.2f ns/lookup, outgoing %.2f ns/lookup\n", input_ns, output_ns);
+        printf("\tcompiling %lu bindings: %.2f us, table of %lu bytes\n", count, compile_us, sizeof(MappingTable));
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
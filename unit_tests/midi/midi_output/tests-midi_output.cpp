@@ -0,0 +1,319 @@
+
+#define MYCELIUM_LATENCY_PROBES
+#include "midi/midi_output/midi_output.h"
+
+#include "../../hw/sim/clock.hpp"
+#include "../../hw/sim/uart.hpp"
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <utility>
+
+using namespace midi;
+using namespace midi::midi_output;
+
+using bytes = std::vector<uint8_t>;
+
+static std::array<sim::Uart, BUSES_COUNT> uarts;
+
+struct SimContext
+{
+    static size_t available_for_write(bus b)
+        { return uarts[static_cast<uint8_t>(b)].available(); }
+    static size_t write(bus b, const uint8_t* data, size_t count)
+        { return uarts[static_cast<uint8_t>(b)].write(data, count); }
+    static unsigned long micros()       { return sim::Clock::micros(); }
+};
+
+using output_type = MidiOutput<SimContext>;
+
+static void reset_bench()
+{
+    sim::Clock::reset();
+    for (auto& s: uarts)
+        { s = sim::Uart{}; s.capacity = 1024; }
+    OutputDefaultSettings::NoteOffAsNoteOn = true;
+    OutputDefaultSettings::StatusRefreshPeriod = 1000000;
+}
+
+/** Latency marks of traced messages, in call order */
+static std::vector<std::pair<uint8_t, latency::stage>> marks;
+
+static void record_mark(uint8_t key, latency::stage s)
+{
+    marks.push_back({key, s});
+}
+
+static bytes transmitted(output_type& output, bus b=bus::Bus1)
+{
+    output.flush();
+    return uarts[static_cast<uint8_t>(b)].bytes;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing running status encoding" << std::endl;
+    {
+        reset_bench();
+        output_type output;
+        output.setup();
+        assert(output.note_on(bus::Bus1, 0, 0x3C, 0x64));
+        assert(output.note_on(bus::Bus1, 0, 0x3E, 0x64));
+        assert(output.note_off(bus::Bus1, 0, 0x3C, 0x40));     /* sent as a zero velocity note on */
+        assert(output.note_on(bus::Bus1, 1, 0x3C, 0x7F));      /* channel change */
+        assert(output.control_change(bus::Bus1, 1, 0x07, 0x10));
+        assert(output.control_change(bus::Bus1, 1, 0x07, 0x11));
+        assert(output.program_change(bus::Bus1, 2, 0x05));
+        assert(output.program_change(bus::Bus1, 2, 0x06));
+        assert(output.pitch_bend(bus::Bus1, 2, 0x2000));
+        assert(transmitted(output) == (bytes{
+                0x90, 0x3C, 0x64,   0x3E, 0x64,     0x3C, 0x00,
+                0x91, 0x3C, 0x7F,
+                0xB1, 0x07, 0x10,   0x07, 0x11,
+                0xC2, 0x05,         0x06,
+                0xE2, 0x00, 0x40,
+            }));
+
+        const bus_counters& counters = output.counters(bus::Bus1);
+        assert(counters.messages == 9 && counters.saved == 4);
+        assert(counters.queued == 21 && counters.sent == 21 && counters.dropped == 0);
+        assert(output.occupancy(bus::Bus1) == 0 && output.peak_occupancy(bus::Bus1) == 21);
+    }
+
+    std::cout << "Testing note off kept when configured" << std::endl;
+    {
+        reset_bench();
+        OutputDefaultSettings::NoteOffAsNoteOn = false;
+        output_type output;
+        output.setup();
+        output.note_on(bus::Bus1, 0, 0x3C, 0x64);
+        output.note_off(bus::Bus1, 0, 0x3C, 0x40);
+        output.note_off(bus::Bus1, 0, 0x3D, 0x40);
+        assert(transmitted(output) == (bytes{0x90, 0x3C, 0x64, 0x80, 0x3C, 0x40, 0x3D, 0x40}));
+    }
+
+    std::cout << "Testing realtime and system messages" << std::endl;
+    {
+        reset_bench();
+        output_type output;
+        output.setup();
+        output.note_on(bus::Bus1, 0, 0x3C, 0x64);
+        output.realtime(bus::Bus1, status::Clock);             /* keeps running status */
+        output.note_on(bus::Bus1, 0, 0x3D, 0x64);
+        output.send(bus::Bus1, {static_cast<uint8_t>(status::SongPosition), 0x10, 0x00});
+        output.note_on(bus::Bus1, 0, 0x3E, 0x64);              /* cancelled by system common */
+        const uint8_t sysex[] = {0xF0, 0x47, 0x7F, 0x73, 0x60, 0x00, 0x04, 0x41, 0x08, 0x02, 0x01, 0xF7};
+        assert(output.send_sysex(bus::Bus1, sysex, sizeof(sysex)));
+        output.note_on(bus::Bus1, 0, 0x3F, 0x64);              /* cancelled by sysex */
+        output.realtime(bus::Bus1, status::Start);
+        output.send(bus::Bus1, {static_cast<uint8_t>(status::TuneRequest), 0, 0});
+        output.note_on(bus::Bus1, 0, 0x40, 0x64);
+
+        bytes expected = {0x90, 0x3C, 0x64, 0xF8, 0x3D, 0x64, 0xF2, 0x10, 0x00, 0x90, 0x3E, 0x64};
+        expected.insert(expected.end(), sysex, sysex + sizeof(sysex));
+        expected.insert(expected.end(), {0x90, 0x3F, 0x64, 0xFA, 0xF6, 0x90, 0x40, 0x64});
+        assert(transmitted(output) == expected);
+        assert(output.counters(bus::Bus1).saved == 1);
+    }
+
+    std::cout << "Testing invalid messages" << std::endl;
+    {
+        reset_bench();
+        output_type output;
+        output.setup();
+        assert(!output.send(bus::Bus1, {0x3C, 0x64, 0x00}));                   /* no status */
+        assert(!output.send(bus::Bus1, {0x90, 0x80, 0x00}));                   /* status as data */
+        assert(!output.send(bus::Bus1, {0xF0, 0x00, 0x00}));                   /* sysex as short message */
+        const uint8_t unterminated[] = {0xF0, 0x01, 0x02};
+        const uint8_t corrupted[] = {0xF0, 0x01, 0x90, 0xF7};
+        assert(!output.send_sysex(bus::Bus1, unterminated, sizeof(unterminated)));
+        assert(!output.send_sysex(bus::Bus1, corrupted, sizeof(corrupted)));
+        assert(output.occupancy(bus::Bus1) == 0 && output.counters(bus::Bus1).messages == 0);
+    }
+
+    std::cout << "Testing status refresh" << std::endl;
+    {
+        reset_bench();
+        OutputDefaultSettings::StatusRefreshPeriod = 300000;
+        output_type output;
+        output.setup();
+        output.control_change(bus::Bus1, 0, 0x30, 0x01);
+        sim::Clock::advance(200000000);
+        output.control_change(bus::Bus1, 0, 0x30, 0x02);
+        sim::Clock::advance(200000000);
+        output.control_change(bus::Bus1, 0, 0x30, 0x03);       /* 400ms after the explicit status */
+        output.control_change(bus::Bus1, 0, 0x30, 0x04);
+        assert(transmitted(output) == (bytes{0xB0, 0x30, 0x01, 0x30, 0x02, 0xB0, 0x30, 0x03, 0x30, 0x04}));
+    }
+
+    std::cout << "Testing full buffer drops whole messages" << std::endl;
+    {
+        reset_bench();
+        output_type output;
+        output.setup();
+        /* 85 notes fill 1 + 2 * 85 bytes, the 86th doesn't fit in the 3 remaining bytes... */
+        size_t accepted = 0;
+        for (uint8_t i=0; i<127; ++i)
+            { accepted += static_cast<bool>(output.note_on(bus::Bus1, 0, i, 0x7F)); }
+        assert(accepted == (TX_BUFFER_SIZE -1) / 2 && output.occupancy(bus::Bus1) == TX_BUFFER_SIZE -1);
+        assert(output.counters(bus::Bus1).dropped == 127 - accepted);
+        /* ...nor does a status change, the running status remains the queued one */
+        assert(!output.note_on(bus::Bus1, 1, 0x00, 0x7F));
+        assert(static_cast<error::errcode>(output.note_on(bus::Bus1, 1, 0x00, 0x7F)) == error::errcode::MEMORY_ERROR);
+
+        const bytes first = transmitted(output);
+        assert(first.size() == TX_BUFFER_SIZE -1 && first[0] == 0x90 && first.back() == 0x7F);
+        output.note_on(bus::Bus1, 0, 0x7F, 0x7F);
+        output.note_on(bus::Bus1, 1, 0x00, 0x7F);
+        const bytes all = transmitted(output);
+        assert(bytes(all.begin() + first.size(), all.end()) == (bytes{0x7F, 0x7F, 0x91, 0x00, 0x7F}));
+    }
+
+    std::cout << "Testing non-blocking flush and buses independence" << std::endl;
+    {
+        reset_bench();
+        for (auto& s: uarts)
+            { s.capacity = 8; }
+        output_type output;
+        output.setup();
+
+        bytes expected1, expected2;
+        for (uint8_t i=0; i<40; ++i)
+            {
+                output.note_on(bus::Bus1, 0, i, 0x7F);
+                output.control_change(bus::Bus2, 3, 0x07, i);
+                if (i == 0)
+                    {
+                        expected1.push_back(0x90);
+                        expected2.push_back(0xB3);
+                    }
+                expected1.insert(expected1.end(), {i, 0x7F});
+                expected2.insert(expected2.end(), {0x07, i});
+            }
+
+        /* each flush hands at most what the serial port accepts */
+        size_t flushes = 0;
+        while (output.occupancy(bus::Bus1) || output.occupancy(bus::Bus2))
+            {
+                assert(output.flush() <= 2 * 8);
+                sim::Clock::advance(1000000);
+                flushes += 1;
+            }
+        assert(flushes > 8);
+        assert(uarts[0].bytes == expected1 && uarts[1].bytes == expected2);
+        assert(output.counters(bus::Bus2).sent == expected2.size());
+    }
+
+    std::cout << "Testing latency marks" << std::endl;
+    {
+        using latency::stage;
+        using mark = std::pair<uint8_t, stage>;
+        reset_bench();
+        uarts[0].capacity = 4;
+        output_type output;
+        output.setup();
+        marks.clear();
+        latency::probe = &record_mark;
+
+        /* marked once queued, then once their last byte is handed to the serial port */
+        assert(output.note_on(bus::Bus1, 0, 0x35, 0x7F, 3));
+        assert(output.control_change(bus::Bus1, 0, 0x07, 0x40));
+        assert(output.note_on(bus::Bus1, 0, 0x36, 0x7F, 5));
+        assert(marks == (std::vector<mark>{{3, stage::TxEnqueue}, {5, stage::TxEnqueue}}));
+        assert(output.flush() == 4);
+        assert(marks.size() == 3 && marks.back() == mark(3, stage::TxComplete));
+        while (output.occupancy(bus::Bus1))
+            {
+                assert(marks.size() == 3);
+                sim::Clock::advance(1000000);
+                output.flush();
+            }
+        assert(marks.size() == 4 && marks.back() == mark(5, stage::TxComplete));
+
+        /* dropped messages are not marked, nor messages beyond the followed traces */
+        marks.clear();
+        size_t accepted = 0;
+        for (uint8_t i=0; i<200; ++i)
+            { accepted += static_cast<bool>(output.note_on(bus::Bus1, 0, i & 0x7F, 0x7F, i)); }
+        /* running status kept from the previous notes: two bytes each */
+        assert(accepted == TX_BUFFER_SIZE / 2);
+        assert(marks.size() == TX_TRACES_COUNT);
+        while (output.occupancy(bus::Bus1))
+            {
+                sim::Clock::advance(1000000);
+                output.flush();
+            }
+        assert(marks.size() == 2 * TX_TRACES_COUNT);
+        for (size_t i=0; i<TX_TRACES_COUNT; ++i)
+            { assert(marks[TX_TRACES_COUNT + i] == mark(i, stage::TxComplete)); }
+
+        latency::probe = nullptr;
+    }
+
+    std::cout << "\nController traffic, 10s: 8 faders and 8 encoders moving, pads pressed" << std::endl;
+    {
+        reset_bench();
+        for (auto& s: uarts)
+            { s.capacity = 40; }       /* teensy serial transmit buffer */
+        output_type output;
+        output.setup();
+
+        std::mt19937 rand(0x31d1);
+        std::uniform_int_distribution<int> pick(0, 7);
+        std::uniform_int_distribution<int> event(0, 99);
+        unsigned long events = 0;
+        size_t full_size = 0;
+        uint8_t values[16] = {};
+        int gesture = 0;
+        uint8_t control = 0;
+        for (sim::Clock::time_point t=0; t<10000000000ULL; t+=250000)
+            {
+                sim::Clock::advance(t - sim::Clock::now());
+                /* ~160 messages per second, with bursts of ~800 messages per second every other second */
+                const int load = (t / 1000000000) % 2 ? 20 : 4;
+                if (event(rand) < load)
+                    {
+                        /* a gesture moves a single control for a while, then another one is touched */
+                        if (event(rand) < 5)
+                            {
+                                gesture = event(rand);
+                                control = pick(rand);
+                            }
+                        if (gesture < 10)
+                            {
+                                output.note_on(bus::Bus1, control, 0x35, 0x7F);
+                                output.note_off(bus::Bus1, control, 0x35, 0x7F);
+                            }
+                        else if (gesture < 55)
+                            { output.control_change(bus::Bus1, control, 0x07, ++values[control] & 0x7F); }
+                        else
+                            { output.control_change(bus::Bus1, 0, 0x30 + control, ++values[8 + control] & 0x7F); }
+                        events += gesture < 10 ? 2 : 1;
+                        full_size += 3 * (gesture < 10 ? 2 : 1);
+                    }
+                output.flush();
+            }
+
+        const bus_counters& c = output.counters(bus::Bus1);
+        printf("\t%8s %10s %10s %10s %8s | %10s %10s\n", "messages", "bytes", "full", "saved", "saved%", "peak", "dropped");
+        printf("\t%8lu %10lu %10lu %10lu %7.1f%% | %6lu/%3lu %10lu\n",
+            c.messages, c.queued, full_size, c.saved, 100.0 * c.saved / full_size,
+            output.peak_occupancy(bus::Bus1), output.capacity(), c.dropped);
+
+        assert(c.messages == events && c.dropped == 0);
+        assert(c.queued + c.saved == full_size);
+        assert(c.saved > c.messages / 3);
+        assert(uarts[0].bytes.size() == c.sent);
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,356 @@
+
+#include "midi/midi_router/midi_router.h"
+#include "midi/midi_input/midi_input.h"
+#include "midi/midi_output/midi_output.h"
+
+#include "../../hw/sim/clock.hpp"
+#include "../../hw/sim/uart.hpp"
+
+#include <array>
+#include <deque>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <algorithm>
+
+using namespace midi;
+using namespace midi::midi_router;
+
+static std::array<sim::Uart, BUSES_COUNT> uarts;
+
+struct SimContext
+{
+    static size_t available_for_write(bus b)
+        { return uarts[static_cast<uint8_t>(b)].available(); }
+    static size_t write(bus b, const uint8_t* bytes, size_t count)
+        { return uarts[static_cast<uint8_t>(b)].write(bytes, count); }
+    static unsigned long micros()       { return sim::Clock::micros(); }
+};
+
+using output_type = midi_output::MidiOutput<SimContext>;
+using router_type = Router<output_type>;
+
+static void reset_bench()
+{
+    sim::Clock::reset();
+    for (auto& u: uarts)
+        { u = sim::Uart{}; }
+}
+
+/** Parses a whole byte stream into events, sysex events carry their size */
+static std::vector<midi_input::event> parse(const std::vector<uint8_t>& bytes)
+{
+    midi_input::Parser parser;
+    std::vector<midi_input::event> events;
+    for (uint8_t byte: bytes)
+        {
+            parser.feed(byte, 0);
+            midi_input::event e;
+            while (parser.poll(e))
+                { events.push_back(e); }
+        }
+    return events;
+}
+
+static bool same(const midi_input::event& a, const midi_input::event& b)
+{
+    /* note offs may be sent as zero velocity note ons */
+    auto normalized = [](const midi_input::event& e) {
+            midi_input::event n = e;
+            if (type_of(e.status) == status::NoteOff)
+                { n.status = make_status(status::NoteOn, channel_of(e.status)); n.data2 = 0; }
+            return n;
+        };
+    const midi_input::event x = normalized(a), y = normalized(b);
+    return x.status == y.status && x.data1 == y.data1 && x.data2 == y.data2 && x.sysex_size == y.sysex_size;
+}
+
+/**
+ * Saturated input stream: back to back messages with running status,
+ *  clock ticks at 120 BPM and occasional system exclusive messages
+ */
+struct Stream
+{
+    std::vector<uint8_t> bytes;
+    std::vector<bool> realtime;     ///< byte is a clock tick
+};
+
+static Stream saturated(size_t size, double sysex_rate, uint32_t seed)
+{
+    std::mt19937 rand(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    Stream stream;
+    uint8_t running = 0;
+    double next_clock = 0;
+    auto push = [&](uint8_t byte) {
+            const double t = stream.bytes.size() * BYTE_DURATION_US;
+            if (t >= next_clock)
+                {
+                    stream.bytes.push_back(0xF8);
+                    stream.realtime.push_back(true);
+                    next_clock += 20833;
+                }
+            stream.bytes.push_back(byte);
+            stream.realtime.push_back(false);
+        };
+
+    while (stream.bytes.size() < size)
+        {
+            if (uniform(rand) < sysex_rate)
+                {
+                    push(0xF0);
+                    for (size_t i=rand() % 60 + 8; i>0; --i)
+                        { push(rand() & DATA_BITMASK); }
+                    push(0xF7);
+                    running = 0;
+                    continue;
+                }
+            const uint8_t status = (rand() & 1 ? 0x90 : 0xB0) | (rand() & 0x03);
+            if (status != running)
+                { push(status); }
+            running = status;
+            push(rand() & DATA_BITMASK);
+            push(rand() & DATA_BITMASK);
+        }
+    return stream;
+}
+
+struct Report
+{
+    size_t messages = 0;
+    size_t dropped = 0;
+    std::vector<double> waits_ms;           ///< queue wait of forwarded non-realtime messages
+    std::vector<double> realtime_waits_ms;  ///< queue wait of forwarded realtime messages
+};
+
+/**
+ * Both inputs saturated and merged on the first output, main loop iterating every @c loop_us
+ */
+static Report merge(size_t bytes_count, sim::Clock::time_point loop_us, uint32_t seed)
+{
+    reset_bench();
+    output_type output;
+    output.setup();
+    router_type router(output);
+    router.connect(source::Rx1, sink::Tx1);
+    router.connect(source::Rx2, sink::Tx1);
+
+    const Stream streams[2] = {saturated(bytes_count, 0.02, seed), saturated(bytes_count, 0.02, seed + 1)};
+    midi_input::Parser parsers[2];
+    size_t received[2] = {0, 0};
+
+    struct queued { size_t first_byte; unsigned long at; bool realtime; };
+    std::vector<queued> queue;
+    Report report;
+
+    const unsigned long end = bytes_count * BYTE_DURATION_US;
+    while (sim::Clock::micros() < end)
+        {
+            const unsigned long now = sim::Clock::micros();
+            for (size_t i=0; i<2; ++i)
+                {
+                    const size_t arrived = std::min<size_t>(streams[i].bytes.size(), now / BYTE_DURATION_US);
+                    parsers[i].feed(streams[i].bytes.data() + received[i], arrived - received[i], now);
+                    received[i] = arrived;
+
+                    midi_input::event e;
+                    while (parsers[i].poll(e))
+                        {
+                            const size_t before = output.counters(bus::Bus1).queued;
+                            const midi_input::sysex_span sysex = e.is_sysex()
+                                ? parsers[i].sysex(e) : midi_input::sysex_span{{nullptr, nullptr}, {0, 0}};
+                            const bool sent = router.dispatch(i == 0 ? source::Rx1 : source::Rx2, e, sysex,
+                                [](source, const midi_input::event&) {});
+                            report.messages += 1;
+                            if (!sent)
+                                { report.dropped += 1; continue; }
+                            /* a status omitted by the running status still starts the message */
+                            assert(output.counters(bus::Bus1).queued > before);
+                            queue.push_back({before, now, is_realtime(e.status)});
+                        }
+                }
+            output.flush();
+            sim::Clock::advance(loop_us * 1000);
+        }
+    while (output.occupancy(bus::Bus1))
+        {
+            output.flush();
+            sim::Clock::advance(loop_us * 1000);
+        }
+
+    const sim::Uart& uart = uarts[0];
+    for (const auto& q: queue)
+        {
+            const double wait_ms = (uart.starts[q.first_byte] - q.at) / 1e3;
+            (q.realtime ? report.realtime_waits_ms : report.waits_ms).push_back(wait_ms);
+        }
+
+    /* every forwarded message went out whole, in order per input */
+    const auto events = parse(uart.bytes);
+    assert(events.size() == queue.size());
+    return report;
+}
+
+static double percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+        { return 0; }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() -1, static_cast<size_t>(p / 100 * values.size()))];
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing message classes" << std::endl;
+    {
+        assert(class_of(0x80) == Notes && class_of(0x9F) == Notes && class_of(0xA3) == PolyPressure);
+        assert(class_of(0xB0) == ControlChange && class_of(0xC0) == ProgramChange);
+        assert(class_of(0xD0) == ChannelPressure && class_of(0xE5) == PitchBend);
+        assert(class_of(0xF0) == SysEx && class_of(0xF2) == Common && class_of(0xF6) == Common);
+        assert(class_of(0xF8) == Clock && class_of(0xFA) == Transport && class_of(0xFC) == Transport);
+        assert(class_of(0xFE) == Sensing && class_of(0xF9) == 0 && class_of(0x40) == 0);
+
+        const route notes = {Notes | ControlChange, 0x0005};
+        assert(notes.accepts(0x90) && notes.accepts(0x82) && notes.accepts(0xB2));
+        assert(!notes.accepts(0x91) && !notes.accepts(0xE0) && !notes.accepts(0xF8));
+        const route clock = {Clock | Transport, 0};
+        assert(clock.accepts(0xF8) && clock.accepts(0xFA) && !clock.accepts(0x90));
+        const route none = {0, ALL_CHANNELS};
+        assert(!none.is_connected());
+    }
+
+    std::cout << "Testing routing matrix" << std::endl;
+    {
+        reset_bench();
+        output_type output;
+        output.setup();
+        router_type router(output);
+        router.connect(source::Rx1, sink::Tx1);                             /* thru */
+        router.connect(source::Rx1, sink::Tx2, Notes, 0x0001);             /* notes of channel 1 */
+        router.connect(source::Rx2, sink::Internal, Clock | Transport);
+        router.connect(source::Rx2, sink::Tx2, SysEx);
+        router.connect(source::Surface, sink::Tx1, ChannelVoice);
+        router.connect(source::Surface, sink::Internal);
+
+        std::vector<std::pair<source, uint8_t>> internal;
+        auto handler = [&](source s, const midi_input::event& e) { internal.push_back({s, e.status}); };
+
+        midi_input::Parser rx1, rx2;
+        const std::vector<uint8_t> in1 = {0x90, 0x3C, 0x64, 0x91, 0x3C, 0x64, 0xF8, 0xB0, 0x07, 0x10, 0x80, 0x3C, 0x00};
+        const std::vector<uint8_t> in2 = {0xFA, 0x90, 0x01, 0x02, 0xF0, 0x7E, 0x01, 0xF7, 0xF8};
+        rx1.feed(in1.data(), in1.size(), 0);
+        rx2.feed(in2.data(), in2.size(), 0);
+        assert(router.process(source::Rx1, rx1, handler) == 5);
+        assert(router.process(source::Rx2, rx2, handler) == 4);
+        assert(router.dispatch(source::Surface, message{0x95, 0x35, 0x01}, 0, handler) == 2);
+        assert(router.dispatch(source::Surface, message{0xF8, 0, 0}, 0, handler) == 1);
+
+        while (output.occupancy(bus::Bus1) || output.occupancy(bus::Bus2))
+            {
+                output.flush();
+                sim::Clock::advance(BYTE_DURATION_US * 1000);
+            }
+
+        /* note offs are sent as zero velocity note ons */
+        assert((uarts[0].bytes == std::vector<uint8_t>{
+            0x90, 0x3C, 0x64, 0x91, 0x3C, 0x64, 0xF8, 0xB0, 0x07, 0x10, 0x90, 0x3C, 0x00, 0x95, 0x35, 0x01}));
+        assert((uarts[1].bytes == std::vector<uint8_t>{0x90, 0x3C, 0x64, 0x3C, 0x00, 0xF0, 0x7E, 0x01, 0xF7}));
+        assert((internal == std::vector<std::pair<source, uint8_t>>{
+            {source::Rx2, 0xFA}, {source::Rx2, 0xF8}, {source::Surface, 0x95}, {source::Surface, 0xF8}}));
+
+        assert(router.counters(source::Rx1, sink::Tx1).forwarded == 5);
+        assert(router.counters(source::Rx1, sink::Tx2).forwarded == 2 && router.counters(source::Rx1, sink::Tx2).filtered == 3);
+        assert(router.counters(source::Rx2, sink::Internal).filtered == 2);
+        assert(router.counters(source::Rx2, sink::Tx1).forwarded == 0);
+
+        router.disconnect(source::Rx1, sink::Tx1);
+        assert(!router.route_of(source::Rx1, sink::Tx1).is_connected());
+        router.clear();
+        assert(router.counters(source::Rx1, sink::Tx2).forwarded == 0);
+    }
+
+    std::cout << "Testing merged system exclusive messages stay whole" << std::endl;
+    {
+        reset_bench();
+        output_type output;
+        output.setup();
+        router_type router(output);
+        router.connect(source::Rx1, sink::Tx1);
+        router.connect(source::Rx2, sink::Tx1);
+        RouterDefaultSettings::MaxDelay = 1000000;
+
+        std::mt19937 rand(4);
+        midi_input::Parser parsers[2];
+        std::vector<midi_input::event> sent;
+        /* sysex sizes make the parser buffer wrap around */
+        for (int round=0; round<200; ++round)
+            {
+                for (size_t i=0; i<2; ++i)
+                    {
+                        std::vector<uint8_t> bytes = {0xF0};
+                        for (size_t n=rand() % 150 + 1; n>0; --n)
+                            { bytes.push_back(rand() & DATA_BITMASK); }
+                        bytes.push_back(0xF7);
+                        bytes.insert(bytes.end(), {static_cast<uint8_t>(0x90 | i), 0x10, 0x20});
+                        parsers[i].feed(bytes.data(), bytes.size(), 0);
+                    }
+                for (size_t i=0; i<2; ++i)
+                    {
+                        midi_input::event e;
+                        while (parsers[i].poll(e))
+                            {
+                                const midi_input::sysex_span sysex = e.is_sysex()
+                                    ? parsers[i].sysex(e) : midi_input::sysex_span{{nullptr, nullptr}, {0, 0}};
+                                if (router.dispatch(i ? source::Rx2 : source::Rx1, e, sysex, [](source, const midi_input::event&) {}))
+                                    { sent.push_back(e); }
+                            }
+                    }
+                while (output.occupancy(bus::Bus1))
+                    {
+                        output.flush();
+                        sim::Clock::advance(BYTE_DURATION_US * 1000);
+                    }
+            }
+        RouterDefaultSettings::MaxDelay = 10000;
+
+        const auto received = parse(uarts[0].bytes);
+        assert(received.size() == sent.size() && sent.size() > 600);
+        for (size_t i=0; i<sent.size(); ++i)
+            { assert(same(received[i], sent[i])); }
+    }
+
+    std::cout << "\nBoth inputs saturated and merged on a single output, 20s" << std::endl;
+    printf("%9s %6s | %9s %8s | %9s %9s %9s | %9s\n",
+        "max.delay", "loop", "messages", "dropped", "wait.p50", "wait.p99", "wait.max", "clock.max");
+    for (unsigned long max_delay: {5000UL, 10000UL, 20000UL})
+        for (sim::Clock::time_point loop_us: {50UL, 500UL})
+            {
+                RouterDefaultSettings::MaxDelay = max_delay;
+                RouterDefaultSettings::RealtimeMaxDelay = 2 * max_delay;
+                const Report r = merge(20000000 / BYTE_DURATION_US, loop_us, 21);
+                const double max = *std::max_element(r.waits_ms.begin(), r.waits_ms.end());
+                const double clock_max = *std::max_element(r.realtime_waits_ms.begin(), r.realtime_waits_ms.end());
+
+                printf("%7.0fms %4luus | %9lu %7.1f%% | %7.2fms %7.2fms %7.2fms | %7.2fms\n",
+                    max_delay / 1e3, loop_us, r.messages, 100.0 * r.dropped / r.messages,
+                    percentile(r.waits_ms, 50), percentile(r.waits_ms, 99), max, clock_max);
+
+                /* bound, plus the serial FIFO, the byte on the wire and the loop period */
+                const double slack_ms = (sim::Uart::FIFO_SIZE + 1) * BYTE_DURATION_US / 1e3 + loop_us / 1e3;
+                assert(max <= max_delay / 1e3 + slack_ms);
+                assert(clock_max <= 2 * max_delay / 1e3 + slack_ms);
+                /* two saturated inputs on one output: about half the messages have to go */
+                assert(r.dropped > r.messages / 4 && r.dropped < r.messages * 3 / 4);
+            }
+    RouterDefaultSettings::MaxDelay = 10000;
+    RouterDefaultSettings::RealtimeMaxDelay = 20000;
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
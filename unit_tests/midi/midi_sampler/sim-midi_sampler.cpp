@@ -0,0 +1,284 @@
+
+#include "midi/midi_sampler/midi_sampler.h"
+
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <algorithm>
+
+using namespace midi::midi_sampler;
+
+/**
+ * Controller motion as received: a timestamped value on each change, in us
+ */
+struct Trace
+{
+    struct sample
+    {
+        double time;
+        uint16_t value;
+    };
+
+    const char* name;
+    std::vector<sample> samples;
+
+    /** Stores @c value at @c time if it changed */
+    void add(double time, double value, uint16_t max)
+        {
+            const uint16_t v = static_cast<uint16_t>(std::clamp(std::lround(value), 0L, static_cast<long>(max)));
+            if (samples.empty() || samples.back().value != v)
+                { samples.push_back(sample{time, v}); }
+        }
+
+    /** Value held at each tick of @c period us, until @c duration */
+    std::vector<uint16_t> quantize(double period, double duration) const
+        {
+            std::vector<uint16_t> values;
+            size_t next = 0;
+            uint16_t value = samples.front().value;
+            for (double t=0; t<duration; t+=period)
+                {
+                    while (next < samples.size() && samples[next].time <= t)
+                        { value = samples[next++].value; }
+                    values.push_back(value);
+                }
+            return values;
+        }
+};
+
+/** Duration of recorded traces, in us */
+static constexpr double DURATION = 30e6;
+
+/**
+ * Hand moves: a target is reached with a smooth trajectory, then held for a while,
+ *  received every millisecond while moving
+ */
+static Trace gestures(const char* name, uint16_t max, double hold_min, double hold_max, double move_max, uint32_t seed)
+{
+    std::mt19937 rand(seed);
+    std::uniform_real_distribution<double> target(0, max);
+    std::uniform_real_distribution<double> hold(hold_min, hold_max);
+    std::uniform_real_distribution<double> move(50e3, move_max);
+
+    Trace trace{name, {}};
+    double t = 0, value = max / 2.0;
+    trace.add(0, value, max);
+    while (t < DURATION)
+        {
+            const double from = value, to = target(rand), duration = move(rand);
+            for (double dt=0; dt<duration; dt+=1000)
+                {
+                    /* eased trajectory, as a hand accelerates and slows down */
+                    const double x = dt / duration;
+                    value = from + (to - from) * (3 * x * x - 2 * x * x * x);
+                    trace.add(t + dt, value, max);
+                }
+            value = to;
+            t += duration;
+            trace.add(t, value, max);
+            t += hold(rand);
+        }
+    return trace;
+}
+
+/** Hand wobble around a centre, at about @c hz, received every millisecond */
+static Trace wobble(const char* name, uint16_t max, double hz, double noise, uint32_t seed)
+{
+    std::mt19937 rand(seed);
+    std::normal_distribution<double> jitter(0, noise);
+    Trace trace{name, {}};
+    double phase = 0;
+    for (double t=0; t<DURATION; t+=1000)
+        {
+            phase += 2 * M_PI * hz * (1 + 0.2 * std::sin(t / 1.7e6)) * 1e-3;
+            trace.add(t, max / 2.0 + max * 0.35 * std::sin(phase) + jitter(rand), max);
+        }
+    return trace;
+}
+
+using slot_type = motion_slot<>;
+
+/** Records @c values from the first tick, returns the recorded count */
+static size_t record(slot_type& slot, const std::vector<uint16_t>& values)
+{
+    Recorder<> recorder;
+    recorder.begin(slot, values.front());
+    size_t count = 1;
+    while (count < values.size() && recorder.tick(values[count]))
+        { count += 1; }
+    recorder.end();
+    assert(slot.ticks == count && slot.size <= slot_type::Size);
+    return count;
+}
+
+/** Plays a slot twice, checking both loops replay @c values */
+static void check_playback(const slot_type& slot, const std::vector<uint16_t>& values)
+{
+    Player<> player;
+    player.begin(slot);
+    for (int loop=0; loop<2; ++loop)
+        for (size_t i=0; i<slot.ticks; ++i)
+            {
+                const uint16_t v = player.tick();
+                assert(v == values[i]);
+                assert(player.changed() == (i > 0 ? values[i] != values[i -1] : loop > 0 && values[0] != values[slot.ticks -1]));
+            }
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing encoding" << std::endl;
+    {
+        const std::vector<uint16_t> values = {10, 10, 10, 11, 12, 13, 14, 14, 15, 16, 100, 37, 36, 4095, 4094};
+        slot_type slot;
+        assert(record(slot, values) == values.size());
+        const std::vector<uint8_t> expected = {
+            HOLD | 1,                   /* 10, 10 */
+            DELTA_BIAS + 1, RAMP | 2,   /* 11, 12, 13, 14 */
+            HOLD | 0,                   /* 14 */
+            RAMP | 1,                   /* 15, 16: the delta repeats after a hold */
+            ABSOLUTE, 0x00, 100,        /* 100: out of delta range */
+            DELTA_BIAS - 63,            /* 37 */
+            DELTA_BIAS - 1,             /* 36 */
+            ABSOLUTE, 0x0F, 0xFF,       /* 4095 */
+            DELTA_BIAS - 1,             /* 4094 */
+        };
+        assert(slot.start == 10 && slot.size == expected.size());
+        assert(std::equal(expected.begin(), expected.end(), slot.bytes));
+        check_playback(slot, values);
+
+        /* runs longer than a code, values out of a delta range */
+        std::vector<uint16_t> runs(1, 500);
+        for (int i=0; i<200; ++i) { runs.push_back(500); }
+        for (int i=0; i<100; ++i) { runs.push_back(runs.back() + 3); }
+        runs.push_back(0);
+        runs.push_back(65535);
+        for (int i=0; i<70; ++i) { runs.push_back(runs.back() - 64); }
+        assert(record(slot, runs) == runs.size());
+        check_playback(slot, runs);
+
+        /* random motion round trips */
+        std::mt19937 rand(1);
+        std::uniform_int_distribution<int> step(-70, 70), kind(0, 3), length(1, 80);
+        for (int r=0; r<200; ++r)
+            {
+                std::vector<uint16_t> v(1, 2048);
+                while (v.size() < 150)
+                    {
+                        const int k = kind(rand), d = step(rand);
+                        for (int i=length(rand); i>0; --i)
+                            { v.push_back(std::clamp(v.back() + (k == 0 ? 0 : k == 1 ? d : step(rand)), 0, 4095)); }
+                    }
+                assert(record(slot, v) == v.size());
+                check_playback(slot, v);
+            }
+    }
+
+    std::cout << "Testing full slots" << std::endl;
+    {
+        motion_slot<16> small;
+        Recorder<16> recorder;
+        recorder.begin(small, 0);
+        size_t recorded = 1;
+        std::vector<uint16_t> values(1, 0);
+        for (uint16_t v=300; recorder.tick(v); v += 300)
+            {
+                values.push_back(v);
+                recorded += 1;
+            }
+        assert(recorder.is_full() && !recorder.tick(0));
+        recorder.end();
+        /* five absolute values fill 15 bytes, a sixth one does not fit */
+        assert(recorded == 6 && small.ticks == 6 && small.size == 15);
+
+        Player<16> player;
+        player.begin(small);
+        for (uint16_t v: values)
+            { assert(player.tick() == v); }
+        assert(player.tick() == 0 && player.elapsed() == 1);
+
+        /* a pending run always has room */
+        recorder.begin(small, 0);
+        for (int i=1; i<=15; ++i)
+            { assert(recorder.tick(i & 1)); }
+        assert(small.size == 15);
+        assert(recorder.tick(1) && recorder.tick(1) && !recorder.tick(0));
+        recorder.end();
+        assert(small.size == 16 && small.bytes[15] == (HOLD | 1) && small.ticks == 18);
+
+        /* empty slots hold their value */
+        motion_slot<16> empty{};
+        player.begin(empty);
+        assert(player.tick() == 0 && !player.changed());
+    }
+
+    std::cout << "Testing recorded traces" << std::endl;
+    {
+        const std::vector<Trace> traces = {
+            gestures("knob, slow turns", 127, 0.5e6, 3e6, 1.5e6, 1),
+            gestures("fader, fast moves", 127, 0.2e6, 1e6, 0.3e6, 2),
+            wobble("knob, 2Hz wobble", 127, 2, 0.3, 3),
+            gestures("CV 12 bits, turns", 4095, 0.5e6, 3e6, 1.5e6, 4),
+            wobble("CV 12 bits, 2Hz", 4095, 2, 2, 5),
+        };
+
+        /* 96 ppqn at 120 BPM */
+        const double tick = 60e6 / (120 * 96);
+        printf("\t%lu bytes slots, %.0f ticks per second, raw samples of 6 bytes (time and value)\n",
+            slot_type::Size, 1e6 / tick);
+        printf("\t%-20s %7s %8s %7s %8s %7s %9s %9s %8s\n",
+            "", "events", "raw(B)", "ticks", "coded(B)", "ratio", "B/tick", "slot(s)", "ns/tick");
+
+        for (const Trace& trace: traces)
+            {
+                const std::vector<uint16_t> values = trace.quantize(tick, DURATION);
+
+                /* whole trace, in a slot large enough */
+                static motion_slot<1 << 15> large;
+                Recorder<1 << 15> recorder;
+                recorder.begin(large, values.front());
+                for (size_t i=1; i<values.size(); ++i)
+                    { assert(recorder.tick(values[i])); }
+                recorder.end();
+
+                Player<1 << 15> player;
+                player.begin(large);
+                for (uint16_t v: values)
+                    { assert(player.tick() == v); }
+
+                /* playback cost, over several loops */
+                constexpr int LOOPS = 20;
+                uint32_t sum = 0;
+                auto begin = std::chrono::steady_clock::now();
+                for (int l=0; l<LOOPS; ++l)
+                    for (size_t i=0; i<values.size(); ++i)
+                        { sum += player.tick(); }
+                const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count()
+                    / (LOOPS * values.size());
+                assert(sum > 0);
+
+                /* duration fitting in a regular slot */
+                slot_type slot;
+                const size_t fitting = record(slot, values);
+                check_playback(slot, values);
+
+                const size_t raw = trace.samples.size() * 6;
+                printf("\t%-20s %7lu %8lu %7lu %8u %7.1f %9.3f %9.1f %8.2f\n",
+                    trace.name, trace.samples.size(), raw, values.size(), large.size,
+                    static_cast<double>(raw) / large.size, static_cast<double>(large.size) / values.size(),
+                    fitting * tick / 1e6, ns);
+                assert(large.size < raw);
+            }
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,329 @@
+#include "midi/midi_scheduler/midi_scheduler.h"
+#include "midi/midi_input/midi_input.h"
+#include "midi/midi_output/midi_output.h"
+
+#include "../../hw/sim/clock.hpp"
+#include "../../hw/sim/uart.hpp"
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <algorithm>
+
+using namespace midi;
+using namespace midi::midi_scheduler;
+
+static std::array<sim::Uart, BUSES_COUNT> uarts;
+
+struct SimContext
+{
+    static size_t available_for_write(bus b)
+        { return uarts[static_cast<uint8_t>(b)].available(); }
+    static size_t write(bus b, const uint8_t* bytes, size_t count)
+        { return uarts[static_cast<uint8_t>(b)].write(bytes, count); }
+    static unsigned long micros()       { return sim::Clock::micros(); }
+};
+
+using output_type = midi_output::MidiOutput<SimContext>;
+using scheduler_type = Scheduler<output_type>;
+
+static void reset_bench()
+{
+    sim::Clock::reset();
+    for (auto& u: uarts)
+        { u = sim::Uart{}; }
+}
+
+/** A message decoded from the wire, stamped with the start of its last byte */
+struct received
+{
+    midi_input::event e;
+    unsigned long end;
+};
+
+static std::vector<received> parse(const sim::Uart& uart)
+{
+    midi_input::Parser parser;
+    std::vector<received> messages;
+    for (size_t i=0; i<uart.bytes.size(); ++i)
+        {
+            parser.feed(uart.bytes[i], uart.starts[i]);
+            midi_input::event e;
+            while (parser.poll(e))
+                { messages.push_back({e, uart.starts[i]}); }
+        }
+    return messages;
+}
+
+static void run(scheduler_type& scheduler, unsigned long duration_us, unsigned long loop_us=200)
+{
+    const unsigned long end = sim::Clock::micros() + duration_us;
+    while (sim::Clock::micros() < end)
+        {
+            scheduler.flush(sim::Clock::micros());
+            sim::Clock::advance(loop_us * 1000);
+        }
+}
+
+struct Report
+{
+    size_t notes = 0;
+    size_t notes_received = 0;
+    unsigned long note_max_us = 0;
+    unsigned long note_p99_us = 0;
+    size_t controls = 0;
+    size_t controls_received = 0;
+    size_t stale_controls = 0;      ///< controllers whose last value never reached the wire
+    scheduler_counters counters{};
+};
+
+/**
+ * Control surface flooding controllers: 9 faders swept every millisecond, about 9 times the line bandwidth,
+ *  while pads send a note on every 20 to 80ms. Pad notes are numbered by their note and velocity.
+ *  Runs either straight into the output buffer or through the scheduler
+ */
+static Report flood(bool scheduled, unsigned long duration_us)
+{
+    reset_bench();
+    std::mt19937 rand(0xf1d);
+    std::uniform_int_distribution<unsigned long> pads_period(20000, 80000);
+    constexpr unsigned long LOOP_US = 200;
+
+    output_type output;
+    output.setup();
+    scheduler_type scheduler(output);
+    scheduler.setup(0);
+
+    Report report;
+    std::vector<unsigned long> sent_at;
+    std::array<std::array<int, CONTROLLERS_COUNT>, CHANNELS_COUNT> last_control;
+    for (auto& c: last_control)
+        { c.fill(-1); }
+
+    unsigned long next_fader = 0, next_pad = 1000;
+    unsigned long t = 0;
+    while ((t = sim::Clock::micros()) < duration_us)
+        {
+            auto send = [&](const message& msg, uint8_t source) {
+                    if (scheduled)
+                        { scheduler.send(bus::Bus1, msg, source); }
+                    else
+                        { output.send(bus::Bus1, msg); }
+                };
+
+            for (; next_fader <= t; next_fader += 1000)
+                for (uint8_t fader=0; fader<9; ++fader)
+                    {
+                        const uint8_t value = (next_fader / 1000 + fader * 11) & DATA_BITMASK;
+                        send({make_status(status::ControlChange, fader), 7, value}, 0);
+                        last_control[fader][7] = value;
+                        report.controls += 1;
+                    }
+            for (; next_pad <= t; next_pad += pads_period(rand))
+                {
+                    const size_t id = sent_at.size();
+                    send({make_status(status::NoteOn, 0), static_cast<uint8_t>(id & DATA_BITMASK),
+                        static_cast<uint8_t>(1 + ((id >> 7) % 127))}, 1);
+                    sent_at.push_back(t);
+                }
+
+            if (scheduled)
+                { scheduler.flush(t); }
+            else
+                { output.flush(); }
+            sim::Clock::advance(LOOP_US * 1000);
+        }
+
+    /* faders stop, let queues drain */
+    for (unsigned long i=0; i<2000000 / LOOP_US; ++i)
+        {
+            scheduled ? scheduler.flush(sim::Clock::micros()) : output.flush();
+            sim::Clock::advance(LOOP_US * 1000);
+        }
+
+    report.notes = sent_at.size();
+    std::vector<unsigned long> latencies;
+    std::array<std::array<int, CONTROLLERS_COUNT>, CHANNELS_COUNT> wire_control;
+    for (auto& c: wire_control)
+        { c.fill(-1); }
+    for (const auto& r: parse(uarts[0]))
+        {
+            if (type_of(r.e.status) == status::NoteOn && r.e.data2 != 0)
+                {
+                    const size_t id = r.e.data1 | ((r.e.data2 - 1) << 7);
+                    assert(id < sent_at.size());
+                    latencies.push_back(r.end - sent_at[id]);
+                }
+            else if (type_of(r.e.status) == status::ControlChange)
+                {
+                    wire_control[channel_of(r.e.status)][r.e.data1] = r.e.data2;
+                    report.controls_received += 1;
+                }
+        }
+    for (uint8_t c=0; c<CHANNELS_COUNT; ++c)
+        for (uint8_t cc=0; cc<CONTROLLERS_COUNT; ++cc)
+            { report.stale_controls += wire_control[c][cc] != last_control[c][cc]; }
+
+    report.notes_received = latencies.size();
+    if (!latencies.empty())
+        {
+            std::sort(latencies.begin(), latencies.end());
+            report.note_max_us = latencies.back();
+            report.note_p99_us = latencies[latencies.size() * 99 / 100];
+        }
+    report.counters = scheduler.counters(bus::Bus1);
+    return report;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing priority levels" << std::endl;
+    {
+        assert(level_of(make_status(status::NoteOn, 3)) == level::Urgent);
+        assert(level_of(make_status(status::NoteOff, 15)) == level::Urgent);
+        assert(level_of(static_cast<uint8_t>(status::Clock)) == level::Urgent);
+        assert(level_of(static_cast<uint8_t>(status::Stop)) == level::Urgent);
+        assert(level_of(static_cast<uint8_t>(status::SongPosition)) == level::Urgent);
+        assert(level_of(make_status(status::ControlChange, 0)) == level::Controls);
+        assert(level_of(make_status(status::PitchBend, 0)) == level::Others);
+        assert(level_of(make_status(status::ProgramChange, 0)) == level::Others);
+        assert(level_of(static_cast<uint8_t>(status::SongSelect)) == level::Others);
+    }
+
+    std::cout << "Testing notes overtake waiting controllers" << std::endl;
+    {
+        reset_bench();
+        output_type output;
+        output.setup();
+        scheduler_type scheduler(output);
+        scheduler.setup(0);
+
+        for (uint8_t cc=0; cc<20; ++cc)
+            { assert(scheduler.send(bus::Bus1, {make_status(status::ControlChange, 0), cc, 1})); }
+        assert(scheduler.send(bus::Bus1, {make_status(status::NoteOn, 0), 60, 100}, 1));
+        assert(scheduler.pending(bus::Bus1, level::Controls) == 20);
+        assert(scheduler.pending(bus::Bus1, level::Urgent) == 1);
+
+        scheduler.flush(0);
+        const auto messages = parse(uarts[0]);
+        assert(!messages.empty() && type_of(messages[0].e.status) == status::NoteOn && messages[0].e.data1 == 60);
+        /* no more than the allowed depth waits in the output buffer */
+        assert(output.occupancy(bus::Bus1) <= SchedulerDefaultSettings::QueueDepth);
+
+        run(scheduler, 100000);
+        assert(parse(uarts[0]).size() == 21);
+        assert(scheduler.counters(bus::Bus1).released == 21);
+
+        const error::status_byte sysex = scheduler.send(bus::Bus1, {static_cast<uint8_t>(status::SysExStart), 0, 0});
+        assert(static_cast<error::errcode>(sysex) == error::errcode::INVALID_ARGUMENT);
+        assert(!scheduler.send(bus::Bus1, {make_status(status::NoteOn, 0), 60, 100}, SOURCES_COUNT));
+    }
+
+    std::cout << "Testing controllers collapse to their latest value" << std::endl;
+    {
+        reset_bench();
+        output_type output;
+        output.setup();
+        scheduler_type scheduler(output);
+        scheduler.setup(0);
+
+        for (uint8_t v=0; v<50; ++v)
+            {
+                scheduler.send(bus::Bus1, {make_status(status::ControlChange, 2), 7, v});
+                scheduler.send(bus::Bus1, {make_status(status::ControlChange, 3), 7, static_cast<uint8_t>(100 - v)});
+            }
+        assert(scheduler.pending(bus::Bus1, level::Controls) == 2);
+        assert(scheduler.counters(bus::Bus1).merged == 98);
+        assert(scheduler.counters(bus::Bus1).queued == 2);
+
+        run(scheduler, 10000);
+        const auto messages = parse(uarts[0]);
+        assert(messages.size() == 2);
+        /* first queued, first released */
+        assert(messages[0].e.status == make_status(status::ControlChange, 2) && messages[0].e.data2 == 49);
+        assert(messages[1].e.status == make_status(status::ControlChange, 3) && messages[1].e.data2 == 51);
+
+        /* a full queue refuses new controllers but still merges waiting ones */
+        for (uint16_t key=0; key<CONTROLS_QUEUE_SIZE + 10; ++key)
+            { scheduler.send(bus::Bus1, {make_status(status::ControlChange, key >> 7), static_cast<uint8_t>(key & DATA_BITMASK), 1}); }
+        assert(scheduler.counters(bus::Bus1).dropped == 10);
+        assert(scheduler.send(bus::Bus1, {make_status(status::ControlChange, 0), 0, 2}));
+        assert(scheduler.counters(bus::Bus1).merged == 99);
+    }
+
+    std::cout << "Testing per source rate caps" << std::endl;
+    {
+        /* both sources together below the line bandwidth */
+        const unsigned long default_cap = SchedulerDefaultSettings::RateCap;
+        SchedulerDefaultSettings::RateCap = 600;
+        reset_bench();
+        output_type output;
+        output.setup();
+        scheduler_type scheduler(output);
+        scheduler.setup(0);
+
+        /* two sources, each far above its cap, on their own channel:
+         *  at most the burst plus the refill, at least the refill */
+        for (uint8_t cc=0; cc<120; ++cc)
+            {
+                scheduler.send(bus::Bus1, {make_status(status::ControlChange, 0), cc, 1}, 0);
+                scheduler.send(bus::Bus1, {make_status(status::ControlChange, 1), cc, 1}, 1);
+            }
+        run(scheduler, 100000);
+
+        size_t per_source[2] = {0, 0};
+        for (const auto& r: parse(uarts[0]))
+            { per_source[channel_of(r.e.status)] += 1; }
+        const double allowed = (SchedulerDefaultSettings::RateBurst + SchedulerDefaultSettings::RateCap * 0.1) / 3;
+        printf("\t100ms: %lu and %lu messages released, %.1f allowed per source\n", per_source[0], per_source[1], allowed);
+        for (size_t n: per_source)
+            { assert(n <= allowed + 1 && n + 1 >= SchedulerDefaultSettings::RateCap * 0.1 / 3); }
+        assert(scheduler.counters(bus::Bus1).throttled > 0);
+
+        /* an uncapped urgent message still goes through at once */
+        const unsigned long sent = sim::Clock::micros();
+        scheduler.send(bus::Bus1, {make_status(status::NoteOn, 5), 1, 1}, 0);
+        run(scheduler, 5000);
+        const auto messages = parse(uarts[0]);
+        const auto note = std::find_if(messages.begin(), messages.end(),
+            [](const received& r) { return r.e.status == make_status(status::NoteOn, 5); });
+        assert(note != messages.end());
+        assert(note->end - sent <= (SchedulerDefaultSettings::QueueDepth + sim::Uart::FIFO_SIZE + 3) * BYTE_DURATION_US + 200);
+        SchedulerDefaultSettings::RateCap = default_cap;
+    }
+
+    std::cout << "\nFaders flood with pad presses on a single bus, 20s" << std::endl;
+    printf("%10s | %7s %9s %9s %9s | %9s %9s %7s | %8s %8s %9s\n",
+        "path", "notes", "received", "lat.p99", "lat.max", "CC sent", "CC wire", "stale",
+        "merged", "dropped", "throttled");
+    const Report direct = flood(false, 20000000);
+    const Report scheduled = flood(true, 20000000);
+    for (const Report* r: {&direct, &scheduled})
+        {
+            printf("%10s | %7lu %9lu %7.2fms %7.2fms | %9lu %9lu %7lu | %8lu %8lu %9lu\n",
+                r == &direct ? "direct" : "scheduled",
+                r->notes, r->notes_received, r->note_p99_us / 1e3, r->note_max_us / 1e3,
+                r->controls, r->controls_received, r->stale_controls,
+                r->counters.merged, r->counters.dropped, r->counters.throttled);
+        }
+
+    /* a note waits behind the allowed depth, the message on the wire and the serial FIFO,
+     *  plus a loop before being released and the note itself */
+    const unsigned long bound_us = (SchedulerDefaultSettings::QueueDepth + 3 + sim::Uart::FIFO_SIZE + 3) * BYTE_DURATION_US + 200;
+    assert(scheduled.notes_received == scheduled.notes);
+    assert(scheduled.note_max_us <= bound_us);
+    assert(scheduled.stale_controls == 0);
+    assert(scheduled.counters.dropped == 0 && scheduled.counters.merged > 0);
+    /* straight into the output buffer notes wait behind a full ring */
+    assert(direct.note_p99_us > 10 * scheduled.note_max_us);
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,372 @@
+
+#include "midi/midi_sequencer/midi_sequencer.h"
+
+#include "../../hw/sim/clock.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <algorithm>
+
+using namespace midi;
+using namespace midi::midi_sequencer;
+
+/**
+ * Output stand-in: records sent messages with their time in us
+ */
+struct Device
+{
+    struct record
+    {
+        double time;
+        message msg;
+    };
+
+    static unsigned long micros()           { return sim::Clock::micros(); }
+    static void send(const message& m)      { sent.push_back(record{sim::Clock::now() / 1e3, m}); }
+
+    inline static std::vector<record> sent;
+};
+
+using sequencer_type = Sequencer<Device>;
+
+struct Stats
+{
+    double mean = 0;
+    double rms = 0;         ///< around the mean
+    double peak = 0;        ///< peak to peak
+    double late = 0;        ///< largest value
+
+    static Stats of(const std::vector<double>& values)
+        {
+            Stats s;
+            if (values.empty())
+                { return s; }
+            for (double v: values) { s.mean += v; }
+            s.mean /= values.size();
+            for (double v: values) { s.rms += (v - s.mean) * (v - s.mean); }
+            s.rms = std::sqrt(s.rms / values.size());
+            const auto range = std::minmax_element(values.begin(), values.end());
+            s.peak = *range.second - *range.first;
+            s.late = *range.second;
+            return s;
+        }
+};
+
+/**
+ * Main loop iterations last from 200us to 3ms, one in 50 stalls for 12ms, as a SD card write would.
+ *  With @c timer, the tick interrupt runs every tick period with a few us of latency,
+ *  otherwise it is called from the main loop after each update.
+ */
+static void run(sequencer_type& sequencer, double until_us, bool timer, std::mt19937& rand)
+{
+    std::uniform_real_distribution<double> loop(200, 3000);
+    std::uniform_real_distribution<double> latency(0, 3);
+    std::uniform_int_distribution<int> stall(0, 49);
+
+    const double period = sequencer.tick_period();
+    double next_loop = sim::Clock::now() / 1e3;
+    double next_tick = std::ceil(next_loop / period) * period;
+
+    while (sim::Clock::now() / 1e3 < until_us)
+        {
+            const double next = timer ? std::min(next_loop, next_tick + latency(rand)) : next_loop;
+            if (next * 1e3 > sim::Clock::now())
+                { sim::Clock::advance(static_cast<sim::Clock::time_point>(next * 1e3) - sim::Clock::now()); }
+
+            if (timer && next != next_loop)
+                {
+                    sequencer.on_tick();
+                    next_tick += period;
+                    continue;
+                }
+
+            sequencer.update(sim::Clock::micros());
+            if (!timer)
+                { sequencer.on_tick(); }
+            next_loop += stall(rand) == 0 ? 12000 : loop(rand);
+        }
+}
+
+/** Every step of every track active, distinct notes per track */
+static void fill(pattern& p, uint8_t length)
+{
+    for (uint8_t t=0; t<TRACKS_COUNT; ++t)
+        {
+            p.lengths[t] = length;
+            for (uint8_t s=0; s<length; ++s)
+                { assert(p.set(t, s, 36 + t * 8 + s % 8, 64 + s, GATE_UNIT / 2)); }
+        }
+}
+
+/** Note ons of a channel, as the count of steps they were played on */
+static std::vector<double> note_ons(uint8_t channel)
+{
+    std::vector<double> times;
+    for (const Device::record& r: Device::sent)
+        {
+            if (r.msg.status == make_status(status::NoteOn, channel))
+                { times.push_back(r.time); }
+        }
+    return times;
+}
+
+/**
+ * Checks every note on is closed by a note off of the same note, before the next note of its channel
+ */
+static void check_balanced()
+{
+    for (uint8_t c=0; c<TRACKS_COUNT; ++c)
+        {
+            int playing = -1;
+            for (const Device::record& r: Device::sent)
+                {
+                    if (channel_of(r.msg.status) != c)
+                        { continue; }
+                    if (type_of(r.msg.status) == status::NoteOn)
+                        {
+                            assert(playing == -1);
+                            playing = r.msg.data1;
+                        }
+                    else
+                        {
+                            assert(type_of(r.msg.status) == status::NoteOff);
+                            assert(playing == r.msg.data1 || playing == -1);
+                            playing = -1;
+                        }
+                }
+            assert(playing == -1);
+        }
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing timer wheel" << std::endl;
+    {
+        TimerWheel<8, 4> wheel;
+        wheel.setup(1000, 100);
+        std::vector<unsigned long> fired;
+        auto record = [&fired](const message& m, unsigned long time) { fired.push_back(time); assert(m.data1 == time % 128); };
+        auto at = [](unsigned long time) { return message{0x90, static_cast<uint8_t>(time % 128), 1}; };
+
+        /* out of order, sharing slots, farther than a turn, already due */
+        for (unsigned long time: {1250UL, 1210UL, 1250UL, 2900UL, 1730UL, 900UL})
+            { assert(wheel.insert(time, at(time))); }
+        assert(wheel.size() == 6);
+
+        assert(wheel.expire(1000, record) == 1 && fired.back() == 900);
+        assert(wheel.expire(1249, record) == 1 && fired.back() == 1210);
+        assert(wheel.expire(1250, record) == 2);
+        /* a turn is 400us: 2900 shares the slot of 1300 to 1400 and waits for its turn */
+        assert(wheel.expire(1500, record) == 0);
+        /* late expiry catches up every slot */
+        assert(wheel.expire(5000, record) == 2);
+        assert(fired == std::vector<unsigned long>({900, 1210, 1250, 1250, 1730, 2900}));
+        assert(wheel.size() == 0);
+
+        /* full wheel refuses, clearing frees every node */
+        for (int i=0; i<8; ++i)
+            { assert(wheel.insert(6000 + i, at(i))); }
+        assert(!wheel.insert(6000, at(0)));
+        wheel.clear();
+        assert(wheel.size() == 0 && wheel.insert(6000, at(6000)));
+
+        /* wrapping times */
+        wheel.setup(static_cast<unsigned long>(-150), 100);
+        fired.clear();
+        assert(wheel.insert(static_cast<unsigned long>(-20), at(static_cast<unsigned long>(-20))) && wheel.insert(30, at(30)));
+        assert(wheel.expire(10, record) == 1 && wheel.expire(40, record) == 1);
+    }
+
+    std::cout << "Testing pattern" << std::endl;
+    {
+        pattern p;
+        p.clear();
+        assert(p.set(0, 3, 60, 100) && p.is_active(0, 3));
+        assert(p.set(7, 63, 127, 127, 255, 0) && p.is_active(7, 63));
+        assert(!p.set(8, 0, 60, 100));
+        assert(!p.set(0, 64, 60, 100));
+        assert(!p.set(0, 0, 128, 100));
+        assert(!p.set(0, 0, 60, 100, 0));
+        assert(!p.set(0, 0, 60, 100, 8, 101));
+        p.toggle(0, 3);
+        assert(!p.is_active(0, 3));
+        printf("\tpattern: %lu bytes\n", sizeof(pattern));
+    }
+
+    std::cout << "Testing steps timing" << std::endl;
+    {
+        sim::Clock::reset();
+        Device::sent.clear();
+        sequencer_type sequencer;
+        sequencer.setup();
+        assert(!sequencer.set_tempo(1999) && !sequencer.set_tempo(40001));
+        assert(sequencer.set_tempo(12000));
+        sequencer.steps().swing = 58;
+        sequencer.start(0);
+
+        /* 120 BPM sixteenths: 125ms per step, 58% swing delays odd steps by 20ms */
+        assert(sequencer.time_of(0) == 20000);
+        assert(sequencer.time_of(1) == 20000 + 125000 + 20000);
+        assert(sequencer.time_of(2) == 20000 + 250000);
+
+        /* tempo changes keep scheduled steps in place */
+        sequencer.steps().swing = SWING_MIN;
+        sequencer.update(300000);
+        const uint32_t next = sequencer.next_step();
+        const unsigned long before = sequencer.time_of(next);
+        assert(sequencer.set_tempo(24000));
+        assert(sequencer.time_of(next) == before);
+        assert(sequencer.time_of(next + 2) == before + 125000);
+    }
+
+    std::cout << "Testing resolution changes" << std::endl;
+    {
+        sim::Clock::reset();
+        Device::sent.clear();
+        std::mt19937 rand(11);
+        sequencer_type sequencer;
+        sequencer.setup();
+        assert(sequencer.resolution() == TICKS_PER_STEP_DEFAULT);
+        assert(!sequencer.set_resolution(0) && !sequencer.set_resolution(TICKS_PER_STEP_MAX + 1));
+        assert(sequencer.resolution() == TICKS_PER_STEP_DEFAULT);
+
+        /* longest step at the slowest tempo: a 4/4 bar at 20 BPM lasts 12s */
+        assert(sequencer.set_tempo(2000) && sequencer.set_resolution(TICKS_PER_STEP_MAX));
+        sequencer.start(0);
+        assert(sequencer.time_of(1) - sequencer.time_of(0) == 12000000);
+        sequencer.stop(0);
+
+        /* 120 BPM sixteenths, then eighths from the next scheduled step */
+        fill(sequencer.steps(), 16);
+        assert(sequencer.set_tempo(12000) && sequencer.set_resolution(6));
+        sequencer.start(0);
+        run(sequencer, 1e6, true, rand);
+        const uint32_t next = sequencer.next_step();
+        const unsigned long before = sequencer.time_of(next);
+        assert(sequencer.set_resolution(12) && sequencer.resolution() == 12);
+        assert(sequencer.time_of(next) == before);
+        assert(sequencer.time_of(next + 1) == before + 250000);
+        run(sequencer, 3e6, true, rand);
+
+        /* played steps follow: 125ms apart before the change, 250ms after */
+        const std::vector<double> ons = note_ons(0);
+        assert(ons.size() > next + 4);
+        for (size_t k=1; k<ons.size(); ++k)
+            {
+                const double expected = k <= next ? 125000 : 250000;
+                assert(std::abs(ons[k] - ons[k - 1] - expected) <= sequencer.tick_period() + 4);
+            }
+
+        /* refused resolutions leave the running sequence untouched */
+        const unsigned long later = sequencer.time_of(sequencer.next_step() + 1);
+        assert(!sequencer.set_resolution(0));
+        assert(sequencer.time_of(sequencer.next_step() + 1) == later);
+        run(sequencer, 3.5e6, true, rand);
+        sequencer.stop(sim::Clock::micros());
+        run(sequencer, 4e6, true, rand);
+        check_balanced();
+        assert(sequencer.counters().dropped.load() == 0);
+    }
+
+    std::cout << "Testing stop and probability" << std::endl;
+    {
+        sim::Clock::reset();
+        Device::sent.clear();
+        std::mt19937 rand(7);
+        sequencer_type sequencer;
+        sequencer.setup(42);
+        fill(sequencer.steps(), 16);
+        for (uint8_t s=0; s<16; ++s)
+            {
+                sequencer.steps().probabilities[3][s] = 50;
+                sequencer.steps().gates[5][s] = 40;         /* two steps and a half, cut by the next note */
+            }
+        sequencer.steps().lengths[6] = 0;
+        sequencer.set_tempo(15000);
+        sequencer.start(0);
+        run(sequencer, 20e6, true, rand);
+
+        const size_t steps = note_ons(0).size();
+        const double played = static_cast<double>(note_ons(3).size()) / steps;
+        assert(played > 0.4 && played < 0.6);
+        assert(note_ons(5).size() == steps && note_ons(6).empty());
+        assert(sequencer.counters().skipped.load() == steps - note_ons(3).size());
+
+        /* stopping while notes play closes them, nothing already scheduled plays after */
+        const double stopped = sim::Clock::now() / 1e3;
+        sequencer.stop(sim::Clock::micros());
+        run(sequencer, stopped + 100000, true, rand);
+        check_balanced();
+        for (const Device::record& r: Device::sent)
+            { assert(type_of(r.msg.status) != status::NoteOn || r.time <= stopped); }
+
+        /* and starting again does not replay the previous run */
+        const size_t before = Device::sent.size();
+        sequencer.start(sim::Clock::micros());
+        run(sequencer, stopped + 1e6, true, rand);
+        sequencer.stop(sim::Clock::micros());
+        run(sequencer, stopped + 1.1e6, true, rand);
+        assert(Device::sent.size() > before);
+        check_balanced();
+        assert(sequencer.counters().dropped.load() == 0);
+        printf("\t%.0f%% of 50%% steps played, %lu steps\n", played * 100, steps);
+    }
+
+    std::cout << "Testing jitter at 300 BPM, all tracks full" << std::endl;
+    {
+        printf("\t%-24s %6s %10s %10s %10s %10s %6s\n", "", "notes", "delay(us)", "max(us)", "rms(us)", "p-p(us)", "drops");
+        for (bool timer: {true, false})
+            {
+                sim::Clock::reset();
+                Device::sent.clear();
+                std::mt19937 rand(3);
+                sequencer_type sequencer;
+                sequencer.setup();
+                fill(sequencer.steps(), STEPS_MAX);
+                sequencer.steps().swing = 58;
+                sequencer.set_tempo(30000);
+                /* steps do not fall on ticks */
+                sim::Clock::advance(1337000);
+                sequencer.start(sim::Clock::micros());
+                run(sequencer, 60e6, timer, rand);
+
+                std::vector<double> jitter;
+                for (uint8_t c=0; c<TRACKS_COUNT; ++c)
+                    {
+                        const std::vector<double> ons = note_ons(c);
+                        for (size_t k=0; k<ons.size(); ++k)
+                            { jitter.push_back(ons[k] - sequencer.time_of(k)); }
+                    }
+                const Stats s = Stats::of(jitter);
+                printf("\t%-24s %6lu %10.1f %10.1f %10.1f %10.1f %6lu\n",
+                    timer ? "timer wheel, 250us ticks" : "fired from main loop", jitter.size(),
+                    s.mean, s.late, s.rms, s.peak, sequencer.counters().dropped.load());
+
+                /* 60s of sixteenths at 300 BPM on 8 tracks */
+                assert(jitter.size() >= 8 * 1150);
+                assert(sequencer.counters().dropped.load() == 0);
+                if (timer)
+                    {
+                        assert(sequencer.counters().late.load() == 0);
+                        assert(s.late <= sequencer.tick_period() + 4 && s.peak <= 8);
+                    }
+                else
+                    { assert(s.late > 5000); }
+
+                sequencer.stop(sim::Clock::micros());
+                run(sequencer, 60.1e6, timer, rand);
+                check_balanced();
+            }
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -7,11 +7,44 @@ echo "Compiling Tests for Utility library"
 DL_LIST="utils/containers/tests-double_linked_list"
 QUEUES="utils/containers/tests-queues"
 SETS="utils/containers/tests-set"
+RING="utils/containers/tests-ring"
 
 ASYNC="utils/async/tests-async"
 
 LOGGING="utils/logging/tests-logging"
 
+LEDS_TIMING="hw/leds_driver/sim-leds_timing"
+LEDS_REGIONS="hw/leds_driver/tests-leds_regions"
+
+PADS_DEBOUNCE="hw/pads_driver/tests-pads_debounce"
+
+MATRIX_PIPELINE="hw/matrix_driver/tests-matrix_pipeline"
+
+ENCODERS_QUADRATURE="hw/encoders_driver/tests-encoders_quadrature"
+
+ANALOG_FILTER="hw/analog_driver/tests-analog_filter"
+ANALOG_ACQUISITION="hw/analog_driver/sim-analog_acquisition"
+
+LATENCY="utils/latency/sim-latency"
+
+MIDI_OUTPUT="midi/midi_output/tests-midi_output"
+MIDI_INPUT="midi/midi_input/tests-midi_input"
+MIDI_MAPPING="midi/midi_mapping/tests-midi_mapping"
+MIDI_FEEDBACK="midi/midi_feedback/sim-midi_feedback"
+MIDI_CLOCK="midi/midi_clock/sim-midi_clock"
+MIDI_ROUTER="midi/midi_router/sim-midi_router"
+MIDI_SCHEDULER="midi/midi_scheduler/sim-midi_scheduler"
+CONFIG_PARSER="config/config_parser/tests-config_parser"
+CONFIG_CACHE="config/config_cache/sim-config_cache"
+STATE_STORE="config/state_store/sim-state_store"
+BOOT="utils/boot/sim-boot"
+BOOT_LOG="utils/logging/sim-boot_log"
+REFLECT="utils/reflect/tests-reflect"
+MIDI_SEQUENCER="midi/midi_sequencer/sim-midi_sequencer"
+MIDI_SAMPLER="midi/midi_sampler/sim-midi_sampler"
+PWM_DRIVER="hw/pwm_driver/sim-pwm_driver"
+DEFERRED_LOG="utils/logging/tests-deferred_log"
+
 TESTDIR="unit_tests"
 BUILDIDR="build/unit_tests"
 LOGSDIR="logs"
@@ -20,6 +53,27 @@ mkdir -p $BUILDIDR/utils/containers/
 mkdir -p $BUILDIDR/utils/logging/
 mkdir -p $BUILDIDR/utils/mycelium/
 mkdir -p $BUILDIDR/utils/async/
+mkdir -p $BUILDIDR/hw/leds_driver/
+mkdir -p $BUILDIDR/hw/pads_driver/
+mkdir -p $BUILDIDR/hw/matrix_driver/
+mkdir -p $BUILDIDR/hw/encoders_driver/
+mkdir -p $BUILDIDR/hw/analog_driver/
+mkdir -p $BUILDIDR/utils/latency/
+mkdir -p $BUILDIDR/midi/midi_output/
+mkdir -p $BUILDIDR/midi/midi_input/
+mkdir -p $BUILDIDR/midi/midi_mapping/
+mkdir -p $BUILDIDR/midi/midi_feedback/
+mkdir -p $BUILDIDR/midi/midi_clock/
+mkdir -p $BUILDIDR/midi/midi_router/
+mkdir -p $BUILDIDR/midi/midi_scheduler/
+mkdir -p $BUILDIDR/config/config_parser/
+mkdir -p $BUILDIDR/config/config_cache/
+mkdir -p $BUILDIDR/config/state_store/
+mkdir -p $BUILDIDR/utils/boot/
+mkdir -p $BUILDIDR/utils/reflect/
+mkdir -p $BUILDIDR/midi/midi_sequencer/
+mkdir -p $BUILDIDR/midi/midi_sampler/
+mkdir -p $BUILDIDR/hw/pwm_driver/
 mkdir -p $LOGSDIR
 
 INCLUDES="-Imycelium/ \
@@ -81,6 +135,23 @@ fi
 
 date >> $LOGFILE
 
+# ===== RING =====
+
+LOGFILE="$LOGSDIR/ring.log"
+
+echo "Testing $RING"
+date > $LOGFILE
+g++ -g -Wall -Werror -pthread $INCLUDES $TESTDIR/$RING.cpp -o $BUILDIDR/$RING >> $LOGFILE && $BUILDIDR/$RING >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
 # ===== ASYNC =====
 
 LOGFILE="$LOGSDIR/async.log"
@@ -96,6 +167,433 @@ else
     exit
 fi
 
+date >> $LOGFILE
+
+# ===== LEDS DRIVER TIMINGS =====
+
+LOGFILE="$LOGSDIR/leds-timing.log"
+
+echo "Testing $LEDS_TIMING"
+date > $LOGFILE
+g++ -g -Wall -Werror $INCLUDES $TESTDIR/$LEDS_TIMING.cpp mycelium/src/hw/leds_driver/leds_driver.cpp -o $BUILDIDR/$LEDS_TIMING >> $LOGFILE && $BUILDIDR/$LEDS_TIMING >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== LEDS DRIVER REGIONS =====
+
+LOGFILE="$LOGSDIR/leds-regions.log"
+
+echo "Testing $LEDS_REGIONS"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$LEDS_REGIONS.cpp mycelium/src/hw/leds_driver/leds_driver.cpp -o $BUILDIDR/$LEDS_REGIONS >> $LOGFILE && $BUILDIDR/$LEDS_REGIONS >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== PADS DRIVER DEBOUNCE =====
+
+LOGFILE="$LOGSDIR/pads-debounce.log"
+
+echo "Testing $PADS_DEBOUNCE"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$PADS_DEBOUNCE.cpp mycelium/src/hw/pads_driver/pads_driver.cpp -o $BUILDIDR/$PADS_DEBOUNCE >> $LOGFILE && $BUILDIDR/$PADS_DEBOUNCE >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MATRIX DRIVER PIPELINE =====
+
+LOGFILE="$LOGSDIR/matrix-pipeline.log"
+
+echo "Testing $MATRIX_PIPELINE"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$MATRIX_PIPELINE.cpp mycelium/src/hw/leds_driver/leds_driver.cpp mycelium/src/hw/matrix_driver/matrix_driver.cpp -o $BUILDIDR/$MATRIX_PIPELINE >> $LOGFILE && $BUILDIDR/$MATRIX_PIPELINE >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== ENCODERS DRIVER QUADRATURE =====
+
+LOGFILE="$LOGSDIR/encoders-quadrature.log"
+
+echo "Testing $ENCODERS_QUADRATURE"
+date > $LOGFILE
+g++ -g -Wall -Werror -pthread $INCLUDES $TESTDIR/$ENCODERS_QUADRATURE.cpp mycelium/src/hw/encoders_driver/encoders_driver.cpp -o $BUILDIDR/$ENCODERS_QUADRATURE >> $LOGFILE && $BUILDIDR/$ENCODERS_QUADRATURE >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== ANALOG DRIVER FILTER =====
+
+LOGFILE="$LOGSDIR/analog-filter.log"
+
+echo "Testing $ANALOG_FILTER"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$ANALOG_FILTER.cpp mycelium/src/hw/analog_driver/analog_driver.cpp -o $BUILDIDR/$ANALOG_FILTER >> $LOGFILE && $BUILDIDR/$ANALOG_FILTER >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== ANALOG DRIVER ACQUISITION =====
+
+LOGFILE="$LOGSDIR/analog-acquisition.log"
+
+echo "Testing $ANALOG_ACQUISITION"
+date > $LOGFILE
+g++ -g -Wall -Werror $INCLUDES $TESTDIR/$ANALOG_ACQUISITION.cpp mycelium/src/hw/analog_driver/analog_driver.cpp -o $BUILDIDR/$ANALOG_ACQUISITION >> $LOGFILE && $BUILDIDR/$ANALOG_ACQUISITION >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== LATENCY PROBES =====
+
+LOGFILE="$LOGSDIR/latency.log"
+
+echo "Testing $LATENCY"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$LATENCY.cpp mycelium/src/hw/leds_driver/leds_driver.cpp mycelium/src/hw/matrix_driver/matrix_driver.cpp mycelium/src/midi/midi_mapping/midi_mapping.cpp mycelium/src/midi/midi_output/midi_output.cpp -o $BUILDIDR/$LATENCY >> $LOGFILE && $BUILDIDR/$LATENCY >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MIDI OUTPUT =====
+
+LOGFILE="$LOGSDIR/midi-output.log"
+
+echo "Testing $MIDI_OUTPUT"
+date > $LOGFILE
+g++ -g -Wall -Werror $INCLUDES $TESTDIR/$MIDI_OUTPUT.cpp mycelium/src/midi/midi_output/midi_output.cpp -o $BUILDIDR/$MIDI_OUTPUT >> $LOGFILE && $BUILDIDR/$MIDI_OUTPUT >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MIDI INPUT =====
+
+LOGFILE="$LOGSDIR/midi-input.log"
+
+echo "Testing $MIDI_INPUT"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$MIDI_INPUT.cpp mycelium/src/midi/midi_input/midi_input.cpp mycelium/src/midi/midi_output/midi_output.cpp -o $BUILDIDR/$MIDI_INPUT >> $LOGFILE && $BUILDIDR/$MIDI_INPUT >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MIDI MAPPING =====
+
+LOGFILE="$LOGSDIR/midi-mapping.log"
+
+echo "Testing $MIDI_MAPPING"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$MIDI_MAPPING.cpp mycelium/src/midi/midi_mapping/midi_mapping.cpp -o $BUILDIDR/$MIDI_MAPPING >> $LOGFILE && $BUILDIDR/$MIDI_MAPPING >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MIDI LEDS FEEDBACK =====
+
+LOGFILE="$LOGSDIR/midi-feedback.log"
+
+echo "Testing $MIDI_FEEDBACK"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$MIDI_FEEDBACK.cpp mycelium/src/midi/midi_feedback/midi_feedback.cpp mycelium/src/midi/midi_mapping/midi_mapping.cpp mycelium/src/midi/midi_input/midi_input.cpp mycelium/src/hw/leds_driver/leds_driver.cpp -o $BUILDIDR/$MIDI_FEEDBACK >> $LOGFILE && $BUILDIDR/$MIDI_FEEDBACK >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MIDI CLOCK FOLLOWER =====
+
+LOGFILE="$LOGSDIR/midi-clock.log"
+
+echo "Testing $MIDI_CLOCK"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$MIDI_CLOCK.cpp mycelium/src/midi/midi_clock/midi_clock.cpp mycelium/src/midi/midi_input/midi_input.cpp -o $BUILDIDR/$MIDI_CLOCK >> $LOGFILE && $BUILDIDR/$MIDI_CLOCK >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MIDI ROUTER =====
+
+LOGFILE="$LOGSDIR/midi-router.log"
+
+echo "Testing $MIDI_ROUTER"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$MIDI_ROUTER.cpp mycelium/src/midi/midi_router/midi_router.cpp mycelium/src/midi/midi_input/midi_input.cpp mycelium/src/midi/midi_output/midi_output.cpp -o $BUILDIDR/$MIDI_ROUTER >> $LOGFILE && $BUILDIDR/$MIDI_ROUTER >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MIDI TX SCHEDULER =====
+
+LOGFILE="$LOGSDIR/midi-scheduler.log"
+
+echo "Testing $MIDI_SCHEDULER"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$MIDI_SCHEDULER.cpp mycelium/src/midi/midi_scheduler/midi_scheduler.cpp mycelium/src/midi/midi_input/midi_input.cpp mycelium/src/midi/midi_output/midi_output.cpp -o $BUILDIDR/$MIDI_SCHEDULER >> $LOGFILE && $BUILDIDR/$MIDI_SCHEDULER >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== CONFIG PARSER =====
+
+LOGFILE="$LOGSDIR/config-parser.log"
+
+echo "Testing $CONFIG_PARSER"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$CONFIG_PARSER.cpp mycelium/src/config/config_parser/config_parser.cpp mycelium/src/midi/midi_mapping/midi_mapping.cpp -o $BUILDIDR/$CONFIG_PARSER >> $LOGFILE && $BUILDIDR/$CONFIG_PARSER >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== CONFIG CACHE =====
+
+LOGFILE="$LOGSDIR/config-cache.log"
+
+echo "Testing $CONFIG_CACHE"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$CONFIG_CACHE.cpp mycelium/src/config/config_cache/config_cache.cpp mycelium/src/config/config_parser/config_parser.cpp mycelium/src/midi/midi_mapping/midi_mapping.cpp -o $BUILDIDR/$CONFIG_CACHE >> $LOGFILE && $BUILDIDR/$CONFIG_CACHE $BUILDIDR/config/config_cache/config.img >> $LOGFILE \
+    && g++ -O2 -Wall -Werror $INCLUDES tools/config_inspect/config_inspect.cpp mycelium/src/config/config_cache/config_cache.cpp mycelium/src/config/config_parser/config_parser.cpp mycelium/src/midi/midi_mapping/midi_mapping.cpp -o $BUILDIDR/config_inspect >> $LOGFILE \
+    && $BUILDIDR/config_inspect $BUILDIDR/config/config_cache/config.img >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== STATE STORE =====
+
+LOGFILE="$LOGSDIR/state-store.log"
+
+echo "Testing $STATE_STORE"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$STATE_STORE.cpp mycelium/src/config/state_store/state_store.cpp mycelium/src/config/config_parser/config_parser.cpp mycelium/src/midi/midi_mapping/midi_mapping.cpp -o $BUILDIDR/$STATE_STORE >> $LOGFILE && $BUILDIDR/$STATE_STORE >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== BOOT =====
+
+LOGFILE="$LOGSDIR/boot.log"
+
+echo "Testing $BOOT"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$BOOT.cpp mycelium/src/utils/boot/boot.cpp -o $BUILDIDR/$BOOT >> $LOGFILE && $BUILDIDR/$BOOT >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== BOOT LOG =====
+
+LOGFILE="$LOGSDIR/boot-log.log"
+
+echo "Testing $BOOT_LOG"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$BOOT_LOG.cpp mycelium/src/utils/boot/boot.cpp -o $BUILDIDR/$BOOT_LOG >> $LOGFILE && $BUILDIDR/$BOOT_LOG >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== REFLECT =====
+
+LOGFILE="$LOGSDIR/reflect.log"
+
+echo "Testing $REFLECT"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$REFLECT.cpp -o $BUILDIDR/$REFLECT >> $LOGFILE && $BUILDIDR/$REFLECT >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MIDI_SEQUENCER =====
+
+LOGFILE="$LOGSDIR/midi-sequencer.log"
+
+echo "Testing $MIDI_SEQUENCER"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$MIDI_SEQUENCER.cpp mycelium/src/midi/midi_sequencer/midi_sequencer.cpp -o $BUILDIDR/$MIDI_SEQUENCER >> $LOGFILE && $BUILDIDR/$MIDI_SEQUENCER >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== MIDI_SAMPLER =====
+
+LOGFILE="$LOGSDIR/midi-sampler.log"
+
+echo "Testing $MIDI_SAMPLER"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$MIDI_SAMPLER.cpp -o $BUILDIDR/$MIDI_SAMPLER >> $LOGFILE && $BUILDIDR/$MIDI_SAMPLER >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== PWM_DRIVER =====
+
+LOGFILE="$LOGSDIR/pwm-driver.log"
+
+echo "Testing $PWM_DRIVER"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror $INCLUDES $TESTDIR/$PWM_DRIVER.cpp mycelium/src/hw/pwm_driver/pwm_driver.cpp mycelium/src/hw/leds_driver/leds_driver.cpp -o $BUILDIDR/$PWM_DRIVER >> $LOGFILE && $BUILDIDR/$PWM_DRIVER >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
+date >> $LOGFILE
+
+# ===== DEFERRED_LOG =====
+
+LOGFILE="$LOGSDIR/deferred-log.log"
+
+echo "Testing $DEFERRED_LOG"
+date > $LOGFILE
+g++ -O2 -g -Wall -Werror -pthread $INCLUDES $TESTDIR/$DEFERRED_LOG.cpp -o $BUILDIDR/$DEFERRED_LOG >> $LOGFILE && $BUILDIDR/$DEFERRED_LOG >> $LOGFILE
+
+if [ $? -eq 0 ]; then
+    echo " ... passed"
+else
+    echo " ... failed"
+    exit
+fi
+
 date >> $LOGFILE
 exit
 
@@ -0,0 +1,295 @@
+
+#include "utils/boot/boot.h"
+
+#include "../../hw/sim/clock.hpp"
+
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <cassert>
+
+using namespace boot;
+
+struct SimContext
+{
+    static unsigned long micros()       { return sim::Clock::micros(); }
+};
+
+using executor_type = Executor<SimContext>;
+
+/**
+ * Cost of a step: CPU time spent in the step, and time it has to wait for a peripheral.
+ *  Computations are sliced in chunks of at most SLICE_US, waits are polled every POLL_US
+ */
+struct cost
+{
+    uint32_t busy_us;
+    uint32_t wall_us;
+    step_result outcome = step_result::Done;
+    uint8_t retries = 0;        ///< times the step asks to be retried first
+};
+
+static constexpr const uint32_t SLICE_US = 250;
+static constexpr const uint32_t POLL_US = 5;
+
+/**
+ * Estimates on the target, the SD card mount dominates:
+ *  it takes from 50 to 200ms depending on the card
+ */
+static const cost DEVICE_COSTS[DEVICE_STEPS_COUNT] = {
+    /* InitLogger */                {   50,      0 },
+    /* BeginSerial */               {  200,      0 },
+    /* InitSdCard */                {  400, 120000 },
+    /* LogToSerial */               {   20,      0 },
+    /* LogToFile */                 {  300,   8000 },
+    /* LoadConfig */                {  800,      0 },   /* cached configuration image */
+    /* ConfigureHardware */         {   20,      0 },
+    /* SetupLedsDriver */           {  100,      0 },
+    /* ConfigureI2CBuses */         {  100,   2000 },
+    /* ConfigureMcpRegisters */     {  600,   3000 },   /* 8 expanders */
+    /* SetupPadsDriver */           {   50,      0 },
+    /* SetupEncodersDriver */       {   50,      0 },
+    /* SetupAnalog */               {  100,   1000 },
+    /* SetupErrorLed */             {   10,      0 },
+    /* ConfigureRawGpio */          {  100,      0 },
+    /* InitState */                 {  300,   1500 },   /* first led frame on the wire */
+    /* InitControlSurface */        {  200,      0 },
+    /* SetupActionTimers */         {   50,      0 },
+    /* SetupActionsStack */         {   50,      0 },
+    /* SetupQuadratureDecoders */   {   50,      0 },
+    /* SetupMidi */                 {  100,      0 },
+    /* BeginMidi */                 {   50,    500 },
+    /* ConfigureSoftware */         {  500,      0 },
+};
+
+static cost costs[STEPS_MAX];
+
+struct progress
+{
+    unsigned long launched_us;
+    uint32_t spent_us;
+    uint8_t attempts;
+};
+static progress progresses[STEPS_MAX];
+
+template <uint8_t I>
+static step_result simulated(bool launch)
+{
+    progress& p = progresses[I];
+    const cost& c = costs[I];
+    if (launch)
+        {
+            p.launched_us = sim::Clock::micros();
+            p.spent_us = 0;
+            p.attempts += 1;
+        }
+
+    const uint32_t slice = std::min(c.busy_us - p.spent_us, SLICE_US);
+    sim::Clock::advance((slice ? slice : POLL_US) * 1000ULL);
+    p.spent_us += slice;
+
+    if (p.spent_us < c.busy_us || sim::Clock::micros() - p.launched_us < c.wall_us)
+        { return step_result::Running; }
+    if (p.attempts <= c.retries)
+        { return step_result::Retry; }
+    return c.outcome;
+}
+
+template <size_t ...I>
+static constexpr std::array<step_fn, sizeof...(I)> make_steps(std::index_sequence<I...>)
+    { return { &simulated<I>... }; }
+
+static const std::array<step_fn, STEPS_MAX> STEPS = make_steps(std::make_index_sequence<STEPS_MAX>{});
+
+static void reset(const cost* c, uint8_t count)
+{
+    sim::Clock::reset();
+    for (uint8_t i=0; i<STEPS_MAX; ++i)
+        {
+            costs[i] = i < count ? c[i] : cost{0, 0};
+            progresses[i] = progress{0, 0, 0};
+        }
+}
+
+/**
+ * Boot graph as drawn before, hardware waits for the configuration:
+ *  everything is queued behind the SD card
+ */
+static const node* as_drawn()
+{
+    static node graph[DEVICE_STEPS_COUNT];
+    std::copy(DEVICE_GRAPH, DEVICE_GRAPH + DEVICE_STEPS_COUNT, graph);
+    graph[static_cast<uint8_t>(device_step::ConfigureHardware)].needs = bit(device_step::LoadConfig);
+    graph[static_cast<uint8_t>(device_step::ConfigureSoftware)].needs = bit(device_step::LoadConfig);
+    return graph;
+}
+
+struct mprintf
+{
+    template <typename ...Args>
+    error::status_byte operator() (const char* fmt, Args... args) const
+        {
+            if (printf(fmt, args...) < 0)
+                { return error::errcode::GENERIC_ERROR | error::severity::ERROR; }
+            return error::status_byte{};
+        }
+};
+
+using mlogger = logging::Logger<mprintf, logging::severity_filter>;
+
+static void print_path(const executor_type& executor, uint8_t target)
+{
+    uint8_t path[STEPS_MAX];
+    const uint8_t length = executor.critical_path(target, path);
+    printf("\t");
+    for (uint8_t i=0; i<length; ++i)
+        { printf("%s%s", i ? " > " : "", executor.name(path[i])); }
+    printf("\n");
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    constexpr uint8_t FIRST_LED = static_cast<uint8_t>(device_step::InitState);
+    constexpr uint8_t SD_CARD = static_cast<uint8_t>(device_step::InitSdCard);
+
+    std::cout << "Testing graphs checks" << std::endl;
+    {
+        executor_type device(DEVICE_GRAPH, STEPS.data(), DEVICE_STEPS_COUNT);
+        assert(device.setup());
+
+        const node cycle[] = { {"a", 0, 0}, {"b", bit(0) | bit(2), 0}, {"c", 0, bit(1)} };
+        executor_type cyclic(cycle, STEPS.data(), 3);
+        assert(static_cast<error::errcode>(cyclic.setup()) == error::errcode::INVALID_ARGUMENT);
+
+        const node outside[] = { {"a", 0, 0}, {"b", bit(3), 0} };
+        executor_type dangling(outside, STEPS.data(), 2);
+        assert(!dangling.setup());
+
+        const node self[] = { {"a", 0, bit(0)} };
+        executor_type looping(self, STEPS.data(), 1);
+        assert(!looping.setup());
+
+        executor_type large(DEVICE_GRAPH, STEPS.data(), STEPS_MAX + 1);
+        assert(!large.setup());
+    }
+
+    std::cout << "Testing dependencies" << std::endl;
+    {
+        reset(DEVICE_COSTS, DEVICE_STEPS_COUNT);
+        executor_type executor(DEVICE_GRAPH, STEPS.data(), DEVICE_STEPS_COUNT);
+        assert(executor.setup());
+        assert(executor.update() == step_state::Running);
+        assert(executor.state(0) == step_state::Done);
+        assert(executor.run() == step_state::Done && executor.is_over());
+        for (uint8_t i=0; i<DEVICE_STEPS_COUNT; ++i)
+            {
+                assert(executor.state(i) == step_state::Done);
+                const mask dependencies = DEVICE_GRAPH[i].needs | DEVICE_GRAPH[i].after;
+                for (uint8_t d=0; d<DEVICE_STEPS_COUNT; ++d)
+                    {
+                        if (dependencies & bit(d))
+                            { assert(executor.timing(i).launched >= executor.timing(d).finished); }
+                    }
+                assert(executor.timing(i).duration() >= std::max(costs[i].busy_us, costs[i].wall_us));
+            }
+
+        /* the SD card is polled while hardware is configured */
+        assert(executor.timing(FIRST_LED).finished < executor.timing(SD_CARD).finished);
+        assert(executor.timing(SD_CARD).polls > 100);
+    }
+
+    std::cout << "Testing failures" << std::endl;
+    {
+        /* without a card the configuration falls back to defaults, file logs are skipped */
+        reset(DEVICE_COSTS, DEVICE_STEPS_COUNT);
+        costs[SD_CARD].outcome = step_result::Failed;
+        executor_type executor(DEVICE_GRAPH, STEPS.data(), DEVICE_STEPS_COUNT);
+        assert(executor.setup());
+        assert(executor.run() == step_state::Failed);
+        assert(executor.state(SD_CARD) == step_state::Failed);
+        const uint8_t file = static_cast<uint8_t>(device_step::LogToFile);
+        assert(executor.state(file) == step_state::Skipped && executor.timing(file).polls == 0);
+        assert(executor.state(static_cast<uint8_t>(device_step::LoadConfig)) == step_state::Done);
+        assert(executor.state(static_cast<uint8_t>(device_step::ConfigureSoftware)) == step_state::Done);
+
+        /* recoverable steps are launched again */
+        reset(DEVICE_COSTS, DEVICE_STEPS_COUNT);
+        costs[SD_CARD].retries = 2;
+        executor_type retried(DEVICE_GRAPH, STEPS.data(), DEVICE_STEPS_COUNT);
+        assert(retried.setup());
+        assert(retried.run() == step_state::Done);
+        assert(progresses[SD_CARD].attempts == 3);
+        assert(retried.timing(SD_CARD).duration() >= 3 * costs[SD_CARD].wall_us);
+
+        /* as long as they do not run out of time */
+        reset(DEVICE_COSTS, DEVICE_STEPS_COUNT);
+        costs[SD_CARD].retries = 100;
+        executor_type stuck(DEVICE_GRAPH, STEPS.data(), DEVICE_STEPS_COUNT, 1000000);
+        assert(stuck.setup());
+        assert(stuck.run() == step_state::Failed);
+        assert(stuck.state(SD_CARD) == step_state::Timedout);
+        assert(stuck.timing(SD_CARD).duration() > 1000000 && stuck.timing(SD_CARD).duration() < 1200000);
+        assert(stuck.state(static_cast<uint8_t>(device_step::LogToFile)) == step_state::Skipped);
+    }
+
+    std::cout << "\nBoot timings, estimated costs on the target" << std::endl;
+    {
+        /* blocking boot: every step runs to completion, one after the other */
+        uint32_t blocking_first_led = 0, blocking_total = 0;
+        for (uint8_t i=0; i<DEVICE_STEPS_COUNT; ++i)
+            {
+                blocking_total += std::max(DEVICE_COSTS[i].busy_us, DEVICE_COSTS[i].wall_us);
+                if (i == FIRST_LED)
+                    { blocking_first_led = blocking_total; }
+            }
+
+        reset(DEVICE_COSTS, DEVICE_STEPS_COUNT);
+        executor_type drawn(as_drawn(), STEPS.data(), DEVICE_STEPS_COUNT);
+        assert(drawn.setup() && drawn.run() == step_state::Done);
+
+        reset(DEVICE_COSTS, DEVICE_STEPS_COUNT);
+        executor_type device(DEVICE_GRAPH, STEPS.data(), DEVICE_STEPS_COUNT);
+        assert(device.setup() && device.run() == step_state::Done);
+
+        printf("\t%-36s | %12s %12s\n", "", "first led", "boot over");
+        printf("\t%-36s | %10.2fms %10.2fms\n", "blocking steps", blocking_first_led / 1e3, blocking_total / 1e3);
+        printf("\t%-36s | %10.2fms %10.2fms\n", "interleaved, hardware after config",
+            drawn.timing(FIRST_LED).finished / 1e3, drawn.elapsed() / 1e3);
+        printf("\t%-36s | %10.2fms %10.2fms\n", "interleaved, device graph",
+            device.timing(FIRST_LED).finished / 1e3, device.elapsed() / 1e3);
+
+        std::cout << "\n\tcritical path to the first led, hardware after config" << std::endl;
+        print_path(drawn, FIRST_LED);
+        std::cout << "\tcritical path to the first led, device graph" << std::endl;
+        print_path(device, FIRST_LED);
+        std::cout << std::endl;
+
+        mlogger logger{mprintf{}, logging::severity_filter{error::severity::INFO}};
+        device.dump(logger, "boot");
+
+        assert(drawn.elapsed() < blocking_total);
+        assert(device.timing(FIRST_LED).finished < drawn.timing(FIRST_LED).finished);
+        assert(device.timing(FIRST_LED).finished < 20000);
+
+        uint8_t path[STEPS_MAX];
+        const uint8_t length = device.critical_path(FIRST_LED, path);
+        assert(path[0] == 0 && path[length - 1] == FIRST_LED);
+        assert(std::find(path, path + length, SD_CARD) == path + length);
+        const uint8_t drawn_length = drawn.critical_path(FIRST_LED, path);
+        assert(std::find(path, path + drawn_length, SD_CARD) != path + drawn_length);
+
+        /* boot ends with the SD card, on both graphs */
+        const uint8_t total_length = device.critical_path(path);
+        assert(std::find(path, path + total_length, SD_CARD) != path + total_length);
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
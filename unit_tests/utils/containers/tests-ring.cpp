@@ -0,0 +1,147 @@
+#include "ring.hpp"
+
+#include <deque>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <cassert>
+#include <random>
+
+using namespace containers;
+
+using ring_t = Ring<uint8_t, 16>;
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing ring bounds" << std::endl;
+    {
+        ring_t ring;
+        uint8_t val = 0;
+        assert(ring.is_empty() && !ring.pop(val));
+        for (uint8_t i=0; i<ring_t::MaxSize; ++i)
+            { assert(ring.push(i)); }
+        assert(ring.is_full() && !ring.push(0xFF));
+        assert(ring.peak() == ring_t::MaxSize);
+
+        const uint8_t many[4] = {0xA0, 0xA1, 0xA2, 0xA3};
+        assert(ring.pop(val) && val == 0);
+        assert(!ring.push(many, 4) && ring.size() == ring_t::MaxSize -1);
+        for (uint8_t i=1; i<4; ++i)
+            { assert(ring.pop(val) && val == i); }
+        assert(ring.push(many, 4) && ring.is_full());
+
+        ring.clear();
+        assert(ring.is_empty() && ring.free() == ring_t::MaxSize);
+        ring.reset_peak();
+        assert(ring.peak() == 0);
+    }
+
+    std::cout << "Testing contiguous peeks across wrap around" << std::endl;
+    {
+        ring_t ring;
+        for (uint8_t i=0; i<12; ++i)
+            { ring.push(i); }
+        size_t count = 0;
+        ring.peek(count);
+        assert(count == 12);
+        ring.consume(10);
+
+        for (uint8_t i=12; i<24; ++i)
+            { assert(ring.push(i)); }
+        const uint8_t* data = ring.peek(count);
+        assert(count == 6 && data[0] == 10 && data[5] == 15);
+        ring.consume(count);
+        data = ring.peek(count);
+        assert(count == 8 && data[0] == 16 && data[7] == 23);
+        ring.consume(100);
+        assert(ring.is_empty());
+        ring.peek(count);
+        assert(count == 0);
+    }
+
+    std::cout << "Testing random operations against std::deque" << std::endl;
+    {
+        ring_t ring;
+        std::deque<uint8_t> reference;
+        std::mt19937 rand(7);
+        uint8_t next = 0;
+        for (int i=0; i<100000; ++i)
+            {
+                switch (rand() % 3)
+                    {
+                    case 0:
+                        {
+                            const bool pushed = ring.push(next);
+                            assert(pushed == (reference.size() < ring_t::MaxSize));
+                            if (pushed)
+                                { reference.push_back(next++); }
+                            break;
+                        }
+                    case 1:
+                        {
+                            uint8_t val = 0;
+                            assert(ring.pop(val) == !reference.empty());
+                            if (!reference.empty())
+                                {
+                                    assert(val == reference.front());
+                                    reference.pop_front();
+                                }
+                            break;
+                        }
+                    default:
+                        {
+                            size_t count = 0;
+                            const uint8_t* data = ring.peek(count);
+                            assert(count <= reference.size());
+                            const size_t taken = count ? rand() % (count + 1) : 0;
+                            for (size_t k=0; k<taken; ++k)
+                                {
+                                    assert(data[k] == reference.front());
+                                    reference.pop_front();
+                                }
+                            ring.consume(taken);
+                            break;
+                        }
+                    }
+                assert(ring.size() == reference.size());
+            }
+    }
+
+    std::cout << "Testing single producer single consumer threads" << std::endl;
+    {
+        Ring<uint32_t, 64> ring;
+        constexpr uint32_t COUNT = 1000000;
+
+        std::thread producer([&]() {
+                for (uint32_t i=0; i<COUNT; )
+                    {
+                        if (ring.push(i))
+                            { ++i; }
+                        else
+                            { std::this_thread::yield(); }
+                    }
+            });
+
+        uint32_t expected = 0;
+        while (expected < COUNT)
+            {
+                size_t count = 0;
+                const uint32_t* data = ring.peek(count);
+                for (size_t k=0; k<count; ++k)
+                    { assert(data[k] == expected + k); }
+                ring.consume(count);
+                expected += count;
+                if (count == 0)
+                    { std::this_thread::yield(); }
+            }
+        producer.join();
+        assert(ring.is_empty());
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
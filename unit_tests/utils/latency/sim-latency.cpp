@@ -0,0 +1,260 @@
+
+#define MYCELIUM_LATENCY_PROBES
+
+#include "utils/latency/latency.h"
+#include "hw/matrix_driver/matrix_driver.h"
+#include "midi/midi_mapping/midi_mapping.h"
+#include "midi/midi_output/midi_output.h"
+
+#include "../../hw/sim/clock.hpp"
+#include "../../hw/sim/i2c.hpp"
+#include "../../hw/sim/mcp23017.hpp"
+#include "../../hw/sim/switch.hpp"
+#include "../../hw/sim/uart.hpp"
+
+#include <array>
+#include <deque>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <cassert>
+#include <random>
+
+using namespace hw;
+using namespace hw::leds_driver;
+using hw::matrix_driver::MatrixDriver;
+using settings_type = hw::matrix_driver::DriverDefaultSettings;
+
+static constexpr size_t PADS_COUNT = static_cast<size_t>(pads::Pad::__PADS_COUNT__);
+
+static std::array<sim::I2CMaster, ANNODE_DRIVER_COUNT> masters;
+static std::array<sim::MCP23017, ANNODE_DRIVER_COUNT> mcps;
+static std::array<sim::Switch, PADS_COUNT> switches;
+static std::array<bool, 64> pins;
+
+static sim::Uart uart;
+
+struct SimContext
+{
+    using master_type = sim::I2CMaster;
+
+    static master_type& i2c_master(annode_driver d)
+        { return masters[static_cast<uint8_t>(d)]; }
+
+    static void pin_mode_output(uint8_t pin)            {}
+    static void pin_mode_input_pullup(uint8_t pin)      {}
+    static void digital_write(uint8_t pin, bool level)  { pins[pin] = level; }
+
+    static uint16_t read_rows()
+        {
+            if (pins[CATHODE_ENABLE_PIN] != CATHODE_ENABLE_LEVEL)
+                { return 0x3FFF; }
+            const uint8_t column = (pins[CATHODE_ADDR_PINA0] ? 1 : 0)
+                | (pins[CATHODE_ADDR_PINA1] ? 2 : 0)
+                | (pins[CATHODE_ADDR_PINA2] ? 4 : 0);
+            uint16_t levels = 0;
+            for (uint8_t row=0; row<pads_driver::ROWS_COUNT; ++row)
+                {
+                    const bool closed = switches[(row << 3) | column].is_closed(sim::Clock::now());
+                    levels |= (closed ? 0 : 1) << row;
+                }
+            return levels;
+        }
+
+    static size_t available_for_write(midi::bus b)
+        { return b == midi::bus::Bus1 ? uart.available() : 0; }
+
+    static size_t write(midi::bus b, const uint8_t* bytes, size_t count)
+        { return b == midi::bus::Bus1 ? uart.write(bytes, count) : 0; }
+
+    static unsigned long micros()       { return sim::Clock::micros(); }
+};
+
+using collector_type = latency::Collector<SimContext>;
+
+struct mprintf
+{
+    template <typename ...Args>
+    error::status_byte operator() (const char* fmt, Args... args) const
+        {
+            if (printf(fmt, args...) < 0)
+                { return error::errcode::GENERIC_ERROR | error::severity::ERROR; }
+            return error::status_byte{};
+        }
+};
+
+using mlogger = logging::Logger<mprintf, logging::severity_filter>;
+
+struct Run
+{
+    size_t events = 0;
+    size_t sent = 0;
+};
+
+/**
+ * Presses random pads while the main loop polls, maps and transmits their messages
+ *  with the APC40 mapping, main loop iterations last 5 to 200us
+ */
+static Run simulate(collector_type& collector, unsigned long refresh_rate, uint64_t duration_ns)
+{
+    settings_type::RefreshRate = refresh_rate;
+    sim::Clock::reset();
+    pins.fill(false);
+    for (size_t i=0; i<ANNODE_DRIVER_COUNT; ++i)
+        {
+            masters[i] = sim::I2CMaster{};
+            mcps[i].reset();
+            masters[i].attach(mcps[i]);
+        }
+
+    midi::midi_mapping::Mappings mappings;
+    mappings.setup();
+
+    sim::BounceModel bounce;
+    std::mt19937 rand(0x1a7e);
+    std::uniform_int_distribution<uint64_t> hold(60000000, 400000000);
+    std::uniform_int_distribution<uint64_t> work(5000, 200000);
+    for (size_t p=0; p<PADS_COUNT; ++p)
+        {
+            sim::Switch& s = switches[p];
+            s = sim::Switch{};
+            /* pads not wired are never pressed */
+            if (!mappings.active().output(static_cast<pads::Pad>(p)).is_bound())
+                { continue; }
+            uint64_t t = hold(rand);
+            bool closed = true;
+            while (t < duration_ns)
+                {
+                    s.schedule(t, closed, bounce, rand);
+                    closed = !closed;
+                    t += hold(rand);
+                }
+        }
+
+    collector.reset();
+    collector.install();
+
+    MatrixDriver<SimContext> driver;
+    midi::midi_output::MidiOutput<SimContext> output;
+    Run run;
+    uart = sim::Uart{};
+    driver.setup();
+    output.setup();
+    while (sim::Clock::now() < duration_ns)
+        {
+            driver.update();
+
+            pads_driver::pad_event event;
+            while (driver.poll(event))
+                {
+                    midi::message msg;
+                    assert(mappings.pad_message(event.pad, event.pressed, msg));
+                    assert(output.send(midi::bus::Bus1, msg, static_cast<uint8_t>(event.pad)));
+                    run.events += 1;
+                }
+            output.flush();
+            sim::Clock::advance(work(rand));
+        }
+    for (size_t i=0; i<100; ++i)
+        {
+            sim::Clock::advance(1000000);
+            output.flush();
+        }
+    const midi::midi_output::bus_counters& counters = output.counters(midi::bus::Bus1);
+    assert(output.occupancy(midi::bus::Bus1) == 0 && counters.sent == uart.bytes.size());
+    run.sent = counters.messages;
+
+    collector.uninstall();
+    return run;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing histogram buckets" << std::endl;
+    {
+        using latency::Histogram;
+        for (uint32_t us=0; us<100000; ++us)
+            {
+                const size_t b = Histogram::bucket_of(us);
+                assert(b < Histogram::BUCKETS_COUNT);
+                assert(Histogram::lower_bound(b) <= us);
+                assert(b + 1 == Histogram::BUCKETS_COUNT || us < Histogram::lower_bound(b + 1));
+            }
+        assert(Histogram::bucket_of(UINT32_MAX) == Histogram::BUCKETS_COUNT -1);
+
+        Histogram h;
+        for (uint32_t us=1; us<=100; ++us)
+            { h.add(us); }
+        assert(h.count() == 100 && h.min() == 1 && h.max() == 100 && h.mean() == 50);
+        assert(h.percentile(50) >= 50 && h.percentile(50) < 56);
+        assert(h.percentile(99) >= 99 && h.percentile(99) <= 100);
+        assert(h.percentile(100) == 100);
+    }
+
+    std::cout << "Testing traces" << std::endl;
+    {
+        sim::Clock::reset();
+        collector_type collector;
+        collector.install();
+
+        LATENCY_MARK(5, ScanSample);
+        sim::Clock::advance(3000000);
+        LATENCY_MARK(5, ScanSample);        /* bounce: first contact is kept */
+        sim::Clock::advance(9000000);
+        LATENCY_MARK(5, DebounceEdge);
+        sim::Clock::advance(100000);
+        LATENCY_MARK(5, EventQueue);
+        LATENCY_MARK(5, Mapping);
+        LATENCY_MARK(5, TxEnqueue);
+        sim::Clock::advance(960000);
+        LATENCY_MARK(5, TxComplete);
+
+        assert(collector.total().count() == 1 && collector.total().max() == 13060);
+        assert(collector.histogram(latency::stage::DebounceEdge).max() == 12000);
+        assert(collector.histogram(latency::stage::EventQueue).max() == 100);
+        assert(collector.histogram(latency::stage::TxComplete).max() == 960);
+
+        /* a glitch which never debounced is restarted by next press */
+        LATENCY_MARK(7, ScanSample);
+        sim::Clock::advance(500000000);
+        LATENCY_MARK(7, ScanSample);
+        sim::Clock::advance(1000000);
+        LATENCY_MARK(7, TxComplete);
+        assert(collector.abandoned_count() == 1 && collector.total().count() == 2);
+        assert(collector.total().max() == 13060 && collector.total().min() == 1000);
+
+        collector.uninstall();
+        assert(latency::probe == nullptr);
+        LATENCY_MARK(5, ScanSample);
+    }
+
+    mlogger logger{mprintf{}, logging::severity_filter{error::severity::DEBUG}};
+
+    std::cout << "\nPad press to MIDI TX complete, 30s of random presses per refresh rate\n" << std::endl;
+    for (unsigned long rate: {125UL, 250UL, 500UL})
+        {
+            collector_type collector;
+            const Run run = simulate(collector, rate, 30000000000ULL);
+
+            char facility[16];
+            snprintf(facility, sizeof(facility), "%luHz", rate);
+            /* buckets of the total are detailed at the default rate */
+            logger.filter.log_level = rate == 250 ? error::severity::DEBUG : error::severity::INFO;
+            collector.dump(logger, facility);
+            std::cout << std::endl;
+
+            assert(run.events > 0 && run.sent == run.events);
+            assert(collector.total().count() == run.events);
+            assert(collector.abandoned_count() == 0);
+
+            /* bounce + 4 samples + a frame to reach the column, plus a few messages ahead in the UART */
+            const double bound_us = 5000 + 5 * 1e6 / rate + 8 * 3 * 320;
+            assert(collector.total().percentile(99) < bound_us);
+        }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+
+#include "utils/logging/logging.h"
+#include "utils/logging/boot_log.h"
+#include "utils/boot/boot.h"
+
+#include "../../hw/sim/clock.hpp"
+
+#include <array>
+#include <string>
+#include <utility>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <cassert>
+
+using namespace logging;
+
+/**
+ * Serial port or log file: receives what is written while attached,
+ *  at most @c room bytes per write, as an USB endpoint buffer
+ */
+struct Endpoint
+{
+    std::string received;
+    bool attached = false;
+    size_t room = SIZE_MAX;
+    unsigned long writes = 0;
+    unsigned long flushes = 0;
+};
+
+struct Transport
+{
+    bool is_available() const           { return endpoint->attached; }
+
+    size_t write(const char* bytes, size_t size)
+        {
+            assert(endpoint->attached);
+            const size_t written = size < endpoint->room ? size : endpoint->room;
+            endpoint->received.append(bytes, written);
+            endpoint->writes += 1;
+            return written;
+        }
+
+    error::status_byte flush()
+        {
+            endpoint->flushes += 1;
+            return error::status_byte{};
+        }
+
+    Endpoint* endpoint;
+};
+
+/**
+ * Reference copy of the log
+ */
+struct StringPrinter
+{
+    template <typename ...Args>
+    error::status_byte operator() (const char* fmt, Args... args) const
+        {
+            char line[BOOT_LOG_LINE_MAX_SIZE];
+            snprintf(line, sizeof(line), fmt, args...);
+            *out += line;
+            return error::status_byte{};
+        }
+
+    std::string* out;
+};
+
+using boot_log_type = BootLog<4096, Transport, Transport>;
+
+static Endpoint serial, sdcard;
+static boot_log_type boot_log{Transport{&serial}, Transport{&sdcard}};
+static Logger<boot_log_type::printer_type, severity_filter> logger{boot_log.printer(), {error::severity::INFO}};
+
+static std::string expected;
+static Logger<StringPrinter, severity_filter> reference{StringPrinter{&expected}, {error::severity::INFO}};
+
+template <typename ...Args>
+static void log(const char* facility, const char* fmt, Args... args)
+{
+    const raw_header header{facility, error::errcode::OK | error::severity::INFO, sim::Clock::micros()};
+    logger(header, fmt, args...);
+    reference(header, fmt, args...);
+}
+
+struct SimContext
+{
+    static unsigned long micros()       { return sim::Clock::micros(); }
+};
+
+/**
+ * Boot steps logging their progress, each takes 200us polled every 20us
+ */
+template <uint8_t I>
+static boot::step_result step(bool launch)
+{
+    static unsigned long launched;
+    if (launch)
+        {
+            launched = sim::Clock::micros();
+            log("boot", "%s launched\n", boot::DEVICE_GRAPH[I].name);
+        }
+    sim::Clock::advance(20000);
+    if (sim::Clock::micros() - launched < 200)
+        { return boot::step_result::Running; }
+    log("boot", "%s done in %luus\n", boot::DEVICE_GRAPH[I].name, sim::Clock::micros() - launched);
+    return boot::step_result::Done;
+}
+
+template <size_t ...I>
+static constexpr std::array<boot::step_fn, sizeof...(I)> make_steps(std::index_sequence<I...>)
+    { return { &step<I>... }; }
+
+static const auto STEPS = make_steps(std::make_index_sequence<boot::DEVICE_STEPS_COUNT>{});
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing ring" << std::endl;
+    {
+        LogRing<512> ring;
+        char out[512];
+        ring.append("first\n", 6);
+        assert(ring.head() == 6 && ring.tail() == 0);
+        assert(ring.read(0, out, sizeof(out)) == 6 && std::string(out, 6) == "first\n");
+        assert(ring.read(2, out, 3) == 3 && std::string(out, 3) == "rst");
+        assert(ring.read(6, out, sizeof(out)) == 0);
+
+        /* oldest lines are dropped whole, and reads wrap around */
+        std::string line(99, 'x');
+        line += '\n';
+        for (int i=0; i<5; ++i)
+            { ring.append(line.data(), line.size()); }
+        assert(ring.head() == 506 && ring.tail() == 0);
+        ring.append(line.data(), line.size());
+        assert(ring.tail() == 106 && ring.head() - ring.tail() <= 512);
+        assert(ring.read(0, out, sizeof(out)) == 0);
+        assert(ring.read(ring.tail(), out, sizeof(out)) == 500 && std::string(out, 500) == line + line + line + line + line);
+    }
+
+    std::cout << "Testing boot without transport" << std::endl;
+    {
+        sim::Clock::reset();
+        boot::Executor<SimContext> executor{boot::DEVICE_GRAPH, STEPS.data(), boot::DEVICE_STEPS_COUNT};
+        assert(executor.setup());
+        unsigned long updates = 0;
+        while (executor.update() == boot::step_state::Running)
+            {
+                boot_log.pump();
+                updates += 1;
+            }
+        log("boot", "boot over in %luus\n", static_cast<unsigned long>(executor.elapsed()));
+        assert(executor.run() == boot::step_state::Done);
+        printf("\tboot over after %lu updates, %lu bytes of log buffered\n", updates, static_cast<unsigned long>(expected.size()));
+
+        assert(serial.received.empty() && sdcard.received.empty());
+        assert(boot_log.ring().tail() == 0 && boot_log.ring().head() == expected.size());
+    }
+
+    std::cout << "Testing replay on attachment" << std::endl;
+    {
+        /* a host opens the serial port, 64 bytes accepted per write */
+        serial.attached = true;
+        serial.room = 64;
+        boot_log.pump();
+        assert(serial.received == expected && boot_log.is_drained(0));
+        assert(serial.writes >= expected.size() / 64);
+
+        log("surface", "pad %d pressed\n", 12);
+        assert(serial.received == expected);
+
+        /* the card mounts later, and gets the whole log too */
+        assert(!boot_log.is_drained(1));
+        sdcard.attached = true;
+        log("sdcard", "log file opened\n");
+        assert(sdcard.received == expected && serial.received == expected);
+        assert(boot_log.lost_count(0) == 0 && boot_log.lost_count(1) == 0);
+
+        assert(boot_log.flush());
+        assert(serial.flushes == 1 && sdcard.flushes == 1);
+    }
+
+    std::cout << "Testing full transport" << std::endl;
+    {
+        /* host not reading: nothing is accepted, the rest of the log is kept */
+        serial.room = 0;
+        log("surface", "pad %d released\n", 12);
+        assert(!boot_log.is_drained(0) && boot_log.is_drained(1));
+        serial.room = 64;
+        boot_log.pump();
+        assert(serial.received == expected);
+    }
+
+    std::cout << "Testing overflow" << std::endl;
+    {
+        /* a port detached long enough misses lines, and is told so */
+        serial.attached = false;
+        const size_t detached = expected.size();
+        for (int i=0; i<200; ++i)
+            { log("surface", "encoder %d turned to %d\n", i % 8, i); }
+        serial.attached = true;
+        boot_log.pump();
+        assert(sdcard.received == expected);
+
+        const uint32_t lost = boot_log.lost_count(0);
+        char notice[48];
+        snprintf(notice, sizeof(notice), "... %lu log bytes lost\n", static_cast<unsigned long>(lost));
+        printf("\t%lu bytes logged while detached, %lu lost, %lu replayed\n",
+            static_cast<unsigned long>(expected.size() - detached), static_cast<unsigned long>(lost),
+            static_cast<unsigned long>(expected.size() - detached - lost));
+
+        assert(lost > 0 && boot_log.is_drained(0));
+        const std::string replayed = serial.received.substr(detached);
+        assert(replayed.compare(0, strlen(notice), notice) == 0);
+        assert(replayed.substr(strlen(notice)) == expected.substr(detached + lost));
+        assert(expected[detached + lost - 1] == '\n');
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
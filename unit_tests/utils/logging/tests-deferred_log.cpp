@@ -0,0 +1,432 @@
+#include "utils/logging/logging.h"
+#include "utils/logging/deferred_log.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <cassert>
+
+using namespace logging;
+
+/**
+ * Counter stamping records in call order, keeps the host clock cost out of measures
+ */
+struct CountingClock
+{
+    static unsigned long micros()           { return ticks.fetch_add(1, std::memory_order_relaxed); }
+
+    inline static std::atomic<unsigned long> ticks{0};
+};
+
+/**
+ * Serial port or host link: takes at most @c room bytes per write
+ */
+struct StringTransport
+{
+    bool is_available() const           { return true; }
+
+    size_t write(const char* bytes, size_t size)
+        {
+            const size_t written = size < room ? size : room;
+            received.append(bytes, written);
+            return written;
+        }
+
+    error::status_byte flush()          { return error::status_byte{}; }
+
+    std::string received;
+    size_t room = SIZE_MAX;
+};
+
+/**
+ * Reference copy of the log, formatted at call time
+ */
+struct StringPrinter
+{
+    template <typename ...Args>
+    error::status_byte operator() (const char* fmt, Args... args) const
+        {
+            char line[DEFERRED_LOG_LINE_MAX_SIZE];
+            snprintf(line, sizeof(line), fmt, args...);
+            *out += line;
+            return error::status_byte{};
+        }
+
+    std::string* out;
+};
+
+/**
+ * Logger printer handle on an output
+ */
+struct OutputPrinter
+{
+    template <typename ...Args>
+    error::status_byte operator() (const char* fmt, Args... args) const
+        { return (*output)(fmt, args...); }
+
+    AbstractOutput<>* output;
+};
+
+/**
+ * Current output path: formats with vsnprintf in the caller, then copies to the transmit buffer
+ */
+struct BufferOutput: AbstractOutput<>
+{
+    error::status_byte flush() override         { size = 0; return error::status_byte{}; }
+    explicit operator bool() const override     { return true; }
+
+    error::status_byte print_impl(const char* fmt, va_list args) override
+        {
+            char line[DEFERRED_LOG_LINE_MAX_SIZE];
+            const int n = vsnprintf(line, sizeof(line), fmt, args);
+            const size_t count = n < 0 ? 0 : static_cast<size_t>(n) < sizeof(line) ? n : sizeof(line) -1;
+            if (size + count > sizeof(buffer))
+                { size = 0; }
+            std::memcpy(buffer + size, line, count);
+            size += count;
+            return error::status_byte{};
+        }
+
+    char buffer[1 << 16];
+    size_t size = 0;
+};
+
+enum class Mode: uint8_t { Idle, Playing = 7 };
+
+using log_type = DeferredLog<CountingClock, 1 << 16>;
+
+template <typename ...Args>
+static void check_format(const char* fmt, Args... args)
+{
+    static log_type log;
+    StringTransport transport;
+    assert(log(fmt, args...));
+    assert(log.drain(transport) == 1 && log.is_empty());
+
+    char expected[DEFERRED_LOG_LINE_MAX_SIZE];
+    snprintf(expected, sizeof(expected), fmt, args...);
+    if (transport.received != expected)
+        { printf("\tmismatch: '%s' instead of '%s'\n", transport.received.c_str(), expected); }
+    assert(transport.received == expected);
+}
+
+/** Formats a stream of raw records as a host decoder would */
+static std::string decode(const std::string& stream)
+{
+    std::string text;
+    std::vector<uint32_t> words(stream.size() / 4);
+    std::memcpy(words.data(), stream.data(), words.size() * 4);
+    for (size_t w=0; w<words.size(); )
+        {
+            const record_view record{words.data() + w};
+            assert(record.size() >= RECORD_ARGS_WORD && w + record.size() <= words.size());
+            char line[DEFERRED_LOG_LINE_MAX_SIZE];
+            /* same address space here: a firmware decoder would look format pointers up in the image */
+            format_record(record, line, sizeof(line), [](uint64_t p) { return reinterpret_cast<const char*>(static_cast<uintptr_t>(p)); });
+            text += line;
+            w += record.size();
+        }
+    return text;
+}
+
+template <typename Fn>
+static double measure(size_t calls, Fn&& fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i=0; i<calls; ++i)
+        { fn(i); }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / calls;
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing formatting" << std::endl;
+    {
+        check_format("no argument\n");
+        check_format("%d %i %u %x %X %o %c|\n", -42, 17, 3000000000U, 0xBEEFU, 0xCAFEU, 8U, 'z');
+        check_format("%ld %lu %lld %llu %zu %jd %td\n", -5L, 6UL, -7LL, 8ULL, sizeof(int), static_cast<intmax_t>(-9), static_cast<ptrdiff_t>(10));
+        check_format("[%5d] [%-5d] [%+d] [% d] [%05d] [%#x] [%.3d]\n", 42, 42, 42, 42, 42, 42, 42);
+        check_format("%f %.2f %e %g %10.3f %-8.1f|\n", 3.14159, 2.5f, 12345.678, 0.0001, -1.5, 9.99);
+        check_format("%s %-8s| %8s %.3s %%\n", "hello", "left", "right", "truncated");
+        check_format("%*d|%-*d|%.*f|%*.*s|\n", 6, 1, 4, 2, 2, 3.14159, 7, 2, "abc");
+        check_format("%hhu %hd %d %d\n", 300, -2, true, 'A');
+        static int anchor;
+        check_format("%p %p\n", static_cast<const void*>(&anchor), nullptr);
+
+        char expected[DEFERRED_LOG_LINE_MAX_SIZE];
+        const std::string long_text(300, 'x');
+        snprintf(expected, sizeof(expected), "%s and more", long_text.c_str());
+        log_type log;
+        StringTransport transport;
+        log("%s and more", long_text.c_str());
+        log.drain(transport);
+        assert(transport.received == expected && transport.received.size() == DEFERRED_LOG_LINE_MAX_SIZE -1);
+
+        /* enums are recorded as their value */
+        transport.received.clear();
+        log("mode %d\n", Mode::Playing);
+        log.drain(transport);
+        assert(transport.received == "mode 7\n");
+
+        /* arguments not matching their conversion are never read */
+        transport.received.clear();
+        log("%d and %s\n", 1.5, "x");
+        log("%s\n", 12);
+        log("%n %d\n", 1);
+        log("%d %d\n", 1);
+        log("%Lf\n", 1.0);
+        assert(log.drain(transport) == 5);
+        assert(transport.received == "<?><?><?>1 <?><?>");
+    }
+
+    std::cout << "Testing records shipped by a 32 bits device" << std::endl;
+    {
+        /* as a Teensy ships them: 32 bits pointers and longs, formats looked up by address in the image */
+        auto resolve = [](uint64_t address) -> const char* {
+                switch (address)
+                {
+                case 0x60001000:    return "event %lu late by %ld us on %s, %zu queued\n";
+                case 0x60001040:    return "Sched";
+                case 0x60001080:    return "%llu ticks, %lx, %hhu%c %p\n";
+                default:            return "?";
+                }
+            };
+        auto kinds = [](std::initializer_list<arg_kind> args) {
+                uint32_t word = 0, shift = 0;
+                for (arg_kind k: args)
+                    { word |= static_cast<uint32_t>(k) << shift; shift += 2; }
+                return word;
+            };
+
+        /* header, timestamp, format on two words, kinds */
+        assert(RECORD_ARGS_WORD == 5);
+        std::vector<uint32_t> words;
+        auto begin_record = [&words](uint32_t size, uint32_t args, uint32_t timestamp, uint32_t format) {
+                words.insert(words.end(), {size | (args << 8), timestamp, format, 0});
+            };
+        begin_record(RECORD_ARGS_WORD + 1 + 1 + 2 + 1, 4, 1000, 0x60001000);
+        words.push_back(kinds({arg_kind::Int32, arg_kind::Int32, arg_kind::Pointer, arg_kind::Int32}));
+        words.insert(words.end(), {4000000000U, static_cast<uint32_t>(-25), 0x60001040, 0, 3});
+        begin_record(RECORD_ARGS_WORD + 2 + 1 + 1 + 1 + 2, 5, 2000, 0x60001080);
+        words.push_back(kinds({arg_kind::Int64, arg_kind::Int32, arg_kind::Int32, arg_kind::Int32, arg_kind::Pointer}));
+        words.insert(words.end(), {0x00000002, 0x00000001, 0xBEEF, 300, 'x', 0x20001234, 0});
+        /* drop notice */
+        begin_record(RECORD_ARGS_WORD, 0, 7, 0);
+        words.push_back(0);
+
+        std::string text;
+        for (size_t w=0; w<words.size(); )
+            {
+                const record_view record{words.data() + w};
+                char line[DEFERRED_LOG_LINE_MAX_SIZE];
+                format_record(record, line, sizeof(line), resolve);
+                text += line;
+                w += record.size();
+            }
+        char expected[DEFERRED_LOG_LINE_MAX_SIZE];
+        snprintf(expected, sizeof(expected), "%llu ticks, %x, %hhu%c %p\n",
+            0x100000002ULL, 0xBEEFU, 300, 'x', reinterpret_cast<void*>(0x20001234));
+        assert(text == std::string("event 4000000000 late by -25 us on Sched, 3 queued\n")
+            + expected + "... 7 log records dropped\n");
+    }
+
+    std::cout << "Testing logger" << std::endl;
+    {
+        log_type log;
+        Logger<log_type::printer_type, severity_filter> logger{log.printer(), {error::severity::INFO}};
+        std::string expected;
+        Logger<StringPrinter, severity_filter> reference{StringPrinter{&expected}, {error::severity::INFO}};
+
+        for (unsigned long i=0; i<50; ++i)
+            {
+                const raw_header header{"Sched", error::errcode::TIMEOUT_ERROR | (i % 3 ? error::severity::WARNING : error::severity::DEBUG), 1000 * i};
+                logger(header, "event %lu late by %d us\n", i, static_cast<int>(i * 7));
+                reference(header, "event %lu late by %d us\n", i, static_cast<int>(i * 7));
+            }
+
+        /* transport taking a few bytes at a time */
+        StringTransport transport;
+        transport.room = 7;
+        while (!log.is_empty())
+            { log.drain(transport, 3); }
+        assert(transport.received == expected);
+        assert(log.records_count() == 2 * 33);
+    }
+
+    std::cout << "Testing overflow" << std::endl;
+    {
+        /* 128 words: records of 5 + 1 words fit 21 times */
+        DeferredLog<CountingClock, 512> log;
+        std::string expected;
+        size_t kept = 0;
+        for (int i=0; i<30; ++i)
+            {
+                if (log("record %d\n", i))
+                    {
+                        kept += 1;
+                        expected += "record " + std::to_string(i) + "\n";
+                    }
+            }
+        assert(kept == 128 / (RECORD_ARGS_WORD + 1) && log.dropped_count() == 30 - kept);
+
+        /* the notice comes before the records following the drops */
+        expected += "... " + std::to_string(30 - kept) + " log records dropped\n";
+        StringTransport transport;
+        assert(log.drain(transport) == kept);
+        assert(log("after %d\n", 1));
+        assert(log.drain(transport) == 1);
+        expected += "after 1\n";
+        assert(transport.received == expected);
+
+        /* raw stream carries the notice as a record without format */
+        for (int i=0; i<30; ++i)
+            { log("again %d\n", i); }
+        StringTransport raw, text;
+        assert(log.ship(raw) == kept);
+        assert(raw.received.size() == (kept + 1) * (RECORD_ARGS_WORD + 1) * 4 - 4);
+        std::string again;
+        for (size_t i=0; i<kept; ++i)
+            { again += "again " + std::to_string(i) + "\n"; }
+        assert(decode(raw.received) == again + "... " + std::to_string(30 - kept) + " log records dropped\n");
+    }
+
+    std::cout << "Testing raw records" << std::endl;
+    {
+        log_type formatted, shipped;
+        for (int i=0; i<200; ++i)
+            {
+                formatted("cv %d = %.3f V, %s\n", i, i / 51.2, i % 2 ? "gate" : "free");
+                shipped("cv %d = %.3f V, %s\n", i, i / 51.2, i % 2 ? "gate" : "free");
+            }
+        StringTransport text, raw;
+        raw.room = 13;
+        assert(formatted.drain(text) == 200);
+        size_t records = 0;
+        while (!shipped.is_empty())
+            { records += shipped.ship(raw); }
+        assert(records == 200);
+        assert(decode(raw.received) == text.received);
+        printf("\t%lu bytes of text, %lu bytes of records\n", text.received.size(), raw.received.size());
+    }
+
+    std::cout << "Testing concurrent producers" << std::endl;
+    {
+        static DeferredLog<CountingClock, 4096> log;
+        constexpr int PRODUCERS = 3;
+        constexpr int CALLS = 50000;
+        std::atomic<int> running{PRODUCERS};
+        std::vector<std::thread> producers;
+        for (int p=0; p<PRODUCERS; ++p)
+            {
+                producers.emplace_back([p, &running]() {
+                        for (int i=0; i<CALLS; ++i)
+                            {
+                                log("%d %d %lld\n", p, i, static_cast<long long>(i) * 1000003);
+                                if (i % 16 == 0)
+                                    { std::this_thread::yield(); }
+                            }
+                        running -= 1;
+                    });
+            }
+
+        /* single reader, as the low priority task */
+        StringTransport transport;
+        int last[PRODUCERS] = {-1, -1, -1};
+        size_t received = 0;
+        while (running.load() > 0 || !log.is_empty())
+            {
+                transport.received.clear();
+                log.drain(transport, 64);
+                const char* line = transport.received.c_str();
+                int p, i;
+                long long check;
+                int consumed;
+                while (*line != '\0')
+                    {
+                        if (*line == '.')
+                            {
+                                line = std::strchr(line, '\n') + 1;
+                                continue;
+                            }
+                        assert(sscanf(line, "%d %d %lld\n%n", &p, &i, &check, &consumed) == 3);
+                        assert(0 <= p && p < PRODUCERS && i > last[p] && check == static_cast<long long>(i) * 1000003);
+                        last[p] = i;
+                        received += 1;
+                        line += consumed;
+                    }
+            }
+        for (std::thread& t: producers)
+            { t.join(); }
+        assert(received + log.dropped_count() == PRODUCERS * CALLS);
+        printf("\t%lu records received, %u dropped\n", received, log.dropped_count());
+    }
+
+    std::cout << "Benchmarking per call cost" << std::endl;
+    {
+        constexpr size_t CALLS = 200000;
+        constexpr size_t BATCH = 500;
+        static log_type log;
+        static BufferOutput output;
+        StringTransport sink;
+
+        Logger<log_type::printer_type, severity_filter> deferred{log.printer(), {error::severity::DEBUG}};
+        Logger<OutputPrinter, severity_filter> direct{OutputPrinter{&output}, {error::severity::DEBUG}};
+
+        /* deferred calls are measured by batches, drained out of the measure */
+        auto batched = [&sink](auto call) {
+                double ns = 0;
+                for (size_t b=0; b<CALLS / BATCH; ++b)
+                    {
+                        ns += measure(BATCH, call) * BATCH;
+                        sink.received.clear();
+                        log.drain(sink);
+                    }
+                return ns / CALLS;
+            };
+
+        printf("\t%-28s %12s %12s %14s\n", "ns/call", "vsnprintf", "deferred", "later format");
+
+        auto report = [&](const char* name, auto direct_call, auto deferred_call) {
+                const double d = measure(CALLS, direct_call);
+                const double r = batched(deferred_call);
+                /* formatting cost, paid by the low priority task */
+                for (size_t i=0; i<BATCH; ++i)
+                    { deferred_call(i); }
+                sink.received.clear();
+                auto begin = std::chrono::steady_clock::now();
+                const size_t records = log.drain(sink);
+                const double f = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / records;
+                printf("\t%-28s %12.1f %12.1f %14.1f\n", name, d, r, f);
+                assert(r < d);
+            };
+
+        report("3 integers",
+            [](size_t i) { output("note %d vel %d ch %d\n", static_cast<int>(i & 127), 100, 3); },
+            [](size_t i) { log("note %d vel %d ch %d\n", static_cast<int>(i & 127), 100, 3); });
+        report("string and long",
+            [](size_t i) { output("%s: %lu us late\n", "sequencer", static_cast<unsigned long>(i)); },
+            [](size_t i) { log("%s: %lu us late\n", "sequencer", static_cast<unsigned long>(i)); });
+        report("float",
+            [](size_t i) { output("cv %d = %.3f V\n", static_cast<int>(i & 15), i * 0.001); },
+            [](size_t i) { log("cv %d = %.3f V\n", static_cast<int>(i & 15), i * 0.001); });
+
+        const raw_header header{"Sched", error::errcode::TIMEOUT_ERROR | error::severity::WARNING, 1234};
+        report("Logger, header and message",
+            [&direct, &header](size_t i) { direct(header, "event %lu late\n", static_cast<unsigned long>(i)); },
+            [&deferred, &header](size_t i) { deferred(header, "event %lu late\n", static_cast<unsigned long>(i)); });
+        assert(log.dropped_count() == 0);
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+
+
+#include "hw/hw_names.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <cassert>
+
+using hw::pads::Pad;
+using hw::pads::PadRow;
+using hw::analog::Encoder;
+using hw::analog::Fader;
+
+namespace sample
+{
+
+enum class Sparse: uint8_t
+    {
+        A,
+        B,
+        __C__,
+        D = 5,
+    };
+
+} /* endof namespace sample */
+
+template <>
+struct reflect::enum_size<sample::Sparse>
+    { static constexpr const size_t value = 7; };
+
+/** Hand-written name table, as device element names used to be */
+static const char* const PAD_NAMES[] = {
+    "CLIP_0_0", "CLIP_0_1", "CLIP_0_2", "CLIP_0_3", "CLIP_0_4", "CLIP_0_5", "CLIP_0_6", "CLIP_0_7",
+};
+
+/** Linear search through every name, the lookup replaced by the perfect hash */
+template <typename E>
+static bool linear_from_name(const char* text, size_t size, E& out)
+{
+    for (size_t i=0; i<reflect::enum_size<E>::value; ++i)
+        {
+            const char* name = reflect::name_of(static_cast<E>(i));
+            if (name != nullptr && std::strncmp(name, text, size) == 0 && name[size] == '\0')
+                {
+                    out = static_cast<E>(i);
+                    return true;
+                }
+        }
+    return false;
+}
+
+template <typename E>
+static void check_names(const char* title)
+{
+    size_t named = 0;
+    for (size_t i=0; i<reflect::enum_size<E>::value; ++i)
+        {
+            const char* name = reflect::name_of(static_cast<E>(i));
+            if (name == nullptr)
+                { continue; }
+            named += 1;
+
+            E found;
+            assert(reflect::from_name(name, std::strlen(name), found) && found == static_cast<E>(i));
+            /* prefixes, extensions and other cases are not names */
+            assert(!reflect::from_name(name, std::strlen(name) -1, found));
+            const std::string longer = std::string(name) + "0";
+            assert(!reflect::from_name(longer.c_str(), longer.size(), found));
+            std::string lower = name;
+            for (char& c: lower)
+                { c = c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; }
+            assert(lower == name || !reflect::from_name(lower.c_str(), lower.size(), found));
+        }
+
+    using index_type = reflect::name_index<reflect::enum_size<E>::value>;
+    const auto& table = reflect::detail::table<E>;
+    printf("\t%-8s %3lu values, %3lu named, %3lu slots, %2lu buckets, index %4lu bytes, names %4lu bytes\n",
+        title, reflect::enum_size<E>::value, named, index_type::Slots, index_type::Buckets,
+        sizeof(index_type), sizeof(table));
+}
+
+template <typename Lookup>
+static double measure(const std::vector<std::string>& names, Lookup lookup, size_t& found)
+{
+    constexpr size_t RUNS = 20000;
+    found = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t r=0; r<RUNS; ++r)
+        for (const std::string& n: names)
+            { found += lookup(n.c_str(), n.size()); }
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return s * 1e9 / (RUNS * names.size());
+}
+
+int main(int argc, char* const argv[])
+{
+    std::cout << "\n===== BEGIN AUTO TESTS =====\n" << std::endl;
+
+    std::cout << "Testing enumerator names" << std::endl;
+    {
+        static_assert(reflect::enumerator_name<sample::Sparse, sample::Sparse::A>() == "A");
+        static_assert(reflect::enumerator_name<sample::Sparse, sample::Sparse::__C__>().empty());
+        static_assert(reflect::enumerator_name<sample::Sparse, static_cast<sample::Sparse>(3)>().empty());
+        static_assert(reflect::is_round_trip<sample::Sparse>());
+
+        assert(std::strcmp(reflect::name_of(sample::Sparse::D), "D") == 0);
+        assert(reflect::name_of(static_cast<sample::Sparse>(4)) == nullptr);
+        assert(reflect::name_of(static_cast<sample::Sparse>(200)) == nullptr);
+
+        for (size_t i=0; i<sizeof(PAD_NAMES) / sizeof(PAD_NAMES[0]); ++i)
+            { assert(std::strcmp(reflect::name_of(static_cast<Pad>(i)), PAD_NAMES[i]) == 0); }
+        assert(std::strcmp(reflect::name_of(Pad::STOP_ALL_CLIPS), "STOP_ALL_CLIPS") == 0);
+        assert(std::strcmp(reflect::name_of(PadRow::SoloCue), "SoloCue") == 0);
+        assert(std::strcmp(reflect::name_of(Encoder::CTRL_5), "CTRL_5") == 0);
+        assert(std::strcmp(reflect::name_of(Fader::MASTER_LEVEL), "MASTER_LEVEL") == 0);
+        /* aliases declared after the count do not hide first values */
+        assert(std::strcmp(reflect::name_of(Pad::__FIRST_PAD__), "CLIP_0_0") == 0);
+        assert(reflect::name_of(Pad::__PADS_COUNT__) == nullptr);
+    }
+
+    std::cout << "Testing names lookups" << std::endl;
+    {
+        check_names<Pad>("Pad");
+        check_names<PadRow>("PadRow");
+        check_names<Encoder>("Encoder");
+        check_names<Fader>("Fader");
+
+        Pad pad;
+        assert(!reflect::from_name("", 0, pad));
+        assert(!reflect::from_name("__UNUSED_33_7__", 15, pad));
+        assert(!reflect::from_name("CUE_LEVEL", 9, pad));
+        Encoder encoder;
+        assert(reflect::from_name("CUE_LEVEL", 9, encoder) && encoder == Encoder::CUE_LEVEL);
+        assert(reflect::from_name("CTRL_70", 6, encoder) && encoder == Encoder::CTRL_7);
+    }
+
+    std::cout << "Benchmarking names lookups" << std::endl;
+    {
+        std::vector<std::string> known, unknown;
+        for (size_t i=0; i<reflect::enum_size<Pad>::value; ++i)
+            {
+                if (const char* name = reflect::name_of(static_cast<Pad>(i)))
+                    {
+                        known.push_back(name);
+                        unknown.push_back(std::string(name) + "X");
+                    }
+            }
+
+        size_t found;
+        const double hashed = measure(known, [](const char* t, size_t s) { Pad p; return reflect::from_name(t, s, p); }, found);
+        assert(found == 20000 * known.size());
+        const double linear = measure(known, [](const char* t, size_t s) { Pad p; return linear_from_name(t, s, p); }, found);
+        assert(found == 20000 * known.size());
+        const double hashed_miss = measure(unknown, [](const char* t, size_t s) { Pad p; return reflect::from_name(t, s, p); }, found);
+        assert(found == 0);
+        const double linear_miss = measure(unknown, [](const char* t, size_t s) { Pad p; return linear_from_name(t, s, p); }, found);
+        assert(found == 0);
+
+        volatile uint8_t value = 0;
+        size_t length = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t r=0; r<2000000; ++r)
+            {
+                length += std::strlen(reflect::name_of(static_cast<Pad>(value)));
+                value = (value + 1) & 31;
+            }
+        const double reverse = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() * 1e9 / 2000000;
+        assert(length > 0);
+
+        printf("\t%lu pad names, ns/lookup:\n", known.size());
+        printf("\t%-16s %8s %8s\n", "", "known", "unknown");
+        printf("\t%-16s %8.1f %8.1f\n", "perfect hash", hashed, hashed_miss);
+        printf("\t%-16s %8.1f %8.1f\n", "linear strncmp", linear, linear_miss);
+        printf("\t%-16s %8.1f\n", "name_of + strlen", reverse);
+    }
+
+    std::cout << "\n===== ALL TESTS PASSED =====\n" << std::endl;
+
+    return EXIT_SUCCESS;
+}